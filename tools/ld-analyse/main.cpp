@@ -94,6 +94,11 @@ int main(int argc, char *argv[])
                                        QCoreApplication::translate("main", "Show debug"));
     parser.addOption(showDebugOption);
 
+    // Option to write a binary metadata sidecar (--write-sidecar)
+    QCommandLineOption writeSidecarOption(QStringList() << "write-sidecar",
+                                          QCoreApplication::translate("main", "Write a binary metadata sidecar (.json.bin) so the JSON metadata opens faster next time"));
+    parser.addOption(writeSidecarOption);
+
     // Positional argument to specify input video file
     parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file"));
 
@@ -102,6 +107,7 @@ int main(int argc, char *argv[])
 
     // Get the configured settings from the parser
     bool isDebugOn = parser.isSet(showDebugOption);
+    bool isWriteSidecarSet = parser.isSet(writeSidecarOption);
 
     // Process the command line options
     if (isDebugOn) showDebug = true;
@@ -116,7 +122,7 @@ int main(int argc, char *argv[])
     }
 
     // Start the GUI application
-    MainWindow w(inputFileName);
+    MainWindow w(inputFileName, isWriteSidecarSet);
     w.show();
 
     return a.exec();
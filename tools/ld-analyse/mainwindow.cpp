@@ -25,7 +25,7 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 
-MainWindow::MainWindow(QString inputFilenameParam, QWidget *parent) :
+MainWindow::MainWindow(QString inputFilenameParam, bool isWriteSidecarSetParam, QWidget *parent) :
     QMainWindow(parent),
     ui(new Ui::MainWindow)
 {
@@ -41,6 +41,7 @@ MainWindow::MainWindow(QString inputFilenameParam, QWidget *parent) :
     // Set the initial frame number
     currentFrameNumber = 1;
     isFileOpen = false;
+    isWriteSidecarSet = isWriteSidecarSetParam;
 
     // Add an event filter to the frame viewer label to catch mouse events
     ui->frameViewerLabel->installEventFilter(ui->frameViewerLabel);
@@ -127,6 +128,7 @@ void MainWindow::updateGuiLoaded(void)
     ui->frameGroupBox->setEnabled(true);
 
     // Enable menu options
+    ui->actionGo_to_picture->setEnabled(true);
     ui->actionLine_scope->setEnabled(true);
     ui->actionVBI->setEnabled(true);
     ui->actionNTSC->setEnabled(true);
@@ -179,6 +181,7 @@ void MainWindow::updateGuiUnloaded(void)
     sourceVideoStatus.setText(tr("No source video file loaded"));
 
     // Disable menu options
+    ui->actionGo_to_picture->setEnabled(false);
     ui->actionLine_scope->setEnabled(false);
     ui->actionVBI->setEnabled(false);
     ui->actionNTSC->setEnabled(false);
@@ -265,20 +268,22 @@ void MainWindow::showFrame(qint32 frameNumber, bool showActiveVideoArea, bool hi
 
         // Draw the drop out data for the first field
         imagePainter.setPen(Qt::red);
-        for (qint32 dropOutIndex = 0; dropOutIndex < firstField.dropOuts.startx.size(); dropOutIndex++) {
-            qint32 startx = firstField.dropOuts.startx[dropOutIndex];
-            qint32 endx = firstField.dropOuts.endx[dropOutIndex];
-            qint32 fieldLine = firstField.dropOuts.fieldLine[dropOutIndex];
+        DropOutSpan firstFieldDropOuts = ldDecodeMetaData.getFieldDropOuts(firstFieldNumber);
+        for (qint32 dropOutIndex = 0; dropOutIndex < firstFieldDropOuts.size(); dropOutIndex++) {
+            qint32 startx = firstFieldDropOuts.startx(dropOutIndex);
+            qint32 endx = firstFieldDropOuts.endx(dropOutIndex);
+            qint32 fieldLine = firstFieldDropOuts.fieldLine(dropOutIndex);
 
             imagePainter.drawLine(startx, ((fieldLine - 1) * 2), endx, ((fieldLine - 1) * 2));
         }
 
         // Draw the drop out data for the second field
         imagePainter.setPen(Qt::blue);
-        for (qint32 dropOutIndex = 0; dropOutIndex < secondField.dropOuts.startx.size(); dropOutIndex++) {
-            qint32 startx = secondField.dropOuts.startx[dropOutIndex];
-            qint32 endx = secondField.dropOuts.endx[dropOutIndex];
-            qint32 fieldLine = secondField.dropOuts.fieldLine[dropOutIndex];
+        DropOutSpan secondFieldDropOuts = ldDecodeMetaData.getFieldDropOuts(secondFieldNumber);
+        for (qint32 dropOutIndex = 0; dropOutIndex < secondFieldDropOuts.size(); dropOutIndex++) {
+            qint32 startx = secondFieldDropOuts.startx(dropOutIndex);
+            qint32 endx = secondFieldDropOuts.endx(dropOutIndex);
+            qint32 fieldLine = secondFieldDropOuts.fieldLine(dropOutIndex);
 
             imagePainter.drawLine(startx, ((fieldLine - 1) * 2) + 1, endx, ((fieldLine - 1) * 2) + 1);
         }
@@ -342,10 +347,6 @@ QImage MainWindow::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNum
     // Get the metadata for the video parameters
     LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
 
-    // Get the raw data for the fields
-    QByteArray firstFieldData = sourceVideo.getVideoField(firstFieldNumber)->getFieldData();
-    QByteArray secondFieldData = sourceVideo.getVideoField(secondFieldNumber)->getFieldData();
-
     // Calculate the frame height
     qint32 frameHeight = (videoParameters.fieldHeight * 2) - 1;
 
@@ -356,29 +357,30 @@ QImage MainWindow::generateQImage(qint32 firstFieldNumber, qint32 secondFieldNum
     // Create a QImage
     QImage frameImage = QImage(videoParameters.fieldWidth, frameHeight, QImage::Format_RGB888);
 
+    // Get the raw data for the fields (the frame is left black if they cannot be read)
+    FieldBuffer firstField;
+    FieldBuffer secondField;
+    if (!getFrameFields(firstFieldNumber, secondFieldNumber, firstField, secondField)) {
+        frameImage.fill(Qt::black);
+        return frameImage;
+    }
+
     // Copy the raw 16-bit grayscale data into the RGB888 QImage
     for (qint32 y = 0; y < frameHeight; y++) {
-        // Extract the current scan line data from the frame
-        qint32 startPointer = (y / 2) * videoParameters.fieldWidth * 2;
-        qint32 length = videoParameters.fieldWidth * 2;
-
-        QByteArray firstLineData = firstFieldData.mid(startPointer, length);
-        QByteArray secondLineData = secondFieldData.mid(startPointer, length);
+        // Get the current scan line data from the frame (even scan lines are from the first field)
+        const quint16 *lineData;
+        if (y % 2) lineData = secondField.constLine(y / 2);
+        else lineData = firstField.constLine(y / 2);
 
+        uchar *imageLine = frameImage.scanLine(y);
         for (qint32 x = 0; x < videoParameters.fieldWidth; x++) {
             // Take just the MSB of the input data
-            qint32 dp = x * 2;
-            uchar pixelValue;
-            if (y % 2) {
-                pixelValue = static_cast<uchar>(secondLineData[dp + 1]);
-            } else {
-                pixelValue = static_cast<uchar>(firstLineData[dp + 1]);
-            }
+            uchar pixelValue = static_cast<uchar>(lineData[x] >> 8);
 
             qint32 xpp = x * 3;
-            *(frameImage.scanLine(y) + xpp + 0) = static_cast<uchar>(pixelValue); // R
-            *(frameImage.scanLine(y) + xpp + 1) = static_cast<uchar>(pixelValue); // G
-            *(frameImage.scanLine(y) + xpp + 2) = static_cast<uchar>(pixelValue); // B
+            *(imageLine + xpp + 0) = static_cast<uchar>(pixelValue); // R
+            *(imageLine + xpp + 1) = static_cast<uchar>(pixelValue); // G
+            *(imageLine + xpp + 2) = static_cast<uchar>(pixelValue); // B
         }
     }
 
@@ -416,6 +418,17 @@ void MainWindow::loadTbcFile(QString inputFileName)
         // Update the GUI
         updateGuiUnloaded();
     } else {
+        // If requested (--write-sidecar) and the metadata was parsed from the JSON file, write
+        // a sidecar so the file opens instantly next time (failure is not an error, e.g. the
+        // directory may be read-only)
+        if (isWriteSidecarSet && !ldDecodeMetaData.isReadFromSidecar()) {
+            if (ldDecodeMetaData.writeSidecar(inputFileName + ".json")) {
+                qInfo() << "Wrote the metadata sidecar" << inputFileName + ".json.bin";
+            } else {
+                qInfo() << "Could not write the metadata sidecar" << inputFileName + ".json.bin";
+            }
+        }
+
         // Opened meta data file, now open TBC source video file
         LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
         sourceVideo.close();
@@ -505,7 +518,7 @@ void MainWindow::on_frameNumberSpinBox_editingFinished()
 {
     if (ui->frameNumberSpinBox->value() != currentFrameNumber) {
         if (ui->frameNumberSpinBox->value() < 1) ui->frameNumberSpinBox->setValue(1);
-        if (ui->frameNumberSpinBox->value() > sourceVideo.getNumberOfAvailableFields()) ui->frameNumberSpinBox->setValue(ldDecodeMetaData.getNumberOfFrames());
+        if (ui->frameNumberSpinBox->value() > ldDecodeMetaData.getNumberOfFrames()) ui->frameNumberSpinBox->setValue(ldDecodeMetaData.getNumberOfFrames());
         currentFrameNumber = ui->frameNumberSpinBox->value();
         ui->frameHorizontalSlider->setValue(currentFrameNumber);
         showFrame(currentFrameNumber, ui->showActiveVideoCheckBox->isChecked(), ui->highlightDropOutsCheckBox->isChecked());
@@ -559,6 +572,30 @@ void MainWindow::on_actionVideo_metadata_triggered()
     videoMetadataDialog->show();
 }
 
+// Go to a frame by its VBI picture number (CAV) or time code (CLV)
+void MainWindow::on_actionGo_to_picture_triggered()
+{
+    bool isOk;
+    QString position = QInputDialog::getText(this, tr("Go to picture"),
+                                             tr("CAV picture number or CLV time code (h:mm:ss.pp):"),
+                                             QLineEdit::Normal, QString(), &isOk);
+    if (!isOk || position.isEmpty()) return;
+
+    qint32 frameNumber = ldDecodeMetaData.getFrameNumberForPosition(position);
+    if (frameNumber == -1) {
+        // Show an error to the user
+        QMessageBox messageBox;
+        messageBox.warning(this, "Warning", "The picture number or time code was not found in the VBI metadata");
+        messageBox.setFixedSize(500, 200);
+        return;
+    }
+
+    currentFrameNumber = frameNumber;
+    ui->frameNumberSpinBox->setValue(currentFrameNumber);
+    ui->frameHorizontalSlider->setValue(currentFrameNumber);
+    showFrame(currentFrameNumber, ui->showActiveVideoCheckBox->isChecked(), ui->highlightDropOutsCheckBox->isChecked());
+}
+
 void MainWindow::on_actionVBI_triggered()
 {
     // Show the VBI dialogue
@@ -580,7 +617,7 @@ void MainWindow::on_combFilterPushButton_clicked()
     qint32 frameHeight = (videoParameters.fieldHeight * 2) - 1;
     qint32 firstActiveScanLine = 44;
     qint32 lastActiveScanLine = 617;
-    QByteArray outputData;
+    FieldBuffer outputData;
 
     // Perform a PAL 2D comb filter on the current frame
     if (videoParameters.isSourcePal) {
@@ -600,9 +637,12 @@ void MainWindow::on_combFilterPushButton_clicked()
         qreal tSaturation = 125.0 + ((100.0 / 20.0) * (20.0 - ldDecodeMetaData.getField(firstFieldNumber).medianBurstIRE));
 
         // Perform the PALcolour filtering (output is RGB 16-16-16)
-        PalColour palColour(videoParameters);
-        outputData = palColour.performDecode(sourceVideo.getVideoField(firstFieldNumber)->getFieldData(), sourceVideo.getVideoField(secondFieldNumber)->getFieldData(),
-                                              100, static_cast<qint32>(tSaturation));
+        FieldBuffer firstField;
+        FieldBuffer secondField;
+        if (getFrameFields(firstFieldNumber, secondFieldNumber, firstField, secondField)) {
+            PalColour palColour(videoParameters);
+            palColour.performDecode(firstField, secondField, 100, static_cast<qint32>(tSaturation), outputData);
+        }
     } else {
         // NTSC source
 
@@ -644,10 +684,15 @@ void MainWindow::on_combFilterPushButton_clicked()
         // Update the comb filter object's configuration
         comb.setConfiguration(configuration);
 
-        outputData = comb.process(sourceVideo.getVideoField(firstFieldNumber)->getFieldData(), sourceVideo.getVideoField(secondFieldNumber)->getFieldData(),
-                                                        ldDecodeMetaData.getField(firstFieldNumber).medianBurstIRE,
-                                                        ldDecodeMetaData.getField(firstFieldNumber).fieldPhaseID,
-                                                        ldDecodeMetaData.getField(secondFieldNumber).fieldPhaseID);
+        FieldBuffer firstField;
+        FieldBuffer secondField;
+        if (getFrameFields(firstFieldNumber, secondFieldNumber, firstField, secondField)) {
+            comb.process(firstField, secondField,
+                         ldDecodeMetaData.getField(firstFieldNumber).medianBurstIRE,
+                         ldDecodeMetaData.getField(firstFieldNumber).fieldPhaseID,
+                         ldDecodeMetaData.getField(secondFieldNumber).fieldPhaseID,
+                         outputData);
+        }
     }
 
     // Create a QImage
@@ -655,25 +700,23 @@ void MainWindow::on_combFilterPushButton_clicked()
     frameImage.fill(Qt::black);
 
     // Copy the raw 16-bit grayscale data into the RGB888 QImage
-    for (qint32 y = firstActiveScanLine; y < lastActiveScanLine; y++) {
-        // Extract the current scan line data from the frame
-        qint32 startPointer = y * videoParameters.fieldWidth * 6;
-        qint32 length = videoParameters.fieldWidth * 6;
-
-        QByteArray rgbData = outputData.mid(startPointer, length);
+    for (qint32 y = firstActiveScanLine; y < lastActiveScanLine && !outputData.isNull(); y++) {
+        // Get the current scan line data from the frame
+        const quint16 *rgbData = outputData.constLine(y);
 
+        uchar *imageLine = frameImage.scanLine(y);
         for (qint32 x = videoParameters.activeVideoStart; x < videoParameters.activeVideoEnd; x++) {
             // Take just the MSB of the input data
-            qint32 dp = x * 6;
+            qint32 dp = x * 3;
 
-            uchar pixelValueR = static_cast<uchar>(rgbData[dp + 1]);
-            uchar pixelValueG = static_cast<uchar>(rgbData[dp + 3]);
-            uchar pixelValueB = static_cast<uchar>(rgbData[dp + 5]);
+            uchar pixelValueR = static_cast<uchar>(rgbData[dp + 0] >> 8);
+            uchar pixelValueG = static_cast<uchar>(rgbData[dp + 1] >> 8);
+            uchar pixelValueB = static_cast<uchar>(rgbData[dp + 2] >> 8);
 
             qint32 xpp = x * 3;
-            *(frameImage.scanLine(y) + xpp + 0) = static_cast<uchar>(pixelValueR); // R
-            *(frameImage.scanLine(y) + xpp + 1) = static_cast<uchar>(pixelValueG); // G
-            *(frameImage.scanLine(y) + xpp + 2) = static_cast<uchar>(pixelValueB); // B
+            *(imageLine + xpp + 0) = static_cast<uchar>(pixelValueR); // R
+            *(imageLine + xpp + 1) = static_cast<uchar>(pixelValueG); // G
+            *(imageLine + xpp + 2) = static_cast<uchar>(pixelValueB); // B
         }
     }
 
@@ -752,9 +795,33 @@ void MainWindow::updateOscilloscopeDialogue(qint32 frameNumber, qint32 scanLine)
     qint32 secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber);
 
     // Update the oscilloscope dialogue
-    oscilloscopeDialog->showTraceImage(sourceVideo.getVideoField(firstFieldNumber)->getFieldData(),
-                                       sourceVideo.getVideoField(secondFieldNumber)->getFieldData(),
-                                       videoParameters, scanLine);
+    FieldBuffer firstField;
+    FieldBuffer secondField;
+    if (!getFrameFields(firstFieldNumber, secondFieldNumber, firstField, secondField)) return;
+    oscilloscopeDialog->showTraceImage(firstField, secondField, videoParameters, scanLine);
+}
+
+// Method to get the source fields for a frame (if either field cannot be read, e.g. a corrupt
+// field in a compressed TBC file, a warning is shown and false is returned)
+bool MainWindow::getFrameFields(qint32 firstFieldNumber, qint32 secondFieldNumber, FieldBuffer &firstField, FieldBuffer &secondField)
+{
+    qint32 fieldWidth = ldDecodeMetaData.getVideoParameters().fieldWidth;
+    QSharedPointer<SourceField> firstSourceField = sourceVideo.getVideoField(firstFieldNumber);
+    QSharedPointer<SourceField> secondSourceField = sourceVideo.getVideoField(secondFieldNumber);
+
+    if (firstSourceField.isNull() || secondSourceField.isNull()) {
+        qWarning() << "Could not read fields" << firstFieldNumber << "and" << secondFieldNumber << "from the TBC file";
+
+        // Show an error to the user
+        QMessageBox messageBox;
+        messageBox.warning(this, "Warning", "Could not read the fields of the frame from the TBC video file");
+        messageBox.setFixedSize(500, 200);
+        return false;
+    }
+
+    firstField = FieldBuffer(firstSourceField, fieldWidth);
+    secondField = FieldBuffer(secondSourceField, fieldWidth);
+    return true;
 }
 
 
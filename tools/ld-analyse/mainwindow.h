@@ -31,12 +31,14 @@
 #include <QDir>
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QInputDialog>
 #include <QLabel>
 #include <QPainter>
 #include <QMouseEvent>
 
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
+#include "fieldbuffer.h"
 #include "oscilloscopedialog.h"
 #include "aboutdialog.h"
 #include "vbidialog.h"
@@ -55,7 +57,7 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
-    explicit MainWindow(QString inputFilenameParam, QWidget *parent = nullptr);
+    explicit MainWindow(QString inputFilenameParam, bool isWriteSidecarSetParam, QWidget *parent = nullptr);
     ~MainWindow();
 
 private slots:
@@ -79,6 +81,7 @@ private slots:
     void on_frameHorizontalSlider_valueChanged(int value);
 
     void on_actionVideo_metadata_triggered();
+    void on_actionGo_to_picture_triggered();
 
 private:
     Ui::MainWindow *ui;
@@ -98,6 +101,7 @@ private:
     qint32 currentFrameNumber;
     qint32 lastScopeLine;
     bool isFileOpen;
+    bool isWriteSidecarSet;
 
     void updateGuiLoaded(void);
     void updateGuiUnloaded(void);
@@ -106,6 +110,7 @@ private:
     void hideFrame(void);
 
     QImage generateQImage(qint32 firstFieldNumber, qint32 secondFieldNumber);
+    bool getFrameFields(qint32 firstFieldNumber, qint32 secondFieldNumber, FieldBuffer &firstField, FieldBuffer &secondField);
 
     void loadTbcFile(QString inputFileName);
     void updateOscilloscopeDialogue(qint32 frameNumber, qint32 scanLine);
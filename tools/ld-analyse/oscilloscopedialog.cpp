@@ -52,7 +52,7 @@ OscilloscopeDialog::~OscilloscopeDialog()
     delete ui;
 }
 
-void OscilloscopeDialog::showTraceImage(QByteArray firstFieldData, QByteArray secondFieldData, LdDecodeMetaData::VideoParameters videoParameters, qint32 scanLine)
+void OscilloscopeDialog::showTraceImage(FieldBuffer firstField, FieldBuffer secondField, LdDecodeMetaData::VideoParameters videoParameters, qint32 scanLine)
 {
     qDebug() << "OscilloscopeDialog::showTraceImage(): Called for scan-line" << scanLine;
 
@@ -84,8 +84,8 @@ void OscilloscopeDialog::showTraceImage(QByteArray firstFieldData, QByteArray se
 
     // Always take the raw frame data (without DOC)
     QImage traceImage;
-    if (isFieldTop) traceImage = getFieldLineTraceImage(firstFieldData, videoParameters, fieldLine);
-    else traceImage = getFieldLineTraceImage(secondFieldData, videoParameters, fieldLine);
+    if (isFieldTop) traceImage = getFieldLineTraceImage(firstField, videoParameters, fieldLine);
+    else traceImage = getFieldLineTraceImage(secondField, videoParameters, fieldLine);
 
     // Add the QImage to the QLabel in the dialogue
     ui->scopeLabel->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
@@ -106,7 +106,7 @@ void OscilloscopeDialog::showTraceImage(QByteArray firstFieldData, QByteArray se
     maximumScanLines = frameHeight;
 }
 
-QImage OscilloscopeDialog::getFieldLineTraceImage(QByteArray fieldLineData, LdDecodeMetaData::VideoParameters videoParameters, qint32 fieldLine)
+QImage OscilloscopeDialog::getFieldLineTraceImage(FieldBuffer field, LdDecodeMetaData::VideoParameters videoParameters, qint32 fieldLine)
 {
     qDebug() << "OscilloscopeDialog::getFieldLineTraceImage(): Called for field line" << fieldLine;
 
@@ -129,7 +129,7 @@ QImage OscilloscopeDialog::getFieldLineTraceImage(QByteArray fieldLineData, LdDe
     QPainter scopePainter;
 
     // Ensure we have valid data
-    if (fieldLineData.isEmpty()) {
+    if (field.isNull()) {
         qWarning() << "Did not get valid RGB data for the requested field!";
         return scopeImage;
     }
@@ -183,11 +183,11 @@ QImage OscilloscopeDialog::getFieldLineTraceImage(QByteArray fieldLineData, LdDe
     // To extract C from PAL, a HPF of 3.8MHz is required
     // To extract C from NTSC, a HPF of 3.0MHz is required
 
-    // Get the YC data
+    // Get the YC data (field lines are numbered from 1)
+    const quint16 *fieldLineData = field.constLine(fieldLine - 1);
     for (qint32 xPosition = 0; xPosition < videoParameters.fieldWidth; xPosition++) {
-        // Get the 16-bit YC value for the current pixel (frame data is numbered 0-624 or 0-524)
-        uchar *pixelPointer =  reinterpret_cast<uchar*>(fieldLineData.data()) + ((fieldLine - 1) * videoParameters.fieldWidth * 2) + (xPosition * 2);
-        signalDataYC[xPosition] = (pixelPointer[1] * 256) + pixelPointer[0];
+        // Get the 16-bit YC value for the current pixel
+        signalDataYC[xPosition] = fieldLineData[xPosition];
     }
 
     if (showY) {
@@ -32,6 +32,7 @@
 
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
+#include "fieldbuffer.h"
 
 namespace Ui {
 class OscilloscopeDialog;
@@ -45,7 +46,7 @@ public:
     explicit OscilloscopeDialog(QWidget *parent = nullptr);
     ~OscilloscopeDialog();
 
-    void showTraceImage(QByteArray topFieldData, QByteArray bottomFieldData, LdDecodeMetaData::VideoParameters videoParameters, qint32 scanLine);
+    void showTraceImage(FieldBuffer topField, FieldBuffer bottomField, LdDecodeMetaData::VideoParameters videoParameters, qint32 scanLine);
 
 signals:
     void scanLineChanged(qint32 scanLine);
@@ -62,7 +63,7 @@ private:
     Ui::OscilloscopeDialog *ui;
     qint32 maximumScanLines;
 
-    QImage getFieldLineTraceImage(QByteArray rgbData, LdDecodeMetaData::VideoParameters frameParameters, qint32 fieldLine);
+    QImage getFieldLineTraceImage(FieldBuffer field, LdDecodeMetaData::VideoParameters frameParameters, qint32 fieldLine);
 };
 
 #endif // OSCILLOSCOPEDIALOG_H
@@ -80,9 +80,11 @@ void Comb::setConfiguration(Comb::Configuration configurationParam)
     postConfigurationTasks();
 }
 
-// Process the input buffer into the RGB output buffer
-QByteArray Comb::process(QByteArray firstFieldInputBuffer, QByteArray secondFieldInputBuffer, qreal burstMedianIre,
-                         qint32 firstFieldPhaseID, qint32 secondFieldPhaseID)
+// Process the input fields into the RGB output frame
+// Returns false if no frame was output (the 3D filter needs three frames before it can output
+// the first); the output frame is reused if it is already the required size
+bool Comb::process(FieldBuffer firstField, FieldBuffer secondField, qreal burstMedianIre,
+                   qint32 firstFieldPhaseID, qint32 secondFieldPhaseID, FieldBuffer &rgbOutputFrame)
 {
     qint32 frameHeight = ((configuration.fieldHeight * 2) - 1);
 
@@ -91,16 +93,21 @@ QByteArray Comb::process(QByteArray firstFieldInputBuffer, QByteArray secondFiel
 
     qint32 currentFrameBuffer = (configuration.filterDepth == 3) ? 1 : 0; // Set f = 1 if filterdepth = 3 else f = 0
 
-    // Shift the frames in the buffer
+    // Shift the frames in the buffer (the oldest frame's raw buffer is reused for the new frame,
+    // rather than allocating a new one)
+    FieldBuffer recycledRawBuffer = frameBuffer[2].rawbuffer;
     frameBuffer[2] = frameBuffer[1];
     frameBuffer[1] = frameBuffer[0];
+    frameBuffer[0].rawbuffer.swap(recycledRawBuffer);
+    recycledRawBuffer = FieldBuffer();
 
     // Interlace the input fields and place in the frame's raw buffer
+    frameBuffer[0].rawbuffer.resize(configuration.fieldWidth, frameHeight);
+    size_t lineBytes = static_cast<size_t>(configuration.fieldWidth) * 2;
     qint32 fieldLine = 0;
-    frameBuffer[0].rawbuffer.clear();
     for (qint32 frameLine = 0; frameLine < (configuration.fieldHeight * 2); frameLine += 2) {
-        frameBuffer[0].rawbuffer.append(firstFieldInputBuffer.mid(fieldLine * configuration.fieldWidth * 2, configuration.fieldWidth * 2));
-        if (frameLine < frameHeight) frameBuffer[0].rawbuffer.append(secondFieldInputBuffer.mid(fieldLine * configuration.fieldWidth * 2, configuration.fieldWidth * 2));
+        memcpy(frameBuffer[0].rawbuffer.line(frameLine), firstField.constLine(fieldLine), lineBytes);
+        if (frameLine < frameHeight) memcpy(frameBuffer[0].rawbuffer.line(frameLine + 1), secondField.constLine(fieldLine), lineBytes);
         fieldLine++;
     }
 
@@ -129,8 +136,8 @@ QByteArray Comb::process(QByteArray firstFieldInputBuffer, QByteArray secondFiel
         // If filterDepth is 3, make sure we have 3 frames before processing further
         if (frameCounter < 2) {
             frameCounter++;
-            // Just return an empty output buffer
-            return nullptr;
+            // No output frame yet
+            return false;
         }
 
         split3D(currentFrameBuffer, configuration.opticalflow);
@@ -145,10 +152,10 @@ QByteArray Comb::process(QByteArray firstFieldInputBuffer, QByteArray secondFiel
     doCNR(tempYiqBuffer);
 
     // Convert the YIQ result to RGB
-    QByteArray rgbOutputBuffer = yiqToRgbFrame(currentFrameBuffer, tempYiqBuffer);
+    yiqToRgbFrame(currentFrameBuffer, tempYiqBuffer, rgbOutputFrame);
     frameCounter++;
 
-    return rgbOutputBuffer;
+    return true;
 }
 
 // Private methods ----------------------------------------------------------------------------------------------------
@@ -241,7 +248,7 @@ void Comb::split1D(qint32 currentFrameBuffer)
 
     for (qint32 lineNumber = configuration.firstVisibleFrameLine; lineNumber < frameHeight; lineNumber++) {
         // Get a pointer to the line's data
-        quint16 *line = reinterpret_cast<quint16 *>(frameBuffer[currentFrameBuffer].rawbuffer.data() + (lineNumber * configuration.fieldWidth) * 2);
+        const quint16 *line = frameBuffer[currentFrameBuffer].rawbuffer.constLine(lineNumber);
 
         // Determine if the line phase should be inverted
         if ((lineNumber % 2) == 0) {
@@ -363,11 +370,11 @@ void Comb::split3D(qint32 currentFrameBuffer, bool opt_flow)
     qint32 frameHeight = ((configuration.fieldHeight * 2) - 1);
 
     for (qint32 lineNumber = configuration.firstVisibleFrameLine; lineNumber < frameHeight; lineNumber++) {
-        quint16 *line = reinterpret_cast<quint16 *>(frameBuffer[currentFrameBuffer].rawbuffer.data() + (lineNumber * configuration.fieldWidth) * 2);
+        const quint16 *line = frameBuffer[currentFrameBuffer].rawbuffer.constLine(lineNumber);
 
         // shortcuts for previous/next 1D/pixel lines
-        quint16 *p3line = reinterpret_cast<quint16 *>(frameBuffer[0].rawbuffer.data() + (lineNumber * configuration.fieldWidth) * 2);
-        quint16 *n3line = reinterpret_cast<quint16 *>(frameBuffer[2].rawbuffer.data() + (lineNumber * configuration.fieldWidth) * 2);
+        const quint16 *p3line = frameBuffer[0].rawbuffer.constLine(lineNumber);
+        const quint16 *n3line = frameBuffer[2].rawbuffer.constLine(lineNumber);
 
         Filter lp_3d({0.005719569452904, 0.009426612841315, 0.019748592575455, 0.036822680065252, 0.058983880135427, 0.082947830292278, 0.104489989820068,
                       0.119454688318951, 0.124812312996699, 0.119454688318952, 0.104489989820068, 0.082947830292278, 0.058983880135427, 0.036822680065252,
@@ -378,10 +385,9 @@ void Comb::split3D(qint32 currentFrameBuffer, bool opt_flow)
         for (qint32 h = configuration.activeVideoStart; (configuration.filterDepth >= 3) && (h < configuration.activeVideoEnd); h++) {
             qint32 adr = (lineNumber * configuration.fieldWidth) + h;
 
-            // Since the underlying raw buffer is a QByteArray we have to map the data points to quint16
-            quint16 *f0 = reinterpret_cast<quint16 *>(frameBuffer[0].rawbuffer.data() + (adr * 2));
-            quint16 *f1 = reinterpret_cast<quint16 *>(frameBuffer[1].rawbuffer.data() + (adr * 2));
-            quint16 *f2 = reinterpret_cast<quint16 *>(frameBuffer[2].rawbuffer.data() + (adr * 2));
+            const quint16 *f0 = frameBuffer[0].rawbuffer.constData() + adr;
+            const quint16 *f1 = frameBuffer[1].rawbuffer.constData() + adr;
+            const quint16 *f2 = frameBuffer[2].rawbuffer.constData() + adr;
 
             qreal __k = abs(f0[0] - f2[0]);
             __k += abs((f1[0] - f2[0]) - (f1[0] - f0[0]));
@@ -429,7 +435,7 @@ void Comb::splitIQ(qint32 currentFrameBuffer)
 
     for (qint32 lineNumber = configuration.firstVisibleFrameLine; lineNumber < frameHeight; lineNumber++) {
         // Get a pointer to the line's data
-        quint16 *line = reinterpret_cast<quint16 *>(frameBuffer[currentFrameBuffer].rawbuffer.data() + (lineNumber * configuration.fieldWidth) * 2);
+        const quint16 *line = frameBuffer[currentFrameBuffer].rawbuffer.constLine(lineNumber);
 
         // Determine if the line phase should be inverted
         if ((lineNumber % 2) == 0) {
@@ -534,20 +540,19 @@ void Comb::doYNR(QVector<yiqLine_t> &yiqBuffer, qreal min)
 }
 
 // Convert frame from YIQ to RGB
-QByteArray Comb::yiqToRgbFrame(qint32 currentFrameBuffer, QVector<yiqLine_t> yiqBuffer)
+void Comb::yiqToRgbFrame(qint32 currentFrameBuffer, QVector<yiqLine_t> yiqBuffer, FieldBuffer &rgbOutputFrame)
 {
     qint32 frameHeight = ((configuration.fieldHeight * 2) - 1);
 
-    QByteArray rgbOutputFrame;
-    rgbOutputFrame.resize((configuration.fieldWidth * frameHeight * 3) * 2); // * 3 for RGB 16-16-16)
+    rgbOutputFrame.resize(configuration.fieldWidth * 3, frameHeight); // * 3 for RGB 16-16-16
 
     // Initialise the output frame
     rgbOutputFrame.fill(0);
 
     // Perform YIQ to RGB conversion
     for (qint32 lineNumber = configuration.firstVisibleFrameLine; lineNumber < frameHeight; lineNumber++) {
-        // Map the QByteArray data to an unsigned 16 bit pointer
-        quint16 *line_output = reinterpret_cast<quint16 *>(rgbOutputFrame.data() + ((configuration.fieldWidth * 3 * lineNumber) * 2));
+        // Get a pointer to the output line
+        quint16 *line_output = rgbOutputFrame.line(lineNumber);
 
         // Offset the output by the activeVideoStart to keep the output frame
         // in the same x position as the input video frame
@@ -573,9 +578,6 @@ QByteArray Comb::yiqToRgbFrame(qint32 currentFrameBuffer, QVector<yiqLine_t> yiq
             line_output[o++] = static_cast<quint16>(r.b);
         }
     }
-
-    // Return the RGB frame data
-    return rgbOutputFrame;
 }
 
 // Perform optical flow detection
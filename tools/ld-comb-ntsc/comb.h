@@ -37,6 +37,7 @@
 #include "filter.h"
 #include "yiq.h"
 #include "rgb.h"
+#include "fieldbuffer.h"
 
 // Fix required for Mac OS compilation - environment doesn't seem to set up
 // the expected definitions properly
@@ -72,7 +73,8 @@ public:
 
     Configuration getConfiguration(void);
     void setConfiguration(Configuration configurationParam);
-    QByteArray process(QByteArray topFieldInputBuffer, QByteArray bottomFieldInputBuffer, qreal burstMedianIre, qint32 topFieldPhaseID, qint32 bottomFieldPhaseID);
+    bool process(FieldBuffer topField, FieldBuffer bottomField, qreal burstMedianIre, qint32 topFieldPhaseID, qint32 bottomFieldPhaseID,
+                 FieldBuffer &rgbOutputFrame);
 
 protected:
 
@@ -109,7 +111,7 @@ private:
     };
 
     struct frame_t {
-        QByteArray rawbuffer;
+        FieldBuffer rawbuffer;
 
         qreal clpbuffer[3][max_y][max_x];
         qreal combk[3][max_y][max_x];
@@ -139,7 +141,7 @@ private:
     void splitIQ(qint32 currentFrameBuffer);
     void doCNR(QVector<yiqLine_t> &yiqBuffer, qreal min = -1.0);
     void doYNR(QVector<yiqLine_t> &yiqBuffer, qreal min = -1.0);
-    QByteArray yiqToRgbFrame(qint32 currentFrameBuffer, QVector<yiqLine_t> yiqBuffer);
+    void yiqToRgbFrame(qint32 currentFrameBuffer, QVector<yiqLine_t> yiqBuffer, FieldBuffer &rgbOutputFrame);
     void opticalFlow3D(QVector<yiqLine_t> yiqBuffer);
     void adjustY(qint32 currentFrameBuffer, QVector<yiqLine_t> &yiqBuffer);
 
@@ -118,6 +118,18 @@ int main(int argc, char *argv[])
                                         QCoreApplication::translate("main", "number"));
     parser.addOption(lengthOption);
 
+    // Option to select the start frame by VBI picture number or time code (--start-picture)
+    QCommandLineOption startPictureOption(QStringList() << "start-picture",
+                                        QCoreApplication::translate("main", "Specify the start frame by CAV picture number or CLV time code (h:mm:ss.pp)"),
+                                        QCoreApplication::translate("main", "picture"));
+    parser.addOption(startPictureOption);
+
+    // Option to select the end frame by VBI picture number or time code (--end-picture)
+    QCommandLineOption endPictureOption(QStringList() << "end-picture",
+                                        QCoreApplication::translate("main", "Specify the last frame to process by CAV picture number or CLV time code (h:mm:ss.pp)"),
+                                        QCoreApplication::translate("main", "picture"));
+    parser.addOption(endPictureOption);
+
     // Option to set the black and white output flag (causes output to be black and white) (-b)
     QCommandLineOption setBwModeOption(QStringList() << "b" << "blackandwhite",
                                        QCoreApplication::translate("main", "Output in black and white"));
@@ -144,11 +156,23 @@ int main(int argc, char *argv[])
                                         QCoreApplication::translate("main", "number 0-65535"));
     parser.addOption(black16IreOption);
 
+    // Option to set the size of the field cache (-m)
+    QCommandLineOption cacheSizeOption(QStringList() << "m" << "cachesize",
+                                       QCoreApplication::translate("main", "Specify the size of the field cache in MiB (default 64)"),
+                                       QCoreApplication::translate("main", "number"));
+    parser.addOption(cacheSizeOption);
+
+    // Option to specify the input metadata file (--input-json)
+    QCommandLineOption inputJsonOption(QStringList() << "input-json",
+                                       QCoreApplication::translate("main", "Specify the input JSON file (default input.json)"),
+                                       QCoreApplication::translate("main", "filename"));
+    parser.addOption(inputJsonOption);
+
     // Positional argument to specify input video file
-    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file"));
+    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file (- for piped input)"));
 
         // Positional argument to specify output video file
-    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify output RGB file"));
+    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify output RGB file (- for piped output)"));
 
     // Process the command line options and arguments given by the user
     parser.process(a);
@@ -176,6 +200,26 @@ int main(int argc, char *argv[])
 
     qint32 startFrame = -1;
     qint32 length = -1;
+    QString startPosition;
+    QString endPosition;
+
+    if (parser.isSet(startPictureOption)) {
+        if (parser.isSet(startFrameOption)) {
+            // Quit with error
+            qCritical("The start frame and start picture cannot both be specified");
+            return -1;
+        }
+        startPosition = parser.value(startPictureOption);
+    }
+
+    if (parser.isSet(endPictureOption)) {
+        if (parser.isSet(lengthOption)) {
+            // Quit with error
+            qCritical("The length and end picture cannot both be specified");
+            return -1;
+        }
+        endPosition = parser.value(endPictureOption);
+    }
 
     if (parser.isSet(startFrameOption)) {
         startFrame = parser.value(startFrameOption).toInt();
@@ -209,6 +253,17 @@ int main(int argc, char *argv[])
         }
     }
 
+    qint32 cacheSize = -1;
+    if (parser.isSet(cacheSizeOption)) {
+        cacheSize = parser.value(cacheSizeOption).toInt();
+
+        if (cacheSize < 0) {
+            // Quit with error
+            qCritical("Specified cache size must be zero or greater");
+            return -1;
+        }
+    }
+
     QString inputFileName;
     QString outputFileName;
     QStringList positionalArguments = parser.positionalArguments();
@@ -221,17 +276,28 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    if (inputFileName == outputFileName) {
+    if (inputFileName == outputFileName && inputFileName != "-") {
         // Quit with error
         qCritical("Input and output file names cannot be the same");
         return -1;
     }
 
+    // Get the metadata file name (piped input has no file name to derive the metadata
+    // file name from)
+    QString inputJsonFileName = inputFileName + ".json";
+    if (parser.isSet(inputJsonOption)) {
+        inputJsonFileName = parser.value(inputJsonOption);
+    } else if (inputFileName == "-") {
+        // Quit with error
+        qCritical("You must specify the input JSON file when using piped input");
+        return -1;
+    }
+
     // Process the input file
-    ntscFilter.process(inputFileName, outputFileName,
-                       startFrame, length,
+    ntscFilter.process(inputFileName, inputJsonFileName, outputFileName,
+                       startFrame, length, startPosition, endPosition,
                        filterDepth, blackAndWhite, adaptive2d, opticalFlow, crop,
-                       overrideBlack16Ire);
+                       overrideBlack16Ire, cacheSize);
 
     // Quit with success
     return 0;
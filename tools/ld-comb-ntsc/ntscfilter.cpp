@@ -30,14 +30,16 @@ NtscFilter::NtscFilter(QObject *parent) : QObject(parent)
 
 }
 
-bool NtscFilter::process(QString inputFileName, QString outputFileName,
+// Note: A file name of "-" reads the input TBC from stdin or writes the output RGB to stdout
+bool NtscFilter::process(QString inputFileName, QString inputJsonFileName, QString outputFileName,
                          qint32 startFrame, qint32 length,
+                         QString startPosition, QString endPosition,
                          qint32 filterDepth, bool blackAndWhite,
                          bool adaptive2d, bool opticalFlow,
-                         bool cropOutput, qint32 overrideBlack16Ire)
+                         bool cropOutput, qint32 overrideBlack16Ire, qint32 cacheSize)
 {
     // Open the source video metadata
-    if (!ldDecodeMetaData.read(inputFileName + ".json")) {
+    if (!ldDecodeMetaData.read(inputJsonFileName)) {
         qInfo() << "Unable to open ld-decode metadata file";
         return false;
     }
@@ -92,13 +94,18 @@ bool NtscFilter::process(QString inputFileName, QString outputFileName,
                "will be colourised and trimmed to" << static_cast<qint32>(cropVideoEnd) - static_cast<qint32>(cropVideoStart) << "x" <<
                static_cast<qint32>(cropLastActiveScanLine) - static_cast<qint32>(cropFirstActiveScanLine);
 
-    // Open the source video file
+    // Open the source video file (if the source is a stream the number of fields is taken from the metadata)
+    if (cacheSize != -1) sourceVideo.setCacheSize(cacheSize);
+    sourceVideo.setStreamFieldCount(ldDecodeMetaData.getNumberOfFields());
     if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
         // Could not open source video file
         qInfo() << "Unable to open ld-decode video file";
         return false;
     }
 
+    // Find the start and end frames from the VBI picture numbers or time codes (if specified)
+    if (!ldDecodeMetaData.getFrameRangeForPositions(startPosition, endPosition, startFrame, length)) return false;
+
     // If no startFrame parameter was specified, set the start frame to 1
     if (startFrame == -1) startFrame = 1;
 
@@ -119,9 +126,10 @@ bool NtscFilter::process(QString inputFileName, QString outputFileName,
 
     qInfo() << "Processing from start frame #" << startFrame << "with a length of" << length << "frames";
 
-    // Open the output RGB file
-    QFile targetVideo(outputFileName);
-    if (!targetVideo.open(QIODevice::WriteOnly)) {
+    // Open the output RGB file - the frames are written by a background thread so that the
+    // filtering does not wait for the writes
+    OutputWriter targetVideo;
+    if (!targetVideo.open(outputFileName, videoParameters.fieldWidth * frameHeight * 6)) {
             // Failed to open output file
             qCritical() << "Could not open " << outputFileName << "as RGB output file";
             sourceVideo.close();
@@ -175,6 +183,10 @@ bool NtscFilter::process(QString inputFileName, QString outputFileName,
 
     if (overrideBlack16Ire != -1) qInfo() << "Overriding JSON Black16IRE with" << overrideBlack16Ire;
 
+    // The output buffers are reused for each frame
+    FieldBuffer rgbOutputData;
+    FieldBuffer croppedOutputData;
+
     // Process the frames
     QElapsedTimer totalTimer;
     totalTimer.start();
@@ -186,24 +198,39 @@ bool NtscFilter::process(QString inputFileName, QString outputFileName,
         qint32 firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber);
         qint32 secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber);
 
+        // Get the field metadata (without copying it)
+        const LdDecodeMetaData::Field &firstField = ldDecodeMetaData.getConstField(firstFieldNumber);
+        const LdDecodeMetaData::Field &secondField = ldDecodeMetaData.getConstField(secondFieldNumber);
+
+        // Get the source fields (the read fails if a compressed field cannot be decoded or a
+        // piped input ends early)
+        QSharedPointer<SourceField> firstSourceField = sourceVideo.getVideoField(firstFieldNumber);
+        QSharedPointer<SourceField> secondSourceField = sourceVideo.getVideoField(secondFieldNumber);
+        if (firstSourceField.isNull() || secondSourceField.isNull()) {
+            qCritical() << "Reading fields" << firstFieldNumber << "and" << secondFieldNumber << "from the input video file failed";
+            targetVideo.close();
+            sourceVideo.close();
+            return false;
+        }
+
         // Filter the frame
-        QByteArray rgbOutputData = comb.process(sourceVideo.getVideoField(firstFieldNumber)->getFieldData(), sourceVideo.getVideoField(secondFieldNumber)->getFieldData(),
-                                                ldDecodeMetaData.getField(firstFieldNumber).medianBurstIRE,
-                                                ldDecodeMetaData.getField(firstFieldNumber).fieldPhaseID,
-                                                ldDecodeMetaData.getField(secondFieldNumber).fieldPhaseID);
+        bool isFrameOutput = comb.process(FieldBuffer(firstSourceField, videoParameters.fieldWidth),
+                                          FieldBuffer(secondSourceField, videoParameters.fieldWidth),
+                                          firstField.medianBurstIRE, firstField.fieldPhaseID, secondField.fieldPhaseID,
+                                          rgbOutputData);
 
-        // Check the output data isn't empty (the first two 3D processed frames are empty)
-        if (!rgbOutputData.isEmpty()) {
+        // Check there is output data (the first two 3D processed frames are empty)
+        if (isFrameOutput) {
             // The NTSC filter outputs the whole frame, so here we crop it to the required dimensions
-            QByteArray croppedOutputData;
+            croppedOutputData.resize((cropVideoEnd - cropVideoStart) * 3, cropLastActiveScanLine - cropFirstActiveScanLine);
 
-            for (qint32 y = static_cast<qint32>(cropFirstActiveScanLine); y < static_cast<qint32>(cropLastActiveScanLine); y++) {
-                croppedOutputData.append(rgbOutputData.mid((y * videoParameters.fieldWidth * 6) + (static_cast<qint32>(cropVideoStart) * 6),
-                                                        ((static_cast<qint32>(cropVideoEnd) - static_cast<qint32>(cropVideoStart)) * 6)));
+            for (qint32 y = cropFirstActiveScanLine; y < cropLastActiveScanLine; y++) {
+                memcpy(croppedOutputData.line(y - cropFirstActiveScanLine), rgbOutputData.constLine(y) + (cropVideoStart * 3),
+                       static_cast<size_t>((cropVideoEnd - cropVideoStart) * 6));
             }
 
             // Save the frame data to the output file
-            if (!targetVideo.write(croppedOutputData.data(), croppedOutputData.size())) {
+            if (!targetVideo.write(reinterpret_cast<const char *>(croppedOutputData.constData()), croppedOutputData.getSizeInBytes())) {
                 // Could not write to target video file
                 qInfo() << "Writing to the output video file failed";
                 targetVideo.close();
@@ -220,9 +247,18 @@ bool NtscFilter::process(QString inputFileName, QString outputFileName,
                     "/" << secondFieldNumber << ") -" << fps << "FPS";
     }
 
-    // Close the input and output files
+    // Show the field cache statistics
+    SourceVideo::CacheStatistics cacheStatistics = sourceVideo.getCacheStatistics();
+    qInfo() << "Field cache:" << cacheStatistics.hits << "hits," << cacheStatistics.misses << "misses," <<
+               cacheStatistics.evictions << "evictions";
+    qDebug() << "NtscFilter::process(): Field buffer allocations:" << FieldBuffer::getAllocationCount();
+
+    // Close the input and output files (once all of the queued frames are written)
     sourceVideo.close();
-    targetVideo.close();
+    if (!targetVideo.close()) {
+        qInfo() << "Writing to the output video file failed";
+        return false;
+    }
 
     return true;
 }
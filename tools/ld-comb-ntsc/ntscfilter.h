@@ -34,6 +34,7 @@
 // Include the ld-decode-tools shared libary headers
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
+#include "outputwriter.h"
 
 #include "comb.h"
 
@@ -43,9 +44,10 @@ class NtscFilter : public QObject
 public:
     explicit NtscFilter(QObject *parent = nullptr);
 
-    bool process(QString inputFileName, QString outputFileName, qint32 startFrame, qint32 length, qint32 filterDepth = 2,
+    bool process(QString inputFileName, QString inputJsonFileName, QString outputFileName, qint32 startFrame, qint32 length,
+                 QString startPosition, QString endPosition, qint32 filterDepth = 2,
                  bool blackAndWhite = false, bool adaptive2d = true, bool opticalFlow = true,
-                 bool cropOutput = false, qint32 overrideBlack16Ire = -1);
+                 bool cropOutput = false, qint32 overrideBlack16Ire = -1, qint32 cacheSize = -1);
 
 signals:
 
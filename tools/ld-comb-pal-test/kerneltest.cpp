@@ -0,0 +1,289 @@
+/************************************************************************
+
+    kerneltest.cpp
+
+    ld-comb-pal-test - Tests for the PALcolour filter kernels
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-comb-pal-test is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "kerneltest.h"
+
+#include <cmath>
+#include <limits>
+
+namespace {
+    // The visible area that is compared (as cropped by ld-comb-pal)
+    const qint32 firstActiveScanLine = 44;
+    const qint32 lastActiveScanLine = 617;
+
+    // The minimum PSNR (in dB, of the visible area) of the single precision and fixed-point
+    // decoders against the double precision scalar decoder.  On the synthetic frames they
+    // measure 86-101 dB and 76-78 dB
+    const qreal minimumSinglePrecisionPsnr = 80.0;
+    const qreal minimumFixedPointPsnr = 70.0;
+
+    // Pseudo-random numbers for the synthetic frames (the same on every platform, so a
+    // failure can be repeated)
+    quint32 randomState = 1;
+
+    qint32 getRandom(qint32 range)
+    {
+        randomState = randomState * 1103515245 + 12345;
+        return static_cast<qint32>((randomState >> 16) % static_cast<quint32>(range));
+    }
+}
+
+KernelTest::KernelTest(QObject *parent) : QObject(parent)
+{
+    numberOfFailures = 0;
+}
+
+// Run the tests (returns false if any of them failed)
+bool KernelTest::process(QString inputFileName, qint32 numberOfFrames)
+{
+    QVector<TestFrame> testFrames;
+    addSyntheticFrames(testFrames, numberOfFrames);
+    if (!inputFileName.isEmpty() && !addRealFrames(testFrames, inputFileName, numberOfFrames)) return false;
+
+    if (PalColour::getFastestKernel() == PalColour::scalarKernel) {
+        qInfo() << "The CPU does not support a SIMD filter kernel - only the scalar kernels are tested";
+    }
+
+    numberOfFailures = 0;
+    for (qint32 i = 0; i < testFrames.size(); i++) testFrame(testFrames[i]);
+
+    if (numberOfFailures != 0) {
+        qInfo() << numberOfFailures << "checks failed";
+        return false;
+    }
+
+    qInfo() << "All checks passed on" << testFrames.size() << "frames";
+    return true;
+}
+
+// Get the video parameters of the synthetic frames (a PAL TBC file at 4 x fSC)
+LdDecodeMetaData::VideoParameters KernelTest::getSyntheticVideoParameters(void)
+{
+    LdDecodeMetaData::VideoParameters videoParameters = LdDecodeMetaData::VideoParameters();
+    videoParameters.isSourcePal = true;
+    videoParameters.fieldWidth = 1135;
+    videoParameters.fieldHeight = 313;
+    videoParameters.sampleRate = 17734475;
+    videoParameters.fsc = 4433618;
+    videoParameters.colourBurstStart = 98;
+    videoParameters.colourBurstEnd = 138;
+    videoParameters.blackLevelStart = 148;
+    videoParameters.blackLevelEnd = 178;
+    videoParameters.activeVideoStart = 185;
+    videoParameters.activeVideoEnd = 1107;
+    videoParameters.white16bIre = 54016;
+    videoParameters.black16bIre = 16384;
+
+    return videoParameters;
+}
+
+// Add the synthetic frames: a colour burst and a subcarrier of varying amplitude and phase
+// over a luma ramp, and full-range noise (which exercises the extremes of the filter sums)
+void KernelTest::addSyntheticFrames(QVector<TestFrame> &testFrames, qint32 numberOfFrames)
+{
+    LdDecodeMetaData::VideoParameters videoParameters = getSyntheticVideoParameters();
+    randomState = 1;
+
+    for (qint32 frame = 0; frame < numberOfFrames * 2; frame++) {
+        bool isNoise = (frame >= numberOfFrames);
+
+        TestFrame testFrame;
+        testFrame.name = QString(isNoise ? "noise frame %1" : "synthetic frame %1").arg(frame % numberOfFrames + 1);
+        testFrame.videoParameters = videoParameters;
+        testFrame.firstField.resize(videoParameters.fieldWidth, videoParameters.fieldHeight);
+        testFrame.secondField.resize(videoParameters.fieldWidth, videoParameters.fieldHeight);
+        testFrame.saturation = 125 + (frame % numberOfFrames) * 5;
+        testFrame.isAccuracyTested = !isNoise;
+
+        for (qint32 field = 0; field < 2; field++) {
+            FieldBuffer &fieldBuffer = (field == 0) ? testFrame.firstField : testFrame.secondField;
+
+            for (qint32 y = 0; y < videoParameters.fieldHeight; y++) {
+                quint16 *line = fieldBuffer.line(y);
+
+                for (qint32 x = 0; x < videoParameters.fieldWidth; x++) {
+                    qreal value;
+                    if (isNoise) {
+                        value = getRandom(65536);
+                    } else if (x >= videoParameters.blackLevelStart && x < videoParameters.blackLevelEnd) {
+                        value = videoParameters.black16bIre + getRandom(100);
+                    } else {
+                        qreal phase = (2 * M_PI * x * videoParameters.fsc / videoParameters.sampleRate) +
+                                      (y * M_PI / 2) + (field * 0.3) + frame;
+                        qreal amplitude = (x >= videoParameters.colourBurstStart && x < videoParameters.colourBurstEnd) ?
+                                    6000 : 4000 + 3000 * sin((y * 0.05) + (x * 0.01) + frame);
+                        value = 20000 + (20000.0 * x / videoParameters.fieldWidth) + (amplitude * sin(phase)) + getRandom(200);
+                    }
+
+                    line[x] = static_cast<quint16>(value);
+                }
+            }
+        }
+
+        testFrames.append(testFrame);
+    }
+}
+
+// Add frames from a PAL TBC file (spread evenly over the file)
+bool KernelTest::addRealFrames(QVector<TestFrame> &testFrames, QString inputFileName, qint32 numberOfFrames)
+{
+    LdDecodeMetaData ldDecodeMetaData;
+    SourceVideo sourceVideo;
+
+    if (!ldDecodeMetaData.read(inputFileName + ".json")) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+    if (!videoParameters.isSourcePal) {
+        qInfo() << "The PALcolour filter is for PAL video sources only";
+        return false;
+    }
+
+    if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
+        qInfo() << "Unable to open ld-decode video file";
+        return false;
+    }
+
+    qint32 numberOfSourceFrames = ldDecodeMetaData.getNumberOfFrames();
+    if (numberOfFrames > numberOfSourceFrames) numberOfFrames = numberOfSourceFrames;
+
+    for (qint32 i = 0; i < numberOfFrames; i++) {
+        qint32 frameNumber = 1 + static_cast<qint32>((static_cast<qint64>(i) * numberOfSourceFrames) / numberOfFrames);
+        qint32 firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber);
+        qint32 secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber);
+
+        QSharedPointer<SourceField> firstSourceField = sourceVideo.getVideoField(firstFieldNumber);
+        QSharedPointer<SourceField> secondSourceField = sourceVideo.getVideoField(secondFieldNumber);
+        if (firstSourceField.isNull() || secondSourceField.isNull()) {
+            qInfo() << "Reading frame" << frameNumber << "from the input video file failed";
+            sourceVideo.close();
+            return false;
+        }
+
+        // Calculate the saturation level from the burst median IRE (as ld-comb-pal does)
+        qreal saturation = 125.0 + ((100.0 / 20.0) * (20.0 - ldDecodeMetaData.getConstField(firstFieldNumber).medianBurstIRE));
+
+        // The field data is copied, as the source video is closed once the frames are read
+        TestFrame testFrame;
+        testFrame.name = QString("frame %1 of %2").arg(frameNumber).arg(inputFileName);
+        testFrame.videoParameters = videoParameters;
+        testFrame.firstField = FieldBuffer(firstSourceField->getFieldData(), videoParameters.fieldWidth);
+        testFrame.secondField = FieldBuffer(secondSourceField->getFieldData(), videoParameters.fieldWidth);
+        testFrame.saturation = static_cast<qint32>(saturation);
+        testFrame.isAccuracyTested = true;
+        testFrames.append(testFrame);
+    }
+
+    sourceVideo.close();
+    return true;
+}
+
+// Decode a frame with each precision and check that the SIMD kernel matches the scalar kernel
+// of the same precision within PalColour::getKernelTolerance(), and (except for noise frames,
+// where the burst decisions are arbitrary) that the single precision and fixed-point output
+// is within the minimum PSNR of the double precision scalar decoder
+void KernelTest::testFrame(const TestFrame &testFrame)
+{
+    QVector<PalColour::Precision> precisions;
+    precisions << PalColour::doublePrecision << PalColour::singlePrecision << PalColour::fixedPoint;
+
+    FieldBuffer referenceFrame;
+    if (testFrame.isAccuracyTested) referenceFrame = decodeFrame(testFrame, PalColour::scalarKernel, PalColour::doublePrecision);
+
+    for (qint32 i = 0; i < precisions.size(); i++) {
+        PalColour::Precision precision = precisions[i];
+        qint32 maximumDifference;
+        qreal psnr;
+
+        FieldBuffer scalarFrame = (precision == PalColour::doublePrecision && testFrame.isAccuracyTested) ?
+                    referenceFrame : decodeFrame(testFrame, PalColour::scalarKernel, precision);
+        if (testFrame.isAccuracyTested && precision != PalColour::doublePrecision) {
+            compareFrames(scalarFrame, referenceFrame, testFrame.videoParameters, maximumDifference, psnr);
+            qreal minimumPsnr = (precision == PalColour::singlePrecision) ? minimumSinglePrecisionPsnr : minimumFixedPointPsnr;
+
+            if (psnr < minimumPsnr) {
+                qInfo() << "FAIL:" << testFrame.name << "-" << PalColour::getPrecisionName(precision) <<
+                           "PSNR against the double precision decoder is" << psnr << "dB (minimum" << minimumPsnr << "dB)";
+                numberOfFailures++;
+            } else {
+                qInfo() << testFrame.name << "-" << PalColour::getPrecisionName(precision) << "PSNR" << psnr <<
+                           "dB, maximum difference" << maximumDifference;
+            }
+        }
+
+        if (PalColour::getFastestKernel() == PalColour::scalarKernel) continue;
+
+        FieldBuffer simdFrame = decodeFrame(testFrame, PalColour::getFastestKernel(), precision);
+        compareFrames(simdFrame, scalarFrame, testFrame.videoParameters, maximumDifference, psnr);
+
+        if (maximumDifference > PalColour::getKernelTolerance(precision)) {
+            qInfo() << "FAIL:" << testFrame.name << "-" << PalColour::getPrecisionName(precision) <<
+                       PalColour::getKernelName(PalColour::getFastestKernel()) << "kernel differs from the scalar kernel by" <<
+                       maximumDifference << "(tolerance" << PalColour::getKernelTolerance(precision) << ")";
+            numberOfFailures++;
+        } else {
+            qDebug() << "KernelTest::testFrame():" << testFrame.name << "-" << PalColour::getPrecisionName(precision) <<
+                        "kernels differ by" << maximumDifference;
+        }
+    }
+}
+
+// Decode a frame with the given filter kernel and precision
+FieldBuffer KernelTest::decodeFrame(const TestFrame &testFrame, PalColour::FilterKernel filterKernel, PalColour::Precision precision)
+{
+    PalColour palColour(testFrame.videoParameters);
+    palColour.setFilterKernel(filterKernel);
+    palColour.setPrecision(precision);
+
+    FieldBuffer outputFrame;
+    palColour.performDecode(testFrame.firstField, testFrame.secondField, 100, testFrame.saturation, outputFrame);
+    return outputFrame;
+}
+
+// Compare the visible areas of two decoded frames, giving the largest difference and the peak
+// signal to noise ratio in dB (as ld-comb-pal's --verify does; infinite if they are identical)
+void KernelTest::compareFrames(const FieldBuffer &frame, const FieldBuffer &reference,
+                               const LdDecodeMetaData::VideoParameters &videoParameters, qint32 &maximumDifference, qreal &psnr)
+{
+    qreal squaredError = 0;
+    qint64 samples = 0;
+    maximumDifference = 0;
+
+    for (qint32 y = firstActiveScanLine; y < lastActiveScanLine; y++) {
+        const quint16 *frameLine = frame.constLine(y);
+        const quint16 *referenceLine = reference.constLine(y);
+
+        for (qint32 x = videoParameters.activeVideoStart * 3; x < videoParameters.activeVideoEnd * 3; x++) {
+            qint32 difference = qAbs(static_cast<qint32>(frameLine[x]) - static_cast<qint32>(referenceLine[x]));
+            if (difference > maximumDifference) maximumDifference = difference;
+            squaredError += static_cast<qreal>(difference) * difference;
+        }
+        samples += (videoParameters.activeVideoEnd - videoParameters.activeVideoStart) * 3;
+    }
+
+    if (squaredError == 0) psnr = std::numeric_limits<qreal>::infinity();
+    else psnr = 10.0 * log10((65535.0 * 65535.0) / (squaredError / static_cast<qreal>(samples)));
+}
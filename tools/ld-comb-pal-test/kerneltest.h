@@ -0,0 +1,76 @@
+/************************************************************************
+
+    kerneltest.h
+
+    ld-comb-pal-test - Tests for the PALcolour filter kernels
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-comb-pal-test is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef KERNELTEST_H
+#define KERNELTEST_H
+
+#include <QObject>
+#include <QVector>
+#include <QString>
+#include <QDebug>
+
+#include "sourcevideo.h"
+#include "lddecodemetadata.h"
+#include "fieldbuffer.h"
+#include "../ld-comb-pal/palcolour.h"
+
+// Decodes synthetic frames (and, if a TBC file is given, real frames) with each filter kernel
+// and precision of PalColour, and checks that the SIMD kernels match the scalar kernels and
+// that the reduced precisions are close to the double precision decoder
+class KernelTest : public QObject
+{
+    Q_OBJECT
+public:
+    explicit KernelTest(QObject *parent = nullptr);
+    bool process(QString inputFileName, qint32 numberOfFrames);
+
+signals:
+
+public slots:
+
+private slots:
+
+private:
+    // A frame to test
+    struct TestFrame {
+        QString name;
+        LdDecodeMetaData::VideoParameters videoParameters;
+        FieldBuffer firstField;
+        FieldBuffer secondField;
+        qint32 saturation;
+        bool isAccuracyTested;
+    };
+
+    qint32 numberOfFailures;
+
+    static LdDecodeMetaData::VideoParameters getSyntheticVideoParameters(void);
+    void addSyntheticFrames(QVector<TestFrame> &testFrames, qint32 numberOfFrames);
+    bool addRealFrames(QVector<TestFrame> &testFrames, QString inputFileName, qint32 numberOfFrames);
+    void testFrame(const TestFrame &testFrame);
+    FieldBuffer decodeFrame(const TestFrame &testFrame, PalColour::FilterKernel filterKernel, PalColour::Precision precision);
+    void compareFrames(const FieldBuffer &frame, const FieldBuffer &reference,
+                       const LdDecodeMetaData::VideoParameters &videoParameters, qint32 &maximumDifference, qreal &psnr);
+};
+
+#endif // KERNELTEST_H
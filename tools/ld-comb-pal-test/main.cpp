@@ -0,0 +1,144 @@
+/************************************************************************
+
+    main.cpp
+
+    ld-comb-pal-test - Tests for the PALcolour filter kernels
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-comb-pal-test is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QtGlobal>
+#include <QCommandLineParser>
+
+#include "kerneltest.h"
+
+// Global for debug output
+static bool showDebug = false;
+
+// Qt debug message handler
+void debugOutputHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    // Use:
+    // context.file - to show the filename
+    // context.line - to show the line number
+    // context.function - to show the function name
+
+    QByteArray localMsg = msg.toLocal8Bit();
+    switch (type) {
+    case QtDebugMsg: // These are debug messages meant for developers
+        if (showDebug) {
+            // If the code was compiled as 'release' the context.file will be NULL
+            if (context.file != nullptr) fprintf(stderr, "Debug: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+            else fprintf(stderr, "Debug: %s\n", localMsg.constData());
+        }
+        break;
+    case QtInfoMsg: // These are information messages meant for end-users
+        if (context.file != nullptr) fprintf(stderr, "Info: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+        else fprintf(stderr, "Info: %s\n", localMsg.constData());
+        break;
+    case QtWarningMsg:
+        if (context.file != nullptr) fprintf(stderr, "Warning: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+        else fprintf(stderr, "Warning: %s\n", localMsg.constData());
+        break;
+    case QtCriticalMsg:
+        if (context.file != nullptr) fprintf(stderr, "Critical: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+        else fprintf(stderr, "Critical: %s\n", localMsg.constData());
+        break;
+    case QtFatalMsg:
+        if (context.file != nullptr) fprintf(stderr, "Fatal: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+        else fprintf(stderr, "Fatal: %s\n", localMsg.constData());
+        abort();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Install the local debug message handler
+    qInstallMessageHandler(debugOutputHandler);
+
+    QCoreApplication a(argc, argv);
+
+    // Set application name and version
+    QCoreApplication::setApplicationName("ld-comb-pal-test");
+    QCoreApplication::setApplicationVersion("1.0");
+    QCoreApplication::setOrganizationDomain("domesday86.com");
+
+    // Set up the command line parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "ld-comb-pal-test - Tests for the PALcolour filter kernels\n"
+                "\n"
+                "(c)2018 Simon Inns\n"
+                "GPLv3 Open-Source - github: https://github.com/happycube/ld-decode");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    // Option to show debug (-d)
+    QCommandLineOption showDebugOption(QStringList() << "d" << "debug",
+                                       QCoreApplication::translate("main", "Show debug"));
+    parser.addOption(showDebugOption);
+
+    // Option to select the number of frames to test (-f)
+    QCommandLineOption framesOption(QStringList() << "f" << "frames",
+                                       QCoreApplication::translate("main", "Specify the number of synthetic (and real) frames to test (default 4)"),
+                                       QCoreApplication::translate("main", "number"));
+    parser.addOption(framesOption);
+
+    // Positional argument to specify an input video file
+    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify a PAL TBC file to also test real frames from (optional)"));
+
+    // Process the command line options and arguments given by the user
+    parser.process(a);
+
+    // Get the options from the parser
+    bool isDebugOn = parser.isSet(showDebugOption);
+
+    // Get the arguments from the parser
+    QString inputFileName;
+    QStringList positionalArguments = parser.positionalArguments();
+    if (positionalArguments.count() == 1) {
+        inputFileName = positionalArguments.at(0);
+    } else if (positionalArguments.count() > 1) {
+        // Quit with error
+        qCritical("You must specify at most one input TBC file");
+        return -1;
+    }
+
+    qint32 numberOfFrames = 4;
+    if (parser.isSet(framesOption)) {
+        numberOfFrames = parser.value(framesOption).toInt();
+
+        if (numberOfFrames < 1) {
+            // Quit with error
+            qCritical("Specified number of frames must be at least 1");
+            return -1;
+        }
+    }
+
+    // Process the command line options
+    if (isDebugOn) showDebug = true;
+
+    // Run the tests (the exit code is non-zero if a test fails)
+    KernelTest kernelTest;
+    if (!kernelTest.process(inputFileName, numberOfFrames)) return -1;
+
+    // Quit with success
+    return 0;
+}
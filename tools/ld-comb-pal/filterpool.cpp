@@ -0,0 +1,178 @@
+/************************************************************************
+
+    filterpool.cpp
+
+    ld-comb-pal - PAL colourisation filter for ld-decode
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-comb-pal is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+
+#include "filterpool.h"
+#include "filterthread.h"
+
+#include <QtMath>
+
+namespace {
+    // The maximum number of frames in the pool for each filter thread.  More than one frame
+    // per thread is allowed so that the threads do not stall whilst the next frame in order
+    // is still being filtered, or whilst the producer is waiting on the source video
+    const qint32 framesInPoolPerThread = 4;
+}
+
+FilterPool::FilterPool(LdDecodeMetaData::VideoParameters videoParameters, bool isVP415CropSet,
+                       qint32 numberOfThreads, bool isPinThreadsSet, PalColour::FilterKernel filterKernel,
+                       PalColour::Precision precision, bool isVerifySet, QObject *parent) : QObject(parent)
+{
+    abort = false;
+    framesInPool = 0;
+    maximumFramesInPool = numberOfThreads * framesInPoolPerThread;
+    totalFilterNsecs = 0;
+    verifyMismatchCount = 0;
+    verifyMaximumDifference = 0;
+    verifySquaredError = 0;
+    verifySamples = 0;
+
+    // Start the filter threads (they wait until frames are queued).  If pinning is set,
+    // thread n is pinned to the n'th available CPU
+    for (qint32 i = 0; i < numberOfThreads; i++) {
+        filterThreads.append(new FilterThread(this, videoParameters, isVP415CropSet, isPinThreadsSet ? i : -1,
+                                              filterKernel, precision, isVerifySet));
+        filterThreads.last()->start(QThread::LowPriority);
+    }
+}
+
+FilterPool::~FilterPool()
+{
+    stop();
+    qDeleteAll(filterThreads);
+}
+
+// Add a frame to the work queue, waiting until there is room in the pool (returns false if
+// the pool is stopped)
+bool FilterPool::queueFrame(const Job &job)
+{
+    QMutexLocker locker(&mutex);
+    while (framesInPool >= maximumFramesInPool && !abort) resultTaken.wait(&mutex);
+    if (abort) return false;
+
+    framesInPool++;
+    jobs.enqueue(job);
+    jobQueued.wakeOne();
+
+    return true;
+}
+
+// Wait for a queued frame to be filtered and take its result (a null buffer if the filter
+// failed, or if the pool is stopped).  Note: the result shares its data with the filter
+// thread; release it before the filter thread's next frame, or the thread will have to
+// allocate a new output buffer
+FieldBuffer FilterPool::waitForResult(qint32 frameNumber)
+{
+    QMutexLocker locker(&mutex);
+    while (!results.contains(frameNumber) && !abort) resultReady.wait(&mutex);
+    if (!results.contains(frameNumber)) return FieldBuffer();
+
+    framesInPool--;
+    resultTaken.wakeOne();
+
+    return results.take(frameNumber);
+}
+
+// Discard the queued frames and stop the filter threads (once they have finished their
+// current frames, so the source video can be closed)
+void FilterPool::stop(void)
+{
+    mutex.lock();
+    abort = true;
+    jobs.clear();
+    jobQueued.wakeAll();
+    resultReady.wakeAll();
+    resultTaken.wakeAll();
+    mutex.unlock();
+
+    for (qint32 i = 0; i < filterThreads.size(); i++) filterThreads[i]->wait();
+}
+
+qint32 FilterPool::getNumberOfThreads(void)
+{
+    return filterThreads.size();
+}
+
+// Get the total time the filter threads have spent filtering (not waiting for frames)
+qint64 FilterPool::getFilterNsecs(void)
+{
+    QMutexLocker locker(&mutex);
+    return totalFilterNsecs;
+}
+
+// Get the number of frames where the SIMD filter kernel differed from the scalar kernel of
+// the same precision by more than the kernel tolerance (if the output is verified)
+qint32 FilterPool::getVerifyMismatchCount(void)
+{
+    QMutexLocker locker(&mutex);
+    return verifyMismatchCount;
+}
+
+// Get the largest difference between the output and the double precision scalar decoder
+qint32 FilterPool::getVerifyMaximumDifference(void)
+{
+    QMutexLocker locker(&mutex);
+    return verifyMaximumDifference;
+}
+
+// Get the peak signal to noise ratio (in dB) of the output, taking the double precision
+// scalar decoder as the reference (0 if they are identical)
+qreal FilterPool::getVerifyPsnr(void)
+{
+    QMutexLocker locker(&mutex);
+    if (verifySamples == 0 || verifySquaredError == 0) return 0.0;
+
+    qreal meanSquaredError = verifySquaredError / static_cast<qreal>(verifySamples);
+    return 10.0 * log10((65535.0 * 65535.0) / meanSquaredError);
+}
+
+// Wait for a frame to be queued and take it from the queue (returns false when the pool is
+// stopped)
+bool FilterPool::takeJob(Job &job)
+{
+    QMutexLocker locker(&mutex);
+    while (jobs.isEmpty() && !abort) jobQueued.wait(&mutex);
+    if (abort) return false;
+
+    job = jobs.dequeue();
+    return true;
+}
+
+void FilterPool::putResult(qint32 frameNumber, FieldBuffer rgbOutputFrame, qint64 filterNsecs)
+{
+    QMutexLocker locker(&mutex);
+    results.insert(frameNumber, rgbOutputFrame);
+    totalFilterNsecs += filterNsecs;
+    resultReady.wakeAll();
+}
+
+// Record the result of verifying a frame
+void FilterPool::putVerifyResult(bool isMismatch, qint32 maximumDifference, qreal squaredError, qint64 samples)
+{
+    QMutexLocker locker(&mutex);
+    if (isMismatch) verifyMismatchCount++;
+    if (maximumDifference > verifyMaximumDifference) verifyMaximumDifference = maximumDifference;
+    verifySquaredError += squaredError;
+    verifySamples += samples;
+}
@@ -0,0 +1,114 @@
+/************************************************************************
+
+    filterpool.h
+
+    ld-comb-pal - PAL colourisation filter for ld-decode
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-comb-pal is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+
+#ifndef FILTERPOOL_H
+#define FILTERPOOL_H
+
+#include <QObject>
+#include <QVector>
+#include <QQueue>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QDebug>
+
+#include "lddecodemetadata.h"
+#include "fieldbuffer.h"
+#include "palcolour.h"
+
+class FilterThread;
+
+// A pool of filter threads fed from a work queue.  Frames are queued with queueFrame(), and
+// each idle filter thread takes the next frame from the queue; the results are collected
+// (in any order) with waitForResult(), so the finished frames waiting to be collected act
+// as a reorder buffer.  The threads wait on conditions when there is no work, and
+// waitForResult() waits until the frame is finished, so neither side polls.
+//
+// The number of frames in the pool (queued, being filtered or waiting to be collected) is
+// limited, and queueFrame() blocks until there is room, so a producer that is faster than
+// the filter threads does not use unlimited memory.
+class FilterPool : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FilterPool(LdDecodeMetaData::VideoParameters videoParameters, bool isVP415CropSet,
+                        qint32 numberOfThreads, bool isPinThreadsSet, PalColour::FilterKernel filterKernel,
+                        PalColour::Precision precision, bool isVerifySet, QObject *parent = nullptr);
+    ~FilterPool() override;
+
+    // A frame to be filtered (the input fields are empty if they could not be read)
+    struct Job {
+        qint32 frameNumber;
+        qint32 firstFieldNumber;
+        qint32 secondFieldNumber;
+        qreal burstMedianIre;
+        FieldBuffer firstField;
+        FieldBuffer secondField;
+    };
+
+    bool queueFrame(const Job &job);
+    FieldBuffer waitForResult(qint32 frameNumber);
+    void stop(void);
+
+    qint32 getNumberOfThreads(void);
+    qint64 getFilterNsecs(void);
+    qint32 getVerifyMismatchCount(void);
+    qint32 getVerifyMaximumDifference(void);
+    qreal getVerifyPsnr(void);
+
+    // Used by the filter threads
+    bool takeJob(Job &job);
+    void putResult(qint32 frameNumber, FieldBuffer rgbOutputFrame, qint64 filterNsecs);
+    void putVerifyResult(bool isMismatch, qint32 maximumDifference, qreal squaredError, qint64 samples);
+
+signals:
+
+private:
+    // Thread control (the queue and results are only accessed with the mutex locked)
+    QMutex mutex;
+    QWaitCondition jobQueued;
+    QWaitCondition resultReady;
+    QWaitCondition resultTaken;
+    bool abort;
+
+    // The number of frames in the pool, and the limit
+    qint32 framesInPool;
+    qint32 maximumFramesInPool;
+
+    // The total time the filter threads have spent filtering
+    qint64 totalFilterNsecs;
+
+    // The results of the verification (if set)
+    qint32 verifyMismatchCount;
+    qint32 verifyMaximumDifference;
+    qreal verifySquaredError;
+    qint64 verifySamples;
+
+    QQueue<Job> jobs;
+    QHash<qint32, FieldBuffer> results;
+    QVector<FilterThread *> filterThreads;
+};
+
+#endif // FILTERPOOL_H
@@ -23,23 +23,30 @@
 ************************************************************************/
 
 #include "filterthread.h"
+#include "filterpool.h"
 
-FilterThread::FilterThread(LdDecodeMetaData::VideoParameters videoParametersParam, bool isVP415CropSetParam, QObject *parent) : QThread(parent)
+FilterThread::FilterThread(FilterPool *filterPoolParam, LdDecodeMetaData::VideoParameters videoParametersParam,
+                           bool isVP415CropSetParam, qint32 pinnedThreadNumberParam,
+                           PalColour::FilterKernel filterKernelParam, PalColour::Precision precisionParam,
+                           bool isVerifySetParam, QObject *parent) : QThread(parent)
 {
-    // Thread control variables
-    isProcessing = false;
-    abort = false;
+    filterPool = filterPoolParam;
+    pinnedThreadNumber = pinnedThreadNumberParam;
 
-    // Configure PAL colour
+    // Configure PAL colour (the PAL colour object and the output buffers are allocated by the
+    // thread when it starts)
     videoParameters = videoParametersParam;
     isVP415CropSet = isVP415CropSetParam;
-    palColour = new PalColour(videoParameters);
+    palColour = nullptr;
+    filterKernel = filterKernelParam;
+    precision = precisionParam;
+    isVerifySet = isVerifySetParam;
+    referencePalColour = nullptr;
+    kernelReferencePalColour = nullptr;
 
     // Calculate the frame height
     qint32 frameHeight = (videoParameters.fieldHeight * 2) - 1;
 
-    outputData.resize(videoParameters.fieldWidth * frameHeight * 6);
-
     // Set the first and last active scan line
     firstActiveScanLine = 44;
     lastActiveScanLine = 617;
@@ -70,86 +77,135 @@ FilterThread::FilterThread(LdDecodeMetaData::VideoParameters videoParametersPara
     }
 }
 
+// Note: the thread must have been stopped (see FilterPool::stop())
 FilterThread::~FilterThread()
 {
-    mutex.lock();
-    abort = true;
-    condition.wakeOne();
-    mutex.unlock();
-
     wait();
 
     delete palColour;
+    delete referencePalColour;
+    delete kernelReferencePalColour;
 }
 
-void FilterThread::startFilter(QByteArray firstFieldParam, QByteArray secondFieldParam, qreal burstMedianIreParam)
+void FilterThread::run()
 {
-    QMutexLocker locker(&mutex);
-
-    // Move all the parameters to be local
-    firstFieldData = firstFieldParam;
-    secondFieldData = secondFieldParam;
-    burstMedianIre = burstMedianIreParam;
-
-    // Is the run process already running?
-    if (!isRunning()) {
-        // Yes, start with low priority
-        start(LowPriority);
-        isProcessing = true;
-    } else {
-        // No, set the restart condition
-        isProcessing = true;
-        condition.wakeOne();
-    }
-}
+    qDebug() << "FilterThread::run(): Thread running";
 
-QByteArray FilterThread::getResult(void)
-{
-    return rgbOutputData;
-}
+    // Pin the thread to its CPU (if set) before allocating its buffers, so that the memory
+    // is first touched, and so allocated, on the CPU's NUMA node
+    if (pinnedThreadNumber >= 0) ThreadAffinity::pinCurrentThread(pinnedThreadNumber);
 
-bool FilterThread::isBusy(void)
-{
-    return isProcessing;
-}
+    if (palColour == nullptr) {
+        palColour = new PalColour(videoParameters);
+        palColour->setFilterKernel(filterKernel);
+        palColour->setPrecision(precision);
+    }
+    if (isVerifySet && referencePalColour == nullptr) {
+        referencePalColour = new PalColour(videoParameters);
+        referencePalColour->setFilterKernel(PalColour::scalarKernel);
+
+        // The double precision SIMD kernel is checked against the reference itself
+        if (palColour->getFilterKernel() != PalColour::scalarKernel && precision != PalColour::doublePrecision) {
+            kernelReferencePalColour = new PalColour(videoParameters);
+            kernelReferencePalColour->setFilterKernel(PalColour::scalarKernel);
+            kernelReferencePalColour->setPrecision(precision);
+        }
+    }
+    outputFrame.resize(videoParameters.fieldWidth * 3, (videoParameters.fieldHeight * 2) - 1);
+    rgbOutputFrame.resize((videoEnd - videoStart) * 3, lastActiveScanLine - firstActiveScanLine);
+
+    // Take frames from the work queue until the pool is stopped
+    FilterPool::Job job;
+    while (filterPool->takeJob(job)) {
+        // The input fields are empty if the reader could not read them
+        if (job.firstField.isNull() || job.secondField.isNull()) {
+            // Return an empty result to indicate the failure
+            filterPool->putResult(job.frameNumber, FieldBuffer(), 0);
+            continue;
+        }
 
-void FilterThread::run()
-{
-    qDebug() << "FilterThread::run(): Thread running";
+        QElapsedTimer filterTimer;
+        filterTimer.start();
+
+        // Calculate the saturation level from the burst median IRE
+        // Note: This code works as a temporary MTF compensator whilst ld-decode gets
+        // real MTF compensation added to it.
+        qreal tSaturation = 125.0 + ((100.0 / 20.0) * (20.0 - job.burstMedianIre));
+
+        // Perform the PALcolour filtering
+        palColour->performDecode(job.firstField, job.secondField, 100, static_cast<qint32>(tSaturation), outputFrame);
+
+        // Check the output against the double precision scalar decoder (if set), and the
+        // output of a SIMD kernel against the scalar kernel of the same precision (which it
+        // is expected to match within the tolerance)
+        if (isVerifySet) {
+            referencePalColour->performDecode(job.firstField, job.secondField, 100, static_cast<qint32>(tSaturation), referenceFrame);
+
+            qint32 maximumDifference;
+            qreal squaredError;
+            qint64 samples;
+            compareFrames(outputFrame, referenceFrame, maximumDifference, squaredError, samples);
+
+            qint32 kernelDifference = 0;
+            if (kernelReferencePalColour != nullptr) {
+                kernelReferencePalColour->performDecode(job.firstField, job.secondField, 100, static_cast<qint32>(tSaturation),
+                                                        kernelReferenceFrame);
+
+                qreal kernelSquaredError;
+                qint64 kernelSamples;
+                compareFrames(outputFrame, kernelReferenceFrame, kernelDifference, kernelSquaredError, kernelSamples);
+            } else if (palColour->getFilterKernel() != PalColour::scalarKernel) {
+                kernelDifference = maximumDifference;
+            }
 
-    while(!abort) {
-        if (isProcessing) {
-            // Lock and copy all parameters to 'thread-safe' variables
-            mutex.lock();
-            tsFirstFieldData = firstFieldData;
-            tsSecondFieldData = secondFieldData;
-            mutex.unlock();
-
-            // Calculate the saturation level from the burst median IRE
-            // Note: This code works as a temporary MTF compensator whilst ld-decode gets
-            // real MTF compensation added to it.
-            qreal tSaturation = 125.0 + ((100.0 / 20.0) * (20.0 - burstMedianIre));
-
-            // Perform the PALcolour filtering
-            outputData = palColour->performDecode(tsFirstFieldData, tsSecondFieldData, 100, static_cast<qint32>(tSaturation));
-
-            // The PAL colour library outputs the whole frame, so here we have to strip all the non-visible stuff to just get the
-            // actual required image - it would be better if PALcolour gave back only the required RGB, but it's not my library.
-            rgbOutputData.clear();
-
-            // Since PALcolour uses +-3 scan-lines to colourise, the final lines before the non-visible area may not come out quite
-            // right, but we're including them here anyway.
-            for (qint32 y = firstActiveScanLine; y < lastActiveScanLine; y++) {
-                rgbOutputData.append(outputData.mid((y * videoParameters.fieldWidth * 6) + (videoStart * 6),
-                                                        ((videoEnd - videoStart) * 6)));
+            bool isMismatch = (kernelDifference > PalColour::getKernelTolerance(precision));
+            if (isMismatch) {
+                qWarning() << "Frame" << job.frameNumber << "differs from the" << PalColour::getPrecisionName(precision) <<
+                              "scalar filter kernel by up to" << kernelDifference;
             }
+            filterPool->putVerifyResult(isMismatch, maximumDifference, squaredError, samples);
+        }
+
+        // The PAL colour library outputs the whole frame, so here we have to strip all the non-visible stuff to just get the
+        // actual required image - it would be better if PALcolour gave back only the required RGB, but it's not my library.
+        rgbOutputFrame.resize((videoEnd - videoStart) * 3, lastActiveScanLine - firstActiveScanLine);
 
-            isProcessing = false;
+        // Since PALcolour uses +-3 scan-lines to colourise, the final lines before the non-visible area may not come out quite
+        // right, but we're including them here anyway.
+        for (qint32 y = firstActiveScanLine; y < lastActiveScanLine; y++) {
+            memcpy(rgbOutputFrame.line(y - firstActiveScanLine), outputFrame.constLine(y) + (videoStart * 3),
+                   static_cast<size_t>((videoEnd - videoStart) * 6));
+        }
+
+        // Release the input fields before waiting for the next frame
+        job.firstField = FieldBuffer();
+        job.secondField = FieldBuffer();
+
+        filterPool->putResult(job.frameNumber, rgbOutputFrame, filterTimer.nsecsElapsed());
+    }
+}
+
+// Compare the visible area of a frame with the reference frame, giving the largest difference
+// between the samples, the sum of the squared differences and the number of samples compared
+void FilterThread::compareFrames(const FieldBuffer &frame, const FieldBuffer &reference, qint32 &maximumDifference,
+                                 qreal &squaredError, qint64 &samples)
+{
+    maximumDifference = 0;
+    squaredError = 0;
+    samples = 0;
+
+    for (qint32 y = firstActiveScanLine; y < lastActiveScanLine; y++) {
+        const quint16 *frameLine = frame.constLine(y);
+        const quint16 *referenceLine = reference.constLine(y);
+
+        qint64 lineSquaredError = 0;
+        for (qint32 x = videoStart * 3; x < videoEnd * 3; x++) {
+            qint32 difference = qAbs(static_cast<qint32>(frameLine[x]) - static_cast<qint32>(referenceLine[x]));
+            if (difference > maximumDifference) maximumDifference = difference;
+            lineSquaredError += static_cast<qint64>(difference) * difference;
         }
 
-        // Sleep the thread until it is restarted
-        mutex.lock();
-        if (!isProcessing && !abort) condition.wait(&mutex);
-        mutex.unlock();
+        squaredError += static_cast<qreal>(lineSquaredError);
+        samples += (videoEnd - videoStart) * 3;
     }
 }
@@ -27,39 +27,57 @@
 
 #include <QObject>
 #include <QThread>
-#include <QMutex>
-#include <QWaitCondition>
+#include <QElapsedTimer>
 #include <QDebug>
 
-#include "sourcevideo.h"
 #include "lddecodemetadata.h"
 #include "palcolour.h"
+#include "fieldbuffer.h"
+#include "threadaffinity.h"
 
+class FilterPool;
+
+// A filter thread takes frames from its FilterPool's work queue, colourises them and gives
+// the results back to the pool
 class FilterThread : public QThread
 {
     Q_OBJECT
 public:
-    explicit FilterThread(LdDecodeMetaData::VideoParameters videoParametersParam, bool isVP415CropSetParam, QObject *parent = nullptr);
+    explicit FilterThread(FilterPool *filterPoolParam, LdDecodeMetaData::VideoParameters videoParametersParam,
+                          bool isVP415CropSetParam, qint32 pinnedThreadNumberParam = -1,
+                          PalColour::FilterKernel filterKernelParam = PalColour::scalarKernel,
+                          PalColour::Precision precisionParam = PalColour::doublePrecision,
+                          bool isVerifySetParam = false, QObject *parent = nullptr);
     ~FilterThread() override;
 
-    void startFilter(QByteArray topFieldParam, QByteArray bottomFieldParam, qreal burstMedianIreParam);
-    QByteArray getResult(void);
-    bool isBusy(void);
-
 signals:
 
 protected:
     void run() override;
 
 private:
-    // Thread control
-    QMutex mutex;
-    QWaitCondition condition;
-    bool isProcessing;
-    bool abort;
+    // The pool the frames are taken from
+    FilterPool *filterPool;
 
-    // PAL colour object
+    // The thread number used to choose the CPU the thread is pinned to (-1 if not pinned)
+    qint32 pinnedThreadNumber;
+
+    // PAL colour object (created by the thread, so it is allocated on the thread's NUMA node
+    // when the thread is pinned)
     PalColour *palColour;
+    PalColour::FilterKernel filterKernel;
+    PalColour::Precision precision;
+
+    // Verification (each frame is also decoded by the double precision scalar decoder, and
+    // the visible areas are compared.  The output of a SIMD kernel is also checked against
+    // the scalar kernel of the same precision)
+    bool isVerifySet;
+    PalColour *referencePalColour;
+    FieldBuffer referenceFrame;
+    PalColour *kernelReferencePalColour;
+    FieldBuffer kernelReferenceFrame;
+    void compareFrames(const FieldBuffer &frame, const FieldBuffer &reference, qint32 &maximumDifference,
+                       qreal &squaredError, qint64 &samples);
     LdDecodeMetaData::VideoParameters videoParameters;
     bool isVP415CropSet;
 
@@ -69,16 +87,9 @@ private:
     qint32 videoStart;
     qint32 videoEnd;
 
-    // Input data buffers
-    QByteArray firstFieldData;
-    QByteArray secondFieldData;
-    QByteArray tsFirstFieldData;
-    QByteArray tsSecondFieldData;
-    QByteArray outputData;
-    QByteArray rgbOutputData;
-
-    // Burst level data
-    qreal burstMedianIre;
+    // Output data buffers (reused for each frame)
+    FieldBuffer outputFrame;
+    FieldBuffer rgbOutputFrame;
 };
 
 #endif // FILTERTHREAD_H
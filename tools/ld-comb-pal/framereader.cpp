@@ -0,0 +1,88 @@
+/************************************************************************
+
+    framereader.cpp
+
+    ld-comb-pal - PAL colourisation filter for ld-decode
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-comb-pal is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "framereader.h"
+
+FrameReader::FrameReader(FilterPool *filterPoolParam, SourceVideo *sourceVideoParam,
+                         QVector<FilterPool::Job> jobsParam, qint32 fieldWidthParam, QObject *parent) : QThread(parent)
+{
+    filterPool = filterPoolParam;
+    sourceVideo = sourceVideoParam;
+    jobs = jobsParam;
+    fieldWidth = fieldWidthParam;
+
+    framesRead = 0;
+    totalReadNsecs = 0;
+}
+
+// Note: the filter pool must have been stopped, or all of the frames collected
+FrameReader::~FrameReader()
+{
+    wait();
+}
+
+// Get the number of frames read (call once the thread has finished)
+qint32 FrameReader::getFramesRead(void)
+{
+    return framesRead;
+}
+
+// Get the total time spent reading from the source video, not including the time spent
+// waiting for room in the filter pool (call once the thread has finished)
+qint64 FrameReader::getReadNsecs(void)
+{
+    return totalReadNsecs;
+}
+
+void FrameReader::run()
+{
+    qDebug() << "FrameReader::run(): Thread running";
+
+    for (qint32 i = 0; i < jobs.size(); i++) {
+        FilterPool::Job &job = jobs[i];
+
+        // Read the input fields from the source video
+        QElapsedTimer readTimer;
+        readTimer.start();
+        QSharedPointer<SourceField> firstField = sourceVideo->getVideoField(job.firstFieldNumber);
+        QSharedPointer<SourceField> secondField = sourceVideo->getVideoField(job.secondFieldNumber);
+        bool isRead = !firstField.isNull() && !secondField.isNull();
+        if (isRead) {
+            job.firstField = FieldBuffer(firstField, fieldWidth);
+            job.secondField = FieldBuffer(secondField, fieldWidth);
+            framesRead++;
+        } else {
+            qWarning() << "FrameReader::run(): Could not read fields" << job.firstFieldNumber << "and" << job.secondFieldNumber;
+        }
+        totalReadNsecs += readTimer.nsecsElapsed();
+
+        // Queue the frame (the filter pool shares the field data, so release the reader's copy)
+        bool isQueued = filterPool->queueFrame(job);
+        job.firstField = FieldBuffer();
+        job.secondField = FieldBuffer();
+        if (!isQueued || !isRead) break;
+    }
+
+    qDebug() << "FrameReader::run(): Thread stopped";
+}
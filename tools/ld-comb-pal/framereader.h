@@ -0,0 +1,72 @@
+/************************************************************************
+
+    framereader.h
+
+    ld-comb-pal - PAL colourisation filter for ld-decode
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-comb-pal is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef FRAMEREADER_H
+#define FRAMEREADER_H
+
+#include <QObject>
+#include <QThread>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QDebug>
+
+#include "sourcevideo.h"
+#include "fieldbuffer.h"
+#include "filterpool.h"
+
+// The reader stage of the filter pipeline.  The frame reader reads the input fields of each
+// frame from the source video in order (so the source video's prefetching is used) and
+// queues the frames in the filter pool; it waits whilst the pool is full.  If the fields
+// of a frame cannot be read, the frame is queued without them (so the failure is reported
+// in order) and the reader stops.
+class FrameReader : public QThread
+{
+    Q_OBJECT
+public:
+    explicit FrameReader(FilterPool *filterPoolParam, SourceVideo *sourceVideoParam,
+                         QVector<FilterPool::Job> jobsParam, qint32 fieldWidthParam, QObject *parent = nullptr);
+    ~FrameReader() override;
+
+    qint32 getFramesRead(void);
+    qint64 getReadNsecs(void);
+
+signals:
+
+protected:
+    void run() override;
+
+private:
+    FilterPool *filterPool;
+    SourceVideo *sourceVideo;
+
+    // The frames to read (the field numbers and burst levels are filled in by the caller)
+    QVector<FilterPool::Job> jobs;
+    qint32 fieldWidth;
+
+    // Statistics (only valid once the thread has finished)
+    qint32 framesRead;
+    qint64 totalReadNsecs;
+};
+
+#endif // FRAMEREADER_H
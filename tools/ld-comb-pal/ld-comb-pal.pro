@@ -18,7 +18,9 @@ SOURCES += \
         main.cpp \
     palcombfilter.cpp \
     palcolour.cpp \
-    filterthread.cpp
+    filterthread.cpp \
+    filterpool.cpp \
+    framereader.cpp
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
@@ -39,4 +41,6 @@ win32:LIBS += $$quote($$MYDLLDIR/ld-decode-shared.dll)
 HEADERS += \
     palcombfilter.h \
     palcolour.h \
-    filterthread.h
+    filterthread.h \
+    filterpool.h \
+    framereader.h
@@ -28,6 +28,7 @@
 #include <QCommandLineParser>
 
 #include "palcombfilter.h"
+#include "threadaffinity.h"
 
 // Global for debug output
 static bool showDebug = false;
@@ -108,16 +109,67 @@ int main(int argc, char *argv[])
                                         QCoreApplication::translate("main", "number"));
     parser.addOption(lengthOption);
 
+    // Option to select the start frame by VBI picture number or time code (--start-picture)
+    QCommandLineOption startPictureOption(QStringList() << "start-picture",
+                                        QCoreApplication::translate("main", "Specify the start frame by CAV picture number or CLV time code (h:mm:ss.pp)"),
+                                        QCoreApplication::translate("main", "picture"));
+    parser.addOption(startPictureOption);
+
+    // Option to select the end frame by VBI picture number or time code (--end-picture)
+    QCommandLineOption endPictureOption(QStringList() << "end-picture",
+                                        QCoreApplication::translate("main", "Specify the last frame to process by CAV picture number or CLV time code (h:mm:ss.pp)"),
+                                        QCoreApplication::translate("main", "picture"));
+    parser.addOption(endPictureOption);
+
     // Option to crop output to VP415 dimensions (-c)
     QCommandLineOption showCropOption(QStringList() << "c" << "crop",
                                        QCoreApplication::translate("main", "Crop output to VP415 dimensions"));
     parser.addOption(showCropOption);
 
+    // Option to set the size of the field cache (-m)
+    QCommandLineOption cacheSizeOption(QStringList() << "m" << "cachesize",
+                                       QCoreApplication::translate("main", "Specify the size of the field cache in MiB (default 64)"),
+                                       QCoreApplication::translate("main", "number"));
+    parser.addOption(cacheSizeOption);
+
+    // Option to select the number of filter threads (-t)
+    QCommandLineOption threadsOption(QStringList() << "t" << "threads",
+                                       QCoreApplication::translate("main", "Specify the number of filter threads (default is one per available CPU)"),
+                                       QCoreApplication::translate("main", "number"));
+    parser.addOption(threadsOption);
+
+    // Option to pin each filter thread to a CPU (--pin-threads)
+    QCommandLineOption pinThreadsOption(QStringList() << "pin-threads",
+                                       QCoreApplication::translate("main", "Pin each filter thread to one of the available CPUs (Linux only)"));
+    parser.addOption(pinThreadsOption);
+
+    // Option to use the scalar filter kernel (--no-simd)
+    QCommandLineOption noSimdOption(QStringList() << "no-simd",
+                                       QCoreApplication::translate("main", "Use the scalar filter kernel, rather than the fastest kernel the CPU supports"));
+    parser.addOption(noSimdOption);
+
+    // Option to select the decoder arithmetic (--precision)
+    QCommandLineOption precisionOption(QStringList() << "precision",
+                                       QCoreApplication::translate("main", "Specify the decoder arithmetic: double, single or fixed (default double)"),
+                                       QCoreApplication::translate("main", "type"));
+    parser.addOption(precisionOption);
+
+    // Option to verify the output against the scalar decoders (--verify)
+    QCommandLineOption verifyOption(QStringList() << "verify",
+                                       QCoreApplication::translate("main", "Check the output against the double precision scalar decoder and show the PSNR, and the SIMD filter kernel against the scalar kernel (slow)"));
+    parser.addOption(verifyOption);
+
+    // Option to specify the input metadata file (--input-json)
+    QCommandLineOption inputJsonOption(QStringList() << "input-json",
+                                       QCoreApplication::translate("main", "Specify the input JSON file (default input.json)"),
+                                       QCoreApplication::translate("main", "filename"));
+    parser.addOption(inputJsonOption);
+
     // Positional argument to specify input video file
-    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file"));
+    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file (- for piped input)"));
 
     // Positional argument to specify output video file
-    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify output RGB file"));
+    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify output RGB file (- for piped output)"));
 
     // Process the command line options and arguments given by the user
     parser.process(a);
@@ -125,6 +177,8 @@ int main(int argc, char *argv[])
     // Get the options from the parser
     bool isDebugOn = parser.isSet(showDebugOption);
     bool isVP415CropSet = parser.isSet(showCropOption);
+    bool isPinThreadsSet = parser.isSet(pinThreadsOption);
+    bool isVerifySet = parser.isSet(verifyOption);
 
     // Get the arguments from the parser
     QString inputFileName;
@@ -139,14 +193,45 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    if (inputFileName == outputFileName) {
+    if (inputFileName == outputFileName && inputFileName != "-") {
         // Quit with error
         qCritical("Input and output files cannot be the same");
         return -1;
     }
 
+    // Get the metadata file name (piped input has no file name to derive the metadata
+    // file name from)
+    QString inputJsonFileName = inputFileName + ".json";
+    if (parser.isSet(inputJsonOption)) {
+        inputJsonFileName = parser.value(inputJsonOption);
+    } else if (inputFileName == "-") {
+        // Quit with error
+        qCritical("You must specify the input JSON file when using piped input");
+        return -1;
+    }
+
     qint32 startFrame = -1;
     qint32 length = -1;
+    QString startPosition;
+    QString endPosition;
+
+    if (parser.isSet(startPictureOption)) {
+        if (parser.isSet(startFrameOption)) {
+            // Quit with error
+            qCritical("The start frame and start picture cannot both be specified");
+            return -1;
+        }
+        startPosition = parser.value(startPictureOption);
+    }
+
+    if (parser.isSet(endPictureOption)) {
+        if (parser.isSet(lengthOption)) {
+            // Quit with error
+            qCritical("The length and end picture cannot both be specified");
+            return -1;
+        }
+        endPosition = parser.value(endPictureOption);
+    }
 
     if (parser.isSet(startFrameOption)) {
         startFrame = parser.value(startFrameOption).toInt();
@@ -168,12 +253,51 @@ int main(int argc, char *argv[])
         }
     }
 
+    qint32 cacheSize = -1;
+    if (parser.isSet(cacheSizeOption)) {
+        cacheSize = parser.value(cacheSizeOption).toInt();
+
+        if (cacheSize < 0) {
+            // Quit with error
+            qCritical("Specified cache size must be zero or greater");
+            return -1;
+        }
+    }
+
+    qint32 numberOfThreads = ThreadAffinity::getDefaultThreadCount();
+    if (parser.isSet(threadsOption)) {
+        numberOfThreads = parser.value(threadsOption).toInt();
+
+        if (numberOfThreads < 1) {
+            // Quit with error
+            qCritical("Specified number of threads must be at least 1");
+            return -1;
+        }
+    }
+
+    PalColour::FilterKernel filterKernel = PalColour::getFastestKernel();
+    if (parser.isSet(noSimdOption)) filterKernel = PalColour::scalarKernel;
+
+    PalColour::Precision precision = PalColour::doublePrecision;
+    if (parser.isSet(precisionOption)) {
+        QString precisionName = parser.value(precisionOption);
+        if (precisionName == "double") precision = PalColour::doublePrecision;
+        else if (precisionName == "single") precision = PalColour::singlePrecision;
+        else if (precisionName == "fixed") precision = PalColour::fixedPoint;
+        else {
+            // Quit with error
+            qCritical("Specified precision must be double, single or fixed");
+            return -1;
+        }
+    }
+
     // Process the command line options
     if (isDebugOn) showDebug = true;
 
     // Perform the processing
     PalCombFilter palCombFilter;
-    palCombFilter.process(inputFileName, outputFileName, startFrame, length, isVP415CropSet);
+    palCombFilter.process(inputFileName, inputJsonFileName, outputFileName, startFrame, length, startPosition, endPosition, isVP415CropSet,
+                          numberOfThreads, isPinThreadsSet, filterKernel, precision, isVerifySet, cacheSize);
 
     // Quit with success
     return 0;
@@ -31,6 +31,362 @@
 
 #include "palcolour.h"
 
+// The AVX2 kernel is built with GCC/Clang function targets, so the rest of the code does not
+// require AVX2 and the kernel is only used if the CPU supports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PALCOLOUR_AVX2_KERNEL
+#include <immintrin.h>
+#endif
+
+namespace {
+    // The number of fractional bits of the fixed-point sine and cosine look-up tables
+    const qint32 fixedPointShift = 12;
+
+    // The inputs, outputs and coefficients of the 2D filter for one line.  m and n are the
+    // current line multiplied by the sine and cosine references, m1/n1 to m6/n6 are the lines
+    // above and below (see decodeFrame())
+    template <typename T>
+    struct LineFilter {
+        const T *m, *n;
+        const T *m1, *n1, *m2, *n2, *m3, *n3, *m4, *n4, *m5, *n5, *m6, *n6;
+        T *pu, *qu, *pv, *qv, *py, *qy;
+        const T *cfilt[4];
+        const T *yfilt[4];
+        qint32 taps;
+        double cdiv;
+        double ydiv;
+    };
+
+    // Multiply a sample by the sine or cosine reference
+    inline double modulate(quint16 sample, double reference)
+    {
+        return sample * reference;
+    }
+
+    inline float modulate(quint16 sample, float reference)
+    {
+        return sample * reference;
+    }
+
+    inline qint32 modulate(quint16 sample, qint32 reference)
+    {
+        return (sample * reference + (1 << (fixedPointShift - 1))) >> fixedPointShift;
+    }
+
+    // Store a normalised output of the 2D filter (the fixed-point outputs are rounded)
+    inline void storeOutput(double &output, double value)
+    {
+        output = value;
+    }
+
+    inline void storeOutput(float &output, double value)
+    {
+        output = static_cast<float>(value);
+    }
+
+    inline void storeOutput(qint32 &output, double value)
+    {
+        output = qRound(value);
+    }
+
+    // Scalar 2D filter for the pixels from firstPixel to lastPixel (exclusive).  The double
+    // precision filter with qint32 accumulators is the reference
+    template <typename T, typename Accumulator>
+    void filterPixelsScalar(const LineFilter<T> &f, qint32 firstPixel, qint32 lastPixel)
+    {
+        const T *m = f.m, *n = f.n;
+        const T *m1 = f.m1, *n1 = f.n1, *m2 = f.m2, *n2 = f.n2, *m3 = f.m3, *n3 = f.n3;
+        const T *m4 = f.m4, *n4 = f.n4, *m5 = f.m5, *n5 = f.n5, *m6 = f.m6, *n6 = f.n6;
+        const T * const *cfilt = f.cfilt;
+        const T * const *yfilt = f.yfilt;
+
+        Accumulator PU,QU, PV,QV, PY,QY;
+        for (qint32 i = firstPixel; i < lastPixel; i++) {
+            PU=QU=0; PV=QV=0; PY=QY=0;
+
+            // Carry out 2D filtering. P and Q are the two arbitrary SINE & COS
+            // phases components. U filters for U, V for V, and Y for Y
+            // U and V are the same for lines n, n+/-2, but differ in sign for
+            // n+/-1, n+/-3 owing to the forward/backward axis slant
+            // For Y, only use lines n, n+/-2: the others cancel!!!
+            //  *have tried* using lines +/-1 & 3 --- can be made to work, but
+            //  introduces *phase-sensitivity* to the filter -> leaks too much
+            //  subcarrier if *any* phase-shifts!
+
+            qint32 l,r;
+
+            for (qint32 b = 0; b < f.taps; b++)
+            {
+                l=i-b; r=i+b;
+
+                PU+=(m[r]+m[l])*cfilt[0][b]+(+n1[r]+n1[l]-n2[l]-n2[r])*cfilt[1][b]-(m3[l]+m3[r]+m4[l]+m4[r])*cfilt[2][b]+(-n5[r]-n5[l]+n6[l]+n6[r])*cfilt[3][b];
+                QU+=(n[r]+n[l])*cfilt[0][b]+(-m1[r]-m1[l]+m2[l]+m2[r])*cfilt[1][b]-(n3[l]+n3[r]+n4[l]+n4[r])*cfilt[2][b]+(+m5[r]+m5[l]-m6[l]-m6[r])*cfilt[3][b];
+                PV+=(m[r]+m[l])*cfilt[0][b]+(-n1[r]-n1[l]+n2[l]+n2[r])*cfilt[1][b]-(m3[l]+m3[r]+m4[l]+m4[r])*cfilt[2][b]+(+n5[r]+n5[l]-n6[l]-n6[r])*cfilt[3][b];
+                QV+=(n[r]+n[l])*cfilt[0][b]+(+m1[r]+m1[l]-m2[l]-m2[r])*cfilt[1][b]-(n3[l]+n3[r]+n4[l]+n4[r])*cfilt[2][b]+(-m5[r]-m5[l]+m6[l]+m6[r])*cfilt[3][b];
+
+                PY+=(m[r]+m[l])*yfilt[0][b]-(m3[l]+m3[r]+m4[l]+m4[r])*yfilt[2][b];  // note omission of yfilt[1] and [3] for PAL
+                QY+=(n[r]+n[l])*yfilt[0][b]-(n3[l]+n3[r]+n4[l]+n4[r])*yfilt[2][b];  // note omission of yfilt[1] and [3] for PAL
+            }
+            storeOutput(f.pu[i], PU/f.cdiv); storeOutput(f.qu[i], QU/f.cdiv);
+            storeOutput(f.pv[i], PV/f.cdiv); storeOutput(f.qv[i], QV/f.cdiv);
+            storeOutput(f.py[i], PY/f.ydiv); storeOutput(f.qy[i], QY/f.ydiv);
+        }
+    }
+
+#ifdef PALCOLOUR_AVX2_KERNEL
+    // AVX2 2D filter, four adjacent pixels at a time (any remaining pixels are filtered by
+    // the scalar kernel).
+    //
+    // The results are identical to the scalar kernel: the sums are evaluated in the same
+    // order, and the accumulators are truncated to integers after each tap as the scalar
+    // kernel's qint32 accumulators are.  The V (and QV) terms of lines n+/-1 and n+/-3 are
+    // the exact negations of the U terms, so they are computed once and subtracted.  FMA is
+    // deliberately not used, as fusing the multiply and add would change the rounding.
+    __attribute__((target("avx2")))
+    void filterLineAvx2(const LineFilter<double> &f, qint32 firstPixel, qint32 lastPixel)
+    {
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+        const __m256d cdiv = _mm256_set1_pd(f.cdiv);
+        const __m256d ydiv = _mm256_set1_pd(f.ydiv);
+        const int truncate = _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC;
+
+        qint32 i = firstPixel;
+        for (; i + 4 <= lastPixel; i += 4) {
+            __m256d PU = _mm256_setzero_pd(), QU = _mm256_setzero_pd();
+            __m256d PV = _mm256_setzero_pd(), QV = _mm256_setzero_pd();
+            __m256d PY = _mm256_setzero_pd(), QY = _mm256_setzero_pd();
+
+            for (qint32 b = 0; b < f.taps; b++) {
+                qint32 l = i - b;
+                qint32 r = i + b;
+
+                __m256d c0 = _mm256_set1_pd(f.cfilt[0][b]);
+                __m256d c1 = _mm256_set1_pd(f.cfilt[1][b]);
+                __m256d c2 = _mm256_set1_pd(f.cfilt[2][b]);
+                __m256d c3 = _mm256_set1_pd(f.cfilt[3][b]);
+                __m256d y0 = _mm256_set1_pd(f.yfilt[0][b]);
+                __m256d y2 = _mm256_set1_pd(f.yfilt[2][b]);
+
+                // Line n
+                __m256d mSum = _mm256_add_pd(_mm256_loadu_pd(f.m + r), _mm256_loadu_pd(f.m + l));
+                __m256d nSum = _mm256_add_pd(_mm256_loadu_pd(f.n + r), _mm256_loadu_pd(f.n + l));
+
+                // Lines n+/-1: (+n1[r]+n1[l]-n2[l]-n2[r]) and (-m1[r]-m1[l]+m2[l]+m2[r])
+                __m256d n12 = _mm256_sub_pd(_mm256_sub_pd(_mm256_add_pd(_mm256_loadu_pd(f.n1 + r), _mm256_loadu_pd(f.n1 + l)),
+                                                          _mm256_loadu_pd(f.n2 + l)), _mm256_loadu_pd(f.n2 + r));
+                __m256d m12 = _mm256_add_pd(_mm256_add_pd(_mm256_sub_pd(_mm256_xor_pd(_mm256_loadu_pd(f.m1 + r), signMask),
+                                                                        _mm256_loadu_pd(f.m1 + l)),
+                                                          _mm256_loadu_pd(f.m2 + l)), _mm256_loadu_pd(f.m2 + r));
+
+                // Lines n+/-2: (m3[l]+m3[r]+m4[l]+m4[r])
+                __m256d m34 = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(f.m3 + l), _mm256_loadu_pd(f.m3 + r)),
+                                                          _mm256_loadu_pd(f.m4 + l)), _mm256_loadu_pd(f.m4 + r));
+                __m256d n34 = _mm256_add_pd(_mm256_add_pd(_mm256_add_pd(_mm256_loadu_pd(f.n3 + l), _mm256_loadu_pd(f.n3 + r)),
+                                                          _mm256_loadu_pd(f.n4 + l)), _mm256_loadu_pd(f.n4 + r));
+
+                // Lines n+/-3: (-n5[r]-n5[l]+n6[l]+n6[r]) and (+m5[r]+m5[l]-m6[l]-m6[r])
+                __m256d n56 = _mm256_add_pd(_mm256_add_pd(_mm256_sub_pd(_mm256_xor_pd(_mm256_loadu_pd(f.n5 + r), signMask),
+                                                                        _mm256_loadu_pd(f.n5 + l)),
+                                                          _mm256_loadu_pd(f.n6 + l)), _mm256_loadu_pd(f.n6 + r));
+                __m256d m56 = _mm256_sub_pd(_mm256_sub_pd(_mm256_add_pd(_mm256_loadu_pd(f.m5 + r), _mm256_loadu_pd(f.m5 + l)),
+                                                          _mm256_loadu_pd(f.m6 + l)), _mm256_loadu_pd(f.m6 + r));
+
+                __m256d mc0 = _mm256_mul_pd(mSum, c0);
+                __m256d nc0 = _mm256_mul_pd(nSum, c0);
+                __m256d n12c1 = _mm256_mul_pd(n12, c1);
+                __m256d m12c1 = _mm256_mul_pd(m12, c1);
+                __m256d m34c2 = _mm256_mul_pd(m34, c2);
+                __m256d n34c2 = _mm256_mul_pd(n34, c2);
+                __m256d n56c3 = _mm256_mul_pd(n56, c3);
+                __m256d m56c3 = _mm256_mul_pd(m56, c3);
+
+                __m256d termPU = _mm256_add_pd(_mm256_sub_pd(_mm256_add_pd(mc0, n12c1), m34c2), n56c3);
+                __m256d termQU = _mm256_add_pd(_mm256_sub_pd(_mm256_add_pd(nc0, m12c1), n34c2), m56c3);
+                __m256d termPV = _mm256_sub_pd(_mm256_sub_pd(_mm256_sub_pd(mc0, n12c1), m34c2), n56c3);
+                __m256d termQV = _mm256_sub_pd(_mm256_sub_pd(_mm256_sub_pd(nc0, m12c1), n34c2), m56c3);
+                __m256d termPY = _mm256_sub_pd(_mm256_mul_pd(mSum, y0), _mm256_mul_pd(m34, y2));
+                __m256d termQY = _mm256_sub_pd(_mm256_mul_pd(nSum, y0), _mm256_mul_pd(n34, y2));
+
+                PU = _mm256_round_pd(_mm256_add_pd(PU, termPU), truncate);
+                QU = _mm256_round_pd(_mm256_add_pd(QU, termQU), truncate);
+                PV = _mm256_round_pd(_mm256_add_pd(PV, termPV), truncate);
+                QV = _mm256_round_pd(_mm256_add_pd(QV, termQV), truncate);
+                PY = _mm256_round_pd(_mm256_add_pd(PY, termPY), truncate);
+                QY = _mm256_round_pd(_mm256_add_pd(QY, termQY), truncate);
+            }
+
+            _mm256_storeu_pd(f.pu + i, _mm256_div_pd(PU, cdiv));
+            _mm256_storeu_pd(f.qu + i, _mm256_div_pd(QU, cdiv));
+            _mm256_storeu_pd(f.pv + i, _mm256_div_pd(PV, cdiv));
+            _mm256_storeu_pd(f.qv + i, _mm256_div_pd(QV, cdiv));
+            _mm256_storeu_pd(f.py + i, _mm256_div_pd(PY, ydiv));
+            _mm256_storeu_pd(f.qy + i, _mm256_div_pd(QY, ydiv));
+        }
+
+        filterPixelsScalar<double, qint32>(f, i, lastPixel);
+    }
+
+    // Divide eight single precision sums in double precision (as the scalar filter does)
+    __attribute__((target("avx2")))
+    inline __m256 normaliseSums(__m256 sums, __m256d divisor)
+    {
+        __m128 low = _mm256_cvtpd_ps(_mm256_div_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(sums)), divisor));
+        __m128 high = _mm256_cvtpd_ps(_mm256_div_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(sums, 1)), divisor));
+        return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+    }
+
+    // AVX2 single precision 2D filter, eight adjacent pixels at a time.  The sums are
+    // evaluated and normalised as in the scalar single precision filter, so the results are
+    // the same
+    __attribute__((target("avx2")))
+    void filterLineAvx2(const LineFilter<float> &f, qint32 firstPixel, qint32 lastPixel)
+    {
+        const __m256 signMask = _mm256_set1_ps(-0.0f);
+        const __m256d cdiv = _mm256_set1_pd(f.cdiv);
+        const __m256d ydiv = _mm256_set1_pd(f.ydiv);
+
+        qint32 i = firstPixel;
+        for (; i + 8 <= lastPixel; i += 8) {
+            __m256 PU = _mm256_setzero_ps(), QU = _mm256_setzero_ps();
+            __m256 PV = _mm256_setzero_ps(), QV = _mm256_setzero_ps();
+            __m256 PY = _mm256_setzero_ps(), QY = _mm256_setzero_ps();
+
+            for (qint32 b = 0; b < f.taps; b++) {
+                qint32 l = i - b;
+                qint32 r = i + b;
+
+                __m256 c0 = _mm256_set1_ps(f.cfilt[0][b]);
+                __m256 c1 = _mm256_set1_ps(f.cfilt[1][b]);
+                __m256 c2 = _mm256_set1_ps(f.cfilt[2][b]);
+                __m256 c3 = _mm256_set1_ps(f.cfilt[3][b]);
+                __m256 y0 = _mm256_set1_ps(f.yfilt[0][b]);
+                __m256 y2 = _mm256_set1_ps(f.yfilt[2][b]);
+
+                __m256 mSum = _mm256_add_ps(_mm256_loadu_ps(f.m + r), _mm256_loadu_ps(f.m + l));
+                __m256 nSum = _mm256_add_ps(_mm256_loadu_ps(f.n + r), _mm256_loadu_ps(f.n + l));
+                __m256 n12 = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(f.n1 + r), _mm256_loadu_ps(f.n1 + l)),
+                                                         _mm256_loadu_ps(f.n2 + l)), _mm256_loadu_ps(f.n2 + r));
+                __m256 m12 = _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_xor_ps(_mm256_loadu_ps(f.m1 + r), signMask),
+                                                                       _mm256_loadu_ps(f.m1 + l)),
+                                                         _mm256_loadu_ps(f.m2 + l)), _mm256_loadu_ps(f.m2 + r));
+                __m256 m34 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(f.m3 + l), _mm256_loadu_ps(f.m3 + r)),
+                                                         _mm256_loadu_ps(f.m4 + l)), _mm256_loadu_ps(f.m4 + r));
+                __m256 n34 = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_loadu_ps(f.n3 + l), _mm256_loadu_ps(f.n3 + r)),
+                                                         _mm256_loadu_ps(f.n4 + l)), _mm256_loadu_ps(f.n4 + r));
+                __m256 n56 = _mm256_add_ps(_mm256_add_ps(_mm256_sub_ps(_mm256_xor_ps(_mm256_loadu_ps(f.n5 + r), signMask),
+                                                                       _mm256_loadu_ps(f.n5 + l)),
+                                                         _mm256_loadu_ps(f.n6 + l)), _mm256_loadu_ps(f.n6 + r));
+                __m256 m56 = _mm256_sub_ps(_mm256_sub_ps(_mm256_add_ps(_mm256_loadu_ps(f.m5 + r), _mm256_loadu_ps(f.m5 + l)),
+                                                         _mm256_loadu_ps(f.m6 + l)), _mm256_loadu_ps(f.m6 + r));
+
+                __m256 mc0 = _mm256_mul_ps(mSum, c0);
+                __m256 nc0 = _mm256_mul_ps(nSum, c0);
+                __m256 n12c1 = _mm256_mul_ps(n12, c1);
+                __m256 m12c1 = _mm256_mul_ps(m12, c1);
+                __m256 m34c2 = _mm256_mul_ps(m34, c2);
+                __m256 n34c2 = _mm256_mul_ps(n34, c2);
+                __m256 n56c3 = _mm256_mul_ps(n56, c3);
+                __m256 m56c3 = _mm256_mul_ps(m56, c3);
+
+                PU = _mm256_add_ps(PU, _mm256_add_ps(_mm256_sub_ps(_mm256_add_ps(mc0, n12c1), m34c2), n56c3));
+                QU = _mm256_add_ps(QU, _mm256_add_ps(_mm256_sub_ps(_mm256_add_ps(nc0, m12c1), n34c2), m56c3));
+                PV = _mm256_add_ps(PV, _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(mc0, n12c1), m34c2), n56c3));
+                QV = _mm256_add_ps(QV, _mm256_sub_ps(_mm256_sub_ps(_mm256_sub_ps(nc0, m12c1), n34c2), m56c3));
+                PY = _mm256_add_ps(PY, _mm256_sub_ps(_mm256_mul_ps(mSum, y0), _mm256_mul_ps(m34, y2)));
+                QY = _mm256_add_ps(QY, _mm256_sub_ps(_mm256_mul_ps(nSum, y0), _mm256_mul_ps(n34, y2)));
+            }
+
+            _mm256_storeu_ps(f.pu + i, normaliseSums(PU, cdiv));
+            _mm256_storeu_ps(f.qu + i, normaliseSums(QU, cdiv));
+            _mm256_storeu_ps(f.pv + i, normaliseSums(PV, cdiv));
+            _mm256_storeu_ps(f.qv + i, normaliseSums(QV, cdiv));
+            _mm256_storeu_ps(f.py + i, normaliseSums(PY, ydiv));
+            _mm256_storeu_ps(f.qy + i, normaliseSums(QY, ydiv));
+        }
+
+        filterPixelsScalar<float, float>(f, i, lastPixel);
+    }
+
+    __attribute__((target("avx2")))
+    inline __m256i loadSamples(const qint32 *line, qint32 x)
+    {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(line + x));
+    }
+
+    // AVX2 fixed-point 2D filter, eight adjacent pixels at a time.  The sums are the same as
+    // the scalar fixed-point filter's, so the results are identical
+    __attribute__((target("avx2")))
+    void filterLineAvx2(const LineFilter<qint32> &f, qint32 firstPixel, qint32 lastPixel)
+    {
+        const __m256i zero = _mm256_setzero_si256();
+
+        qint32 i = firstPixel;
+        for (; i + 8 <= lastPixel; i += 8) {
+            __m256i PU = zero, QU = zero, PV = zero, QV = zero, PY = zero, QY = zero;
+
+            for (qint32 b = 0; b < f.taps; b++) {
+                qint32 l = i - b;
+                qint32 r = i + b;
+
+                __m256i c0 = _mm256_set1_epi32(f.cfilt[0][b]);
+                __m256i c1 = _mm256_set1_epi32(f.cfilt[1][b]);
+                __m256i c2 = _mm256_set1_epi32(f.cfilt[2][b]);
+                __m256i c3 = _mm256_set1_epi32(f.cfilt[3][b]);
+                __m256i y0 = _mm256_set1_epi32(f.yfilt[0][b]);
+                __m256i y2 = _mm256_set1_epi32(f.yfilt[2][b]);
+
+                __m256i mSum = _mm256_add_epi32(loadSamples(f.m, r), loadSamples(f.m, l));
+                __m256i nSum = _mm256_add_epi32(loadSamples(f.n, r), loadSamples(f.n, l));
+                __m256i n12 = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_add_epi32(loadSamples(f.n1, r), loadSamples(f.n1, l)),
+                                                                loadSamples(f.n2, l)), loadSamples(f.n2, r));
+                __m256i m12 = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_add_epi32(loadSamples(f.m2, l), loadSamples(f.m2, r)),
+                                                                loadSamples(f.m1, r)), loadSamples(f.m1, l));
+                __m256i m34 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(loadSamples(f.m3, l), loadSamples(f.m3, r)),
+                                                                loadSamples(f.m4, l)), loadSamples(f.m4, r));
+                __m256i n34 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(loadSamples(f.n3, l), loadSamples(f.n3, r)),
+                                                                loadSamples(f.n4, l)), loadSamples(f.n4, r));
+                __m256i n56 = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_add_epi32(loadSamples(f.n6, l), loadSamples(f.n6, r)),
+                                                                loadSamples(f.n5, r)), loadSamples(f.n5, l));
+                __m256i m56 = _mm256_sub_epi32(_mm256_sub_epi32(_mm256_add_epi32(loadSamples(f.m5, r), loadSamples(f.m5, l)),
+                                                                loadSamples(f.m6, l)), loadSamples(f.m6, r));
+
+                __m256i mc0 = _mm256_mullo_epi32(mSum, c0);
+                __m256i nc0 = _mm256_mullo_epi32(nSum, c0);
+                __m256i n12c1 = _mm256_mullo_epi32(n12, c1);
+                __m256i m12c1 = _mm256_mullo_epi32(m12, c1);
+                __m256i m34c2 = _mm256_mullo_epi32(m34, c2);
+                __m256i n34c2 = _mm256_mullo_epi32(n34, c2);
+                __m256i n56c3 = _mm256_mullo_epi32(n56, c3);
+                __m256i m56c3 = _mm256_mullo_epi32(m56, c3);
+
+                PU = _mm256_add_epi32(PU, _mm256_add_epi32(_mm256_sub_epi32(_mm256_add_epi32(mc0, n12c1), m34c2), n56c3));
+                QU = _mm256_add_epi32(QU, _mm256_add_epi32(_mm256_sub_epi32(_mm256_add_epi32(nc0, m12c1), n34c2), m56c3));
+                PV = _mm256_add_epi32(PV, _mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(mc0, n12c1), m34c2), n56c3));
+                QV = _mm256_add_epi32(QV, _mm256_sub_epi32(_mm256_sub_epi32(_mm256_sub_epi32(nc0, m12c1), n34c2), m56c3));
+                PY = _mm256_add_epi32(PY, _mm256_sub_epi32(_mm256_mullo_epi32(mSum, y0), _mm256_mullo_epi32(m34, y2)));
+                QY = _mm256_add_epi32(QY, _mm256_sub_epi32(_mm256_mullo_epi32(nSum, y0), _mm256_mullo_epi32(n34, y2)));
+            }
+
+            // Normalise the sums as the scalar filter does
+            qint32 sums[6][8];
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums[0]), PU);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums[1]), QU);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums[2]), PV);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums[3]), QV);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums[4]), PY);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(sums[5]), QY);
+            for (qint32 x = 0; x < 8; x++) {
+                storeOutput(f.pu[i + x], sums[0][x] / f.cdiv); storeOutput(f.qu[i + x], sums[1][x] / f.cdiv);
+                storeOutput(f.pv[i + x], sums[2][x] / f.cdiv); storeOutput(f.qv[i + x], sums[3][x] / f.cdiv);
+                storeOutput(f.py[i + x], sums[4][x] / f.ydiv); storeOutput(f.qy[i + x], sums[5][x] / f.ydiv);
+            }
+        }
+
+        filterPixelsScalar<qint32, qint32>(f, i, lastPixel);
+    }
+#endif
+}
+
 PalColour::PalColour(LdDecodeMetaData::VideoParameters videoParametersParam, QObject *parent) : QObject(parent)
 {
     // Copy the configuration parameters
@@ -38,6 +394,71 @@ PalColour::PalColour(LdDecodeMetaData::VideoParameters videoParametersParam, QOb
 
     // Build the look-up tables
     buildLookUpTables();
+    buildReducedTables();
+
+    // Use the fastest 2D filter the CPU supports, with double precision
+    filterKernel = getFastestKernel();
+    precision = doublePrecision;
+}
+
+// Get the fastest 2D filter kernel supported by the CPU
+PalColour::FilterKernel PalColour::getFastestKernel(void)
+{
+#ifdef PALCOLOUR_AVX2_KERNEL
+    if (__builtin_cpu_supports("avx2")) return avx2Kernel;
+#endif
+
+    return scalarKernel;
+}
+
+QString PalColour::getKernelName(FilterKernel kernel)
+{
+    if (kernel == avx2Kernel) return "AVX2";
+    return "scalar";
+}
+
+// Set the 2D filter kernel (if the CPU does not support the kernel, the scalar kernel is used)
+void PalColour::setFilterKernel(FilterKernel filterKernelParam)
+{
+    if (filterKernelParam == avx2Kernel && getFastestKernel() != avx2Kernel) {
+        qWarning() << "The CPU does not support the AVX2 filter kernel - using the scalar kernel";
+        filterKernelParam = scalarKernel;
+    }
+
+    filterKernel = filterKernelParam;
+}
+
+PalColour::FilterKernel PalColour::getFilterKernel(void)
+{
+    return filterKernel;
+}
+
+QString PalColour::getPrecisionName(Precision precision)
+{
+    if (precision == singlePrecision) return "single precision";
+    if (precision == fixedPoint) return "fixed-point";
+    return "double precision";
+}
+
+// Returns the maximum difference (in 16-bit output levels) allowed between the output of a
+// SIMD kernel and the scalar kernel of the same precision.  The kernels normally give
+// identical results, but they can round differently if the compiler fuses multiplies and
+// adds; in single precision that can move an output by up to two levels
+qint32 PalColour::getKernelTolerance(Precision precision)
+{
+    if (precision == singlePrecision) return 2;
+    return 1;
+}
+
+// Set the arithmetic used by the decoder
+void PalColour::setPrecision(Precision precisionParam)
+{
+    precision = precisionParam;
+}
+
+PalColour::Precision PalColour::getPrecision(void)
+{
+    return precision;
 }
 
 // Private method to build the look up tables
@@ -115,39 +536,94 @@ void PalColour::buildLookUpTables(void)
     cdiv*=2; ydiv*=2;
 }
 
+// Build the single precision and fixed-point look-up tables from the double precision tables
+// (must be called after buildLookUpTables())
+void PalColour::buildReducedTables(void)
+{
+    for (qint32 i = 0; i < videoParameters.fieldWidth; i++) {
+        singleTables.sine[i] = static_cast<float>(sine[i]);
+        singleTables.cosine[i] = static_cast<float>(cosine[i]);
+        fixedTables.sine[i] = qRound(sine[i] * (1 << fixedPointShift));
+        fixedTables.cosine[i] = qRound(cosine[i] * (1 << fixedPointShift));
+    }
+
+    // The divisors are made from the rounded coefficients, so the gain of the filters is not
+    // changed by the rounding
+    singleTables.cdiv = cdiv;
+    singleTables.ydiv = ydiv;
+    fixedTables.cdiv = 0;
+    fixedTables.ydiv = 0;
+    for (qint32 f = 0; f <= arraySize; f++) {
+        for (qint32 line = 0; line < 4; line++) {
+            singleTables.cfilt[line][f] = static_cast<float>(cfilt[line][f]);
+            singleTables.yfilt[line][f] = static_cast<float>(yfilt[line][f]);
+            fixedTables.cfilt[line][f] = qRound(cfilt[line][f]);
+            fixedTables.yfilt[line][f] = qRound(yfilt[line][f]);
+        }
+
+        fixedTables.cdiv += fixedTables.cfilt[0][f] + 2 * fixedTables.cfilt[1][f] + 2 * fixedTables.cfilt[2][f] + 2 * fixedTables.cfilt[3][f];
+        fixedTables.ydiv += fixedTables.yfilt[0][f] + 2 * fixedTables.yfilt[1][f] + 2 * fixedTables.yfilt[2][f] + 2 * fixedTables.yfilt[3][f];
+    }
+    fixedTables.cdiv *= 2;
+    fixedTables.ydiv *= 2;
+}
+
 // Performs a decode of the 16-bit greyscale input frame and produces a RGB 16-16-16-bit output frame
 // with 16 bit processing
 //
-// Note: This method does not clear the output array before writing to it; if there is garbage
-// in the allocated memory, it will be in the output with the decoded image on top.
-QByteArray PalColour::performDecode(QByteArray firstFieldData, QByteArray secondFieldData, qint32 brightness, qint32 saturation)
+// The output frame is resized if required (a newly allocated frame is cleared to black); pass the
+// same output frame each time to avoid reallocating it for every frame.
+//
+// Note: This method does not clear the output frame before writing to it; anything outside of the
+// decoded area is left as it was.
+void PalColour::performDecode(FieldBuffer firstField, FieldBuffer secondField, qint32 brightness, qint32 saturation, FieldBuffer &outputFrame)
+{
+    switch (precision) {
+    case singlePrecision:
+        decodeFrame<float, float>(firstField, secondField, brightness, saturation, outputFrame, singleTables.sine, singleTables.cosine,
+                                  singleTables.cfilt, singleTables.yfilt, singleTables.cdiv, singleTables.ydiv);
+        break;
+    case fixedPoint:
+        decodeFrame<qint32, qint32>(firstField, secondField, brightness, saturation, outputFrame, fixedTables.sine, fixedTables.cosine,
+                                    fixedTables.cfilt, fixedTables.yfilt, fixedTables.cdiv, fixedTables.ydiv);
+        break;
+    default:
+        decodeFrame<double, qint32>(firstField, secondField, brightness, saturation, outputFrame, sine, cosine, cfilt, yfilt, cdiv, ydiv);
+    }
+}
+
+// Performs the decode with the working data (the look-up tables, line buffers and 2D filter)
+// of type T
+template <typename T, typename Accumulator>
+void PalColour::decodeFrame(const FieldBuffer &firstField, const FieldBuffer &secondField, qint32 brightness, qint32 saturation,
+                            FieldBuffer &outputFrame, const T *sineT, const T *cosineT, const T (*cfiltT)[arraySize + 1],
+                            const T (*yfiltT)[arraySize + 1], double cdivT, double ydivT)
 {
     // Calculate the frame height
     qint32 frameHeight = (videoParameters.fieldHeight * 2) - 1;
 
-    QByteArray outputFrame;
-    outputFrame.resize(videoParameters.fieldWidth * frameHeight * 6);
+    outputFrame.resize(videoParameters.fieldWidth * 3, frameHeight);
 
     double scaledBrightness = 1.75 * brightness / 100.0;
     // NB 1.75 is nominal scaling factor for full-range digitised composite (with sync at code 0 or 1,
     // blanking at code 64 (40h), and peak white at code 211 (d3h) to give 0-255 RGB.
 
-    if (!firstFieldData.isNull() && !secondFieldData.isNull()) {
+    if (!firstField.isNull() && !secondField.isNull()) {
         // Step 2:
         quint16 Y[MAX_WIDTH];
 
         // were all short ints
-        double pu[MAX_WIDTH], qu[MAX_WIDTH], pv[MAX_WIDTH], qv[MAX_WIDTH], py[MAX_WIDTH], qy[MAX_WIDTH];
-        double m[MAX_WIDTH], n[MAX_WIDTH];
-        double m1[MAX_WIDTH], n1[MAX_WIDTH], m2[MAX_WIDTH], n2[MAX_WIDTH];
-        double m3[MAX_WIDTH], n3[MAX_WIDTH], m4[MAX_WIDTH], n4[MAX_WIDTH];
-        double m5[MAX_WIDTH], n5[MAX_WIDTH], m6[MAX_WIDTH], n6[MAX_WIDTH];
+        T pu[MAX_WIDTH], qu[MAX_WIDTH], pv[MAX_WIDTH], qv[MAX_WIDTH], py[MAX_WIDTH], qy[MAX_WIDTH];
+        T m[MAX_WIDTH], n[MAX_WIDTH];
+        T m1[MAX_WIDTH], n1[MAX_WIDTH], m2[MAX_WIDTH], n2[MAX_WIDTH];
+        T m3[MAX_WIDTH], n3[MAX_WIDTH], m4[MAX_WIDTH], n4[MAX_WIDTH];
+        T m5[MAX_WIDTH], n5[MAX_WIDTH], m6[MAX_WIDTH], n6[MAX_WIDTH];
 
         qint32 Vsw; // this will represent the PAL Vswitch state later on...
 
         // Since we're not using Image objects, we need a pointer to the 16-bit image data
-        quint16 *topFieldDataPointer = reinterpret_cast<quint16*>(firstFieldData.data());
-        quint16 *bottomFieldDataPointer = reinterpret_cast<quint16*>(secondFieldData.data());
+        const quint16 *topFieldDataPointer = firstField.constData();
+        const quint16 *bottomFieldDataPointer = secondField.constData();
 
         // Define the 16-bit line buffers
         quint16 b0[MAX_WIDTH];
@@ -183,14 +659,14 @@ QByteArray PalColour::performDecode(QByteArray firstFieldData, QByteArray second
                 }
 
                 for (qint32 i = 0; i < videoParameters.fieldWidth; i++) {
-                    m[i]=b0[i]*sine[i]; n[i]=b0[i]*cosine[i];
-
-                    m1[i]=b1[i]*sine[i];  n1[i]=b1[i]*cosine[i];
-                    m2[i]=b2[i]*sine[i];  n2[i]=b2[i]*cosine[i];
-                    m3[i]=b3[i]*sine[i];  n3[i]=b3[i]*cosine[i];
-                    m4[i]=b4[i]*sine[i];  n4[i]=b4[i]*cosine[i];
-                    m5[i]=b5[i]*sine[i];  n5[i]=b5[i]*cosine[i];
-                    m6[i]=b6[i]*sine[i];  n6[i]=b6[i]*cosine[i];
+                    m[i]=modulate(b0[i], sineT[i]); n[i]=modulate(b0[i], cosineT[i]);
+
+                    m1[i]=modulate(b1[i], sineT[i]);  n1[i]=modulate(b1[i], cosineT[i]);
+                    m2[i]=modulate(b2[i], sineT[i]);  n2[i]=modulate(b2[i], cosineT[i]);
+                    m3[i]=modulate(b3[i], sineT[i]);  n3[i]=modulate(b3[i], cosineT[i]);
+                    m4[i]=modulate(b4[i], sineT[i]);  n4[i]=modulate(b4[i], cosineT[i]);
+                    m5[i]=modulate(b5[i], sineT[i]);  n5[i]=modulate(b5[i], cosineT[i]);
+                    m6[i]=modulate(b6[i], sineT[i]);  n6[i]=modulate(b6[i], cosineT[i]);
                 }
 
                 // Find absolute burst phase
@@ -236,37 +712,24 @@ QByteArray PalColour::performDecode(QByteArray firstFieldData, QByteArray second
                 // NB: Multiline averaging/filtering assumes perfect
                 //     inter-line phase registration...
 
-                qint32 PU,QU, PV,QV, PY,QY;
-                for (qint32 i = videoParameters.activeVideoStart; i < videoParameters.activeVideoEnd; i++) {
-                    PU=QU=0; PV=QV=0; PY=QY=0;
-
-                    // Carry out 2D filtering. P and Q are the two arbitrary SINE & COS
-                    // phases components. U filters for U, V for V, and Y for Y
-                    // U and V are the same for lines n, n+/-2, but differ in sign for
-                    // n+/-1, n+/-3 owing to the forward/backward axis slant
-                    // For Y, only use lines n, n+/-2: the others cancel!!!
-                    //  *have tried* using lines +/-1 & 3 --- can be made to work, but
-                    //  introduces *phase-sensitivity* to the filter -> leaks too much
-                    //  subcarrier if *any* phase-shifts!
-
-                    qint32 l,r;
-
-                    for (qint32 b = 0; b <= arraySize; b++)
-                    {
-                        l=i-b; r=i+b;
-
-                        PU+=(m[r]+m[l])*cfilt[0][b]+(+n1[r]+n1[l]-n2[l]-n2[r])*cfilt[1][b]-(m3[l]+m3[r]+m4[l]+m4[r])*cfilt[2][b]+(-n5[r]-n5[l]+n6[l]+n6[r])*cfilt[3][b];
-                        QU+=(n[r]+n[l])*cfilt[0][b]+(-m1[r]-m1[l]+m2[l]+m2[r])*cfilt[1][b]-(n3[l]+n3[r]+n4[l]+n4[r])*cfilt[2][b]+(+m5[r]+m5[l]-m6[l]-m6[r])*cfilt[3][b];
-                        PV+=(m[r]+m[l])*cfilt[0][b]+(-n1[r]-n1[l]+n2[l]+n2[r])*cfilt[1][b]-(m3[l]+m3[r]+m4[l]+m4[r])*cfilt[2][b]+(+n5[r]+n5[l]-n6[l]-n6[r])*cfilt[3][b];
-                        QV+=(n[r]+n[l])*cfilt[0][b]+(+m1[r]+m1[l]-m2[l]-m2[r])*cfilt[1][b]-(n3[l]+n3[r]+n4[l]+n4[r])*cfilt[2][b]+(-m5[r]-m5[l]+m6[l]+m6[r])*cfilt[3][b];
-
-                        PY+=(m[r]+m[l])*yfilt[0][b]-(m3[l]+m3[r]+m4[l]+m4[r])*yfilt[2][b];  // note omission of yfilt[1] and [3] for PAL
-                        QY+=(n[r]+n[l])*yfilt[0][b]-(n3[l]+n3[r]+n4[l]+n4[r])*yfilt[2][b];  // note omission of yfilt[1] and [3] for PAL
-                    }
-                    pu[i]=PU/cdiv; qu[i]=QU/cdiv;
-                    pv[i]=PV/cdiv; qv[i]=QV/cdiv;
-                    py[i]=PY/ydiv; qy[i]=QY/ydiv;
+                // Carry out the 2D filtering (see filterPixelsScalar())
+                LineFilter<T> lineFilter = {
+                    m, n, m1, n1, m2, n2, m3, n3, m4, n4, m5, n5, m6, n6,
+                    pu, qu, pv, qv, py, qy,
+                    { cfiltT[0], cfiltT[1], cfiltT[2], cfiltT[3] },
+                    { yfiltT[0], yfiltT[1], yfiltT[2], yfiltT[3] },
+                    arraySize + 1, cdivT, ydivT
+                };
+
+#ifdef PALCOLOUR_AVX2_KERNEL
+                if (filterKernel == avx2Kernel) {
+                    filterLineAvx2(lineFilter, videoParameters.activeVideoStart, videoParameters.activeVideoEnd);
+                } else {
+                    filterPixelsScalar<T, Accumulator>(lineFilter, videoParameters.activeVideoStart, videoParameters.activeVideoEnd);
                 }
+#else
+                filterPixelsScalar<T, Accumulator>(lineFilter, videoParameters.activeVideoStart, videoParameters.activeVideoEnd);
+#endif
 
                 // Obtain the black level from the "back porch"
                 // we average over the present line, and two lines above and below to get a good average and avoid "banding"
@@ -288,7 +751,7 @@ QByteArray PalColour::performDecode(QByteArray firstFieldData, QByteArray second
                 }
 
                 // Define scan line pointer to output buffer using 16 bit unsigned words
-                quint16 *ptr = reinterpret_cast<quint16*>(outputFrame.data() + (((fieldLine * 2) + field) * videoParameters.fieldWidth * 6));
+                quint16 *ptr = outputFrame.line((fieldLine * 2) + field);
 
                 // 'saturation' is a user saturation control, nom. 100% - scaled to 16-bit (*256)
                 double scaledSaturation = (saturation / 100.0) / norm;  // 'norm' normalises bp and bq to 1
@@ -325,6 +788,4 @@ QByteArray PalColour::performDecode(QByteArray firstFieldData, QByteArray second
             }
         }
     }
-
-    return outputFrame;
 }
@@ -35,6 +35,7 @@
 #include <QDebug>
 
 #include "lddecodemetadata.h"
+#include "fieldbuffer.h"
 
 class PalColour : public QObject
 {
@@ -44,7 +45,35 @@ public:
     explicit PalColour(LdDecodeMetaData::VideoParameters videoParametersParam, QObject *parent = nullptr);
 
     // Method to perform the colour decoding
-    QByteArray performDecode(QByteArray topFieldData, QByteArray bottomFieldData, qint32 brightness, qint32 saturation);
+    void performDecode(FieldBuffer topField, FieldBuffer bottomField, qint32 brightness, qint32 saturation, FieldBuffer &outputFrame);
+
+    // Implementations of the 2D filter (the scalar kernel is the reference; the SIMD kernel
+    // of each precision produces the same results as the scalar kernel of that precision,
+    // and the SIMD kernels are only used if the CPU supports them)
+    enum FilterKernel {
+        scalarKernel,
+        avx2Kernel
+    };
+
+    static FilterKernel getFastestKernel(void);
+    static QString getKernelName(FilterKernel kernel);
+    void setFilterKernel(FilterKernel filterKernelParam);
+    FilterKernel getFilterKernel(void);
+
+    // The arithmetic used for the look-up tables, the working line buffers and the 2D filter
+    // (double precision is the reference; the others halve the size of the working data and
+    // double the width of the SIMD kernels, at a small cost in accuracy).  The colour
+    // conversion of the filtered lines is always double precision
+    enum Precision {
+        doublePrecision,
+        singlePrecision,    // 32-bit float
+        fixedPoint          // 32-bit integer
+    };
+
+    static QString getPrecisionName(Precision precision);
+    static qint32 getKernelTolerance(Precision precision);
+    void setPrecision(Precision precisionParam);
+    Precision getPrecision(void);
 
     // Replacements for #DEFINE values
     static const int MAX_WIDTH = 1135; // Simon: Maximum based on PAL width
@@ -64,8 +93,36 @@ private:
     double ydiv;
     double refAmpl;
 
+    // The 2D filter implementation and arithmetic used by performDecode()
+    FilterKernel filterKernel;
+    Precision precision;
+
+    // Look-up tables for the single precision and fixed-point decoders (made from the double
+    // precision tables above).  The fixed-point sine and cosine have fixedPointShift
+    // fractional bits; the filter coefficients are whole numbers, and the divisors are the
+    // sums of the rounded coefficients
+    template <typename T>
+    struct ReducedTables {
+        T sine[MAX_WIDTH], cosine[MAX_WIDTH];
+        T cfilt[4][arraySize + 1];
+        T yfilt[4][arraySize + 1];
+        double cdiv;
+        double ydiv;
+    };
+
+    ReducedTables<float> singleTables;
+    ReducedTables<qint32> fixedTables;
+
     // Method to build the required look-up tables
     void buildLookUpTables(void);
+    void buildReducedTables(void);
+
+    // The decoder, for each type of working data (Accumulator is the type of the 2D filter's
+    // sums)
+    template <typename T, typename Accumulator>
+    void decodeFrame(const FieldBuffer &firstField, const FieldBuffer &secondField, qint32 brightness, qint32 saturation,
+                     FieldBuffer &outputFrame, const T *sineT, const T *cosineT, const T (*cfiltT)[arraySize + 1],
+                     const T (*yfiltT)[arraySize + 1], double cdivT, double ydivT);
 };
 
 #endif // PALCOLOUR_H
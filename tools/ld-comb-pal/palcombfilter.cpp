@@ -24,17 +24,24 @@
 
 #include "palcombfilter.h"
 
+namespace {
+    // The number of frames between progress updates
+    const qint32 progressInterval = 16;
+}
+
 PalCombFilter::PalCombFilter(QObject *parent) : QObject(parent)
 {
 
 }
 
-bool PalCombFilter::process(QString inputFileName, QString outputFileName, qint32 startFrame, qint32 length, bool isVP415CropSet)
+// Note: A file name of "-" reads the input TBC from stdin or writes the output RGB to stdout
+bool PalCombFilter::process(QString inputFileName, QString inputJsonFileName, QString outputFileName, qint32 startFrame, qint32 length,
+                            QString startPosition, QString endPosition, bool isVP415CropSet, qint32 numberOfThreads,
+                            bool isPinThreadsSet, PalColour::FilterKernel filterKernel, PalColour::Precision precision,
+                            bool isVerifySet, qint32 cacheSize)
 {
-    qint32 maxThreads = 16;
-
     // Open the source video metadata
-    if (!ldDecodeMetaData.read(inputFileName + ".json")) {
+    if (!ldDecodeMetaData.read(inputJsonFileName)) {
         qInfo() << "Unable to open ld-decode metadata file";
         return false;
     }
@@ -84,20 +91,18 @@ bool PalCombFilter::process(QString inputFileName, QString outputFileName, qint3
                    "will be colourised and trimmed to" << videoEnd - videoStart << "x" <<
                    lastActiveScanLine - firstActiveScanLine;
 
-    // Define a vector of filtering threads to process the video
-    QVector<FilterThread*> filterThreads;
-    filterThreads.resize(maxThreads);
-    for (qint32 i = 0; i < maxThreads; i++) {
-        filterThreads[i] = new FilterThread(videoParameters, isVP415CropSet);
-    }
-
-    // Open the source video file
+    // Open the source video file (if the source is a stream the number of fields is taken from the metadata)
+    if (cacheSize != -1) sourceVideo.setCacheSize(cacheSize);
+    sourceVideo.setStreamFieldCount(ldDecodeMetaData.getNumberOfFields());
     if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
         // Could not open source video file
         qInfo() << "Unable to open ld-decode video file";
         return false;
     }
 
+    // Find the start and end frames from the VBI picture numbers or time codes (if specified)
+    if (!ldDecodeMetaData.getFrameRangeForPositions(startPosition, endPosition, startFrame, length)) return false;
+
     // If no startFrame parameter was specified, set the start frame to 1
     if (startFrame == -1) startFrame = 1;
 
@@ -118,78 +123,147 @@ bool PalCombFilter::process(QString inputFileName, QString outputFileName, qint3
 
     qInfo() << "Processing from start frame #" << startFrame << "with a length of" << length << "frames";
 
-    // Open the target video file (RGB)
-    QFile targetVideo(outputFileName);
-    if (!targetVideo.open(QIODevice::WriteOnly)) {
+    // Open the target video file (RGB) - the frames are written by a background thread so that
+    // the filtering does not wait for the writes
+    OutputWriter targetVideo;
+    if (!targetVideo.open(outputFileName, videoParameters.fieldWidth * frameHeight * 6)) {
             // Could not open target video file
             qInfo() << "Unable to open output video file";
             sourceVideo.close();
             return false;
     }
 
-    // Process the frames
+    // Build the list of frames to process (the reader stage works from the list, so only the
+    // main thread uses the metadata)
+    QVector<FilterPool::Job> frameJobs(length);
+    for (qint32 i = 0; i < length; i++) {
+        FilterPool::Job &job = frameJobs[i];
+        job.frameNumber = startFrame + i;
+
+        // Determine the first and second fields for the frame number
+        job.firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(job.frameNumber);
+        job.secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(job.frameNumber);
+        job.burstMedianIre = ldDecodeMetaData.getConstField(job.firstFieldNumber).medianBurstIRE;
+
+        qDebug() << "PalCombFilter::process(): Frame number" << job.frameNumber << "has a first-field of" << job.firstFieldNumber <<
+                    "and a second field of" << job.secondFieldNumber;
+    }
+
+    // Process the frames as a pipeline: the frame reader reads the input fields and queues
+    // the frames in the pool, each idle filter thread takes the next queued frame, and the
+    // filtered frames are collected here in order and passed to the output writer.  Every
+    // stage runs continuously, so the filter threads are not held up by the slowest frame
+    // of a batch or by the I/O.
+    // Verification compares the output with the double precision scalar decoder, so it is not
+    // needed if that is the decoder used anyway
+    if (isVerifySet && filterKernel == PalColour::scalarKernel && precision == PalColour::doublePrecision) {
+        qInfo() << "The double precision scalar decoder is the reference - nothing to verify";
+        isVerifySet = false;
+    }
+
+    qInfo() << "Using" << numberOfThreads << "filter threads" << (isPinThreadsSet ? "pinned to the available CPUs" : "") <<
+               "with the" << PalColour::getPrecisionName(precision) << PalColour::getKernelName(filterKernel) << "filter kernel";
+    FilterPool filterPool(videoParameters, isVP415CropSet, numberOfThreads, isPinThreadsSet, filterKernel, precision, isVerifySet);
+    FrameReader frameReader(&filterPool, &sourceVideo, frameJobs, videoParameters.fieldWidth);
+    frameReader.start();
+
     QElapsedTimer totalTimer;
     totalTimer.start();
-    for (qint32 frameNumber = startFrame; frameNumber <= length + (startFrame - 1); frameNumber += maxThreads) {
-        QElapsedTimer timer;
-        timer.start();
-
-        // Ensure we don't overflow the maximum number of frames to process
-        // (limit the available number of threads to the remaining number of frames)
-        if ((frameNumber +  maxThreads) > length + (startFrame - 1)) maxThreads = (length + startFrame) - frameNumber;
-
-        QByteArray rgbOutputData;
-        QVector<SourceField*> sourceFirstFields;
-        QVector<SourceField*> sourceSecondFields;
-        QVector<qreal> burstMedianIre;
-        sourceFirstFields.resize(maxThreads);
-        sourceSecondFields.resize(maxThreads);
-        burstMedianIre.resize(maxThreads);
-
-        // Perform filtering
-        for (qint32 i = 0; i < maxThreads; i++) {
-            // Determine the first and second fields for the frame number
-            qint32 firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber + i);
-            qint32 secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber + i);
-
-            // Show what we are about to process
-            qDebug() << "PalCombFilter::process(): Frame number" << frameNumber + i << "has a first-field of" << firstFieldNumber <<
-                        "and a second field of" << secondFieldNumber;
-
-            sourceFirstFields[i] = sourceVideo.getVideoField(firstFieldNumber);
-            sourceSecondFields[i] = sourceVideo.getVideoField(secondFieldNumber);
-            burstMedianIre[i] = ldDecodeMetaData.getField(firstFieldNumber).medianBurstIRE;
-            filterThreads[i]->startFilter(sourceFirstFields[i]->getFieldData(), sourceSecondFields[i]->getFieldData(), burstMedianIre[i]);
+    QElapsedTimer timer;
+    timer.start();
+    for (qint32 i = 0; i < length; i++) {
+        qint32 frameNumber = frameJobs[i].frameNumber;
+        FieldBuffer rgbOutputData = filterPool.waitForResult(frameNumber);
+
+        // An empty result means the frame reader could not read the input fields
+        if (rgbOutputData.isNull()) {
+            qInfo() << "Reading from the input video file failed";
+
+            // Wait for the reader and filter threads to finish with the source video
+            filterPool.stop();
+            frameReader.wait();
+
+            targetVideo.close();
+            sourceVideo.close();
+            return false;
         }
 
-        for (qint32 i = 0; i < maxThreads; i++) {
-            while (filterThreads[i]->isBusy());
-            rgbOutputData = filterThreads[i]->getResult();
-
-            // Save the frame data to the output file
-            if (!targetVideo.write(rgbOutputData.data(), rgbOutputData.size())) {
-                // Could not write to target video file
-                qInfo() << "Writing to the output video file failed";
-                targetVideo.close();
-                sourceVideo.close();
-                return false;
-            }
+        // Save the frame data to the output file
+        if (!targetVideo.write(reinterpret_cast<const char *>(rgbOutputData.constData()), rgbOutputData.getSizeInBytes())) {
+            // Could not write to target video file
+            qInfo() << "Writing to the output video file failed";
+            filterPool.stop();
+            frameReader.wait();
+            targetVideo.close();
+            sourceVideo.close();
+            return false;
         }
 
-        // Show an update to the user
-        qreal fps = maxThreads / (static_cast<qreal>(timer.elapsed()) / 1000.0);
-        qInfo() << frameNumber + maxThreads - 1 << "frames processed -" << fps << "FPS";
+        // Show an update to the user (the rate is only shown once some time has passed)
+        if (((i + 1) % progressInterval) == 0 || i == length - 1) {
+            qint32 framesSinceUpdate = (i % progressInterval) + 1;
+            qint64 elapsedMsecs = timer.restart();
+            if (elapsedMsecs > 0) {
+                qreal fps = framesSinceUpdate / (static_cast<qreal>(elapsedMsecs) / 1000.0);
+                qInfo() << frameNumber << "frames processed -" << fps << "FPS";
+            } else {
+                qInfo() << frameNumber << "frames processed";
+            }
+        }
     }
 
+    // Stop the filter threads and wait for the reader to finish
+    filterPool.stop();
+    frameReader.wait();
+
+    // Close the target video (once all of the queued frames are written)
+    bool isTargetWritten = targetVideo.close();
+
     qreal totalSecs = (static_cast<qreal>(totalTimer.elapsed()) / 1000.0);
-    qInfo() << "Processing complete -" << length + (startFrame - 1) << "frames in" << totalSecs << "seconds (" <<
-               (length + (startFrame - 1)) / totalSecs << "FPS )";
+    qInfo() << "Processing complete -" << length << "frames in" << totalSecs << "seconds (" <<
+               (totalSecs > 0 ? length / totalSecs : 0.0) << "FPS )";
+
+    // Show the sustained rate of each pipeline stage (the frames processed divided by the
+    // time the stage was busy), so the limiting stage can be seen
+    OutputWriter::Statistics writerStatistics = targetVideo.getStatistics();
+    qInfo() << "Pipeline stages: reader" << getStageFps(frameReader.getFramesRead(), frameReader.getReadNsecs()) << "FPS -" <<
+               "filter" << getStageFps(length, filterPool.getFilterNsecs() / filterPool.getNumberOfThreads()) << "FPS (" <<
+               filterPool.getNumberOfThreads() << "threads ) - writer" <<
+               getStageFps(writerStatistics.buffersWritten, writerStatistics.writeNsecs) << "FPS";
+
+    // Show the result of the verification
+    if (isVerifySet) {
+        if (filterPool.getVerifyMaximumDifference() == 0) {
+            qInfo() << "Verification against the double precision scalar decoder: the output is identical";
+        } else {
+            qInfo() << "Verification against the double precision scalar decoder: maximum difference" <<
+                       filterPool.getVerifyMaximumDifference() << "- PSNR" << filterPool.getVerifyPsnr() << "dB";
+        }
+        if (filterKernel != PalColour::scalarKernel) {
+            qInfo() << filterPool.getVerifyMismatchCount() << "of" << length << "frames differed from the" <<
+                       PalColour::getPrecisionName(precision) << "scalar filter kernel by more than" << PalColour::getKernelTolerance(precision);
+        }
+    }
+
+    // Show the field cache statistics
+    SourceVideo::CacheStatistics cacheStatistics = sourceVideo.getCacheStatistics();
+    qInfo() << "Field cache:" << cacheStatistics.hits << "hits," << cacheStatistics.misses << "misses," <<
+               cacheStatistics.evictions << "evictions";
+    qDebug() << "PalCombFilter::process(): Field buffer allocations:" << FieldBuffer::getAllocationCount();
 
-    // Close the source video
     sourceVideo.close();
 
-    // Close the target video
-    targetVideo.close();
+    if (!isTargetWritten) {
+        qInfo() << "Writing to the output video file failed";
+        return false;
+    }
 
     return true;
 }
+
+// Get the sustained rate of a pipeline stage in frames per second
+qreal PalCombFilter::getStageFps(qint64 frames, qint64 busyNsecs)
+{
+    if (busyNsecs <= 0) return 0.0;
+    return static_cast<qreal>(frames) / (static_cast<qreal>(busyNsecs) / 1000000000.0);
+}
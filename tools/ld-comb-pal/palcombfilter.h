@@ -30,14 +30,20 @@
 
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
-#include "filterthread.h"
+#include "outputwriter.h"
+#include "filterpool.h"
+#include "framereader.h"
+#include "palcolour.h"
 
 class PalCombFilter : public QObject
 {
     Q_OBJECT
 public:
     explicit PalCombFilter(QObject *parent = nullptr);
-    bool process(QString inputFileName, QString outputFileName, qint32 startFrame, qint32 length, bool isVP415CropSet);
+    bool process(QString inputFileName, QString inputJsonFileName, QString outputFileName, qint32 startFrame, qint32 length,
+                 QString startPosition, QString endPosition, bool isVP415CropSet, qint32 numberOfThreads, bool isPinThreadsSet,
+                 PalColour::FilterKernel filterKernel, PalColour::Precision precision, bool isVerifySet,
+                 qint32 cacheSize = -1);
 
 signals:
 
@@ -48,6 +54,8 @@ private slots:
 private:
     LdDecodeMetaData ldDecodeMetaData;
     SourceVideo sourceVideo;
+
+    qreal getStageFps(qint64 frames, qint64 busyNsecs);
 };
 
 #endif // PALCOMBFILTER_H
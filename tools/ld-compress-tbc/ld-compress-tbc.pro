@@ -0,0 +1,38 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which as been marked deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# You can also make your code fail to compile if you use deprecated APIs.
+# In order to do so, uncomment the following line.
+# You can also select to disable deprecated APIs only up to a certain version of Qt.
+#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+
+SOURCES += \
+        main.cpp \
+    tbcconverter.cpp
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /usr/local/bin/
+!isEmpty(target.path): INSTALLS += target
+
+MYDLLDIR = $$IN_PWD/../library
+
+# As our header files are in the same directory, we can make Qt Creator find it
+# by specifying it as INCLUDEPATH.
+INCLUDEPATH += $$MYDLLDIR
+
+# Dependency to library domain (libdomain.so for Unices or domain.dll on Win32)
+# Repeat this for more libraries if needed.
+win32:LIBS += $$quote($$MYDLLDIR/ld-decode-shared.dll)
+ unix:LIBS += $$quote(-L$$MYDLLDIR) -lld-decode-shared
+
+HEADERS += \
+    tbcconverter.h
@@ -0,0 +1,296 @@
+/************************************************************************
+
+    tbcconverter.cpp
+
+    ld-compress-tbc - Lossless TBC compression for ld-decode
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-compress-tbc is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "tbcconverter.h"
+
+TbcConverter::TbcConverter(QObject *parent) : QObject(parent)
+{
+
+}
+
+// Compress a raw TBC file into a compressed TBC file
+bool TbcConverter::compress(QString inputFileName, QString outputFileName)
+{
+    LdDecodeMetaData ldDecodeMetaData;
+    SourceVideo sourceVideo;
+
+    // Open the source video metadata
+    if (!ldDecodeMetaData.read(inputFileName + ".json")) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+
+    // Open the source video
+    if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight, videoParameters.fieldWidth)) {
+        // Could not open source video file
+        qInfo() << "Unable to open ld-decode video file";
+        return false;
+    }
+
+    if (sourceVideo.isCompressed()) {
+        qInfo() << "The input TBC file is already compressed";
+        sourceVideo.close();
+        return false;
+    }
+
+    // Open the target video
+    QFile targetVideo(outputFileName);
+    if (!targetVideo.open(QIODevice::WriteOnly)) {
+            // Could not open target video file
+            qInfo() << "Unable to open output video file";
+            sourceVideo.close();
+            return false;
+    }
+
+    // Write a placeholder header (the index offset is not known until the fields are written)
+    TbcCodec::Header header;
+    header.fieldWidth = videoParameters.fieldWidth;
+    header.fieldHeight = videoParameters.fieldHeight;
+    header.numberOfFields = sourceVideo.getNumberOfAvailableFields();
+    header.indexOffset = 0;
+    targetVideo.write(TbcCodec::writeHeader(header));
+
+    // Compress the fields
+    QVector<qint64> fieldOffsets;
+    qint64 uncompressedBytes = 0;
+    qint64 compressedBytes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    for (qint32 fieldNumber = 1; fieldNumber <= sourceVideo.getNumberOfAvailableFields(); fieldNumber++) {
+        QSharedPointer<SourceField> sourceField = sourceVideo.getVideoField(fieldNumber);
+        if (sourceField.isNull()) {
+            qInfo() << "Reading field" << fieldNumber << "from the input video file failed";
+            targetVideo.close();
+            sourceVideo.close();
+            return false;
+        }
+
+        QByteArray fieldData = sourceField->getFieldData();
+        QByteArray compressedData = TbcCodec::compressField(fieldData, videoParameters.fieldWidth, videoParameters.fieldHeight);
+
+        fieldOffsets.append(targetVideo.pos());
+        if (compressedData.isEmpty() || targetVideo.write(compressedData) != compressedData.size()) {
+            // Could not write to target video file
+            qInfo() << "Writing to the output video file failed";
+            targetVideo.close();
+            sourceVideo.close();
+            return false;
+        }
+
+        uncompressedBytes += fieldData.size();
+        compressedBytes += compressedData.size();
+
+        // Show an update to the user
+        if ((fieldNumber % 100) == 0) {
+            qInfo() << fieldNumber << "fields compressed - ratio" << static_cast<qreal>(uncompressedBytes) / static_cast<qreal>(compressedBytes);
+        }
+    }
+    fieldOffsets.append(targetVideo.pos());
+
+    // Write the field offset index and then the real header
+    header.indexOffset = targetVideo.pos();
+    QByteArray indexData(fieldOffsets.size() * 8, 0);
+    uchar *index = reinterpret_cast<uchar *>(indexData.data());
+    for (qint32 i = 0; i < fieldOffsets.size(); i++) {
+        qToLittleEndian<quint64>(static_cast<quint64>(fieldOffsets[i]), index + (i * 8));
+    }
+
+    if (targetVideo.write(indexData) != indexData.size() || !targetVideo.seek(0) ||
+            targetVideo.write(TbcCodec::writeHeader(header)) != TbcCodec::headerSize) {
+        qInfo() << "Writing the index to the output video file failed";
+        targetVideo.close();
+        sourceVideo.close();
+        return false;
+    }
+
+    qreal totalSecs = static_cast<qreal>(timer.elapsed()) / 1000.0;
+    qInfo() << "Compression complete -" << header.numberOfFields << "fields in" << totalSecs << "seconds - ratio" <<
+               static_cast<qreal>(uncompressedBytes) / static_cast<qreal>(compressedBytes) <<
+               "(" << (static_cast<qreal>(compressedBytes) * 8.0) / (static_cast<qreal>(uncompressedBytes) / 2.0) << "bits per sample )";
+
+    // The metadata is unchanged, so copy it for the compressed file
+    ldDecodeMetaData.write(outputFileName + ".json");
+
+    sourceVideo.close();
+    targetVideo.close();
+
+    return true;
+}
+
+// Decompress a compressed TBC file into a raw TBC file
+bool TbcConverter::decompress(QString inputFileName, QString outputFileName)
+{
+    LdDecodeMetaData ldDecodeMetaData;
+    SourceVideo sourceVideo;
+
+    // Open the source video metadata
+    if (!ldDecodeMetaData.read(inputFileName + ".json")) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+
+    // Open the source video
+    if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight, videoParameters.fieldWidth)) {
+        // Could not open source video file
+        qInfo() << "Unable to open ld-decode video file";
+        return false;
+    }
+
+    if (!sourceVideo.isCompressed()) {
+        qInfo() << "The input TBC file is not compressed";
+        sourceVideo.close();
+        return false;
+    }
+
+    // Open the target video
+    QFile targetVideo(outputFileName);
+    if (!targetVideo.open(QIODevice::WriteOnly)) {
+            // Could not open target video file
+            qInfo() << "Unable to open output video file";
+            sourceVideo.close();
+            return false;
+    }
+
+    for (qint32 fieldNumber = 1; fieldNumber <= sourceVideo.getNumberOfAvailableFields(); fieldNumber++) {
+        QSharedPointer<SourceField> sourceField = sourceVideo.getVideoField(fieldNumber);
+        if (sourceField.isNull()) {
+            qInfo() << "Reading field" << fieldNumber << "from the input video file failed";
+            targetVideo.close();
+            sourceVideo.close();
+            return false;
+        }
+
+        QByteArray fieldData = sourceField->getFieldData();
+        if (targetVideo.write(fieldData.constData(), fieldData.size()) != fieldData.size()) {
+            // Could not write to target video file
+            qInfo() << "Writing to the output video file failed";
+            targetVideo.close();
+            sourceVideo.close();
+            return false;
+        }
+    }
+
+    qInfo() << "Decompression complete -" << sourceVideo.getNumberOfAvailableFields() << "fields";
+
+    // The metadata is unchanged, so copy it for the decompressed file
+    ldDecodeMetaData.write(outputFileName + ".json");
+
+    sourceVideo.close();
+    targetVideo.close();
+
+    return true;
+}
+
+// Measure the decompression throughput of a compressed TBC file (the time taken to read
+// the compressed fields is measured separately from the time taken to decompress them)
+bool TbcConverter::benchmark(QString inputFileName)
+{
+    QFile inputFile(inputFileName);
+    if (!inputFile.open(QIODevice::ReadOnly)) {
+        qInfo() << "Unable to open input video file";
+        return false;
+    }
+
+    TbcCodec::Header header;
+    QVector<qint64> fieldOffsets;
+    if (!readCompressedIndex(inputFile, header, fieldOffsets)) {
+        inputFile.close();
+        return false;
+    }
+
+    qint64 readNsecs = 0;
+    qint64 decompressNsecs = 0;
+    qint64 compressedBytes = 0;
+    qint64 uncompressedBytes = 0;
+    QByteArray fieldData;
+    QElapsedTimer timer;
+
+    for (qint32 fieldNumber = 1; fieldNumber <= header.numberOfFields; fieldNumber++) {
+        // Read the compressed field
+        timer.start();
+        qint64 fieldSize = fieldOffsets[fieldNumber] - fieldOffsets[fieldNumber - 1];
+        QByteArray compressedData;
+        if (inputFile.seek(fieldOffsets[fieldNumber - 1])) compressedData = inputFile.read(fieldSize);
+        readNsecs += timer.nsecsElapsed();
+
+        if (compressedData.size() != fieldSize) {
+            qInfo() << "Reading field" << fieldNumber << "from the input video file failed";
+            inputFile.close();
+            return false;
+        }
+
+        // Decompress the field
+        timer.start();
+        bool isValid = TbcCodec::decompressField(compressedData, header.fieldWidth, header.fieldHeight, fieldData);
+        decompressNsecs += timer.nsecsElapsed();
+
+        if (!isValid) {
+            qInfo() << "Field" << fieldNumber << "could not be decompressed";
+            inputFile.close();
+            return false;
+        }
+
+        compressedBytes += compressedData.size();
+        uncompressedBytes += fieldData.size();
+    }
+    inputFile.close();
+
+    qreal readSecs = static_cast<qreal>(readNsecs) / 1000000000.0;
+    qreal decompressSecs = static_cast<qreal>(decompressNsecs) / 1000000000.0;
+    qInfo() << "Benchmarked" << header.numberOfFields << "fields of" << header.fieldWidth << "x" << header.fieldHeight <<
+               "- compression ratio" << static_cast<qreal>(uncompressedBytes) / static_cast<qreal>(compressedBytes);
+    qInfo() << "Read:" << readSecs << "seconds (" << (static_cast<qreal>(compressedBytes) / 1048576.0) / readSecs << "MiB/s compressed )";
+    qInfo() << "Decompress:" << decompressSecs << "seconds (" << (static_cast<qreal>(uncompressedBytes) / 1048576.0) / decompressSecs <<
+               "MiB/s uncompressed," << static_cast<qreal>(header.numberOfFields) / decompressSecs << "fields/s )";
+
+    return true;
+}
+
+// Read the header and field offset index of a compressed TBC file
+bool TbcConverter::readCompressedIndex(QFile &inputFile, TbcCodec::Header &header, QVector<qint64> &fieldOffsets)
+{
+    if (!TbcCodec::readHeader(inputFile.read(TbcCodec::headerSize), header)) {
+        qInfo() << "The input video file is not a compressed TBC file";
+        return false;
+    }
+
+    QByteArray indexData;
+    if (header.numberOfFields >= 0 && inputFile.seek(header.indexOffset)) indexData = inputFile.read((header.numberOfFields + 1) * 8);
+    if (header.numberOfFields < 0 || indexData.size() != (header.numberOfFields + 1) * 8) {
+        qInfo() << "The compressed TBC index is missing or truncated";
+        return false;
+    }
+
+    const uchar *index = reinterpret_cast<const uchar *>(indexData.constData());
+    fieldOffsets.resize(header.numberOfFields + 1);
+    for (qint32 i = 0; i <= header.numberOfFields; i++) {
+        fieldOffsets[i] = static_cast<qint64>(qFromLittleEndian<quint64>(index + (i * 8)));
+    }
+
+    return true;
+}
@@ -0,0 +1,56 @@
+/************************************************************************
+
+    tbcconverter.h
+
+    ld-compress-tbc - Lossless TBC compression for ld-decode
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-compress-tbc is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef TBCCONVERTER_H
+#define TBCCONVERTER_H
+
+#include <QObject>
+#include <QFile>
+#include <QVector>
+#include <QElapsedTimer>
+#include <QtEndian>
+
+#include "sourcevideo.h"
+#include "lddecodemetadata.h"
+#include "tbccodec.h"
+
+class TbcConverter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TbcConverter(QObject *parent = nullptr);
+
+    bool compress(QString inputFileName, QString outputFileName);
+    bool decompress(QString inputFileName, QString outputFileName);
+    bool benchmark(QString inputFileName);
+
+signals:
+
+public slots:
+
+private:
+    bool readCompressedIndex(QFile &inputFile, TbcCodec::Header &header, QVector<qint64> &fieldOffsets);
+};
+
+#endif // TBCCONVERTER_H
@@ -0,0 +1,32 @@
+QT -= gui
+
+CONFIG += c++11 console
+CONFIG -= app_bundle
+
+# The following define makes your compiler emit warnings if you use
+# any feature of Qt which as been marked deprecated (the exact warnings
+# depend on your compiler). Please consult the documentation of the
+# deprecated API in order to know how to port your code away from it.
+DEFINES += QT_DEPRECATED_WARNINGS
+
+# This is a benchmark program, so it is not installed with the tools
+
+SOURCES += \
+        main.cpp \
+    tbcbenchmark.cpp \
+    metadatabenchmark.cpp
+
+MYDLLDIR = $$IN_PWD/../library
+
+# As our header files are in the same directory, we can make Qt Creator find it
+# by specifying it as INCLUDEPATH.
+INCLUDEPATH += $$MYDLLDIR
+
+# Dependency to library domain (libdomain.so for Unices or domain.dll on Win32)
+# Repeat this for more libraries if needed.
+win32:LIBS += $$quote($$MYDLLDIR/ld-decode-shared.dll)
+ unix:LIBS += $$quote(-L$$MYDLLDIR) -lld-decode-shared
+
+HEADERS += \
+    tbcbenchmark.h \
+    metadatabenchmark.h
@@ -0,0 +1,532 @@
+/************************************************************************
+
+    metadatabenchmark.cpp
+
+    ld-decode-benchmark - Benchmarks for ld-decode-tools
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-benchmark is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "metadatabenchmark.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#endif
+
+MetadataBenchmark::MetadataBenchmark(QObject *parent) : QObject(parent)
+{
+
+}
+
+// Run the benchmark for the mode ("dom", "stream", "sidecar", "accessors" or "write").  If
+// numberOfGeneratedFields is not -1, a synthetic metadata file with that many fields is written
+// instead (the memory used to write it would hide the peak of the read, so it is timed by the
+// next run)
+bool MetadataBenchmark::process(QString jsonFileName, QString outputFileName, QString modeName, qint32 numberOfGeneratedFields)
+{
+    if (modeName != "dom" && modeName != "stream" && modeName != "sidecar" && modeName != "accessors" && modeName != "write") {
+        qInfo() << "Unknown benchmark mode" << modeName;
+        return false;
+    }
+
+    if (numberOfGeneratedFields != -1) return generate(jsonFileName, numberOfGeneratedFields);
+
+    qInfo() << "Metadata file" << jsonFileName << "of" << QFileInfo(jsonFileName).size() / 1048576 << "MiB - peak RSS before reading" <<
+               getPeakRss() / 1048576 << "MiB";
+
+    if (modeName == "dom") return benchmarkDomRead(jsonFileName);
+    if (modeName == "stream") return benchmarkStreamingRead(jsonFileName);
+    if (modeName == "accessors") return benchmarkAccessors(jsonFileName);
+    if (modeName == "write") return benchmarkWrite(jsonFileName, outputFileName);
+    return benchmarkSidecarRead(jsonFileName);
+}
+
+// Write a synthetic PAL metadata file, similar to that of a CLV disc (every field has VBI
+// and VITS metadata and 0 to 40 drop-outs).  An existing file is not overwritten
+bool MetadataBenchmark::generate(QString jsonFileName, qint32 numberOfFields)
+{
+    if (QFile::exists(jsonFileName)) {
+        qInfo() << "Metadata file" << jsonFileName << "already exists - it was not replaced with synthetic metadata";
+        return false;
+    }
+
+    LdDecodeMetaData ldDecodeMetaData;
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+    videoParameters.numberOfSequentialFields = numberOfFields;
+    videoParameters.isSourcePal = true;
+    videoParameters.colourBurstStart = 98;
+    videoParameters.colourBurstEnd = 138;
+    videoParameters.blackLevelStart = 141;
+    videoParameters.blackLevelEnd = 170;
+    videoParameters.activeVideoStart = 185;
+    videoParameters.activeVideoEnd = 1107;
+    videoParameters.white16bIre = 54016;
+    videoParameters.black16bIre = 16384;
+    videoParameters.samplesPerUs = 17.734475;
+    videoParameters.fieldWidth = 1135;
+    videoParameters.fieldHeight = 313;
+    videoParameters.sampleRate = 17734475;
+    videoParameters.fsc = 4;
+    ldDecodeMetaData.setVideoParameters(videoParameters);
+
+    // A fixed pseudo-random sequence, so the same file is generated each time
+    quint32 random = 1;
+    QVector<LdDecodeMetaData::Field> fields;
+    for (qint32 fieldIndex = 0; fieldIndex < numberOfFields; fieldIndex++) {
+        LdDecodeMetaData::Field field = LdDecodeMetaData::Field();
+        field.seqNo = fieldIndex + 1;
+        field.isFirstField = (fieldIndex % 2) == 0;
+        field.syncConf = 100;
+        random = random * 1664525 + 1013904223;
+        field.medianBurstIRE = 17.25 + (random >> 8) / 16777216.0;
+        field.fieldPhaseID = (fieldIndex % 8) + 1;
+
+        field.vits.inUse = true;
+        field.vits.snr = 40.5 + (random & 0xFF) / 256.0;
+
+        field.vbi.inUse = true;
+        field.vbi.vbi16 = 8388608 + fieldIndex;
+        field.vbi.vbi17 = 15794176 + fieldIndex;
+        field.vbi.vbi18 = 15794176 + fieldIndex;
+        field.vbi.type = LdDecodeMetaData::clv;
+        field.vbi.picNo = -1;
+        field.vbi.chNo = -1;
+        field.vbi.timeCode.hr = (fieldIndex / 90000) % 24;
+        field.vbi.timeCode.min = (fieldIndex / 1500) % 60;
+        field.vbi.clvPicNo.sec = (fieldIndex / 50) % 60;
+        field.vbi.clvPicNo.picNo = (fieldIndex / 2) % 25;
+        field.vbi.statusCode.valid = true;
+        field.vbi.statusCode.cx = true;
+        field.vbi.statusCode.size = true;
+        field.vbi.statusCode.side = true;
+        field.vbi.statusCode.parity = true;
+
+        random = random * 1664525 + 1013904223;
+        qint32 numberOfDropOuts = static_cast<qint32>((random >> 16) % 41);
+        for (qint32 dropOut = 0; dropOut < numberOfDropOuts; dropOut++) {
+            random = random * 1664525 + 1013904223;
+            qint32 startx = static_cast<qint32>((random >> 8) % 1000);
+            field.dropOuts.startx.append(startx);
+            field.dropOuts.endx.append(startx + 1 + static_cast<qint32>((random >> 4) % 100));
+            field.dropOuts.fieldLine.append(1 + static_cast<qint32>((random >> 20) % 313));
+        }
+
+        fields.append(field);
+    }
+    ldDecodeMetaData.appendFields(fields);
+
+    QElapsedTimer timer;
+    timer.start();
+    if (!ldDecodeMetaData.write(jsonFileName)) {
+        qInfo() << "Unable to write the synthetic metadata file";
+        return false;
+    }
+    qInfo() << "Wrote" << numberOfFields << "synthetic fields to" << jsonFileName << "in" << timer.elapsed() / 1000.0 << "seconds";
+
+    return true;
+}
+
+// Read the file as LdDecodeMetaData::read() originally did: the whole file is read into a
+// QString, converted back to UTF-8 and parsed into a QJsonDocument.  The fields are only
+// walked rather than converted into LdDecodeMetaData::Field, so this is a lower bound
+bool MetadataBenchmark::benchmarkDomRead(QString jsonFileName)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QFile jsonFileHandle(jsonFileName);
+    if (!jsonFileHandle.open(QIODevice::ReadOnly)) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+    QString inputData = jsonFileHandle.readAll();
+    jsonFileHandle.close();
+
+    QJsonDocument jsonDocument = QJsonDocument::fromJson(inputData.toUtf8());
+    if (jsonDocument.isNull()) {
+        qInfo() << "Input JSON file could not be parsed";
+        return false;
+    }
+
+    QJsonArray fields = jsonDocument.object().value("fields").toArray();
+    qint64 numberOfDropOuts = 0;
+    for (qint32 fieldIndex = 0; fieldIndex < fields.size(); fieldIndex++) {
+        QJsonObject field = fields.at(fieldIndex).toObject();
+        numberOfDropOuts += field.value("dropOuts").toObject().value("startx").toArray().size();
+    }
+
+    showResult(QString("QJsonDocument read of %1 fields and %2 drop-outs").arg(fields.size()).arg(numberOfDropOuts), timer.nsecsElapsed());
+    return true;
+}
+
+// Read the file with LdDecodeMetaData::read(), parsing the JSON
+bool MetadataBenchmark::benchmarkStreamingRead(QString jsonFileName)
+{
+    if (isSidecarCurrent(jsonFileName)) {
+        qInfo() << "The metadata sidecar" << MetaDataSidecar::getFileName(jsonFileName) <<
+                   "would be read instead of the JSON file - remove it to time the JSON read";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    LdDecodeMetaData ldDecodeMetaData;
+    if (!ldDecodeMetaData.read(jsonFileName)) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+
+    showResult(QString("Streaming read of %1 fields and %2 drop-outs").arg(ldDecodeMetaData.getNumberOfFields())
+               .arg(ldDecodeMetaData.getDropOutStore().getNumberOfDropOuts()), timer.nsecsElapsed());
+    return true;
+}
+
+// Open the file with LdDecodeMetaData::read() from its sidecar, then decode each field on
+// request and finally load them all.  If the sidecar is missing it is written, so the
+// next run can time it
+bool MetadataBenchmark::benchmarkSidecarRead(QString jsonFileName)
+{
+    if (!isSidecarCurrent(jsonFileName)) {
+        LdDecodeMetaData ldDecodeMetaData;
+        if (!ldDecodeMetaData.read(jsonFileName) || !ldDecodeMetaData.writeSidecar(jsonFileName)) {
+            qInfo() << "Unable to write the metadata sidecar";
+            return false;
+        }
+        qInfo() << "Wrote the metadata sidecar" << MetaDataSidecar::getFileName(jsonFileName) << "- run again to time reading it";
+        return true;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    LdDecodeMetaData ldDecodeMetaData;
+    if (!ldDecodeMetaData.read(jsonFileName)) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+    showResult("Sidecar open", timer.nsecsElapsed());
+
+    timer.restart();
+    LdDecodeMetaData::Field field = ldDecodeMetaData.getField(ldDecodeMetaData.getNumberOfFields() / 2);
+    showResult(QString("Sidecar decode of field %1").arg(field.seqNo), timer.nsecsElapsed());
+
+    timer.restart();
+    qint64 numberOfDropOuts = 0;
+    for (qint32 fieldNumber = 1; fieldNumber <= ldDecodeMetaData.getNumberOfFields(); fieldNumber++) {
+        numberOfDropOuts += ldDecodeMetaData.getField(fieldNumber).dropOuts.startx.size();
+    }
+    showResult(QString("Sidecar decode of %1 fields and %2 drop-outs").arg(ldDecodeMetaData.getNumberOfFields()).arg(numberOfDropOuts),
+               timer.nsecsElapsed());
+
+    timer.restart();
+    ldDecodeMetaData.getFields();
+    showResult("Sidecar load of all fields", timer.nsecsElapsed());
+
+    return true;
+}
+
+// Time the metadata look-ups the comb filters make for each frame: the three getField()
+// copies they originally made, against the two getConstField() references they now use.
+// Then time reading every field through a range, and changing every field with
+// getField()/updateField() against getMutableField()
+bool MetadataBenchmark::benchmarkAccessors(QString jsonFileName)
+{
+    LdDecodeMetaData ldDecodeMetaData;
+    if (!ldDecodeMetaData.read(jsonFileName)) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+
+    // Load the fields first if they come from a sidecar, so that is not timed
+    ldDecodeMetaData.getFields();
+    qint32 numberOfFrames = ldDecodeMetaData.getNumberOfFrames();
+    qint32 numberOfFields = ldDecodeMetaData.getNumberOfFields();
+    if (numberOfFrames < 1) {
+        qInfo() << "There are no frames in the metadata";
+        return false;
+    }
+
+    // The sums are shown, so the look-ups cannot be optimised away
+    QElapsedTimer timer;
+    timer.start();
+    qreal copySum = 0;
+    for (qint32 frameNumber = 1; frameNumber <= numberOfFrames; frameNumber++) {
+        qint32 firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber);
+        qint32 secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber);
+        copySum += ldDecodeMetaData.getField(firstFieldNumber).medianBurstIRE;
+        copySum += ldDecodeMetaData.getField(firstFieldNumber).fieldPhaseID;
+        copySum += ldDecodeMetaData.getField(secondFieldNumber).fieldPhaseID;
+    }
+    qint64 copyNsecs = timer.nsecsElapsed();
+
+    timer.restart();
+    qreal referenceSum = 0;
+    for (qint32 frameNumber = 1; frameNumber <= numberOfFrames; frameNumber++) {
+        qint32 firstFieldNumber = ldDecodeMetaData.getFirstFieldNumber(frameNumber);
+        qint32 secondFieldNumber = ldDecodeMetaData.getSecondFieldNumber(frameNumber);
+        const LdDecodeMetaData::Field &firstField = ldDecodeMetaData.getConstField(firstFieldNumber);
+        const LdDecodeMetaData::Field &secondField = ldDecodeMetaData.getConstField(secondFieldNumber);
+        referenceSum += firstField.medianBurstIRE + firstField.fieldPhaseID + secondField.fieldPhaseID;
+    }
+    qint64 referenceNsecs = timer.nsecsElapsed();
+
+    timer.restart();
+    qreal rangeSum = 0;
+    for (const LdDecodeMetaData::Field &field : ldDecodeMetaData.getFields()) rangeSum += field.medianBurstIRE;
+    qint64 rangeNsecs = timer.nsecsElapsed();
+
+    timer.restart();
+    for (qint32 fieldNumber = 1; fieldNumber <= numberOfFields; fieldNumber++) {
+        LdDecodeMetaData::Field field = ldDecodeMetaData.getField(fieldNumber);
+        field.syncConf++;
+        ldDecodeMetaData.updateField(field, fieldNumber);
+    }
+    qint64 updateNsecs = timer.nsecsElapsed();
+
+    timer.restart();
+    for (qint32 fieldNumber = 1; fieldNumber <= numberOfFields; fieldNumber++) {
+        ldDecodeMetaData.getMutableField(fieldNumber).syncConf++;
+    }
+    qint64 mutableNsecs = timer.nsecsElapsed();
+
+    qDebug() << "MetadataBenchmark::benchmarkAccessors(): Sums" << copySum << referenceSum;
+    if (copySum != referenceSum) {
+        qInfo() << "The copying and reference accessors returned different metadata";
+        return false;
+    }
+
+    qInfo() << numberOfFrames << "frames of" << numberOfFields << "fields:";
+    qInfo() << "  getField() x3 per frame:" << static_cast<qreal>(copyNsecs) / numberOfFrames << "ns/frame";
+    qInfo() << "  getConstField() x2 per frame:" << static_cast<qreal>(referenceNsecs) / numberOfFrames << "ns/frame";
+    qInfo() << "  range iteration:" << static_cast<qreal>(rangeNsecs) / numberOfFields << "ns/field ( mean median burst" <<
+               rangeSum / numberOfFields << "IRE )";
+    qInfo() << "  getField() and updateField():" << static_cast<qreal>(updateNsecs) / numberOfFields << "ns/field";
+    qInfo() << "  getMutableField():" << static_cast<qreal>(mutableNsecs) / numberOfFields << "ns/field";
+
+    return true;
+}
+
+// Time writing the metadata with JsonStreamWriter, indented and compact, and then as the
+// original write() did.  The original path is timed last, as its peak RSS is the largest
+bool MetadataBenchmark::benchmarkWrite(QString jsonFileName, QString outputFileName)
+{
+    if (outputFileName.isEmpty()) {
+        qInfo() << "The write benchmark needs a scratch output file";
+        return false;
+    }
+
+    LdDecodeMetaData ldDecodeMetaData;
+    if (!ldDecodeMetaData.read(jsonFileName)) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+    ldDecodeMetaData.getFields();
+    qInfo() << "Read" << ldDecodeMetaData.getNumberOfFields() << "fields - peak RSS" << getPeakRss() / 1048576 << "MiB";
+
+    QElapsedTimer timer;
+    timer.start();
+    ldDecodeMetaData.setJsonFormat(JsonStreamWriter::indented);
+    if (!ldDecodeMetaData.write(outputFileName)) {
+        qInfo() << "Unable to write the output metadata file";
+        return false;
+    }
+    showResult(QString("JsonStreamWriter indented (%1 MiB)").arg(QFileInfo(outputFileName).size() / 1048576), timer.nsecsElapsed());
+
+    timer.restart();
+    ldDecodeMetaData.setJsonFormat(JsonStreamWriter::compact);
+    if (!ldDecodeMetaData.write(outputFileName)) {
+        qInfo() << "Unable to write the output metadata file";
+        return false;
+    }
+    showResult(QString("JsonStreamWriter compact (%1 MiB)").arg(QFileInfo(outputFileName).size() / 1048576), timer.nsecsElapsed());
+
+    timer.restart();
+    if (!writeJsonDocument(ldDecodeMetaData, outputFileName)) return false;
+    showResult(QString("QJsonDocument indented (%1 MiB)").arg(QFileInfo(outputFileName).size() / 1048576), timer.nsecsElapsed());
+
+    QFile::remove(outputFileName);
+    return true;
+}
+
+// Write the metadata as the original LdDecodeMetaData::write() did: the whole file is built
+// as a QJsonObject tree, converted with QJsonDocument::toJson() and then written
+bool MetadataBenchmark::writeJsonDocument(LdDecodeMetaData &ldDecodeMetaData, QString outputFileName)
+{
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+    QJsonObject jsonVideoParameters;
+    jsonVideoParameters.insert("numberOfSequentialFields", videoParameters.numberOfSequentialFields);
+    jsonVideoParameters.insert("isSourcePal", videoParameters.isSourcePal);
+    jsonVideoParameters.insert("colourBurstStart", videoParameters.colourBurstStart);
+    jsonVideoParameters.insert("colourBurstEnd", videoParameters.colourBurstEnd);
+    jsonVideoParameters.insert("blackLevelStart", videoParameters.blackLevelStart);
+    jsonVideoParameters.insert("blackLevelEnd", videoParameters.blackLevelEnd);
+    jsonVideoParameters.insert("activeVideoStart", videoParameters.activeVideoStart);
+    jsonVideoParameters.insert("activeVideoEnd", videoParameters.activeVideoEnd);
+    jsonVideoParameters.insert("white16bIre", videoParameters.white16bIre);
+    jsonVideoParameters.insert("black16bIre", videoParameters.black16bIre);
+    jsonVideoParameters.insert("samplesPerUs", videoParameters.samplesPerUs);
+    jsonVideoParameters.insert("fieldWidth", videoParameters.fieldWidth);
+    jsonVideoParameters.insert("fieldHeight", videoParameters.fieldHeight);
+    jsonVideoParameters.insert("sampleRate", videoParameters.sampleRate);
+    jsonVideoParameters.insert("fsc", videoParameters.fsc);
+
+    LdDecodeMetaData::PcmAudioParameters pcmAudioParameters = ldDecodeMetaData.getPcmAudioParameters();
+    QJsonObject jsonPcmAudioParameters;
+    jsonPcmAudioParameters.insert("sampleRate", pcmAudioParameters.sampleRate);
+    jsonPcmAudioParameters.insert("isLittleEndian", pcmAudioParameters.isLittleEndian);
+    jsonPcmAudioParameters.insert("isSigned", pcmAudioParameters.isSigned);
+    jsonPcmAudioParameters.insert("bits", pcmAudioParameters.bits);
+
+    QJsonArray fields;
+    for (qint32 fieldNumber = 1; fieldNumber <= ldDecodeMetaData.getNumberOfFields(); fieldNumber++) {
+        LdDecodeMetaData::Field fieldData = ldDecodeMetaData.getField(fieldNumber);
+        QJsonObject field;
+        field.insert("seqNo", fieldData.seqNo);
+        field.insert("isFirstField", fieldData.isFirstField);
+        field.insert("syncConf", fieldData.syncConf);
+        field.insert("medianBurstIRE", fieldData.medianBurstIRE);
+        field.insert("fieldPhaseID", fieldData.fieldPhaseID);
+
+        if (fieldData.vits.inUse) {
+            QJsonObject vits;
+            vits.insert("snr", fieldData.vits.snr);
+            field.insert("vits", vits);
+        }
+
+        if (fieldData.vbi.inUse) {
+            QJsonObject vbi;
+            vbi.insert("vbi16", fieldData.vbi.vbi16);
+            vbi.insert("vbi17", fieldData.vbi.vbi17);
+            vbi.insert("vbi18", fieldData.vbi.vbi18);
+            vbi.insert("type", static_cast<qint32>(fieldData.vbi.type));
+            vbi.insert("leadIn", fieldData.vbi.leadIn);
+            vbi.insert("leadOut", fieldData.vbi.leadOut);
+            vbi.insert("userCode", fieldData.vbi.userCode);
+            vbi.insert("picNo", fieldData.vbi.picNo);
+            vbi.insert("picStop", fieldData.vbi.picStop);
+            vbi.insert("chNo", fieldData.vbi.chNo);
+
+            QJsonObject timeCode;
+            timeCode.insert("hr", fieldData.vbi.timeCode.hr);
+            timeCode.insert("min", fieldData.vbi.timeCode.min);
+            vbi.insert("timeCode", timeCode);
+
+            QJsonObject statusCode;
+            statusCode.insert("valid", fieldData.vbi.statusCode.valid);
+            statusCode.insert("cx", fieldData.vbi.statusCode.cx);
+            statusCode.insert("size", fieldData.vbi.statusCode.size);
+            statusCode.insert("side", fieldData.vbi.statusCode.side);
+            statusCode.insert("teletext", fieldData.vbi.statusCode.teletext);
+            statusCode.insert("dump", fieldData.vbi.statusCode.dump);
+            statusCode.insert("fm", fieldData.vbi.statusCode.fm);
+            statusCode.insert("digital", fieldData.vbi.statusCode.digital);
+            statusCode.insert("soundMode", static_cast<qint32>(fieldData.vbi.statusCode.soundMode));
+            statusCode.insert("parity", fieldData.vbi.statusCode.parity);
+            vbi.insert("statusCode", statusCode);
+
+            QJsonObject statusCodeAm2;
+            statusCodeAm2.insert("valid", fieldData.vbi.statusCodeAm2.valid);
+            statusCodeAm2.insert("cx", fieldData.vbi.statusCodeAm2.cx);
+            statusCodeAm2.insert("size", fieldData.vbi.statusCodeAm2.size);
+            statusCodeAm2.insert("side", fieldData.vbi.statusCodeAm2.side);
+            statusCodeAm2.insert("teletext", fieldData.vbi.statusCodeAm2.teletext);
+            statusCodeAm2.insert("copy", fieldData.vbi.statusCodeAm2.copy);
+            statusCodeAm2.insert("standard", fieldData.vbi.statusCodeAm2.standard);
+            statusCodeAm2.insert("soundMode", static_cast<qint32>(fieldData.vbi.statusCodeAm2.soundMode));
+            vbi.insert("statusCodeAm2", statusCodeAm2);
+
+            QJsonObject clvPicNo;
+            clvPicNo.insert("sec", fieldData.vbi.clvPicNo.sec);
+            clvPicNo.insert("picNo", fieldData.vbi.clvPicNo.picNo);
+            vbi.insert("clvPicNo", clvPicNo);
+
+            field.insert("vbi", vbi);
+        }
+
+        if (fieldData.ntsc.inUse) {
+            QJsonObject ntsc;
+            ntsc.insert("isFmCodeDataValid", fieldData.ntsc.isFmCodeDataValid);
+            ntsc.insert("fmCodeData", fieldData.ntsc.isFmCodeDataValid ? fieldData.ntsc.fmCodeData : -1);
+            ntsc.insert("fieldFlag", fieldData.ntsc.fieldFlag);
+            ntsc.insert("whiteFlag", fieldData.ntsc.whiteFlag);
+            field.insert("ntsc", ntsc);
+        }
+
+        if (fieldData.dropOuts.startx.size() != 0) {
+            QJsonObject dropOuts;
+            QJsonArray startx;
+            QJsonArray endx;
+            QJsonArray fieldLine;
+            for (qint32 doCounter = 0; doCounter < fieldData.dropOuts.startx.size(); doCounter++) {
+                startx.append(fieldData.dropOuts.startx[doCounter]);
+                endx.append(fieldData.dropOuts.endx[doCounter]);
+                fieldLine.append(fieldData.dropOuts.fieldLine[doCounter]);
+            }
+            dropOuts.insert("startx", startx);
+            dropOuts.insert("endx", endx);
+            dropOuts.insert("fieldLine", fieldLine);
+            field.insert("dropOuts", dropOuts);
+        }
+
+        fields.append(field);
+    }
+
+    QJsonObject lddecodeJson;
+    lddecodeJson.insert("videoParameters", jsonVideoParameters);
+    lddecodeJson.insert("pcmAudioParameters", jsonPcmAudioParameters);
+    lddecodeJson.insert("fields", fields);
+    QJsonDocument document(lddecodeJson);
+
+    QFile jsonFileHandle(outputFileName);
+    if (!jsonFileHandle.open(QIODevice::WriteOnly)) {
+        qInfo() << "Unable to write the output metadata file";
+        return false;
+    }
+    jsonFileHandle.write(document.toJson(QJsonDocument::Indented));
+    jsonFileHandle.close();
+
+    return true;
+}
+
+// Check if LdDecodeMetaData::read() would use the sidecar of the JSON file
+bool MetadataBenchmark::isSidecarCurrent(QString jsonFileName)
+{
+    MetaDataSidecar sidecar;
+    bool isCurrent = sidecar.open(MetaDataSidecar::getFileName(jsonFileName), jsonFileName);
+    sidecar.close();
+
+    return isCurrent;
+}
+
+void MetadataBenchmark::showResult(QString name, qint64 nsecs)
+{
+    qint64 peakRss = getPeakRss();
+    qInfo().noquote() << name + ":" << static_cast<qreal>(nsecs) / 1000000.0 << "ms -" <<
+                         (peakRss < 0 ? QString("peak RSS not known") : QString("peak RSS %1 MiB").arg(peakRss / 1048576));
+}
+
+// Get the peak resident set size of the process in bytes (-1 if not known)
+qint64 MetadataBenchmark::getPeakRss(void)
+{
+#ifdef Q_OS_LINUX
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return -1;
+    return static_cast<qint64>(usage.ru_maxrss) * 1024;
+#else
+    return -1;
+#endif
+}
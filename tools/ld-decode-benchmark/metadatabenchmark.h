@@ -0,0 +1,77 @@
+/************************************************************************
+
+    metadatabenchmark.h
+
+    ld-decode-benchmark - Benchmarks for ld-decode-tools
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-benchmark is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef METADATABENCHMARK_H
+#define METADATABENCHMARK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDebug>
+
+#include "lddecodemetadata.h"
+#include "metadatasidecar.h"
+
+// Times opening a JSON metadata file, and shows the peak resident set size afterwards
+// (Linux only).  The peak cannot go down again, so each read path is timed in a process of
+// its own (--mode):
+//   dom     - the QJsonDocument read that LdDecodeMetaData::read() originally used
+//   stream  - LdDecodeMetaData::read() parsing the JSON file
+//   sidecar - LdDecodeMetaData::read() opening the binary sidecar, then the fields decoded
+//             on request and loaded into memory
+// The accessors mode times the per-frame metadata look-ups of the comb filters, and a
+// change to every field, with the copying and the reference accessors.  The write mode
+// times writing the metadata to a scratch file with JsonStreamWriter (indented and compact)
+// and then with the QJsonDocument tree that LdDecodeMetaData::write() originally built
+class MetadataBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetadataBenchmark(QObject *parent = nullptr);
+    bool process(QString jsonFileName, QString outputFileName, QString modeName, qint32 numberOfGeneratedFields);
+
+signals:
+
+public slots:
+
+private slots:
+
+private:
+    bool generate(QString jsonFileName, qint32 numberOfFields);
+    bool benchmarkDomRead(QString jsonFileName);
+    bool benchmarkStreamingRead(QString jsonFileName);
+    bool benchmarkSidecarRead(QString jsonFileName);
+    bool benchmarkAccessors(QString jsonFileName);
+    bool benchmarkWrite(QString jsonFileName, QString outputFileName);
+    bool writeJsonDocument(LdDecodeMetaData &ldDecodeMetaData, QString outputFileName);
+    bool isSidecarCurrent(QString jsonFileName);
+    void showResult(QString name, qint64 nsecs);
+    static qint64 getPeakRss(void);
+};
+
+#endif // METADATABENCHMARK_H
@@ -0,0 +1,249 @@
+/************************************************************************
+
+    tbcbenchmark.cpp
+
+    ld-decode-benchmark - Benchmarks for ld-decode-tools
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-benchmark is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "tbcbenchmark.h"
+
+#ifdef Q_OS_LINUX
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+TbcBenchmark::TbcBenchmark(QObject *parent) : QObject(parent)
+{
+    fieldLength = 0;
+    fieldWidth = 0;
+}
+
+// Run the benchmarks for the mode ("all", "qfile", "mapped", "read" or "scan").  Each pass
+// after the first finds the file in the page cache unless the earlier pass released it (or
+// the file is larger than memory), so for cold cache figures run each mode separately and
+// drop the page cache in between
+bool TbcBenchmark::process(QString inputFileName, QString outputFileName, QString modeName)
+{
+    LdDecodeMetaData ldDecodeMetaData;
+    if (!ldDecodeMetaData.read(inputFileName + ".json")) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+    fieldLength = videoParameters.fieldWidth * videoParameters.fieldHeight;
+    fieldWidth = videoParameters.fieldWidth;
+
+    bool isAll = (modeName == "all");
+    if (!isAll && modeName != "qfile" && modeName != "mapped" && modeName != "read" && modeName != "scan") {
+        qInfo() << "Unknown benchmark mode" << modeName;
+        return false;
+    }
+
+    qInfo() << "Input file" << inputFileName << "- page cache holding" << getCachedBytes(inputFileName) / 1048576 << "MiB of it";
+
+    if ((isAll || modeName == "qfile") && !benchmarkQFileRead(inputFileName)) return false;
+    if ((isAll || modeName == "mapped") && !benchmarkSourceVideoRead(inputFileName, true, false)) return false;
+    if ((isAll || modeName == "read") && !benchmarkSourceVideoRead(inputFileName, false, false)) return false;
+    if ((isAll || modeName == "scan") && !benchmarkSourceVideoRead(inputFileName, false, true)) return false;
+
+    if (!outputFileName.isEmpty()) {
+        qint32 numberOfFields = ldDecodeMetaData.getNumberOfFields();
+        if ((isAll || modeName == "qfile") && !benchmarkQFileWrite(outputFileName, numberOfFields)) return false;
+        if ((isAll || modeName == "mapped" || modeName == "read") && !benchmarkOutputWriter(outputFileName, numberOfFields, false)) return false;
+        if ((isAll || modeName == "scan") && !benchmarkOutputWriter(outputFileName, numberOfFields, true)) return false;
+        QFile::remove(outputFileName);
+    }
+
+    return true;
+}
+
+// Read every field with a QFile seek and read (the original SourceVideo read path)
+bool TbcBenchmark::benchmarkQFileRead(QString inputFileName)
+{
+    QFile inputFile(inputFileName);
+    if (!inputFile.open(QIODevice::ReadOnly)) {
+        qInfo() << "Unable to open ld-decode video file";
+        return false;
+    }
+
+    qint64 fieldBytes = static_cast<qint64>(fieldLength) * 2;
+    qint32 numberOfFields = static_cast<qint32>(inputFile.size() / fieldBytes);
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 bytesRead = 0;
+    for (qint32 fieldNumber = 1; fieldNumber <= numberOfFields; fieldNumber++) {
+        if (!inputFile.seek((fieldNumber - 1) * fieldBytes)) break;
+        QByteArray fieldData = inputFile.read(fieldBytes);
+        if (fieldData.size() != fieldBytes) break;
+        bytesRead += fieldData.size();
+    }
+    qint64 nsecs = timer.nsecsElapsed();
+    inputFile.close();
+
+    showResult("Read, QFile per field", numberOfFields, bytesRead, nsecs, inputFileName);
+    return true;
+}
+
+// Read every field through SourceVideo (memory mapped, with read() or in scan mode)
+bool TbcBenchmark::benchmarkSourceVideoRead(QString inputFileName, bool isMemoryMappingSet, bool isScanModeSet)
+{
+    SourceVideo sourceVideo;
+    sourceVideo.setMemoryMapping(isMemoryMappingSet);
+    sourceVideo.setScanMode(isScanModeSet);
+    if (!sourceVideo.open(inputFileName, fieldLength, fieldWidth)) {
+        qInfo() << "Unable to open ld-decode video file";
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    qint64 bytesRead = 0;
+    for (qint32 fieldNumber = 1; fieldNumber <= sourceVideo.getNumberOfAvailableFields(); fieldNumber++) {
+        QSharedPointer<SourceField> sourceField = sourceVideo.getVideoField(fieldNumber);
+        if (sourceField.isNull()) {
+            qInfo() << "Reading field" << fieldNumber << "from the input video file failed";
+            sourceVideo.close();
+            return false;
+        }
+
+        // Touch the data, so a memory mapped field is read from the file as well
+        const QByteArray fieldData = sourceField->getFieldData();
+        volatile char firstByte = fieldData.constData()[0];
+        Q_UNUSED(firstByte);
+        bytesRead += fieldData.size();
+    }
+    qint64 nsecs = timer.nsecsElapsed();
+    qint32 numberOfFields = sourceVideo.getNumberOfAvailableFields();
+    bool isMapped = sourceVideo.isMemoryMapped();
+    sourceVideo.close();
+
+    QString name = isScanModeSet ? "Read, SourceVideo scan mode" : (isMapped ? "Read, SourceVideo memory mapped" : "Read, SourceVideo read()");
+    showResult(name, numberOfFields, bytesRead, nsecs, inputFileName);
+    return true;
+}
+
+// Write the fields with a QFile write per field
+bool TbcBenchmark::benchmarkQFileWrite(QString outputFileName, qint32 numberOfFields)
+{
+    QFile outputFile(outputFileName);
+    if (!outputFile.open(QIODevice::WriteOnly)) {
+        qInfo() << "Unable to open output video file";
+        return false;
+    }
+
+    QByteArray fieldData(fieldLength * 2, 0);
+    QElapsedTimer timer;
+    timer.start();
+    for (qint32 fieldNumber = 1; fieldNumber <= numberOfFields; fieldNumber++) {
+        if (outputFile.write(fieldData) != fieldData.size()) {
+            qInfo() << "Writing to the output video file failed";
+            return false;
+        }
+    }
+    outputFile.close();
+    qint64 nsecs = timer.nsecsElapsed();
+
+    showResult("Write, QFile per field", numberOfFields, static_cast<qint64>(numberOfFields) * fieldData.size(), nsecs, outputFileName);
+    return true;
+}
+
+// Write the fields with OutputWriter (with or without scan mode)
+bool TbcBenchmark::benchmarkOutputWriter(QString outputFileName, qint32 numberOfFields, bool isScanModeSet)
+{
+    OutputWriter outputWriter;
+    outputWriter.setScanMode(isScanModeSet);
+    if (!outputWriter.open(outputFileName, fieldLength * 2)) {
+        qInfo() << "Unable to open output video file";
+        return false;
+    }
+
+    QByteArray fieldData(fieldLength * 2, 0);
+    QElapsedTimer timer;
+    timer.start();
+    for (qint32 fieldNumber = 1; fieldNumber <= numberOfFields; fieldNumber++) {
+        if (!outputWriter.write(fieldData)) break;
+    }
+    if (!outputWriter.close()) {
+        qInfo() << "Writing to the output video file failed";
+        return false;
+    }
+    qint64 nsecs = timer.nsecsElapsed();
+
+    showResult(isScanModeSet ? "Write, OutputWriter scan mode" : "Write, OutputWriter", numberOfFields,
+               outputWriter.getStatistics().bytesWritten, nsecs, outputFileName);
+    return true;
+}
+
+void TbcBenchmark::showResult(QString name, qint32 numberOfFields, qint64 bytes, qint64 nsecs, QString fileName)
+{
+    qreal totalSecs = static_cast<qreal>(nsecs) / 1000000000.0;
+    qreal totalMiB = static_cast<qreal>(bytes) / 1048576.0;
+    qreal mibPerSec = (totalSecs > 0) ? totalMiB / totalSecs : 0;
+    qint64 cachedBytes = getCachedBytes(fileName);
+
+    qInfo().noquote() << name + ":" << numberOfFields << "fields," << totalMiB << "MiB in" << totalSecs << "seconds (" <<
+                         mibPerSec << "MiB/s ) -" <<
+                         (cachedBytes < 0 ? QString("page cache not known") :
+                                            QString("%1 MiB left in the page cache").arg(cachedBytes / 1048576));
+}
+
+// Get the number of bytes of a file held in the page cache (-1 if not known)
+qint64 TbcBenchmark::getCachedBytes(QString fileName)
+{
+#ifdef Q_OS_LINUX
+    int fd = ::open(QFile::encodeName(fileName).constData(), O_RDONLY);
+    if (fd < 0) return -1;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    if (fileStat.st_size == 0) {
+        ::close(fd);
+        return 0;
+    }
+
+    void *mapping = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return -1;
+
+    qint64 pageSize = sysconf(_SC_PAGESIZE);
+    qint64 pages = (fileStat.st_size + pageSize - 1) / pageSize;
+    QVector<unsigned char> residency(static_cast<qint32>(pages));
+    qint64 cachedBytes = -1;
+    if (mincore(mapping, static_cast<size_t>(fileStat.st_size), residency.data()) == 0) {
+        cachedBytes = 0;
+        for (qint32 page = 0; page < residency.size(); page++) {
+            if (residency[page] & 1) cachedBytes += pageSize;
+        }
+    }
+    munmap(mapping, static_cast<size_t>(fileStat.st_size));
+
+    return cachedBytes;
+#else
+    Q_UNUSED(fileName);
+    return -1;
+#endif
+}
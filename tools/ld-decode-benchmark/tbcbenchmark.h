@@ -0,0 +1,67 @@
+/************************************************************************
+
+    tbcbenchmark.h
+
+    ld-decode-benchmark - Benchmarks for ld-decode-tools
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-benchmark is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef TBCBENCHMARK_H
+#define TBCBENCHMARK_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QDebug>
+
+#include "sourcevideo.h"
+#include "outputwriter.h"
+#include "lddecodemetadata.h"
+
+// Times a sequential pass over a TBC file with each of the SourceVideo read modes, and with
+// the QFile seek and read per field that SourceVideo originally used.  If an output file is
+// given, the same amount of data is also written with OutputWriter (with and without scan
+// mode) and with QFile.  The page cache left holding the file after each pass is shown too
+// (Linux only), as that is what scan mode is for
+class TbcBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TbcBenchmark(QObject *parent = nullptr);
+    bool process(QString inputFileName, QString outputFileName, QString modeName);
+
+signals:
+
+public slots:
+
+private slots:
+
+private:
+    qint32 fieldLength;
+    qint32 fieldWidth;
+
+    bool benchmarkQFileRead(QString inputFileName);
+    bool benchmarkSourceVideoRead(QString inputFileName, bool isMemoryMappingSet, bool isScanModeSet);
+    bool benchmarkQFileWrite(QString outputFileName, qint32 numberOfFields);
+    bool benchmarkOutputWriter(QString outputFileName, qint32 numberOfFields, bool isScanModeSet);
+    void showResult(QString name, qint32 numberOfFields, qint64 bytes, qint64 nsecs, QString fileName);
+    static qint64 getCachedBytes(QString fileName);
+};
+
+#endif // TBCBENCHMARK_H
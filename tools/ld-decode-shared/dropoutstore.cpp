@@ -0,0 +1,268 @@
+/************************************************************************
+
+    dropoutstore.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "dropoutstore.h"
+
+namespace {
+    // The columns are not compacted until there are at least this many unused entries
+    const qint32 minimumUnusedEntries = 65536;
+}
+
+// DropOutSpan --------------------------------------------------------------------------------
+
+DropOutSpan::DropOutSpan()
+{
+    startxData = nullptr;
+    endxData = nullptr;
+    fieldLineData = nullptr;
+    count = 0;
+}
+
+DropOutSpan::DropOutSpan(const qint32 *startxParam, const qint32 *endxParam, const qint32 *fieldLineParam, qint32 countParam)
+{
+    startxData = startxParam;
+    endxData = endxParam;
+    fieldLineData = fieldLineParam;
+    count = countParam;
+}
+
+qint32 DropOutSpan::size(void) const
+{
+    return count;
+}
+
+bool DropOutSpan::isEmpty(void) const
+{
+    return count == 0;
+}
+
+qint32 DropOutSpan::startx(qint32 index) const
+{
+    return startxData[index];
+}
+
+qint32 DropOutSpan::endx(qint32 index) const
+{
+    return endxData[index];
+}
+
+qint32 DropOutSpan::fieldLine(qint32 index) const
+{
+    return fieldLineData[index];
+}
+
+const qint32 *DropOutSpan::constStartx(void) const
+{
+    return startxData;
+}
+
+const qint32 *DropOutSpan::constEndx(void) const
+{
+    return endxData;
+}
+
+const qint32 *DropOutSpan::constFieldLine(void) const
+{
+    return fieldLineData;
+}
+
+// DropOutStore -------------------------------------------------------------------------------
+
+DropOutStore::DropOutStore()
+{
+    numberOfUnusedEntries = 0;
+}
+
+// Remove all of the fields and drop-outs
+void DropOutStore::clear(void)
+{
+    startxColumn.clear();
+    endxColumn.clear();
+    fieldLineColumn.clear();
+    fieldOffsets.clear();
+    fieldCounts.clear();
+    numberOfUnusedEntries = 0;
+}
+
+// Set the number of fields (added fields have no drop-outs)
+void DropOutStore::resize(qint32 numberOfFields)
+{
+    for (qint32 fieldIndex = numberOfFields; fieldIndex < fieldCounts.size(); fieldIndex++) {
+        numberOfUnusedEntries += fieldCounts[fieldIndex];
+    }
+
+    qint32 previousNumberOfFields = fieldCounts.size();
+    fieldOffsets.resize(numberOfFields);
+    fieldCounts.resize(numberOfFields);
+    for (qint32 fieldIndex = previousNumberOfFields; fieldIndex < numberOfFields; fieldIndex++) {
+        fieldOffsets[fieldIndex] = 0;
+        fieldCounts[fieldIndex] = 0;
+    }
+}
+
+// Compact the columns, so the drop-outs are stored in field order with no unused entries
+void DropOutStore::squeeze(void)
+{
+    if (numberOfUnusedEntries == 0) return;
+
+    qint32 numberOfDropOuts = getNumberOfDropOuts();
+    QVector<qint32> newStartx(numberOfDropOuts);
+    QVector<qint32> newEndx(numberOfDropOuts);
+    QVector<qint32> newFieldLine(numberOfDropOuts);
+
+    qint32 offset = 0;
+    for (qint32 fieldIndex = 0; fieldIndex < fieldCounts.size(); fieldIndex++) {
+        qint32 count = fieldCounts[fieldIndex];
+        qint32 oldOffset = fieldOffsets[fieldIndex];
+        for (qint32 i = 0; i < count; i++) {
+            newStartx[offset + i] = startxColumn[oldOffset + i];
+            newEndx[offset + i] = endxColumn[oldOffset + i];
+            newFieldLine[offset + i] = fieldLineColumn[oldOffset + i];
+        }
+        fieldOffsets[fieldIndex] = offset;
+        offset += count;
+    }
+
+    startxColumn.swap(newStartx);
+    endxColumn.swap(newEndx);
+    fieldLineColumn.swap(newFieldLine);
+    numberOfUnusedEntries = 0;
+}
+
+qint32 DropOutStore::getNumberOfFields(void) const
+{
+    return fieldCounts.size();
+}
+
+// Get the total number of drop-outs of all fields
+qint32 DropOutStore::getNumberOfDropOuts(void) const
+{
+    return startxColumn.size() - numberOfUnusedEntries;
+}
+
+qint32 DropOutStore::getNumberOfDropOuts(qint32 fieldIndex) const
+{
+    if (fieldIndex < 0 || fieldIndex >= fieldCounts.size()) return 0;
+    return fieldCounts[fieldIndex];
+}
+
+// Get a view of the drop-outs of a field (an empty view if the field does not exist)
+DropOutSpan DropOutStore::getDropOuts(qint32 fieldIndex) const
+{
+    if (fieldIndex < 0 || fieldIndex >= fieldCounts.size() || fieldCounts[fieldIndex] == 0) return DropOutSpan();
+
+    qint32 offset = fieldOffsets[fieldIndex];
+    return DropOutSpan(startxColumn.constData() + offset, endxColumn.constData() + offset,
+                       fieldLineColumn.constData() + offset, fieldCounts[fieldIndex]);
+}
+
+// Replace the drop-outs of a field (the field is added if the store has too few fields)
+void DropOutStore::setDropOuts(qint32 fieldIndex, const qint32 *startx, const qint32 *endx, const qint32 *fieldLine, qint32 count)
+{
+    if (fieldIndex < 0) {
+        qWarning() << "DropOutStore::setDropOuts(): Field index" << fieldIndex << "is out of range";
+        return;
+    }
+    if (fieldIndex >= fieldCounts.size()) resize(fieldIndex + 1);
+
+    // Reuse the existing entries of the field if the drop-outs fit, otherwise add them to
+    // the end of the columns
+    qint32 offset = fieldOffsets[fieldIndex];
+    if (count > fieldCounts[fieldIndex]) {
+        numberOfUnusedEntries += fieldCounts[fieldIndex];
+        offset = startxColumn.size();
+        startxColumn.resize(offset + count);
+        endxColumn.resize(offset + count);
+        fieldLineColumn.resize(offset + count);
+    } else {
+        numberOfUnusedEntries += fieldCounts[fieldIndex] - count;
+    }
+
+    qint32 *startxTarget = startxColumn.data() + offset;
+    qint32 *endxTarget = endxColumn.data() + offset;
+    qint32 *fieldLineTarget = fieldLineColumn.data() + offset;
+    for (qint32 i = 0; i < count; i++) {
+        startxTarget[i] = startx[i];
+        endxTarget[i] = endx[i];
+        fieldLineTarget[i] = fieldLine[i];
+    }
+
+    fieldOffsets[fieldIndex] = offset;
+    fieldCounts[fieldIndex] = count;
+
+    if (numberOfUnusedEntries > minimumUnusedEntries && numberOfUnusedEntries > getNumberOfDropOuts()) squeeze();
+}
+
+void DropOutStore::setDropOuts(qint32 fieldIndex, const QVector<qint32> &startx, const QVector<qint32> &endx, const QVector<qint32> &fieldLine)
+{
+    if (endx.size() != startx.size() || fieldLine.size() != startx.size()) {
+        qWarning() << "DropOutStore::setDropOuts(): Drop-out columns for field index" << fieldIndex << "have different sizes";
+        return;
+    }
+
+    setDropOuts(fieldIndex, startx.constData(), endx.constData(), fieldLine.constData(), startx.size());
+}
+
+void DropOutStore::clearDropOuts(qint32 fieldIndex)
+{
+    if (fieldIndex < 0 || fieldIndex >= fieldCounts.size()) return;
+
+    numberOfUnusedEntries += fieldCounts[fieldIndex];
+    fieldCounts[fieldIndex] = 0;
+}
+
+// Add a field to the end of the store
+void DropOutStore::appendField(const QVector<qint32> &startx, const QVector<qint32> &endx, const QVector<qint32> &fieldLine)
+{
+    qint32 fieldIndex = fieldCounts.size();
+    resize(fieldIndex + 1);
+    setDropOuts(fieldIndex, startx, endx, fieldLine);
+}
+
+// Replace the whole store.  The columns hold the drop-outs of every field in field order,
+// and fieldCounts holds the number of drop-outs of each field (returns false if the
+// columns and counts do not match)
+bool DropOutStore::setAllDropOuts(const QVector<qint32> &startx, const QVector<qint32> &endx, const QVector<qint32> &fieldLine,
+                                  const QVector<qint32> &fieldCountsParam)
+{
+    if (endx.size() != startx.size() || fieldLine.size() != startx.size()) return false;
+
+    QVector<qint32> newFieldOffsets(fieldCountsParam.size());
+    qint32 offset = 0;
+    for (qint32 fieldIndex = 0; fieldIndex < fieldCountsParam.size(); fieldIndex++) {
+        if (fieldCountsParam[fieldIndex] < 0) return false;
+        newFieldOffsets[fieldIndex] = offset;
+        offset += fieldCountsParam[fieldIndex];
+    }
+    if (offset != startx.size()) return false;
+
+    startxColumn = startx;
+    endxColumn = endx;
+    fieldLineColumn = fieldLine;
+    fieldOffsets.swap(newFieldOffsets);
+    fieldCounts = fieldCountsParam;
+    numberOfUnusedEntries = 0;
+
+    return true;
+}
@@ -0,0 +1,97 @@
+/************************************************************************
+
+    dropoutstore.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef DROPOUTSTORE_H
+#define DROPOUTSTORE_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QVector>
+#include <QDebug>
+
+// A read-only view of the drop-outs of one field.  The view points into the DropOutStore
+// it came from, so it is only valid until the store is next changed
+class LDDECODESHAREDSHARED_EXPORT DropOutSpan
+{
+public:
+    DropOutSpan();
+    DropOutSpan(const qint32 *startxParam, const qint32 *endxParam, const qint32 *fieldLineParam, qint32 countParam);
+
+    qint32 size(void) const;
+    bool isEmpty(void) const;
+
+    qint32 startx(qint32 index) const;
+    qint32 endx(qint32 index) const;
+    qint32 fieldLine(qint32 index) const;
+
+    const qint32 *constStartx(void) const;
+    const qint32 *constEndx(void) const;
+    const qint32 *constFieldLine(void) const;
+
+private:
+    const qint32 *startxData;
+    const qint32 *endxData;
+    const qint32 *fieldLineData;
+    qint32 count;
+};
+
+// Disc-wide drop-out table.  The drop-outs of every field are held in three columns
+// (startx, endx and fieldLine), with the offset and number of drop-outs of each field, so
+// the drop-outs of a field can be read without copying.  Field indexes are zero-based.
+//
+// Replacing the drop-outs of a field reuses its place in the columns if they fit, otherwise
+// they are added to the end of the columns; the columns are compacted when more than half
+// of the entries are unused
+class LDDECODESHAREDSHARED_EXPORT DropOutStore
+{
+public:
+    DropOutStore();
+
+    void clear(void);
+    void resize(qint32 numberOfFields);
+    void squeeze(void);
+
+    qint32 getNumberOfFields(void) const;
+    qint32 getNumberOfDropOuts(void) const;
+    qint32 getNumberOfDropOuts(qint32 fieldIndex) const;
+    DropOutSpan getDropOuts(qint32 fieldIndex) const;
+
+    void setDropOuts(qint32 fieldIndex, const qint32 *startx, const qint32 *endx, const qint32 *fieldLine, qint32 count);
+    void setDropOuts(qint32 fieldIndex, const QVector<qint32> &startx, const QVector<qint32> &endx, const QVector<qint32> &fieldLine);
+    void clearDropOuts(qint32 fieldIndex);
+    void appendField(const QVector<qint32> &startx, const QVector<qint32> &endx, const QVector<qint32> &fieldLine);
+
+    bool setAllDropOuts(const QVector<qint32> &startx, const QVector<qint32> &endx, const QVector<qint32> &fieldLine,
+                        const QVector<qint32> &fieldCounts);
+
+private:
+    QVector<qint32> startxColumn;
+    QVector<qint32> endxColumn;
+    QVector<qint32> fieldLineColumn;
+    QVector<qint32> fieldOffsets;
+    QVector<qint32> fieldCounts;
+    qint32 numberOfUnusedEntries;
+};
+
+#endif // DROPOUTSTORE_H
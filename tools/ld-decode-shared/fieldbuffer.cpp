@@ -0,0 +1,162 @@
+/************************************************************************
+
+    fieldbuffer.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "fieldbuffer.h"
+
+QAtomicInt FieldBuffer::allocationCount(0);
+
+// Construct a null buffer
+FieldBuffer::FieldBuffer()
+{
+    bufferWidth = 0;
+    bufferHeight = 0;
+}
+
+// Construct a buffer of the specified size (all samples are set to zero)
+FieldBuffer::FieldBuffer(qint32 width, qint32 height)
+{
+    bufferWidth = 0;
+    bufferHeight = 0;
+    resize(width, height);
+}
+
+// Construct a buffer that shares existing sample data; the height is derived from the
+// size of the data
+FieldBuffer::FieldBuffer(QByteArray sampleData, qint32 width)
+{
+    samples = sampleData;
+    bufferWidth = width;
+    if (width > 0) bufferHeight = samples.size() / (width * 2);
+    else bufferHeight = 0;
+
+    if (samples.size() != bufferWidth * bufferHeight * 2) {
+        qDebug() << "FieldBuffer::FieldBuffer(): Sample data size" << samples.size() << "is not a whole number of lines of width" << width;
+    }
+}
+
+// Construct a buffer that shares the sample data of a source field.  The buffer holds the
+// field, so data viewed from a memory mapped file stays valid even if the source video is
+// closed (a null field gives a null buffer)
+FieldBuffer::FieldBuffer(QSharedPointer<SourceField> sourceFieldParam, qint32 width)
+{
+    bufferWidth = 0;
+    bufferHeight = 0;
+    if (sourceFieldParam.isNull()) return;
+
+    *this = FieldBuffer(sourceFieldParam->getFieldData(), width);
+    sourceField = sourceFieldParam;
+}
+
+// Returns true if the buffer holds no samples
+bool FieldBuffer::isNull(void) const
+{
+    return samples.isEmpty();
+}
+
+qint32 FieldBuffer::getWidth(void) const
+{
+    return bufferWidth;
+}
+
+qint32 FieldBuffer::getHeight(void) const
+{
+    return bufferHeight;
+}
+
+qint32 FieldBuffer::getSizeInBytes(void) const
+{
+    return bufferWidth * bufferHeight * 2;
+}
+
+// Set the size of the buffer.  If the buffer is already the requested size and is not
+// shared, the existing samples are kept (so a buffer can be reused from frame to frame
+// without reallocating); otherwise a new buffer is allocated with all samples set to zero.
+void FieldBuffer::resize(qint32 width, qint32 height)
+{
+    if (width == bufferWidth && height == bufferHeight && !samples.isEmpty() && samples.isDetached()) return;
+
+    bufferWidth = width;
+    bufferHeight = height;
+    sourceField.clear();
+    if (width <= 0 || height <= 0) {
+        samples.clear();
+        return;
+    }
+
+    samples = QByteArray(width * height * 2, 0);
+    allocationCount.ref();
+}
+
+// Set all of the samples to the specified value
+void FieldBuffer::fill(quint16 value)
+{
+    quint16 *sampleData = data();
+    for (qint32 i = 0; i < bufferWidth * bufferHeight; i++) sampleData[i] = value;
+}
+
+// Exchange the samples of two buffers (without copying)
+void FieldBuffer::swap(FieldBuffer &other)
+{
+    samples.swap(other.samples);
+    sourceField.swap(other.sourceField);
+    qSwap(bufferWidth, other.bufferWidth);
+    qSwap(bufferHeight, other.bufferHeight);
+}
+
+const quint16 *FieldBuffer::constData(void) const
+{
+    return reinterpret_cast<const quint16 *>(samples.constData());
+}
+
+// Get a writable pointer to the samples (this copies the samples if they are shared)
+quint16 *FieldBuffer::data(void)
+{
+    const char *sharedData = samples.constData();
+    char *sampleData = samples.data();
+    if (sampleData != sharedData) allocationCount.ref();
+
+    return reinterpret_cast<quint16 *>(sampleData);
+}
+
+const quint16 *FieldBuffer::constLine(qint32 line) const
+{
+    return constData() + (line * bufferWidth);
+}
+
+// Get a writable pointer to a line (this copies the samples if they are shared)
+quint16 *FieldBuffer::line(qint32 line)
+{
+    return data() + (line * bufferWidth);
+}
+
+// Get the samples as a byte array (the array shares the samples with the buffer)
+QByteArray FieldBuffer::toByteArray(void) const
+{
+    return samples;
+}
+
+qint32 FieldBuffer::getAllocationCount(void)
+{
+    return allocationCount.load();
+}
@@ -0,0 +1,85 @@
+/************************************************************************
+
+    fieldbuffer.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef FIELDBUFFER_H
+#define FIELDBUFFER_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QSharedPointer>
+#include <QDebug>
+
+#include "sourcefield.h"
+
+// A field (or frame) of 16-bit samples, stored line by line with no padding.  The samples
+// are implicitly shared, so a buffer can be passed by value and handed between objects and
+// threads without copying; the samples are only copied if a shared buffer is written to.
+// A buffer made from field data read by SourceVideo shares that data (including memory
+// mapped data), so use the const accessors unless the samples are to be modified.  Make
+// such buffers from the SourceField rather than from its data, so the buffer holds the
+// field (and the memory mapping it views) for as long as the buffer exists.
+//
+// Line numbers are zero-based.  For RGB 16-16-16 frames the width is in samples (three
+// samples per pixel).
+class LDDECODESHAREDSHARED_EXPORT FieldBuffer
+{
+public:
+    FieldBuffer();
+    FieldBuffer(qint32 width, qint32 height);
+    FieldBuffer(QByteArray sampleData, qint32 width);
+    FieldBuffer(QSharedPointer<SourceField> sourceFieldParam, qint32 width);
+
+    bool isNull(void) const;
+    qint32 getWidth(void) const;
+    qint32 getHeight(void) const;
+    qint32 getSizeInBytes(void) const;
+    void resize(qint32 width, qint32 height);
+    void fill(quint16 value);
+    void swap(FieldBuffer &other);
+
+    // Sample access
+    const quint16 *constData(void) const;
+    quint16 *data(void);
+    const quint16 *constLine(qint32 line) const;
+    quint16 *line(qint32 line);
+    QByteArray toByteArray(void) const;
+
+    // Allocation statistics (the number of sample buffers allocated or copied by all
+    // field buffers)
+    static qint32 getAllocationCount(void);
+
+private:
+    QByteArray samples;
+    qint32 bufferWidth;
+    qint32 bufferHeight;
+
+    // The source field the samples are shared with (if any)
+    QSharedPointer<SourceField> sourceField;
+
+    static QAtomicInt allocationCount;
+};
+
+#endif // FIELDBUFFER_H
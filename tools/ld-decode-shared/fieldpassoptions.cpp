@@ -0,0 +1,118 @@
+/************************************************************************
+
+    fieldpassoptions.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "fieldpassoptions.h"
+
+FieldPassOptions::FieldPassOptions() :
+    // Option to leave the metadata updates in the journal (--no-compact)
+    noCompactOption(QStringList() << "no-compact",
+                    QCoreApplication::translate("main", "Leave the metadata updates in the journal instead of rewriting the JSON file")),
+
+    // Option to select the first field to process (--first-field)
+    firstFieldOption(QStringList() << "first-field",
+                     QCoreApplication::translate("main", "Specify the first field to process (default 1)"),
+                     QCoreApplication::translate("main", "number")),
+
+    // Option to select the last field to process (--last-field)
+    lastFieldOption(QStringList() << "last-field",
+                    QCoreApplication::translate("main", "Specify the last field to process (default is the last field)"),
+                    QCoreApplication::translate("main", "number")),
+
+    // Option to specify the output metadata file (--output-json)
+    outputJsonOption(QStringList() << "output-json",
+                     QCoreApplication::translate("main", "Specify the output JSON file (default is the input JSON file; with a field range only the range is written)"),
+                     QCoreApplication::translate("main", "filename"))
+{
+    firstFieldNumber = 1;
+    lastFieldNumber = -1;
+    isNoCompact = false;
+}
+
+// Add the options to a command line parser
+void FieldPassOptions::addOptions(QCommandLineParser &parser)
+{
+    parser.addOption(noCompactOption);
+    parser.addOption(firstFieldOption);
+    parser.addOption(lastFieldOption);
+    parser.addOption(outputJsonOption);
+}
+
+// Get the option values once the parser has processed the command line (returns false if
+// the values are not valid)
+bool FieldPassOptions::readOptions(QCommandLineParser &parser, QString inputFileName)
+{
+    isNoCompact = parser.isSet(noCompactOption);
+
+    // Get the field range
+    firstFieldNumber = 1;
+    lastFieldNumber = -1;
+
+    if (parser.isSet(firstFieldOption)) {
+        firstFieldNumber = parser.value(firstFieldOption).toInt();
+
+        if (firstFieldNumber < 1) {
+            qCritical("Specified first field must be at least 1");
+            return false;
+        }
+    }
+
+    if (parser.isSet(lastFieldOption)) {
+        lastFieldNumber = parser.value(lastFieldOption).toInt();
+
+        if (lastFieldNumber < firstFieldNumber) {
+            qCritical("Specified last field must not be before the first field");
+            return false;
+        }
+    }
+
+    // Get the output metadata file name
+    outputJsonFileName = inputFileName + ".json";
+    if (parser.isSet(outputJsonOption)) outputJsonFileName = parser.value(outputJsonOption);
+
+    return true;
+}
+
+// Get the first field to process
+qint32 FieldPassOptions::getFirstFieldNumber(void)
+{
+    return firstFieldNumber;
+}
+
+// Get the last field to process (-1 for the last field of the TBC file)
+qint32 FieldPassOptions::getLastFieldNumber(void)
+{
+    return lastFieldNumber;
+}
+
+// Get the output JSON file name
+QString FieldPassOptions::getOutputJsonFileName(void)
+{
+    return outputJsonFileName;
+}
+
+// Returns true if --no-compact is set
+bool FieldPassOptions::isNoCompactSet(void)
+{
+    return isNoCompact;
+}
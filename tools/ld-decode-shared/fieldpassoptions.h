@@ -0,0 +1,64 @@
+/************************************************************************
+
+    fieldpassoptions.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef FIELDPASSOPTIONS_H
+#define FIELDPASSOPTIONS_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QCommandLineOption>
+#include <QString>
+#include <QDebug>
+
+// The command line options of the tools that make a pass over the fields of a TBC file and
+// update its metadata: the field range (--first-field and --last-field), the output JSON file
+// (--output-json) and --no-compact (see LdDecodeMetaData::beginFieldPass())
+class LDDECODESHAREDSHARED_EXPORT FieldPassOptions
+{
+public:
+    FieldPassOptions();
+
+    void addOptions(QCommandLineParser &parser);
+    bool readOptions(QCommandLineParser &parser, QString inputFileName);
+
+    qint32 getFirstFieldNumber(void);
+    qint32 getLastFieldNumber(void);
+    QString getOutputJsonFileName(void);
+    bool isNoCompactSet(void);
+
+private:
+    QCommandLineOption noCompactOption;
+    QCommandLineOption firstFieldOption;
+    QCommandLineOption lastFieldOption;
+    QCommandLineOption outputJsonOption;
+
+    qint32 firstFieldNumber;
+    qint32 lastFieldNumber;
+    QString outputJsonFileName;
+    bool isNoCompact;
+};
+
+#endif // FIELDPASSOPTIONS_H
@@ -0,0 +1,224 @@
+/************************************************************************
+
+    fieldprefetcher.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "fieldprefetcher.h"
+
+// The field prefetcher is a background I/O thread used by SourceVideo to read fields
+// ahead of the current field when the source is being accessed sequentially.  For
+// memory mapped sources the prefetcher just touches the pages of the upcoming fields
+// (so they are resident before they are needed); otherwise it reads the fields into
+// buffers that SourceVideo takes on a cache miss.
+
+FieldPrefetcher::FieldPrefetcher(QObject *parent) : QThread(parent)
+{
+    // Thread control variables
+    abort = false;
+
+    // Default object settings
+    inputFile = nullptr;
+    mappedData = nullptr;
+    fieldLength = -1;
+    availableFields = -1;
+
+    windowFirstField = 1;
+    windowLastField = 0;
+    nextFieldNumber = 1;
+}
+
+FieldPrefetcher::~FieldPrefetcher()
+{
+    close();
+}
+
+// Open the source video file for prefetching (returns true on success)
+bool FieldPrefetcher::open(QString fileNameParam, qint32 fieldLengthParam, qint32 availableFieldsParam, const uchar *mappedDataParam)
+{
+    // Close any existing file
+    close();
+
+    fieldLength = fieldLengthParam;
+    availableFields = availableFieldsParam;
+    mappedData = mappedDataParam;
+
+    // A file handle is only needed if the source isn't memory mapped
+    if (mappedData == nullptr) {
+        inputFile = new QFile(fileNameParam);
+        if (!inputFile->open(QIODevice::ReadOnly)) {
+            qDebug() << "FieldPrefetcher::open(): Could not open" << fileNameParam << "- prefetching disabled";
+            delete inputFile;
+            inputFile = nullptr;
+            return false;
+        }
+    }
+
+    mutex.lock();
+    abort = false;
+    windowFirstField = 1;
+    windowLastField = 0;
+    nextFieldNumber = 1;
+    prefetchedFields.clear();
+    mutex.unlock();
+
+    // Start the I/O thread
+    start(NormalPriority);
+
+    return true;
+}
+
+// Stop the I/O thread and close the source video file
+void FieldPrefetcher::close(void)
+{
+    if (isRunning()) {
+        mutex.lock();
+        abort = true;
+        condition.wakeOne();
+        mutex.unlock();
+
+        wait();
+    }
+
+    mutex.lock();
+    prefetchedFields.clear();
+    mutex.unlock();
+
+    if (inputFile != nullptr) {
+        inputFile->close();
+        delete inputFile;
+        inputFile = nullptr;
+    }
+
+    mappedData = nullptr;
+}
+
+// Request that the prefetcher reads fields firstFieldNumber to lastFieldNumber
+// (inclusive).  Any prefetched fields outside of the requested window are discarded.
+void FieldPrefetcher::requestFields(qint32 firstFieldNumber, qint32 lastFieldNumber)
+{
+    QMutexLocker locker(&mutex);
+
+    // Range check the request
+    if (firstFieldNumber < 1) firstFieldNumber = 1;
+    if (lastFieldNumber > availableFields) lastFieldNumber = availableFields;
+
+    // Discard any fields that have fallen out of the window
+    QMap<qint32, QByteArray>::iterator i = prefetchedFields.begin();
+    while (i != prefetchedFields.end()) {
+        if (i.key() < firstFieldNumber || i.key() > lastFieldNumber) i = prefetchedFields.erase(i);
+        else ++i;
+    }
+
+    // If the reader has jumped outside of the current window, restart from the window start
+    if (nextFieldNumber < firstFieldNumber || nextFieldNumber > lastFieldNumber + 1) nextFieldNumber = firstFieldNumber;
+
+    windowFirstField = firstFieldNumber;
+    windowLastField = lastFieldNumber;
+
+    // Wake the I/O thread
+    condition.wakeOne();
+}
+
+// Take a prefetched field (returns false if the field has not been prefetched)
+bool FieldPrefetcher::takeField(qint32 fieldNumber, QByteArray &fieldData)
+{
+    QMutexLocker locker(&mutex);
+
+    if (!prefetchedFields.contains(fieldNumber)) return false;
+
+    fieldData = prefetchedFields.take(fieldNumber);
+    return true;
+}
+
+void FieldPrefetcher::run()
+{
+    qDebug() << "FieldPrefetcher::run(): Thread running";
+
+    mutex.lock();
+    while (!abort) {
+        // Sleep until there is something in the window left to read
+        if (nextFieldNumber > windowLastField) {
+            condition.wait(&mutex);
+            continue;
+        }
+
+        qint32 fieldNumber = nextFieldNumber;
+        nextFieldNumber++;
+        mutex.unlock();
+
+        // Perform the I/O without holding the lock
+        QByteArray fieldData;
+        if (mappedData != nullptr) touchField(fieldNumber);
+        else fieldData = readField(fieldNumber);
+
+        mutex.lock();
+
+        // Only keep the field if it's still within the requested window
+        if (!fieldData.isEmpty() && fieldNumber >= windowFirstField && fieldNumber <= windowLastField) {
+            prefetchedFields.insert(fieldNumber, fieldData);
+        }
+    }
+    mutex.unlock();
+
+    qDebug() << "FieldPrefetcher::run(): Thread stopped";
+}
+
+// Read a field from the source video file (returns an empty array on failure)
+QByteArray FieldPrefetcher::readField(qint32 fieldNumber)
+{
+    QByteArray fieldData;
+
+    qint64 requiredPosition = static_cast<qint64>((fieldLength * 2)) * static_cast<qint64>(fieldNumber - 1);
+    if (!inputFile->seek(requiredPosition)) {
+        qDebug() << "FieldPrefetcher::readField(): Seek to field" << fieldNumber << "failed";
+        return fieldData;
+    }
+
+    fieldData.resize(fieldLength * 2);
+    qint64 totalReceivedBytes = 0;
+    qint64 receivedBytes = 0;
+    do {
+        receivedBytes = inputFile->read(fieldData.data() + totalReceivedBytes, fieldData.size() - totalReceivedBytes);
+        if (receivedBytes > 0) totalReceivedBytes += receivedBytes;
+    } while (receivedBytes > 0 && totalReceivedBytes < fieldData.size());
+
+    if (totalReceivedBytes != fieldData.size()) {
+        qDebug() << "FieldPrefetcher::readField(): Short read for field" << fieldNumber;
+        fieldData.clear();
+    }
+
+    return fieldData;
+}
+
+// Touch every page of a memory mapped field so that it's resident before it's needed
+void FieldPrefetcher::touchField(qint32 fieldNumber)
+{
+    const qint64 pageSize = 4096;
+    qint64 fieldOffset = static_cast<qint64>((fieldLength * 2)) * static_cast<qint64>(fieldNumber - 1);
+    const volatile uchar *fieldPointer = mappedData + fieldOffset;
+
+    uchar sum = 0;
+    for (qint64 offset = 0; offset < fieldLength * 2; offset += pageSize) {
+        sum += fieldPointer[offset];
+    }
+    Q_UNUSED(sum);
+}
@@ -0,0 +1,78 @@
+/************************************************************************
+
+    fieldprefetcher.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef FIELDPREFETCHER_H
+#define FIELDPREFETCHER_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+#include <QMap>
+#include <QDebug>
+
+class LDDECODESHAREDSHARED_EXPORT FieldPrefetcher : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit FieldPrefetcher(QObject *parent = nullptr);
+    ~FieldPrefetcher() override;
+
+    bool open(QString fileNameParam, qint32 fieldLengthParam, qint32 availableFieldsParam, const uchar *mappedDataParam);
+    void close(void);
+
+    void requestFields(qint32 firstFieldNumber, qint32 lastFieldNumber);
+    bool takeField(qint32 fieldNumber, QByteArray &fieldData);
+
+protected:
+    void run() override;
+
+private:
+    // Thread control
+    QMutex mutex;
+    QWaitCondition condition;
+    bool abort;
+
+    // Source file (the prefetcher has its own file handle, so it never
+    // disturbs the seek position of the foreground reader)
+    QFile *inputFile;
+    const uchar *mappedData;
+    qint32 fieldLength;
+    qint32 availableFields;
+
+    // Read-ahead window
+    qint32 windowFirstField;
+    qint32 windowLastField;
+    qint32 nextFieldNumber;
+    QMap<qint32, QByteArray> prefetchedFields;
+
+    QByteArray readField(qint32 fieldNumber);
+    void touchField(qint32 fieldNumber);
+};
+
+#endif // FIELDPREFETCHER_H
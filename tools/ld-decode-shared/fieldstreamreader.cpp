@@ -0,0 +1,212 @@
+/************************************************************************
+
+    fieldstreamreader.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "fieldstreamreader.h"
+
+// The field stream reader is a background I/O thread used by SourceVideo when the input
+// is a pipe (or stdin) rather than a seekable file.  The fields are read in order into a
+// bounded ring buffer; the reader blocks when the buffer is full (so the upstream process
+// is held back) and the oldest fields are released when a field beyond the end of the
+// buffer is requested.  Fields that have left the buffer can no longer be read.
+
+FieldStreamReader::FieldStreamReader(QObject *parent) : QThread(parent)
+{
+    // Thread control variables
+    abort = false;
+    endOfStream = false;
+
+    // Default object settings
+    inputFile = nullptr;
+    fieldLength = -1;
+    availableFields = -1;
+
+    firstBufferedField = 1;
+    lastReadField = 0;
+}
+
+FieldStreamReader::~FieldStreamReader()
+{
+    close();
+}
+
+// Open the source stream (returns true on success)
+// A file name of "-" reads from stdin
+bool FieldStreamReader::open(QString fileNameParam, qint32 fieldLengthParam, qint32 availableFieldsParam, qint32 bufferFieldsParam)
+{
+    // Close any existing stream
+    close();
+
+    fieldLength = fieldLengthParam;
+    availableFields = availableFieldsParam;
+
+    inputFile = new QFile(fileNameParam);
+    bool isOpen;
+    if (fileNameParam == "-") isOpen = inputFile->open(stdin, QIODevice::ReadOnly);
+    else isOpen = inputFile->open(QIODevice::ReadOnly);
+
+    if (!isOpen) {
+        qWarning() << "Could not open" << fileNameParam << "as source video input stream";
+        delete inputFile;
+        inputFile = nullptr;
+        return false;
+    }
+
+    mutex.lock();
+    abort = false;
+    endOfStream = false;
+    ringBuffer.clear();
+    ringBuffer.resize(bufferFieldsParam);
+    firstBufferedField = 1;
+    lastReadField = 0;
+    mutex.unlock();
+
+    // Start the I/O thread
+    start(NormalPriority);
+
+    return true;
+}
+
+// Stop the I/O thread and close the source stream
+// Note: If the thread is blocked reading the stream this waits until the upstream
+// process writes more data or closes the pipe
+void FieldStreamReader::close(void)
+{
+    if (isRunning()) {
+        mutex.lock();
+        abort = true;
+        spaceFree.wakeAll();
+        fieldRead.wakeAll();
+        mutex.unlock();
+
+        wait();
+    }
+
+    mutex.lock();
+    ringBuffer.clear();
+    mutex.unlock();
+
+    if (inputFile != nullptr) {
+        inputFile->close();
+        delete inputFile;
+        inputFile = nullptr;
+    }
+}
+
+// Get a field from the stream, waiting for it to be read if required (returns false if
+// the field has already left the buffer, or the stream ended before the field)
+bool FieldStreamReader::getField(qint32 fieldNumber, QByteArray &fieldData)
+{
+    QMutexLocker locker(&mutex);
+
+    if (fieldNumber < firstBufferedField) {
+        qWarning() << "Field" << fieldNumber << "is no longer available from the input stream";
+        return false;
+    }
+
+    qint32 bufferFields = ringBuffer.size();
+    while (lastReadField < fieldNumber) {
+        if (abort || endOfStream) {
+            qWarning() << "Input stream ended before field" << fieldNumber;
+            return false;
+        }
+
+        // If the buffer is full, release the oldest fields to make room for the requested field
+        if (lastReadField - firstBufferedField + 1 >= bufferFields) {
+            qint32 newFirstBufferedField = fieldNumber - bufferFields + 1;
+            if (newFirstBufferedField > lastReadField + 1) newFirstBufferedField = lastReadField + 1;
+            while (firstBufferedField < newFirstBufferedField) {
+                ringBuffer[(firstBufferedField - 1) % bufferFields].clear();
+                firstBufferedField++;
+            }
+            spaceFree.wakeOne();
+        }
+
+        fieldRead.wait(&mutex);
+    }
+
+    fieldData = ringBuffer[(fieldNumber - 1) % bufferFields];
+    return true;
+}
+
+void FieldStreamReader::run()
+{
+    qDebug() << "FieldStreamReader::run(): Thread running";
+
+    mutex.lock();
+    while (!abort) {
+        // Sleep until there is space in the buffer
+        if (lastReadField - firstBufferedField + 1 >= ringBuffer.size()) {
+            spaceFree.wait(&mutex);
+            continue;
+        }
+
+        // Stop once all of the expected fields have been read
+        if (lastReadField >= availableFields) {
+            endOfStream = true;
+            fieldRead.wakeAll();
+            break;
+        }
+        mutex.unlock();
+
+        // Perform the I/O without holding the lock
+        QByteArray fieldData = readField();
+
+        mutex.lock();
+        if (fieldData.isEmpty()) {
+            endOfStream = true;
+            fieldRead.wakeAll();
+            break;
+        }
+
+        lastReadField++;
+        ringBuffer[(lastReadField - 1) % ringBuffer.size()] = fieldData;
+        fieldRead.wakeAll();
+    }
+    mutex.unlock();
+
+    qDebug() << "FieldStreamReader::run(): Thread stopped after" << lastReadField << "fields";
+}
+
+// Read the next field from the stream (returns an empty array at the end of the stream)
+QByteArray FieldStreamReader::readField(void)
+{
+    QByteArray fieldData;
+    fieldData.resize(fieldLength * 2);
+
+    // Reads from a pipe can return less than a field, so keep reading until the
+    // field is complete
+    qint64 totalReceivedBytes = 0;
+    qint64 receivedBytes = 0;
+    do {
+        receivedBytes = inputFile->read(fieldData.data() + totalReceivedBytes, fieldData.size() - totalReceivedBytes);
+        if (receivedBytes > 0) totalReceivedBytes += receivedBytes;
+    } while (receivedBytes > 0 && totalReceivedBytes < fieldData.size());
+
+    if (totalReceivedBytes < fieldData.size()) {
+        if (totalReceivedBytes != 0) qWarning() << "Input stream ended part way through a field";
+        return QByteArray();
+    }
+
+    return fieldData;
+}
@@ -0,0 +1,75 @@
+/************************************************************************
+
+    fieldstreamreader.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef FIELDSTREAMREADER_H
+#define FIELDSTREAMREADER_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+#include <QVector>
+#include <QDebug>
+
+class LDDECODESHAREDSHARED_EXPORT FieldStreamReader : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit FieldStreamReader(QObject *parent = nullptr);
+    ~FieldStreamReader() override;
+
+    bool open(QString fileNameParam, qint32 fieldLengthParam, qint32 availableFieldsParam, qint32 bufferFieldsParam);
+    void close(void);
+
+    bool getField(qint32 fieldNumber, QByteArray &fieldData);
+
+protected:
+    void run() override;
+
+private:
+    // Thread control
+    QMutex mutex;
+    QWaitCondition fieldRead;
+    QWaitCondition spaceFree;
+    bool abort;
+    bool endOfStream;
+
+    // Source stream
+    QFile *inputFile;
+    qint32 fieldLength;
+    qint32 availableFields;
+
+    // Ring buffer of the most recently read fields (firstBufferedField to lastReadField)
+    QVector<QByteArray> ringBuffer;
+    qint32 firstBufferedField;
+    qint32 lastReadField;
+
+    QByteArray readField(void);
+};
+
+#endif // FIELDSTREAMREADER_H
@@ -0,0 +1,491 @@
+/************************************************************************
+
+    jsonstreamreader.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "jsonstreamreader.h"
+
+JsonStreamReader::JsonStreamReader(QIODevice *deviceParam)
+{
+    device = deviceParam;
+    buffer.resize(blockSize);
+    bufferLength = 0;
+    bufferPosition = 0;
+    bufferFileOffset = 0;
+
+    state = expectValue;
+    tokenType = none;
+    isIntegerToken = false;
+    integerValue = 0;
+    booleanValue = false;
+
+    // Reserve space for the token data (so it is not freed when the data is cleared)
+    tokenData.reserve(256);
+}
+
+// Read the next token from the document.  Returns endDocument once the top-level value has
+// been read, or invalid if the document could not be parsed (see getErrorString())
+JsonStreamReader::TokenType JsonStreamReader::readNext(void)
+{
+    if (tokenType == endDocument || tokenType == invalid) return tokenType;
+
+    char character;
+    if (!getNextNonSpace(character)) {
+        if (state == afterValue && containers.isEmpty()) {
+            tokenType = endDocument;
+            return tokenType;
+        }
+        return setError("Unexpected end of file");
+    }
+
+    // After a value, expect a separator or the end of the enclosing object or array
+    if (state == afterValue) {
+        if (containers.isEmpty()) return setError("Unexpected data after the end of the document");
+
+        if (character == ',') {
+            state = (containers.last() == '{') ? expectName : expectValue;
+            if (!getNextNonSpace(character)) return setError("Unexpected end of file");
+        } else if (character == '}' || character == ']') {
+            if ((character == '}') != (containers.last() == '{')) return setError("Mismatched closing bracket");
+            containers.removeLast();
+            tokenType = (character == '}') ? endObject : endArray;
+            return tokenType;
+        } else {
+            return setError("Expected a comma or a closing bracket");
+        }
+    }
+
+    // Empty objects and arrays
+    if ((state == expectNameOrEnd && character == '}') || (state == expectValueOrEnd && character == ']')) {
+        containers.removeLast();
+        state = afterValue;
+        tokenType = (character == '}') ? endObject : endArray;
+        return tokenType;
+    }
+
+    // Member names (the name separator is consumed with the name)
+    if (state == expectName || state == expectNameOrEnd) {
+        if (character != '"') return setError("Expected a member name");
+        if (!readStringData()) return tokenType;
+        if (!getNextNonSpace(character) || character != ':') return setError("Expected a colon after the member name");
+
+        state = expectValue;
+        tokenType = name;
+        return tokenType;
+    }
+
+    return readValue(character);
+}
+
+// Get the type of the current token
+JsonStreamReader::TokenType JsonStreamReader::getTokenType(void)
+{
+    return tokenType;
+}
+
+// Returns true if the current token is the named member
+bool JsonStreamReader::isName(const char *memberName)
+{
+    return tokenType == name && tokenData == memberName;
+}
+
+// Skip the current value; if the current token starts an object or array, the reader is
+// moved to the matching end token.  Returns false if the document could not be parsed
+bool JsonStreamReader::skipCurrentValue(void)
+{
+    if (tokenType != startObject && tokenType != startArray) return tokenType != invalid;
+
+    qint32 depth = 1;
+    while (depth > 0) {
+        TokenType token = readNext();
+        if (token == startObject || token == startArray) depth++;
+        else if (token == endObject || token == endArray) depth--;
+        else if (token == invalid || token == endDocument) return false;
+    }
+
+    return true;
+}
+
+// Read and skip the next value (e.g. the value of an unknown member)
+bool JsonStreamReader::skipNextValue(void)
+{
+    readNext();
+    return skipCurrentValue();
+}
+
+// Get the current token as a string (returns an empty string if the token is not a string)
+QString JsonStreamReader::getString(void)
+{
+    if (tokenType != string) return QString();
+    return QString::fromUtf8(tokenData);
+}
+
+// Get the current token as an integer (returns 0 if the token is not a number with an
+// integer value that fits in 32 bits)
+qint32 JsonStreamReader::getInt(void)
+{
+    if (tokenType != number) return 0;
+
+    if (isIntegerToken) {
+        if (integerValue < -2147483647LL - 1 || integerValue > 2147483647LL) return 0;
+        return static_cast<qint32>(integerValue);
+    }
+
+    qreal value = tokenData.toDouble();
+    if (value < -2147483648.0 || value > 2147483647.0) return 0;
+    if (static_cast<qreal>(static_cast<qint32>(value)) != value) return 0;
+    return static_cast<qint32>(value);
+}
+
+// Get the current token as a double (returns 0 if the token is not a number)
+qreal JsonStreamReader::getDouble(void)
+{
+    if (tokenType != number) return 0;
+    if (isIntegerToken) return static_cast<qreal>(integerValue);
+    return tokenData.toDouble();
+}
+
+// Get the current token as a boolean (returns false if the token is not a boolean)
+bool JsonStreamReader::getBool(void)
+{
+    if (tokenType != boolean) return false;
+    return booleanValue;
+}
+
+// Read the next value and return true if it starts an object (any other value is skipped)
+bool JsonStreamReader::readStartObject(void)
+{
+    if (readNext() == startObject) return true;
+    skipCurrentValue();
+    return false;
+}
+
+// Read the next value and return true if it starts an array (any other value is skipped)
+bool JsonStreamReader::readStartArray(void)
+{
+    if (readNext() == startArray) return true;
+    skipCurrentValue();
+    return false;
+}
+
+// Read the next value as a string
+QString JsonStreamReader::readString(void)
+{
+    readNext();
+    skipCurrentValue();
+    return getString();
+}
+
+// Read the next value as an integer
+qint32 JsonStreamReader::readInt(void)
+{
+    readNext();
+    skipCurrentValue();
+    return getInt();
+}
+
+// Read the next value as a double
+qreal JsonStreamReader::readDouble(void)
+{
+    readNext();
+    skipCurrentValue();
+    return getDouble();
+}
+
+// Read the next value as a boolean
+bool JsonStreamReader::readBool(void)
+{
+    readNext();
+    skipCurrentValue();
+    return getBool();
+}
+
+// Returns true if the document could not be parsed
+bool JsonStreamReader::hasError(void)
+{
+    return tokenType == invalid;
+}
+
+// Get a description of the parse error (including the file offset of the error)
+QString JsonStreamReader::getErrorString(void)
+{
+    return errorString;
+}
+
+// Private methods ----------------------------------------------------------------------------
+
+// Read the next block of the document into the buffer (returns false at the end of the data)
+bool JsonStreamReader::fillBuffer(void)
+{
+    bufferFileOffset += bufferLength;
+    bufferPosition = 0;
+    bufferLength = 0;
+
+    qint64 bytesRead = device->read(buffer.data(), blockSize);
+    if (bytesRead <= 0) return false;
+
+    bufferLength = static_cast<qint32>(bytesRead);
+    return true;
+}
+
+bool JsonStreamReader::getNextChar(char &character)
+{
+    if (bufferPosition >= bufferLength && !fillBuffer()) return false;
+    character = buffer.constData()[bufferPosition++];
+    return true;
+}
+
+// Get the next character that is not whitespace (indented documents are mostly whitespace,
+// so it is skipped directly in the buffer)
+bool JsonStreamReader::getNextNonSpace(char &character)
+{
+    while (true) {
+        if (bufferPosition >= bufferLength && !fillBuffer()) return false;
+
+        const char *data = buffer.constData();
+        qint32 position = bufferPosition;
+        while (position < bufferLength) {
+            character = data[position++];
+            if (character != ' ' && character != '\n' && character != '\r' && character != '\t') {
+                bufferPosition = position;
+                return true;
+            }
+        }
+        bufferPosition = position;
+    }
+}
+
+// Read a value starting with the specified character
+JsonStreamReader::TokenType JsonStreamReader::readValue(char character)
+{
+    switch (character) {
+    case '{':
+        containers.append('{');
+        state = expectNameOrEnd;
+        tokenType = startObject;
+        return tokenType;
+    case '[':
+        containers.append('[');
+        state = expectValueOrEnd;
+        tokenType = startArray;
+        return tokenType;
+    case '"':
+        if (!readStringData()) return tokenType;
+        tokenType = string;
+        break;
+    case 't':
+        if (!readLiteral("rue")) return setError("Invalid literal");
+        booleanValue = true;
+        tokenType = boolean;
+        break;
+    case 'f':
+        if (!readLiteral("alse")) return setError("Invalid literal");
+        booleanValue = false;
+        tokenType = boolean;
+        break;
+    case 'n':
+        if (!readLiteral("ull")) return setError("Invalid literal");
+        tokenType = null;
+        break;
+    default:
+        if (!readNumberData(character)) return setError("Invalid value");
+        tokenType = number;
+    }
+
+    state = afterValue;
+    return tokenType;
+}
+
+// Read a string (the opening quote has been read) into the token data as UTF-8.  Runs of
+// unescaped characters are copied from the buffer in one go
+bool JsonStreamReader::readStringData(void)
+{
+    tokenData.resize(0);
+
+    while (true) {
+        if (bufferPosition >= bufferLength && !fillBuffer()) {
+            setError("Unexpected end of file in a string");
+            return false;
+        }
+
+        const char *data = buffer.constData();
+        qint32 runStart = bufferPosition;
+        qint32 position = runStart;
+        while (position < bufferLength) {
+            uchar character = static_cast<uchar>(data[position]);
+            if (character == '"' || character == '\\' || character < 0x20) break;
+            position++;
+        }
+        bufferPosition = position;
+        tokenData.append(data + runStart, position - runStart);
+        if (bufferPosition == bufferLength) continue;
+
+        char character = data[bufferPosition++];
+        if (character == '"') return true;
+        if (character != '\\') {
+            setError("Control character in a string");
+            return false;
+        }
+
+        // Escape sequences
+        if (!getNextChar(character)) {
+            setError("Unexpected end of file in a string");
+            return false;
+        }
+
+        quint32 codePoint;
+        switch (character) {
+        case '"': tokenData.append('"'); continue;
+        case '\\': tokenData.append('\\'); continue;
+        case '/': tokenData.append('/'); continue;
+        case 'b': tokenData.append('\b'); continue;
+        case 'f': tokenData.append('\f'); continue;
+        case 'n': tokenData.append('\n'); continue;
+        case 'r': tokenData.append('\r'); continue;
+        case 't': tokenData.append('\t'); continue;
+        case 'u':
+            if (!readUnicodeEscape(codePoint)) return false;
+            break;
+        default:
+            setError("Invalid escape sequence in a string");
+            return false;
+        }
+
+        // Combine UTF-16 surrogate pairs
+        if (codePoint >= 0xD800 && codePoint < 0xDC00) {
+            quint32 lowSurrogate;
+            if (!getNextChar(character) || character != '\\' || !getNextChar(character) || character != 'u' ||
+                    !readUnicodeEscape(lowSurrogate) || lowSurrogate < 0xDC00 || lowSurrogate >= 0xE000) {
+                setError("Invalid surrogate pair in a string");
+                return false;
+            }
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (lowSurrogate - 0xDC00);
+        }
+
+        // Encode the code point as UTF-8
+        if (codePoint < 0x80) {
+            tokenData.append(static_cast<char>(codePoint));
+        } else if (codePoint < 0x800) {
+            tokenData.append(static_cast<char>(0xC0 | (codePoint >> 6)));
+            tokenData.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else if (codePoint < 0x10000) {
+            tokenData.append(static_cast<char>(0xE0 | (codePoint >> 12)));
+            tokenData.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            tokenData.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        } else {
+            tokenData.append(static_cast<char>(0xF0 | (codePoint >> 18)));
+            tokenData.append(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+            tokenData.append(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+            tokenData.append(static_cast<char>(0x80 | (codePoint & 0x3F)));
+        }
+    }
+}
+
+// Read the four hex digits of a \u escape
+bool JsonStreamReader::readUnicodeEscape(quint32 &codeUnit)
+{
+    codeUnit = 0;
+    for (qint32 i = 0; i < 4; i++) {
+        char character;
+        if (!getNextChar(character)) {
+            setError("Unexpected end of file in a string");
+            return false;
+        }
+
+        codeUnit <<= 4;
+        if (character >= '0' && character <= '9') codeUnit |= static_cast<quint32>(character - '0');
+        else if (character >= 'a' && character <= 'f') codeUnit |= static_cast<quint32>(character - 'a' + 10);
+        else if (character >= 'A' && character <= 'F') codeUnit |= static_cast<quint32>(character - 'A' + 10);
+        else {
+            setError("Invalid unicode escape in a string");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Read a number starting with the specified character.  Integers (the common case in the
+// metadata) are converted as they are read; other numbers are kept as text and converted
+// when requested
+bool JsonStreamReader::readNumberData(char character)
+{
+    tokenData.resize(0);
+    tokenData.append(character);
+
+    // Collect the characters of the number (stopping at, but not consuming, the first
+    // character that is not part of it)
+    while (true) {
+        if (bufferPosition >= bufferLength && !fillBuffer()) break;
+
+        const char *data = buffer.constData();
+        qint32 runStart = bufferPosition;
+        qint32 position = runStart;
+        while (position < bufferLength) {
+            char next = data[position];
+            if (!((next >= '0' && next <= '9') || next == '.' || next == 'e' || next == 'E' || next == '+' || next == '-')) break;
+            position++;
+        }
+        bufferPosition = position;
+        tokenData.append(data + runStart, position - runStart);
+        if (bufferPosition < bufferLength) break;
+    }
+
+    // Convert integers directly
+    const char *text = tokenData.constData();
+    qint32 length = tokenData.size();
+    qint32 position = (text[0] == '-') ? 1 : 0;
+    isIntegerToken = (length > position) && (length - position <= 18);
+    integerValue = 0;
+    for (qint32 i = position; i < length && isIntegerToken; i++) {
+        if (text[i] < '0' || text[i] > '9') isIntegerToken = false;
+        else integerValue = (integerValue * 10) + (text[i] - '0');
+    }
+
+    if (isIntegerToken) {
+        if (position == 1) integerValue = -integerValue;
+        return true;
+    }
+
+    bool isValid;
+    tokenData.toDouble(&isValid);
+    return isValid;
+}
+
+// Read the remaining characters of a literal (true, false or null)
+bool JsonStreamReader::readLiteral(const char *literal)
+{
+    for (const char *expected = literal; *expected != '\0'; expected++) {
+        char character;
+        if (!getNextChar(character) || character != *expected) return false;
+    }
+
+    return true;
+}
+
+// Flag a parse error (at the current position in the document)
+JsonStreamReader::TokenType JsonStreamReader::setError(QString message)
+{
+    errorString = message + QString(" at offset %1").arg(bufferFileOffset + bufferPosition);
+    tokenType = invalid;
+    return tokenType;
+}
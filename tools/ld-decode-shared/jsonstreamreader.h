@@ -0,0 +1,127 @@
+/************************************************************************
+
+    jsonstreamreader.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QDebug>
+
+// A streaming (pull) JSON reader.  The document is read from the device a block at a time
+// and returned one token at a time, so a large metadata file can be read without holding
+// the whole file (or a QJsonDocument of it) in memory.  Each call to readNext() returns the
+// next token; member names and values are only valid until the next call.
+//
+// The read methods (readInt() etc.) read the next value and convert it in the same way as
+// QJsonValue (a value of the wrong type gives 0, false or an empty string, and an object
+// or array value is skipped), so the reader stays in step with the document.
+class LDDECODESHAREDSHARED_EXPORT JsonStreamReader
+{
+public:
+    enum TokenType {
+        none,
+        startObject,
+        endObject,
+        startArray,
+        endArray,
+        name,
+        string,
+        number,
+        boolean,
+        null,
+        endDocument,
+        invalid
+    };
+
+    explicit JsonStreamReader(QIODevice *deviceParam);
+
+    // Token handling methods
+    TokenType readNext(void);
+    TokenType getTokenType(void);
+    bool isName(const char *memberName);
+    bool skipCurrentValue(void);
+    bool skipNextValue(void);
+
+    // Value methods (for the current token)
+    QString getString(void);
+    qint32 getInt(void);
+    qreal getDouble(void);
+    bool getBool(void);
+
+    // Value methods (read the next value)
+    bool readStartObject(void);
+    bool readStartArray(void);
+    QString readString(void);
+    qint32 readInt(void);
+    qreal readDouble(void);
+    bool readBool(void);
+
+    // Error handling methods
+    bool hasError(void);
+    QString getErrorString(void);
+
+private:
+    enum State {
+        expectValue,
+        expectValueOrEnd,
+        expectName,
+        expectNameOrEnd,
+        afterValue
+    };
+
+    // Input device and buffer
+    static const qint32 blockSize = 1024 * 1024;
+    QIODevice *device;
+    QByteArray buffer;
+    qint32 bufferLength;
+    qint32 bufferPosition;
+    qint64 bufferFileOffset;
+
+    // Parser state
+    State state;
+    QVector<char> containers;
+    TokenType tokenType;
+    QByteArray tokenData;
+    bool isIntegerToken;
+    qint64 integerValue;
+    bool booleanValue;
+    QString errorString;
+
+    bool fillBuffer(void);
+    bool getNextChar(char &character);
+    bool getNextNonSpace(char &character);
+    TokenType readValue(char character);
+    bool readStringData(void);
+    bool readUnicodeEscape(quint32 &codeUnit);
+    bool readNumberData(char character);
+    bool readLiteral(const char *literal);
+    TokenType setError(QString message);
+};
+
+#endif // JSONSTREAMREADER_H
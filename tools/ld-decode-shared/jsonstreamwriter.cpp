@@ -0,0 +1,316 @@
+/************************************************************************
+
+    jsonstreamwriter.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "jsonstreamwriter.h"
+
+namespace {
+    // The buffer is written to the device once it holds this many bytes
+    const qint32 bufferFlushSize = 1024 * 1024;
+}
+
+JsonStreamWriter::JsonStreamWriter(QIODevice *deviceParam, Format formatParam)
+{
+    device = deviceParam;
+    format = formatParam;
+    bufferUsed = 0;
+    isWriteError = false;
+    isAfterName = false;
+    buffer.resize(bufferFlushSize + 4096);
+}
+
+JsonStreamWriter::JsonStreamWriter(Format formatParam)
+{
+    device = nullptr;
+    format = formatParam;
+    bufferUsed = 0;
+    isWriteError = false;
+    isAfterName = false;
+    buffer.resize(64 * 1024);
+}
+
+void JsonStreamWriter::writeStartObject(void)
+{
+    startElement();
+    startContainer('{');
+}
+
+void JsonStreamWriter::writeEndObject(void)
+{
+    endContainer('}');
+}
+
+void JsonStreamWriter::writeStartArray(void)
+{
+    startElement();
+    startContainer('[');
+}
+
+void JsonStreamWriter::writeEndArray(void)
+{
+    endContainer(']');
+}
+
+// Write the name of an object member (the value must be written next)
+void JsonStreamWriter::writeName(const char *memberName)
+{
+    startElement();
+    append('"');
+    writeEscapedString(memberName, static_cast<qint32>(qstrlen(memberName)));
+    if (format == indented) append("\": ", 3);
+    else append("\":", 2);
+    isAfterName = true;
+}
+
+void JsonStreamWriter::writeInt(qint32 value)
+{
+    startElement();
+
+    // Format the digits backwards (this is called for every drop-out, so it avoids the
+    // temporary QByteArray of QByteArray::number())
+    char digits[12];
+    qint32 position = sizeof(digits);
+    quint32 magnitude = value < 0 ? 0U - static_cast<quint32>(value) : static_cast<quint32>(value);
+    do {
+        digits[--position] = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude != 0);
+    if (value < 0) digits[--position] = '-';
+    append(digits + position, static_cast<qint32>(sizeof(digits)) - position);
+
+    flushIfFull();
+}
+
+// Write a real value (as for QJsonDocument, values that are not finite are written as null)
+void JsonStreamWriter::writeDouble(qreal value)
+{
+    startElement();
+    if (qIsFinite(value)) {
+        QByteArray number = QByteArray::number(value, 'g', QLocale::FloatingPointShortest);
+        append(number.constData(), number.size());
+    } else {
+        append("null", 4);
+    }
+    flushIfFull();
+}
+
+void JsonStreamWriter::writeBool(bool value)
+{
+    startElement();
+    if (value) append("true", 4);
+    else append("false", 5);
+    flushIfFull();
+}
+
+void JsonStreamWriter::writeString(const QString &value)
+{
+    startElement();
+    QByteArray utf8 = value.toUtf8();
+    append('"');
+    writeEscapedString(utf8.constData(), utf8.size());
+    append('"');
+    flushIfFull();
+}
+
+void JsonStreamWriter::writeMember(const char *memberName, qint32 value)
+{
+    writeName(memberName);
+    writeInt(value);
+}
+
+void JsonStreamWriter::writeMember(const char *memberName, qreal value)
+{
+    writeName(memberName);
+    writeDouble(value);
+}
+
+void JsonStreamWriter::writeMember(const char *memberName, bool value)
+{
+    writeName(memberName);
+    writeBool(value);
+}
+
+void JsonStreamWriter::writeMember(const char *memberName, const QString &value)
+{
+    writeName(memberName);
+    writeString(value);
+}
+
+// Start writing a fragment of an array that is open (at the given depth) in another writer;
+// isFirstElement is false if the array already has elements.  The fragment is added to the
+// other writer with writeRawElements()
+void JsonStreamWriter::continueArray(qint32 depth, bool isFirstElement)
+{
+    isFirstElementStack.fill(false, depth);
+    if (depth > 0) isFirstElementStack[depth - 1] = isFirstElement;
+    isAfterName = false;
+}
+
+// Add array elements formatted by another writer (see continueArray())
+void JsonStreamWriter::writeRawElements(const QByteArray &json)
+{
+    if (json.isEmpty()) return;
+
+    append(json.constData(), json.size());
+    if (!isFirstElementStack.isEmpty()) isFirstElementStack.last() = false;
+    flushIfFull();
+}
+
+// Write the buffer to the device
+bool JsonStreamWriter::flush(void)
+{
+    if (device == nullptr || bufferUsed == 0) return !isWriteError;
+
+    if (device->write(buffer.constData(), bufferUsed) != bufferUsed) {
+        if (!isWriteError) qWarning() << "Could not write JSON -" << device->errorString();
+        isWriteError = true;
+    }
+    bufferUsed = 0;
+
+    return !isWriteError;
+}
+
+bool JsonStreamWriter::hasError(void) const
+{
+    return isWriteError;
+}
+
+// Take the buffered JSON (for a writer without a device, the whole document or fragment)
+QByteArray JsonStreamWriter::takeBuffer(void)
+{
+    buffer.resize(bufferUsed);
+    bufferUsed = 0;
+
+    QByteArray json;
+    json.swap(buffer);
+    return json;
+}
+
+// Write the separator and indentation before a value or member name
+void JsonStreamWriter::startElement(void)
+{
+    if (isAfterName) {
+        isAfterName = false;
+        return;
+    }
+    if (isFirstElementStack.isEmpty()) return;
+
+    if (isFirstElementStack.last()) isFirstElementStack.last() = false;
+    else append(',');
+
+    if (format == indented) writeNewLine(isFirstElementStack.size());
+}
+
+void JsonStreamWriter::startContainer(char startCharacter)
+{
+    append(startCharacter);
+    isFirstElementStack.append(true);
+}
+
+// Close an object or array.  As for QJsonDocument, an indented document ends with a new line
+void JsonStreamWriter::endContainer(char endCharacter)
+{
+    if (isFirstElementStack.isEmpty()) {
+        qWarning() << "JsonStreamWriter::endContainer(): There is no object or array to end";
+        return;
+    }
+
+    isFirstElementStack.removeLast();
+    if (format == indented) writeNewLine(isFirstElementStack.size());
+    append(endCharacter);
+    if (format == indented && isFirstElementStack.isEmpty()) append('\n');
+
+    flushIfFull();
+}
+
+// Write a new line, indented by four spaces per level
+void JsonStreamWriter::writeNewLine(qint32 depth)
+{
+    char *target = reserve(1 + depth * 4);
+    target[0] = '\n';
+    memset(target + 1, ' ', static_cast<size_t>(depth * 4));
+    bufferUsed += 1 + depth * 4;
+}
+
+// Write a string with the characters that JSON requires escaping escaped (other characters,
+// including non-ASCII characters, are written as UTF-8)
+void JsonStreamWriter::writeEscapedString(const char *data, qint32 size)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    // Each character is written as at most six bytes
+    char *target = reserve(size * 6);
+    char *start = target;
+    for (qint32 i = 0; i < size; i++) {
+        uchar character = static_cast<uchar>(data[i]);
+        if (character >= 0x20 && character != '"' && character != '\\') {
+            *target++ = static_cast<char>(character);
+            continue;
+        }
+
+        *target++ = '\\';
+        switch (character) {
+        case '"': *target++ = '"'; break;
+        case '\\': *target++ = '\\'; break;
+        case '\b': *target++ = 'b'; break;
+        case '\f': *target++ = 'f'; break;
+        case '\n': *target++ = 'n'; break;
+        case '\r': *target++ = 'r'; break;
+        case '\t': *target++ = 't'; break;
+        default:
+            *target++ = 'u';
+            *target++ = '0';
+            *target++ = '0';
+            *target++ = hexDigits[character >> 4];
+            *target++ = hexDigits[character & 0x0F];
+            break;
+        }
+    }
+    bufferUsed += static_cast<qint32>(target - start);
+}
+
+void JsonStreamWriter::append(char character)
+{
+    *reserve(1) = character;
+    bufferUsed++;
+}
+
+void JsonStreamWriter::append(const char *data, qint32 size)
+{
+    memcpy(reserve(size), data, static_cast<size_t>(size));
+    bufferUsed += size;
+}
+
+// Get space for size more bytes at the end of the buffer (the caller adds the number of
+// bytes it writes to bufferUsed).  The buffer is written through a pointer, rather than
+// with QByteArray::append(), as most of the appends are only a few bytes long
+char *JsonStreamWriter::reserve(qint32 size)
+{
+    if (bufferUsed + size > buffer.size()) buffer.resize(qMax(buffer.size() * 2, bufferUsed + size));
+    return buffer.data() + bufferUsed;
+}
+
+void JsonStreamWriter::flushIfFull(void)
+{
+    if (device != nullptr && bufferUsed >= bufferFlushSize) flush();
+}
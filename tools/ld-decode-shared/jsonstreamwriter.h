@@ -0,0 +1,109 @@
+/************************************************************************
+
+    jsonstreamwriter.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef JSONSTREAMWRITER_H
+#define JSONSTREAMWRITER_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QIODevice>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+#include <QLocale>
+#include <QDebug>
+
+// A streaming JSON writer (the counterpart of JsonStreamReader).  The document is written
+// a token at a time to a buffer, which is written to the device whenever it fills, so a
+// large metadata file can be written without building a QJsonDocument of it.  Members are
+// written in the order they are given (so, to match QJsonDocument, write them in
+// alphabetical order).
+//
+// The indented format is the same as QJsonDocument::Indented (four spaces per level); the
+// compact format has no white space.  Integers are written as integers and reals in their
+// shortest form that reads back exactly.
+//
+// A writer without a device just fills its buffer - this is used to format parts of a
+// document in parallel (see continueArray() and writeRawElements())
+class LDDECODESHAREDSHARED_EXPORT JsonStreamWriter
+{
+public:
+    enum Format {
+        indented,
+        compact
+    };
+
+    explicit JsonStreamWriter(QIODevice *deviceParam, Format formatParam = indented);
+    explicit JsonStreamWriter(Format formatParam = indented);
+
+    // Structure methods
+    void writeStartObject(void);
+    void writeEndObject(void);
+    void writeStartArray(void);
+    void writeEndArray(void);
+    void writeName(const char *memberName);
+
+    // Value methods
+    void writeInt(qint32 value);
+    void writeDouble(qreal value);
+    void writeBool(bool value);
+    void writeString(const QString &value);
+
+    // Member methods (name and value)
+    void writeMember(const char *memberName, qint32 value);
+    void writeMember(const char *memberName, qreal value);
+    void writeMember(const char *memberName, bool value);
+    void writeMember(const char *memberName, const QString &value);
+
+    // Fragment methods
+    void continueArray(qint32 depth, bool isFirstElement);
+    void writeRawElements(const QByteArray &json);
+
+    bool flush(void);
+    bool hasError(void) const;
+    QByteArray takeBuffer(void);
+
+private:
+    QIODevice *device;
+    Format format;
+    QByteArray buffer;
+    qint32 bufferUsed;
+    bool isWriteError;
+
+    // For each open object or array, true until its first element is written
+    QVector<bool> isFirstElementStack;
+    bool isAfterName;
+
+    void startElement(void);
+    void startContainer(char startCharacter);
+    void endContainer(char endCharacter);
+    void writeNewLine(qint32 depth);
+    void writeEscapedString(const char *data, qint32 size);
+    void append(char character);
+    void append(const char *data, qint32 size);
+    char *reserve(qint32 size);
+    void flushIfFull(void);
+};
+
+#endif // JSONSTREAMWRITER_H
@@ -25,13 +25,41 @@ DEFINES += QT_DEPRECATED_WARNINGS
 SOURCES += \
     sourcevideo.cpp \
     lddecodemetadata.cpp \
-    sourcefield.cpp
+    sourcefield.cpp \
+    fieldprefetcher.cpp \
+    fieldstreamreader.cpp \
+    tbccodec.cpp \
+    fieldbuffer.cpp \
+    outputwriter.cpp \
+    jsonstreamreader.cpp \
+    metadatasidecar.cpp \
+    metadatajournal.cpp \
+    dropoutstore.cpp \
+    vbiseekindex.cpp \
+    jsonstreamwriter.cpp \
+    threadaffinity.cpp \
+    fieldpassoptions.cpp \
+    throughputtimer.cpp
 
 HEADERS += \
         ld-decode-shared_global.h \ 
     sourcevideo.h \
     lddecodemetadata.h \
-    sourcefield.h
+    sourcefield.h \
+    fieldprefetcher.h \
+    fieldstreamreader.h \
+    tbccodec.h \
+    fieldbuffer.h \
+    outputwriter.h \
+    jsonstreamreader.h \
+    metadatasidecar.h \
+    metadatajournal.h \
+    dropoutstore.h \
+    vbiseekindex.h \
+    jsonstreamwriter.h \
+    threadaffinity.h \
+    fieldpassoptions.h \
+    throughputtimer.h
 
 unix {
     target.path = /usr/lib
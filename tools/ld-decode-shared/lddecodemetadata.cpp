@@ -23,16 +23,82 @@
 ************************************************************************/
 
 #include "lddecodemetadata.h"
+#include "metadatasidecar.h"
+#include "metadatajournal.h"
+#include "vbiseekindex.h"
+#include "threadaffinity.h"
+
+namespace {
+    // The number of fields in each chunk of the fields array that write() formats in parallel
+    const qint32 fieldsPerWriteChunk = 1024;
+}
 
 LdDecodeMetaData::LdDecodeMetaData(QObject *parent) : QObject(parent)
 {
+    sidecar = nullptr;
+    isSidecarDropOutsPending = false;
+    journal = nullptr;
+    isFrameIndexValid = false;
+    seekIndex = nullptr;
+    isSeekIndexValid = false;
+    partialFirstFieldNumber = 0;
+    journalFirstFieldNumber = 1;
+    journalLastFieldNumber = -1;
+    isFieldPassCompactSet = true;
+    jsonFormat = JsonStreamWriter::indented;
+}
 
+LdDecodeMetaData::~LdDecodeMetaData()
+{
+    // Note: an open journal is closed without ending the pass, so the pass can be resumed
+    delete journal;
+    delete sidecar;
+    delete seekIndex;
 }
 
 // This method opens the JSON metadata file and reads the content into the
-// metadata structure read for use
+// metadata structure read for use.  If there is an up to date binary sidecar for the
+// JSON file (see writeSidecar()) it is used instead (the file name can also be the name
+// of the sidecar itself).  Otherwise the file is parsed as it
+// is read (rather than building a QJsonDocument of the whole file), so large files can
+// be read quickly and without holding the file in memory.  Any field updates in the
+// metadata journal for the file (see openJournal()) are then applied
 bool LdDecodeMetaData::read(QString fileName)
 {
+    delete journal;
+    journal = nullptr;
+
+    // A sidecar can also be read by naming it rather than its JSON file, in which case it
+    // is used even if the JSON file does not exist
+    QString sidecarJsonFileName = MetaDataSidecar::getJsonFileName(fileName);
+    bool isSidecarNamed = !sidecarJsonFileName.isEmpty();
+    if (isSidecarNamed) fileName = sidecarJsonFileName;
+
+    // Use the sidecar if it is up to date
+    MetaDataSidecar *newSidecar = new MetaDataSidecar;
+    if (newSidecar->open(MetaDataSidecar::getFileName(fileName), fileName, isSidecarNamed)) {
+        qDebug() << "LdDecodeMetaData::read(): Using the metadata sidecar for" << fileName;
+        delete sidecar;
+        sidecar = newSidecar;
+        metaData.videoParameters = sidecar->getVideoParameters();
+        metaData.pcmAudioParameters = sidecar->getPcmAudioParameters();
+        metaData.fields.clear();
+        dropOutStore.clear();
+        isSidecarDropOutsPending = true;
+        isFrameIndexValid = false;
+        isSeekIndexValid = false;
+        partialFirstFieldNumber = 0;
+        readFileName = fileName;
+        replayJournal(fileName);
+        return true;
+    }
+    delete newSidecar;
+
+    if (isSidecarNamed) {
+        qWarning() << "Could not use the metadata sidecar" << MetaDataSidecar::getFileName(fileName) << "- it is missing, invalid or out of date";
+        return false;
+    }
+
     // Open the JSON file
     qDebug() << "LdDecodeMetaData::read(): Loading JSON file" << fileName;
     QFile jsonFileHandle(fileName);
@@ -43,552 +109,866 @@ bool LdDecodeMetaData::read(QString fileName)
         return false;
     }
 
-    // Read the file into our JSON document
-    QJsonDocument jsonDocument;
-    QString inputData;
-    inputData = jsonFileHandle.readAll();
-    jsonDocument = QJsonDocument::fromJson(inputData.toUtf8());
-    QJsonObject document = jsonDocument.object(); // Note: fix for Qt 5.9 compatibility
-
-    // Close the file
-    jsonFileHandle.close();
+    // Read into a new metadata structure, so the current metadata is kept if the file
+    // cannot be parsed (parameters that are not in the file are left unchanged)
+    MetaData newMetaData;
+    DropOutStore newDropOutStore;
+    newMetaData.videoParameters = metaData.videoParameters;
+    newMetaData.pcmAudioParameters = metaData.pcmAudioParameters;
+
+    JsonStreamReader reader(&jsonFileHandle);
+    bool isVideoParametersDefined = false;
+    bool isPcmAudioParametersDefined = false;
+    bool isFieldsDefined = false;
+    qint32 newPartialFirstFieldNumber = 0;
+    qint32 newPartialLastFieldNumber = 0;
+
+    if (reader.readStartObject()) {
+        while (reader.readNext() == JsonStreamReader::name) {
+            if (reader.isName("videoParameters")) {
+                isVideoParametersDefined = true;
+                readVideoParameters(reader, newMetaData.videoParameters);
+            } else if (reader.isName("pcmAudioParameters")) {
+                isPcmAudioParametersDefined = true;
+                readPcmAudioParameters(reader, newMetaData.pcmAudioParameters);
+            } else if (reader.isName("fields")) {
+                isFieldsDefined = true;
+                readFields(reader, newMetaData.fields, newDropOutStore);
+            } else if (reader.isName("fieldRange")) {
+                readFieldRange(reader, newPartialFirstFieldNumber, newPartialLastFieldNumber);
+            } else {
+                reader.skipNextValue();
+            }
+        }
+    }
 
-    // Check input file is value
-    if (jsonDocument.isNull()) {
-        qWarning("Input JSON file could not be parsed!");
+    // Check the whole file was parsed
+    if (reader.getTokenType() == JsonStreamReader::endObject) reader.readNext();
+    if (reader.getTokenType() != JsonStreamReader::endDocument) {
+        if (reader.hasError()) qWarning() << "Input JSON file could not be parsed:" << reader.getErrorString();
+        else qWarning("Input JSON file could not be parsed!");
         return false;
     }
 
-    // Read the video paramters
-    if (!document["videoParameters"].isUndefined()) {
-        // Read the video parameters
-        QJsonObject jsonVideoParameters;
-        jsonVideoParameters = document["videoParameters"].toObject();
+    // Close the file
+    jsonFileHandle.close();
 
-        metaData.videoParameters.numberOfSequentialFields = jsonVideoParameters["numberOfSequentialFields"].toInt();
-        metaData.videoParameters.isSourcePal = jsonVideoParameters["isSourcePal"].toBool();
+    if (!isVideoParametersDefined) qDebug() << "LdDecodeMetaData::read(): videoParameters is not defined";
+    if (!isPcmAudioParametersDefined) qDebug() << "LdDecodeMetaData::read(): pcmAudioParameters is not defined";
+    if (!isFieldsDefined || newMetaData.fields.isEmpty()) qDebug() << "LdDecodeMetaData::read(): fields object is not defined";
 
-        metaData.videoParameters.colourBurstStart = jsonVideoParameters["colourBurstStart"].toInt();
-        metaData.videoParameters.colourBurstEnd = jsonVideoParameters["colourBurstEnd"].toInt();
-        metaData.videoParameters.blackLevelStart = jsonVideoParameters["blackLevelStart"].toInt();
-        metaData.videoParameters.blackLevelEnd = jsonVideoParameters["blackLevelEnd"].toInt();
-        metaData.videoParameters.activeVideoStart = jsonVideoParameters["activeVideoStart"].toInt();
-        metaData.videoParameters.activeVideoEnd = jsonVideoParameters["activeVideoEnd"].toInt();
+    // Check the fields of partial metadata match the field range
+    if (newPartialFirstFieldNumber != 0) {
+        if (newPartialFirstFieldNumber < 1 || newPartialLastFieldNumber - newPartialFirstFieldNumber + 1 != newMetaData.fields.size()) {
+            qWarning() << "Input JSON file field range" << newPartialFirstFieldNumber << "to" << newPartialLastFieldNumber <<
+                          "does not match the" << newMetaData.fields.size() << "fields in the file";
+            return false;
+        }
+        qDebug() << "LdDecodeMetaData::read(): Partial metadata for fields" << newPartialFirstFieldNumber << "to" << newPartialLastFieldNumber;
+    }
 
-        metaData.videoParameters.white16bIre = jsonVideoParameters["white16bIre"].toInt();
-        metaData.videoParameters.black16bIre = jsonVideoParameters["black16bIre"].toInt();
+    delete sidecar;
+    sidecar = nullptr;
+    metaData = newMetaData;
+    dropOutStore = newDropOutStore;
+    isSidecarDropOutsPending = false;
+    isFrameIndexValid = false;
+    isSeekIndexValid = false;
+    partialFirstFieldNumber = newPartialFirstFieldNumber;
+    readFileName = fileName;
+    replayJournal(fileName);
 
-        metaData.videoParameters.samplesPerUs = jsonVideoParameters["samplesPerUs"].toDouble();
+    return true;
+}
 
-        metaData.videoParameters.fieldWidth = jsonVideoParameters["fieldWidth"].toInt();
-        metaData.videoParameters.fieldHeight = jsonVideoParameters["fieldHeight"].toInt();
-        metaData.videoParameters.sampleRate = jsonVideoParameters["sampleRate"].toInt();
-        metaData.videoParameters.fsc = jsonVideoParameters["fsc"].toInt();
-    } else {
-        qDebug() << "LdDecodeMetaData::read(): videoParameters is not defined";
+// Read the video parameters object
+void LdDecodeMetaData::readVideoParameters(JsonStreamReader &reader, VideoParameters &videoParameters)
+{
+    videoParameters = VideoParameters();
+    if (!reader.readStartObject()) return;
+
+    while (reader.readNext() == JsonStreamReader::name) {
+        if (reader.isName("numberOfSequentialFields")) videoParameters.numberOfSequentialFields = reader.readInt();
+        else if (reader.isName("isSourcePal")) videoParameters.isSourcePal = reader.readBool();
+
+        else if (reader.isName("colourBurstStart")) videoParameters.colourBurstStart = reader.readInt();
+        else if (reader.isName("colourBurstEnd")) videoParameters.colourBurstEnd = reader.readInt();
+        else if (reader.isName("blackLevelStart")) videoParameters.blackLevelStart = reader.readInt();
+        else if (reader.isName("blackLevelEnd")) videoParameters.blackLevelEnd = reader.readInt();
+        else if (reader.isName("activeVideoStart")) videoParameters.activeVideoStart = reader.readInt();
+        else if (reader.isName("activeVideoEnd")) videoParameters.activeVideoEnd = reader.readInt();
+
+        else if (reader.isName("white16bIre")) videoParameters.white16bIre = reader.readInt();
+        else if (reader.isName("black16bIre")) videoParameters.black16bIre = reader.readInt();
+
+        else if (reader.isName("samplesPerUs")) videoParameters.samplesPerUs = reader.readDouble();
+
+        else if (reader.isName("fieldWidth")) videoParameters.fieldWidth = reader.readInt();
+        else if (reader.isName("fieldHeight")) videoParameters.fieldHeight = reader.readInt();
+        else if (reader.isName("sampleRate")) videoParameters.sampleRate = reader.readInt();
+        else if (reader.isName("fsc")) videoParameters.fsc = reader.readInt();
+        else reader.skipNextValue();
     }
+}
 
-    if (!document["pcmAudioParameters"].isUndefined()) {
-        // Read the PCM audio data
-        QJsonObject pcmAudioParameters = document["pcmAudioParameters"].toObject();
+// Read the PCM audio parameters object
+void LdDecodeMetaData::readPcmAudioParameters(JsonStreamReader &reader, PcmAudioParameters &pcmAudioParameters)
+{
+    pcmAudioParameters = PcmAudioParameters();
+    if (!reader.readStartObject()) return;
+
+    while (reader.readNext() == JsonStreamReader::name) {
+        if (reader.isName("sampleRate")) pcmAudioParameters.sampleRate = reader.readInt();
+        else if (reader.isName("isLittleEndian")) pcmAudioParameters.isLittleEndian = reader.readBool();
+        else if (reader.isName("isSigned")) pcmAudioParameters.isSigned = reader.readBool();
+        else if (reader.isName("bits")) pcmAudioParameters.bits = reader.readInt();
+        else reader.skipNextValue();
+    }
+}
 
-        metaData.pcmAudioParameters.sampleRate = pcmAudioParameters["sampleRate"].toInt();
-        metaData.pcmAudioParameters.isLittleEndian = pcmAudioParameters["isLittleEndian"].toBool();
-        metaData.pcmAudioParameters.isSigned = pcmAudioParameters["isSigned"].toBool();
-        metaData.pcmAudioParameters.bits = pcmAudioParameters["bits"].toInt();
-    } else {
-        qDebug() << "LdDecodeMetaData::read(): pcmAudioParameters is not defined";
+// Read the field range object of partial metadata
+void LdDecodeMetaData::readFieldRange(JsonStreamReader &reader, qint32 &firstFieldNumber, qint32 &lastFieldNumber)
+{
+    firstFieldNumber = 0;
+    lastFieldNumber = 0;
+    if (!reader.readStartObject()) return;
+
+    while (reader.readNext() == JsonStreamReader::name) {
+        if (reader.isName("firstField")) firstFieldNumber = reader.readInt();
+        else if (reader.isName("lastField")) lastFieldNumber = reader.readInt();
+        else reader.skipNextValue();
     }
+}
 
-    QJsonArray jsonFields = document["fields"].toArray();
-    if (!jsonFields.isEmpty()) {
-        // Read the fields
+// Read the array of field objects (the drop-outs of the fields are moved into the drop-out
+// store)
+void LdDecodeMetaData::readFields(JsonStreamReader &reader, QVector<Field> &fields, DropOutStore &dropOuts)
+{
+    fields.clear();
+    dropOuts.clear();
+    if (!reader.readStartArray()) return;
+
+    QVector<qint32> startx;
+    QVector<qint32> endx;
+    QVector<qint32> fieldLine;
+    QVector<qint32> fieldCounts;
+    while (reader.readNext() != JsonStreamReader::endArray) {
+        // Note: values in the array that are not objects give a field with default values
+        Field fieldData = Field();
+        if (reader.getTokenType() == JsonStreamReader::startObject) readField(reader, fieldData);
+        else if (!reader.skipCurrentValue()) return;
+        if (reader.hasError()) return;
+
+        startx += fieldData.dropOuts.startx;
+        endx += fieldData.dropOuts.endx;
+        fieldLine += fieldData.dropOuts.fieldLine;
+        fieldCounts.append(fieldData.dropOuts.startx.size());
+        fieldData.dropOuts = DropOuts();
+
+        fields.append(fieldData);
+    }
 
-        metaData.fields.resize(jsonFields.size());
+    dropOuts.setAllDropOuts(startx, endx, fieldLine, fieldCounts);
+}
 
-        for (qint32 fieldNumber = 0; fieldNumber < jsonFields.size(); fieldNumber++) {
-            Field fieldData;
+// Read a field object (the start of the object has been read)
+void LdDecodeMetaData::readField(JsonStreamReader &reader, Field &fieldData)
+{
+    while (reader.readNext() == JsonStreamReader::name) {
+        if (reader.isName("seqNo")) fieldData.seqNo = reader.readInt();
+
+        else if (reader.isName("isFirstField")) fieldData.isFirstField = reader.readBool();
+        else if (reader.isName("syncConf")) fieldData.syncConf = reader.readInt();
+        else if (reader.isName("medianBurstIRE")) fieldData.medianBurstIRE = reader.readDouble();
+        else if (reader.isName("fieldPhaseID")) fieldData.fieldPhaseID = reader.readInt();
+
+        else if (reader.isName("vits")) {
+            if (!reader.readStartObject()) continue;
+            while (reader.readNext() == JsonStreamReader::name) {
+                // Mark VITS as in use
+                fieldData.vits.inUse = true;
 
-            QJsonObject field;
-            field = jsonFields[fieldNumber].toObject();
+                if (reader.isName("snr")) fieldData.vits.snr = reader.readDouble();
+                else reader.skipNextValue();
+            }
+        }
 
-            fieldData.seqNo = field["seqNo"].toInt();
+        else if (reader.isName("vbi")) readVbi(reader, fieldData.vbi);
 
-            fieldData.isFirstField = field["isFirstField"].toBool();
-            fieldData.syncConf = field["syncConf"].toInt();
-            fieldData.medianBurstIRE = field["medianBurstIRE"].toDouble();
-            fieldData.fieldPhaseID = field["fieldPhaseID"].toInt();
+        // Read the NTSC specific record
+        else if (reader.isName("ntsc")) {
+            if (!reader.readStartObject()) continue;
+            while (reader.readNext() == JsonStreamReader::name) {
+                // Mark as in use
+                fieldData.ntsc.inUse = true;
 
-            QJsonObject vits = field["vits"].toObject();
-            if (!vits.isEmpty()) {
-                fieldData.vits.inUse = true;
-                fieldData.vits.snr = field["snr"].toDouble();
-            } else {
-                // Mark VITS as undefined
-                fieldData.vits.inUse = false;
+                if (reader.isName("isFmCodeDataValid")) fieldData.ntsc.isFmCodeDataValid = reader.readBool();
+                else if (reader.isName("fmCodeData")) fieldData.ntsc.fmCodeData = reader.readInt();
+                else if (reader.isName("fieldFlag")) fieldData.ntsc.fieldFlag = reader.readBool();
+                else if (reader.isName("whiteFlag")) fieldData.ntsc.whiteFlag = reader.readBool();
+                else reader.skipNextValue();
             }
+        }
 
-            QJsonObject vbi = field["vbi"].toObject();
-            if (!vbi.isEmpty()) {
-                // Mark VBI as in use
-                fieldData.vbi.inUse = true;
-
-                fieldData.vbi.vbi16 = vbi["vbi16"].toInt();
-                fieldData.vbi.vbi17 = vbi["vbi17"].toInt();
-                fieldData.vbi.vbi18 = vbi["vbi18"].toInt();
-
-                switch(vbi["discType"].toInt()) {
-                case 0:
-                    fieldData.vbi.type = LdDecodeMetaData::VbiDiscTypes::unknownDiscType;
-                    break;
-                case 1 :
-                    fieldData.vbi.type = LdDecodeMetaData::VbiDiscTypes::clv;
-                    break;
-                case 2 :
-                    fieldData.vbi.type = LdDecodeMetaData::VbiDiscTypes::cav;
-                    break;
-                default:
-                    fieldData.vbi.type = LdDecodeMetaData::VbiDiscTypes::unknownDiscType;
-                }
-
-                fieldData.vbi.leadIn = vbi["leadIn"].toBool();
-                fieldData.vbi.leadOut = vbi["leadOut"].toBool();
-                fieldData.vbi.userCode = vbi["userCode"].toString();
-                fieldData.vbi.picNo = vbi["picNo"].toInt();
-                fieldData.vbi.picStop = vbi["picStop"].toBool();
-                fieldData.vbi.chNo = vbi["chNo"].toInt();
-
-                QJsonObject timeCode = vbi["timeCode"].toObject();
-                fieldData.vbi.timeCode.hr = timeCode["hr"].toInt();
-                fieldData.vbi.timeCode.min = timeCode["min"].toInt();
-
-                // Original programme status code
-                QJsonObject statusCode = vbi["statusCode"].toObject();
-                fieldData.vbi.statusCode.valid = statusCode["valid"].toBool();
-                fieldData.vbi.statusCode.cx = statusCode["cx"].toBool();
-                fieldData.vbi.statusCode.size = statusCode["size"].toBool();
-                fieldData.vbi.statusCode.side = statusCode["side"].toBool();
-                fieldData.vbi.statusCode.teletext = statusCode["teletext"].toBool();
-                fieldData.vbi.statusCode.dump = statusCode["dump"].toBool();
-                fieldData.vbi.statusCode.fm = statusCode["fm"].toBool();
-                fieldData.vbi.statusCode.digital = statusCode["digital"].toBool();
-
-                switch (statusCode["soundMode"].toInt()) {
-                case 0:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::stereo;
-                    break;
-                case 1:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::mono;
-                    break;
-                case 2:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::audioSubCarriersOff;
-                    break;
-                case 3:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::bilingual;
-                    break;
-                case 4:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::stereo_stereo;
-                    break;
-                case 5:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::stereo_bilingual;
-                    break;
-                case 6:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::crossChannelStereo;
-                    break;
-                case 7:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::bilingual_bilingual;
-                    break;
-                case 8:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::mono_dump;
-                    break;
-                case 9:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::stereo_dump;
-                    break;
-                case 10:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::bilingual_dump;
-                    break;
-                case 11:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::futureUse;
-                    break;
-                default:
-                    fieldData.vbi.statusCode.soundMode = LdDecodeMetaData::VbiSoundModes::futureUse;
-                    break;
-                }
-                fieldData.vbi.statusCode.parity = statusCode["parity"].toBool();
-
-                // Amendment 2 programme status code
-                QJsonObject statusCodeAm2 = vbi["statusCodeAm2"].toObject();
-                fieldData.vbi.statusCodeAm2.valid = statusCodeAm2["valid"].toBool();
-                fieldData.vbi.statusCodeAm2.cx = statusCodeAm2["cx"].toBool();
-                fieldData.vbi.statusCodeAm2.size = statusCodeAm2["size"].toBool();
-                fieldData.vbi.statusCodeAm2.side = statusCodeAm2["side"].toBool();
-                fieldData.vbi.statusCodeAm2.teletext = statusCodeAm2["teletext"].toBool();
-                fieldData.vbi.statusCodeAm2.copy = statusCodeAm2["copy"].toBool();
-                fieldData.vbi.statusCodeAm2.standard = statusCodeAm2["standard"].toBool();
-
-                switch (statusCodeAm2["soundMode"].toInt()) {
-                case 0:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::stereo;
-                    break;
-                case 1:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::mono;
-                    break;
-                case 2:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::audioSubCarriersOff;
-                    break;
-                case 3:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::bilingual;
-                    break;
-                case 4:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::stereo_stereo;
-                    break;
-                case 5:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::stereo_bilingual;
-                    break;
-                case 6:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::crossChannelStereo;
-                    break;
-                case 7:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::bilingual_bilingual;
-                    break;
-                case 8:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::mono_dump;
-                    break;
-                case 9:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::stereo_dump;
-                    break;
-                case 10:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::bilingual_dump;
-                    break;
-                case 11:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::futureUse;
-                    break;
-                default:
-                    fieldData.vbi.statusCodeAm2.soundMode = LdDecodeMetaData::VbiSoundModes::futureUse;
-                    break;
-                }
-
-                QJsonObject clvPicNo = vbi["clvPicNo"].toObject();
-                fieldData.vbi.clvPicNo.sec = clvPicNo["sec"].toInt();
-                fieldData.vbi.clvPicNo.picNo = clvPicNo["picNo"].toInt();
-            } else {
-                // Mark VBI as undefined
-                fieldData.vbi.inUse = false;
+        // Read the drop-outs object
+        else if (reader.isName("dropOuts")) {
+            if (!reader.readStartObject()) continue;
+            while (reader.readNext() == JsonStreamReader::name) {
+                if (reader.isName("startx")) readIntArray(reader, fieldData.dropOuts.startx);
+                else if (reader.isName("endx")) readIntArray(reader, fieldData.dropOuts.endx);
+                else if (reader.isName("fieldLine")) readIntArray(reader, fieldData.dropOuts.fieldLine);
+                else reader.skipNextValue();
             }
 
-            // Read the NTSC specific record
-            QJsonObject ntsc = field["ntsc"].toObject();
-            if (!ntsc.isEmpty()) {
-                // Mark as in use
-                fieldData.ntsc.inUse = true;
+            // The number of drop-outs is set by startx (missing values are 0)
+            fieldData.dropOuts.endx.resize(fieldData.dropOuts.startx.size());
+            fieldData.dropOuts.fieldLine.resize(fieldData.dropOuts.startx.size());
+        }
 
-                fieldData.ntsc.isFmCodeDataValid = ntsc["isFmCodeDataValid"].toBool();
-                fieldData.ntsc.fmCodeData = ntsc["fmCodeData"].toInt();
-                fieldData.ntsc.fieldFlag = ntsc["fieldFlag"].toBool();
-                fieldData.ntsc.whiteFlag = ntsc["whiteFlag"].toBool();
-            } else {
-                // Mark ntscSpecific as undefined
-                fieldData.ntsc.inUse = false;
+        else reader.skipNextValue();
+    }
+}
+
+// Read a VBI object
+void LdDecodeMetaData::readVbi(JsonStreamReader &reader, Vbi &vbi)
+{
+    if (!reader.readStartObject()) return;
+
+    while (reader.readNext() == JsonStreamReader::name) {
+        // Mark VBI as in use
+        vbi.inUse = true;
+
+        if (reader.isName("vbi16")) vbi.vbi16 = reader.readInt();
+        else if (reader.isName("vbi17")) vbi.vbi17 = reader.readInt();
+        else if (reader.isName("vbi18")) vbi.vbi18 = reader.readInt();
+
+        // Note: the disc type is written as "type" (earlier versions read "discType")
+        else if (reader.isName("type") || reader.isName("discType")) {
+            switch (reader.readInt()) {
+            case 1:
+                vbi.type = LdDecodeMetaData::VbiDiscTypes::clv;
+                break;
+            case 2:
+                vbi.type = LdDecodeMetaData::VbiDiscTypes::cav;
+                break;
+            default:
+                vbi.type = LdDecodeMetaData::VbiDiscTypes::unknownDiscType;
             }
+        }
 
-            // Read the drop-outs object
-            QJsonObject dropOuts = field["dropOuts"].toObject();
+        else if (reader.isName("leadIn")) vbi.leadIn = reader.readBool();
+        else if (reader.isName("leadOut")) vbi.leadOut = reader.readBool();
+        else if (reader.isName("userCode")) {
+            vbi.userCode = reader.readString();
+            internUserCode(vbi.userCode);
+        }
+        else if (reader.isName("picNo")) vbi.picNo = reader.readInt();
+        else if (reader.isName("picStop")) vbi.picStop = reader.readBool();
+        else if (reader.isName("chNo")) vbi.chNo = reader.readInt();
+
+        else if (reader.isName("timeCode")) {
+            if (!reader.readStartObject()) continue;
+            while (reader.readNext() == JsonStreamReader::name) {
+                if (reader.isName("hr")) vbi.timeCode.hr = reader.readInt();
+                else if (reader.isName("min")) vbi.timeCode.min = reader.readInt();
+                else reader.skipNextValue();
+            }
+        }
 
-            QJsonArray startx = dropOuts["startx"].toArray();
-            QJsonArray endx = dropOuts["endx"].toArray();
-            QJsonArray fieldLine = dropOuts["fieldLine"].toArray();
+        // Original programme status code
+        else if (reader.isName("statusCode")) {
+            if (!reader.readStartObject()) continue;
+            while (reader.readNext() == JsonStreamReader::name) {
+                if (reader.isName("valid")) vbi.statusCode.valid = reader.readBool();
+                else if (reader.isName("cx")) vbi.statusCode.cx = reader.readBool();
+                else if (reader.isName("size")) vbi.statusCode.size = reader.readBool();
+                else if (reader.isName("side")) vbi.statusCode.side = reader.readBool();
+                else if (reader.isName("teletext")) vbi.statusCode.teletext = reader.readBool();
+                else if (reader.isName("dump")) vbi.statusCode.dump = reader.readBool();
+                else if (reader.isName("fm")) vbi.statusCode.fm = reader.readBool();
+                else if (reader.isName("digital")) vbi.statusCode.digital = reader.readBool();
+                else if (reader.isName("soundMode")) vbi.statusCode.soundMode = getSoundMode(reader.readInt());
+                else if (reader.isName("parity")) vbi.statusCode.parity = reader.readBool();
+                else reader.skipNextValue();
+            }
+        }
 
-            for (qint32 doCounter = 0; doCounter < startx.size(); doCounter++) {
-                fieldData.dropOuts.startx.append(startx[doCounter].toInt());
-                fieldData.dropOuts.endx.append(endx[doCounter].toInt());
-                fieldData.dropOuts.fieldLine.append(fieldLine[doCounter].toInt());
+        // Amendment 2 programme status code
+        else if (reader.isName("statusCodeAm2")) {
+            if (!reader.readStartObject()) continue;
+            while (reader.readNext() == JsonStreamReader::name) {
+                if (reader.isName("valid")) vbi.statusCodeAm2.valid = reader.readBool();
+                else if (reader.isName("cx")) vbi.statusCodeAm2.cx = reader.readBool();
+                else if (reader.isName("size")) vbi.statusCodeAm2.size = reader.readBool();
+                else if (reader.isName("side")) vbi.statusCodeAm2.side = reader.readBool();
+                else if (reader.isName("teletext")) vbi.statusCodeAm2.teletext = reader.readBool();
+                else if (reader.isName("copy")) vbi.statusCodeAm2.copy = reader.readBool();
+                else if (reader.isName("standard")) vbi.statusCodeAm2.standard = reader.readBool();
+                else if (reader.isName("soundMode")) vbi.statusCodeAm2.soundMode = getSoundMode(reader.readInt());
+                else reader.skipNextValue();
             }
+        }
 
-            // Insert field data into the vector
-            metaData.fields[fieldNumber] = fieldData;
+        else if (reader.isName("clvPicNo")) {
+            if (!reader.readStartObject()) continue;
+            while (reader.readNext() == JsonStreamReader::name) {
+                if (reader.isName("sec")) vbi.clvPicNo.sec = reader.readInt();
+                else if (reader.isName("picNo")) vbi.clvPicNo.picNo = reader.readInt();
+                else reader.skipNextValue();
+            }
         }
-    }  else {
-        qDebug() << "LdDecodeMetaData::read(): fields object is not defined";
+
+        else reader.skipNextValue();
     }
+}
 
-    return true;
+// Read an array of integers (values that are not integers are read as 0)
+void LdDecodeMetaData::readIntArray(JsonStreamReader &reader, QVector<qint32> &values)
+{
+    values.clear();
+    if (!reader.readStartArray()) return;
+
+    while (reader.readNext() != JsonStreamReader::endArray) {
+        if (!reader.skipCurrentValue()) return;
+        values.append(reader.getInt());
+    }
+}
+
+// Convert a VBI sound mode number to the sound mode
+LdDecodeMetaData::VbiSoundModes LdDecodeMetaData::getSoundMode(qint32 soundMode)
+{
+    switch (soundMode) {
+    case 0:
+        return LdDecodeMetaData::VbiSoundModes::stereo;
+    case 1:
+        return LdDecodeMetaData::VbiSoundModes::mono;
+    case 2:
+        return LdDecodeMetaData::VbiSoundModes::audioSubCarriersOff;
+    case 3:
+        return LdDecodeMetaData::VbiSoundModes::bilingual;
+    case 4:
+        return LdDecodeMetaData::VbiSoundModes::stereo_stereo;
+    case 5:
+        return LdDecodeMetaData::VbiSoundModes::stereo_bilingual;
+    case 6:
+        return LdDecodeMetaData::VbiSoundModes::crossChannelStereo;
+    case 7:
+        return LdDecodeMetaData::VbiSoundModes::bilingual_bilingual;
+    case 8:
+        return LdDecodeMetaData::VbiSoundModes::mono_dump;
+    case 9:
+        return LdDecodeMetaData::VbiSoundModes::stereo_dump;
+    case 10:
+        return LdDecodeMetaData::VbiSoundModes::bilingual_dump;
+    default:
+        return LdDecodeMetaData::VbiSoundModes::futureUse;
+    }
 }
 
 // This method copies the metadata structure into a JSON metadata file
 bool LdDecodeMetaData::write(QString fileName)
 {
-    QJsonObject lddecodeJson;
+    return write(fileName, 1, getNumberOfFields());
+}
 
-    // Write the video parameters and fields
-    QJsonObject jsonVideoParameters;
-    QJsonArray jsonFields;
+// This method writes partial metadata (the parameters and a range of fields) to a JSON
+// metadata file.  Unless the range is all of the fields, the file records the range in a
+// fieldRange object, so partial files can be merged back into the complete metadata
+bool LdDecodeMetaData::write(QString fileName, qint32 firstSequentialFieldNumber, qint32 lastSequentialFieldNumber)
+{
+    if (firstSequentialFieldNumber < 1 || lastSequentialFieldNumber > getNumberOfFields() ||
+            (lastSequentialFieldNumber < firstSequentialFieldNumber && getNumberOfFields() != 0)) {
+        qWarning() << "Cannot write fields" << firstSequentialFieldNumber << "to" << lastSequentialFieldNumber << "- the range is not valid";
+        return false;
+    }
 
-    // Write the video paramters
-    jsonVideoParameters.insert("numberOfSequentialFields", metaData.videoParameters.numberOfSequentialFields);
-    jsonVideoParameters.insert("isSourcePal", metaData.videoParameters.isSourcePal);
+    // Never replace the file the metadata was read from with a range of its fields
+    bool isRange = firstSequentialFieldNumber != 1 || lastSequentialFieldNumber != getNumberOfFields();
+    if (isRange && !readFileName.isEmpty() && isSameFile(fileName, readFileName)) {
+        qWarning() << "Cannot write fields" << firstSequentialFieldNumber << "to" << lastSequentialFieldNumber <<
+                      "to" << fileName << "- it is the JSON file the metadata was read from";
+        return false;
+    }
 
-    jsonVideoParameters.insert("colourBurstStart", metaData.videoParameters.colourBurstStart);
-    jsonVideoParameters.insert("colourBurstEnd", metaData.videoParameters.colourBurstEnd);
-    jsonVideoParameters.insert("blackLevelStart", metaData.videoParameters.blackLevelStart);
-    jsonVideoParameters.insert("blackLevelEnd", metaData.videoParameters.blackLevelEnd);
-    jsonVideoParameters.insert("activeVideoStart", metaData.videoParameters.activeVideoStart);
-    jsonVideoParameters.insert("activeVideoEnd", metaData.videoParameters.activeVideoEnd);
+    // The fields are formatted from the drop-out store, so get the drop-outs from the sidecar
+    if (isSidecarDropOutsPending) loadSidecarDropOuts();
 
-    jsonVideoParameters.insert("white16bIre", metaData.videoParameters.white16bIre);
-    jsonVideoParameters.insert("black16bIre", metaData.videoParameters.black16bIre);
+    qDebug() << "LdDecodeMetaData::write(): Saving JSON file" << fileName;
+    QFile jsonFileHandle(fileName);
 
-    jsonVideoParameters.insert("samplesPerUs", metaData.videoParameters.samplesPerUs);
+    if (!jsonFileHandle.open(QIODevice::WriteOnly)) {
+        qWarning("Could not save JSON file!");
+        return false;
+    }
 
-    jsonVideoParameters.insert("fieldWidth", metaData.videoParameters.fieldWidth);
-    jsonVideoParameters.insert("fieldHeight", metaData.videoParameters.fieldHeight);
-    jsonVideoParameters.insert("sampleRate", metaData.videoParameters.sampleRate);
-    jsonVideoParameters.insert("fsc", metaData.videoParameters.fsc);
+    // The members are written in alphabetical order (as QJsonDocument orders them)
+    JsonStreamWriter writer(&jsonFileHandle, jsonFormat);
+    writer.writeStartObject();
+
+    // Write the field range of partial metadata (the first field of the file is the first
+    // field of the range).  If this metadata is itself partial, the range is given in the
+    // field numbers of the complete metadata
+    if (firstSequentialFieldNumber != 1 || lastSequentialFieldNumber != getNumberOfFields() || isPartial()) {
+        qint32 fieldNumberOffset = isPartial() ? partialFirstFieldNumber - 1 : 0;
+        writer.writeName("fieldRange");
+        writer.writeStartObject();
+        writer.writeMember("firstField", firstSequentialFieldNumber + fieldNumberOffset);
+        writer.writeMember("lastField", lastSequentialFieldNumber + fieldNumberOffset);
+        writer.writeEndObject();
+    }
 
-    // Add the video parameters to the parent object
-    lddecodeJson.insert("videoParameters", jsonVideoParameters);
+    // Write the field data
+    if (getNumberOfFields() != 0) {
+        qDebug() << "LdDecodeMetaData::write(): metadata struct contains" << getNumberOfFields() << "fields, writing fields" <<
+                    firstSequentialFieldNumber << "to" << lastSequentialFieldNumber;
+
+        writer.writeName("fields");
+        writer.writeStartArray();
+        writeFields(writer, firstSequentialFieldNumber - 1, lastSequentialFieldNumber - 1);
+        writer.writeEndArray();
+    }
 
     // Write the PCM audio parameters
-    QJsonObject pcmAudioParameters;
-    pcmAudioParameters.insert("sampleRate", metaData.pcmAudioParameters.sampleRate);
-    pcmAudioParameters.insert("isLittleEndian", metaData.pcmAudioParameters.isLittleEndian);
-    pcmAudioParameters.insert("isSigned", metaData.pcmAudioParameters.isSigned);
-    pcmAudioParameters.insert("bits", metaData.pcmAudioParameters.bits);
+    writer.writeName("pcmAudioParameters");
+    writer.writeStartObject();
+    writer.writeMember("bits", metaData.pcmAudioParameters.bits);
+    writer.writeMember("isLittleEndian", metaData.pcmAudioParameters.isLittleEndian);
+    writer.writeMember("isSigned", metaData.pcmAudioParameters.isSigned);
+    writer.writeMember("sampleRate", metaData.pcmAudioParameters.sampleRate);
+    writer.writeEndObject();
 
-    // Add the audio parameters to the parent object
-    lddecodeJson.insert("pcmAudioParameters", pcmAudioParameters);
+    // Write the video paramters
+    writer.writeName("videoParameters");
+    writer.writeStartObject();
+    writer.writeMember("activeVideoEnd", metaData.videoParameters.activeVideoEnd);
+    writer.writeMember("activeVideoStart", metaData.videoParameters.activeVideoStart);
+    writer.writeMember("black16bIre", metaData.videoParameters.black16bIre);
+    writer.writeMember("blackLevelEnd", metaData.videoParameters.blackLevelEnd);
+    writer.writeMember("blackLevelStart", metaData.videoParameters.blackLevelStart);
+    writer.writeMember("colourBurstEnd", metaData.videoParameters.colourBurstEnd);
+    writer.writeMember("colourBurstStart", metaData.videoParameters.colourBurstStart);
+    writer.writeMember("fieldHeight", metaData.videoParameters.fieldHeight);
+    writer.writeMember("fieldWidth", metaData.videoParameters.fieldWidth);
+    writer.writeMember("fsc", metaData.videoParameters.fsc);
+    writer.writeMember("isSourcePal", metaData.videoParameters.isSourcePal);
+    writer.writeMember("numberOfSequentialFields", metaData.videoParameters.numberOfSequentialFields);
+    writer.writeMember("sampleRate", metaData.videoParameters.sampleRate);
+    writer.writeMember("samplesPerUs", metaData.videoParameters.samplesPerUs);
+    writer.writeMember("white16bIre", metaData.videoParameters.white16bIre);
+    writer.writeEndObject();
+
+    writer.writeEndObject();
+
+    bool isWritten = writer.flush();
+    jsonFileHandle.close();
 
-    // Write the field data
-    if (!metaData.fields.isEmpty()) {
-        QJsonArray fields;
+    if (!isWritten) {
+        qWarning("Could not save JSON file!");
+        return false;
+    }
 
-        qDebug() << "LdDecodeMetaData::write(): metadata struct contains" << metaData.fields.size() << "fields";
+    return true;
+}
+
+// Set the format of the JSON files written by write() (indented by default)
+void LdDecodeMetaData::setJsonFormat(JsonStreamWriter::Format jsonFormatParam)
+{
+    jsonFormat = jsonFormatParam;
+}
 
-        for (qint32 fieldNumber = 0; fieldNumber < metaData.fields.size(); fieldNumber++) {
-            QJsonObject field;
+JsonStreamWriter::Format LdDecodeMetaData::getJsonFormat(void)
+{
+    return jsonFormat;
+}
 
-            field.insert("seqNo", metaData.fields[fieldNumber].seqNo);
+// Formats a chunk of the fields array in its own thread (see writeFields())
+class LdDecodeMetaData::FieldChunkWriter : public QThread
+{
+public:
+    FieldChunkWriter(const LdDecodeMetaData &ldDecodeMetaDataParam, JsonStreamWriter::Format formatParam)
+        : ldDecodeMetaData(ldDecodeMetaDataParam), format(formatParam)
+    {
+        firstFieldIndex = 0;
+        lastFieldIndex = -1;
+        isFirstChunk = true;
+    }
 
-            field.insert("isFirstField", metaData.fields[fieldNumber].isFirstField);
-            field.insert("syncConf", metaData.fields[fieldNumber].syncConf);
-            field.insert("medianBurstIRE", metaData.fields[fieldNumber].medianBurstIRE);
-            field.insert("fieldPhaseID", metaData.fields[fieldNumber].fieldPhaseID);
+    // Start formatting the fields from firstFieldIndexParam to lastFieldIndexParam (inclusive)
+    void startChunk(qint32 firstFieldIndexParam, qint32 lastFieldIndexParam, bool isFirstChunkParam)
+    {
+        firstFieldIndex = firstFieldIndexParam;
+        lastFieldIndex = lastFieldIndexParam;
+        isFirstChunk = isFirstChunkParam;
+        start();
+    }
 
-            // Write the VITS data if in use
-            if (metaData.fields[fieldNumber].vits.inUse) {
-                QJsonObject vits;
-                vits.insert("snr", metaData.fields[fieldNumber].vits.snr);
+    // Get the formatted chunk (once the thread has finished)
+    QByteArray takeJson(void)
+    {
+        QByteArray chunkJson;
+        chunkJson.swap(json);
+        return chunkJson;
+    }
 
-                // Add the vits to the field
-                field.insert("vits", vits);
+protected:
+    void run() override
+    {
+        // The fields array is at depth 2 (in the top-level object)
+        JsonStreamWriter writer(format);
+        writer.continueArray(2, isFirstChunk);
+
+        for (qint32 fieldIndex = firstFieldIndex; fieldIndex <= lastFieldIndex; fieldIndex++) {
+            DropOutSpan dropOuts = ldDecodeMetaData.dropOutStore.getDropOuts(fieldIndex);
+            if (ldDecodeMetaData.sidecar != nullptr) {
+                writeField(writer, ldDecodeMetaData.sidecar->getField(fieldIndex, false), dropOuts);
+            } else {
+                writeField(writer, ldDecodeMetaData.metaData.fields.at(fieldIndex), dropOuts);
             }
+        }
 
-            // Write the VBI data if in use
-            if (metaData.fields[fieldNumber].vbi.inUse) {
-                QJsonObject vbi;
-
-                vbi.insert("vbi16", metaData.fields[fieldNumber].vbi.vbi16);
-                vbi.insert("vbi17", metaData.fields[fieldNumber].vbi.vbi17);
-                vbi.insert("vbi18", metaData.fields[fieldNumber].vbi.vbi18);
-
-                switch(metaData.fields[fieldNumber].vbi.type) {
-                case LdDecodeMetaData::VbiDiscTypes::unknownDiscType:
-                    vbi.insert("type", 0);
-                    break;
-                case LdDecodeMetaData::VbiDiscTypes::clv:
-                    vbi.insert("type", 1);
-                    break;
-                case LdDecodeMetaData::VbiDiscTypes::cav:
-                    vbi.insert("type", 2);
-                    break;
-                }
-
-                vbi.insert("leadIn", metaData.fields[fieldNumber].vbi.leadIn);
-                vbi.insert("leadOut", metaData.fields[fieldNumber].vbi.leadOut);
-                vbi.insert("userCode", metaData.fields[fieldNumber].vbi.userCode);
-                vbi.insert("picNo", metaData.fields[fieldNumber].vbi.picNo);
-                vbi.insert("picStop", metaData.fields[fieldNumber].vbi.picStop);
-                vbi.insert("chNo", metaData.fields[fieldNumber].vbi.chNo);
-
-                QJsonObject timeCode;
-                timeCode.insert("hr", metaData.fields[fieldNumber].vbi.timeCode.hr);
-                timeCode.insert("min", metaData.fields[fieldNumber].vbi.timeCode.min);
-                vbi.insert("timeCode", timeCode);
-
-                // Original programme status code
-                QJsonObject statusCode;
-                statusCode.insert("valid", metaData.fields[fieldNumber].vbi.statusCode.valid);
-                statusCode.insert("cx", metaData.fields[fieldNumber].vbi.statusCode.cx);
-                statusCode.insert("size", metaData.fields[fieldNumber].vbi.statusCode.size);
-                statusCode.insert("side", metaData.fields[fieldNumber].vbi.statusCode.side);
-                statusCode.insert("teletext", metaData.fields[fieldNumber].vbi.statusCode.teletext);
-                statusCode.insert("dump", metaData.fields[fieldNumber].vbi.statusCode.dump);
-                statusCode.insert("fm", metaData.fields[fieldNumber].vbi.statusCode.fm);
-                statusCode.insert("digital", metaData.fields[fieldNumber].vbi.statusCode.digital);
-
-                switch (metaData.fields[fieldNumber].vbi.statusCode.soundMode) {
-                case LdDecodeMetaData::VbiSoundModes::stereo:
-                    statusCode.insert("soundMode", 0);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::mono:
-                    statusCode.insert("soundMode", 1);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::audioSubCarriersOff:
-                    statusCode.insert("soundMode", 2);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::bilingual:
-                    statusCode.insert("soundMode", 3);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::stereo_stereo:
-                    statusCode.insert("soundMode", 4);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::stereo_bilingual:
-                    statusCode.insert("soundMode", 5);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::crossChannelStereo:
-                    statusCode.insert("soundMode", 6);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::bilingual_bilingual:
-                    statusCode.insert("soundMode", 7);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::mono_dump:
-                    statusCode.insert("soundMode", 8);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::stereo_dump:
-                    statusCode.insert("soundMode", 9);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::bilingual_dump:
-                    statusCode.insert("soundMode", 10);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::futureUse:
-                    statusCode.insert("soundMode", 11);
-                    break;
-                }
-                statusCode["parity"] = metaData.fields[fieldNumber].vbi.statusCode.parity;
-                vbi.insert("statusCode", statusCode);
-
-                // Amendment 2 programme status code
-                QJsonObject statusCodeAm2;
-                statusCodeAm2.insert("valid", metaData.fields[fieldNumber].vbi.statusCodeAm2.valid);
-                statusCodeAm2.insert("cx", metaData.fields[fieldNumber].vbi.statusCodeAm2.cx);
-                statusCodeAm2.insert("size", metaData.fields[fieldNumber].vbi.statusCodeAm2.size);
-                statusCodeAm2.insert("side", metaData.fields[fieldNumber].vbi.statusCodeAm2.side);
-                statusCodeAm2.insert("teletext", metaData.fields[fieldNumber].vbi.statusCodeAm2.teletext);
-                statusCodeAm2.insert("copy", metaData.fields[fieldNumber].vbi.statusCodeAm2.copy);
-                statusCodeAm2.insert("standard", metaData.fields[fieldNumber].vbi.statusCodeAm2.standard);
-
-                switch (metaData.fields[fieldNumber].vbi.statusCodeAm2.soundMode) {
-                case LdDecodeMetaData::VbiSoundModes::stereo:
-                    statusCodeAm2.insert("soundMode", 0);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::mono:
-                    statusCodeAm2.insert("soundMode", 1);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::audioSubCarriersOff:
-                    statusCodeAm2.insert("soundMode", 2);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::bilingual:
-                    statusCodeAm2.insert("soundMode", 3);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::stereo_stereo:
-                    statusCodeAm2.insert("soundMode", 4);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::stereo_bilingual:
-                    statusCodeAm2.insert("soundMode", 5);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::crossChannelStereo:
-                    statusCodeAm2.insert("soundMode", 6);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::bilingual_bilingual:
-                    statusCodeAm2.insert("soundMode", 7);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::mono_dump:
-                    statusCodeAm2.insert("soundMode", 8);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::stereo_dump:
-                    statusCodeAm2.insert("soundMode", 9);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::bilingual_dump:
-                    statusCodeAm2.insert("soundMode", 10);
-                    break;
-                case LdDecodeMetaData::VbiSoundModes::futureUse:
-                    statusCodeAm2.insert("soundMode", 11);
-                    break;
-                }
-                vbi.insert("statusCodeAm2", statusCodeAm2);
-
-                QJsonObject clvPicNo;
-                clvPicNo.insert("sec", metaData.fields[fieldNumber].vbi.clvPicNo.sec);
-                clvPicNo.insert("picNo", metaData.fields[fieldNumber].vbi.clvPicNo.picNo);
-                vbi.insert("clvPicNo", clvPicNo);
-
-                // Add the vbi to the field
-                field.insert("vbi", vbi);
-            }
+        json = writer.takeBuffer();
+    }
 
-            // Write the NTSC specific record if in use
-            if (metaData.fields[fieldNumber].ntsc.inUse) {
-                QJsonObject ntsc;
-                ntsc.insert("isFmCodeDataValid", metaData.fields[fieldNumber].ntsc.isFmCodeDataValid);
-                if (metaData.fields[fieldNumber].ntsc.isFmCodeDataValid)
-                    ntsc.insert("fmCodeData", metaData.fields[fieldNumber].ntsc.fmCodeData);
-                else ntsc.insert("fmCodeData", -1);
-                ntsc.insert("fieldFlag", metaData.fields[fieldNumber].ntsc.fieldFlag);
-                ntsc.insert("whiteFlag", metaData.fields[fieldNumber].ntsc.whiteFlag);
-
-                // Add the NTSC specific data to the field
-                field.insert("ntsc", ntsc);
-            }
+private:
+    const LdDecodeMetaData &ldDecodeMetaData;
+    JsonStreamWriter::Format format;
+    qint32 firstFieldIndex;
+    qint32 lastFieldIndex;
+    bool isFirstChunk;
+    QByteArray json;
+};
+
+// Write the fields from firstFieldIndex to lastFieldIndex (inclusive) to the open fields
+// array.  The fields are formatted in chunks by a number of threads: each thread is given
+// a chunk in turn, and the chunks are taken back (and written) in the same order, with each
+// thread starting its next chunk as soon as its last chunk is taken.  So formatting runs
+// in parallel whilst the earlier chunks are written, and only one chunk per thread is held
+// in memory
+void LdDecodeMetaData::writeFields(JsonStreamWriter &writer, qint32 firstFieldIndex, qint32 lastFieldIndex)
+{
+    qint32 numberOfChunks = (lastFieldIndex - firstFieldIndex + fieldsPerWriteChunk) / fieldsPerWriteChunk;
+    qint32 numberOfThreads = qMin(ThreadAffinity::getDefaultThreadCount(), numberOfChunks);
 
-            // Write the drop-out records
-            if (metaData.fields[fieldNumber].dropOuts.startx.size() != 0) {
-                QJsonObject dropOuts;
-                QJsonArray startx;
-                QJsonArray endx;
-                QJsonArray fieldLine;
-
-                // Populate the arrays with the drop out metadata
-                for (qint32 doCounter = 0; doCounter < metaData.fields[fieldNumber].dropOuts.startx.size(); doCounter++) {
-                    startx.append(metaData.fields[fieldNumber].dropOuts.startx[doCounter]);
-                    endx.append(metaData.fields[fieldNumber].dropOuts.endx[doCounter]);
-                    fieldLine.append(metaData.fields[fieldNumber].dropOuts.fieldLine[doCounter]);
-                }
-
-                // Add the drop out arrays to the dropOuts object
-                dropOuts.insert("startx", startx);
-                dropOuts.insert("endx", endx);
-                dropOuts.insert("fieldLine", fieldLine);
-
-                // Add the drop-outs object to the field object
-                field.insert("dropOuts", dropOuts);
-            }
+    QVector<FieldChunkWriter *> chunkWriters;
+    for (qint32 threadNumber = 0; threadNumber < numberOfThreads; threadNumber++) {
+        chunkWriters.append(new FieldChunkWriter(*this, jsonFormat));
+    }
 
-            // Insert field data into the field array
-            fields.insert(fieldNumber, field);
+    // Start the first chunk on each thread
+    qint32 nextFieldIndex = firstFieldIndex;
+    for (qint32 threadNumber = 0; threadNumber < numberOfThreads; threadNumber++) {
+        chunkWriters[threadNumber]->startChunk(nextFieldIndex, qMin(nextFieldIndex + fieldsPerWriteChunk - 1, lastFieldIndex),
+                                               threadNumber == 0);
+        nextFieldIndex += fieldsPerWriteChunk;
+    }
+
+    // Chunk n is formatted by thread n % numberOfThreads
+    for (qint32 chunkNumber = 0; chunkNumber < numberOfChunks; chunkNumber++) {
+        FieldChunkWriter *chunkWriter = chunkWriters[chunkNumber % numberOfThreads];
+        chunkWriter->wait();
+        writer.writeRawElements(chunkWriter->takeJson());
+
+        if (nextFieldIndex <= lastFieldIndex) {
+            chunkWriter->startChunk(nextFieldIndex, qMin(nextFieldIndex + fieldsPerWriteChunk - 1, lastFieldIndex), false);
+            nextFieldIndex += fieldsPerWriteChunk;
         }
+    }
+
+    qDeleteAll(chunkWriters);
+}
 
-        // Add the fields to the parent object
-        lddecodeJson.insert("fields", fields);
+// Write a field object (the members are in alphabetical order).  This uses no member
+// variables, so fields can be formatted by several threads at once
+void LdDecodeMetaData::writeField(JsonStreamWriter &writer, const Field &fieldData, const DropOutSpan &dropOuts)
+{
+    writer.writeStartObject();
+
+    // Write the drop-out records
+    if (!dropOuts.isEmpty()) {
+        writer.writeName("dropOuts");
+        writer.writeStartObject();
+        writeIntArray(writer, "endx", dropOuts.constEndx(), dropOuts.size());
+        writeIntArray(writer, "fieldLine", dropOuts.constFieldLine(), dropOuts.size());
+        writeIntArray(writer, "startx", dropOuts.constStartx(), dropOuts.size());
+        writer.writeEndObject();
     }
 
-    // Add the JSON data to the document
-    qDebug() << "Creating the JSON document";
-    QJsonDocument document(lddecodeJson);
+    writer.writeMember("fieldPhaseID", fieldData.fieldPhaseID);
+    writer.writeMember("isFirstField", fieldData.isFirstField);
+    writer.writeMember("medianBurstIRE", fieldData.medianBurstIRE);
+
+    // Write the NTSC specific record if in use
+    if (fieldData.ntsc.inUse) {
+        writer.writeName("ntsc");
+        writer.writeStartObject();
+        writer.writeMember("fieldFlag", fieldData.ntsc.fieldFlag);
+        writer.writeMember("fmCodeData", fieldData.ntsc.isFmCodeDataValid ? fieldData.ntsc.fmCodeData : -1);
+        writer.writeMember("isFmCodeDataValid", fieldData.ntsc.isFmCodeDataValid);
+        writer.writeMember("whiteFlag", fieldData.ntsc.whiteFlag);
+        writer.writeEndObject();
+    }
 
-    // Write the json document to a file
-    qDebug() << "LdDecodeMetaData::write(): Saving JSON file" << fileName;
-    QFile jsonFileHandle(fileName);
+    writer.writeMember("seqNo", fieldData.seqNo);
+    writer.writeMember("syncConf", fieldData.syncConf);
 
-    if (!jsonFileHandle.open(QIODevice::WriteOnly)) {
-        qWarning("Could not save JSON file!");
+    // Write the VBI data if in use
+    if (fieldData.vbi.inUse) {
+        writer.writeName("vbi");
+        writeVbi(writer, fieldData.vbi);
+    }
+
+    // Write the VITS data if in use
+    if (fieldData.vits.inUse) {
+        writer.writeName("vits");
+        writer.writeStartObject();
+        writer.writeMember("snr", fieldData.vits.snr);
+        writer.writeEndObject();
+    }
+
+    writer.writeEndObject();
+}
+
+// Write a VBI object.  The disc type and sound modes are written as their enum values
+// (see VbiDiscTypes and VbiSoundModes)
+void LdDecodeMetaData::writeVbi(JsonStreamWriter &writer, const Vbi &vbi)
+{
+    writer.writeStartObject();
+    writer.writeMember("chNo", vbi.chNo);
+
+    writer.writeName("clvPicNo");
+    writer.writeStartObject();
+    writer.writeMember("picNo", vbi.clvPicNo.picNo);
+    writer.writeMember("sec", vbi.clvPicNo.sec);
+    writer.writeEndObject();
+
+    writer.writeMember("leadIn", vbi.leadIn);
+    writer.writeMember("leadOut", vbi.leadOut);
+    writer.writeMember("picNo", vbi.picNo);
+    writer.writeMember("picStop", vbi.picStop);
+
+    // Original programme status code
+    writer.writeName("statusCode");
+    writer.writeStartObject();
+    writer.writeMember("cx", vbi.statusCode.cx);
+    writer.writeMember("digital", vbi.statusCode.digital);
+    writer.writeMember("dump", vbi.statusCode.dump);
+    writer.writeMember("fm", vbi.statusCode.fm);
+    writer.writeMember("parity", vbi.statusCode.parity);
+    writer.writeMember("side", vbi.statusCode.side);
+    writer.writeMember("size", vbi.statusCode.size);
+    writer.writeMember("soundMode", static_cast<qint32>(vbi.statusCode.soundMode));
+    writer.writeMember("teletext", vbi.statusCode.teletext);
+    writer.writeMember("valid", vbi.statusCode.valid);
+    writer.writeEndObject();
+
+    // Amendment 2 programme status code
+    writer.writeName("statusCodeAm2");
+    writer.writeStartObject();
+    writer.writeMember("copy", vbi.statusCodeAm2.copy);
+    writer.writeMember("cx", vbi.statusCodeAm2.cx);
+    writer.writeMember("side", vbi.statusCodeAm2.side);
+    writer.writeMember("size", vbi.statusCodeAm2.size);
+    writer.writeMember("soundMode", static_cast<qint32>(vbi.statusCodeAm2.soundMode));
+    writer.writeMember("standard", vbi.statusCodeAm2.standard);
+    writer.writeMember("teletext", vbi.statusCodeAm2.teletext);
+    writer.writeMember("valid", vbi.statusCodeAm2.valid);
+    writer.writeEndObject();
+
+    writer.writeName("timeCode");
+    writer.writeStartObject();
+    writer.writeMember("hr", vbi.timeCode.hr);
+    writer.writeMember("min", vbi.timeCode.min);
+    writer.writeEndObject();
+
+    writer.writeMember("type", static_cast<qint32>(vbi.type));
+    writer.writeMember("userCode", vbi.userCode);
+    writer.writeMember("vbi16", vbi.vbi16);
+    writer.writeMember("vbi17", vbi.vbi17);
+    writer.writeMember("vbi18", vbi.vbi18);
+    writer.writeEndObject();
+}
+
+void LdDecodeMetaData::writeIntArray(JsonStreamWriter &writer, const char *name, const qint32 *values, qint32 count)
+{
+    writer.writeName(name);
+    writer.writeStartArray();
+    for (qint32 index = 0; index < count; index++) writer.writeInt(values[index]);
+    writer.writeEndArray();
+}
+
+// This method writes the metadata to a binary sidecar for the specified JSON file, so the
+// metadata can be read without parsing the JSON file (until the JSON file is changed).
+// The sidecar holds all of the metadata, so JSON and sidecar convert without loss
+bool LdDecodeMetaData::writeSidecar(QString jsonFileName)
+{
+    // The sidecar does not record a field range, so partial metadata is kept as JSON
+    if (isPartial()) {
+        qDebug() << "LdDecodeMetaData::writeSidecar(): Partial metadata is not written to a sidecar";
         return false;
     }
 
-    jsonFileHandle.write(document.toJson(QJsonDocument::Indented));
-    jsonFileHandle.close();
+    // The sidecar is only checked against the JSON file, so it must not include the updates
+    // of a journal (which are replayed by read()); otherwise discarding the journal would not
+    // discard its updates
+    if (QFile::exists(MetaDataJournal::getFileName(jsonFileName))) {
+        qDebug() << "LdDecodeMetaData::writeSidecar(): The JSON file has a metadata journal - not writing a sidecar";
+        return false;
+    }
+
+    return MetaDataSidecar::write(MetaDataSidecar::getFileName(jsonFileName), jsonFileName, *this);
+}
+
+// Returns true if the metadata only holds a range of fields (see write())
+bool LdDecodeMetaData::isPartial(void)
+{
+    return partialFirstFieldNumber != 0;
+}
+
+// Returns the sequential field number, in the complete metadata, of the first field of
+// partial metadata (or 1 if the metadata is complete)
+qint32 LdDecodeMetaData::getPartialFirstFieldNumber(void)
+{
+    return isPartial() ? partialFirstFieldNumber : 1;
+}
+
+// Returns true if the metadata was read from a binary sidecar
+bool LdDecodeMetaData::isReadFromSidecar(void)
+{
+    return sidecar != nullptr;
+}
+
+// This method opens the metadata journal for the specified JSON file.  Whilst the journal
+// is open, every updated field is appended to the journal, so a processing pass that is
+// interrupted can be resumed from getLastJournalledFieldNumber().  The JSON file can be
+// other than the file that was read (e.g. the partial output of a field range), in which
+// case the journal of that file is replayed here.  When the journal is compacted, the
+// fields from firstSequentialFieldNumber to lastSequentialFieldNumber (-1 for the last
+// field) are written to the JSON file
+bool LdDecodeMetaData::openJournal(QString jsonFileName, QString passName,
+                                   qint32 firstSequentialFieldNumber, qint32 lastSequentialFieldNumber)
+{
+    delete journal;
+    journal = nullptr;
+    if (!isSameFile(jsonFileName, readFileName)) replayJournal(jsonFileName);
+
+    journal = new MetaDataJournal;
+    if (!journal->open(MetaDataJournal::getFileName(jsonFileName), jsonFileName, passName)) {
+        delete journal;
+        journal = nullptr;
+        return false;
+    }
 
+    journalJsonFileName = jsonFileName;
+    journalPassName = passName;
+    journalFirstFieldNumber = firstSequentialFieldNumber;
+    journalLastFieldNumber = lastSequentialFieldNumber;
     return true;
 }
 
+// Returns the last field journalled by the open pass in an earlier (interrupted) run, or
+// 0 if the pass has not been run or finished normally
+qint32 LdDecodeMetaData::getLastJournalledFieldNumber(void)
+{
+    if (journal == nullptr) return 0;
+    return journalLastFieldNumbers.value(journalPassName, 0);
+}
+
+// This method writes the JSON file with all of the journalled updates, and empties the
+// journal
+bool LdDecodeMetaData::compactJournal(void)
+{
+    if (journal == nullptr) return false;
+
+    if (!writeJournalFields()) return false;
+    return journal->reset();
+}
+
+// This method ends the open pass and closes the journal.  If isCompactSet is true the JSON
+// file is written and the journal is removed, otherwise the updates are left in the journal
+// (to be applied the next time the JSON file is read)
+bool LdDecodeMetaData::finishJournal(bool isCompactSet)
+{
+    if (journal == nullptr) return false;
+
+    bool isSuccessful = journal->appendEndOfPass();
+    journal->close();
+    delete journal;
+    journal = nullptr;
+    journalLastFieldNumbers.remove(journalPassName);
+
+    if (isCompactSet && isSuccessful) {
+        if (!writeJournalFields()) return false;
+        if (!QFile::remove(MetaDataJournal::getFileName(journalJsonFileName))) {
+            qWarning() << "Could not remove the metadata journal for" << journalJsonFileName;
+            return false;
+        }
+    }
+
+    return isSuccessful;
+}
+
+// This method starts a pass of a tool over a range of fields (the range is checked against
+// the number of fields available in the TBC file; -1 as the last field is the last
+// available field).  The updated fields are journalled (see openJournal()) and, if an
+// earlier run of the pass was interrupted, the first field is moved on to carry on from the
+// last journalled field.  If the output JSON file is not the input JSON file and the range
+// is not all of the fields, just the range is written (as partial metadata for
+// ld-merge-metadata).  Returns false (with a message for the user) if the pass cannot start
+bool LdDecodeMetaData::beginFieldPass(QString outputJsonFileName, QString passName, bool isCompactSet, qint32 numberOfAvailableFields,
+                                      qint32 &firstSequentialFieldNumber, qint32 &lastSequentialFieldNumber)
+{
+    // Check the field range (by default all of the fields are processed)
+    bool isRangeSet = firstSequentialFieldNumber != 1 ||
+            (lastSequentialFieldNumber != -1 && lastSequentialFieldNumber < numberOfAvailableFields);
+    if (lastSequentialFieldNumber == -1 || lastSequentialFieldNumber > numberOfAvailableFields) {
+        lastSequentialFieldNumber = numberOfAvailableFields;
+    }
+    if (firstSequentialFieldNumber > lastSequentialFieldNumber) {
+        qInfo() << "Specified first field is out of bounds, only" << numberOfAvailableFields << "fields available";
+        return false;
+    }
+
+    bool isPartialOutput = isRangeSet && !isSameFile(outputJsonFileName, readFileName);
+    if (isPartialOutput && !isCompactSet) {
+        qInfo() << "Partial metadata is always written to the output JSON file (--no-compact is ignored)";
+        isCompactSet = true;
+    }
+    isFieldPassCompactSet = isCompactSet;
+
+    if (!openJournal(outputJsonFileName, passName, isPartialOutput ? firstSequentialFieldNumber : 1,
+                     isPartialOutput ? lastSequentialFieldNumber : -1)) {
+        qInfo() << "Unable to open the ld-decode metadata journal";
+        return false;
+    }
+
+    qint32 resumeFieldNumber = getLastJournalledFieldNumber() + 1;
+    if (resumeFieldNumber > firstSequentialFieldNumber && resumeFieldNumber <= lastSequentialFieldNumber + 1) {
+        firstSequentialFieldNumber = resumeFieldNumber;
+        qInfo() << "Resuming from field" << firstSequentialFieldNumber;
+    }
+
+    return true;
+}
+
+// This method ends the pass started by beginFieldPass() and (unless --no-compact was set)
+// writes the output JSON file
+bool LdDecodeMetaData::finishFieldPass(void)
+{
+    if (!finishJournal(isFieldPassCompactSet)) {
+        qInfo() << "Unable to write the ld-decode metadata";
+        return false;
+    }
+
+    return true;
+}
+
+// Write the journal's range of fields to its JSON file
+bool LdDecodeMetaData::writeJournalFields(void)
+{
+    qint32 lastFieldNumber = journalLastFieldNumber == -1 ? getNumberOfFields() : journalLastFieldNumber;
+    return write(journalJsonFileName, journalFirstFieldNumber, lastFieldNumber);
+}
+
 LdDecodeMetaData::VideoParameters LdDecodeMetaData::getVideoParameters(void)
 {
     return metaData.videoParameters;
@@ -609,95 +989,425 @@ void LdDecodeMetaData::setPcmAudioParameters(LdDecodeMetaData::PcmAudioParameter
     metaData.pcmAudioParameters = pcmAudioParam;
 }
 
+// Note: this copies the drop-outs of the field, use getFieldDropOuts() to read the drop-outs
+// without copying them
 LdDecodeMetaData::Field LdDecodeMetaData::getField(qint32 sequentialFieldNumber)
 {
-    return metaData.fields[sequentialFieldNumber - 1];
+    if (isSidecarDropOutsPending) return sidecar->getField(sequentialFieldNumber - 1);
+
+    Field field;
+    if (sidecar != nullptr) field = sidecar->getField(sequentialFieldNumber - 1, false);
+    else field = metaData.fields[sequentialFieldNumber - 1];
+
+    DropOutSpan dropOuts = dropOutStore.getDropOuts(sequentialFieldNumber - 1);
+    field.dropOuts.startx.resize(dropOuts.size());
+    field.dropOuts.endx.resize(dropOuts.size());
+    field.dropOuts.fieldLine.resize(dropOuts.size());
+    for (qint32 index = 0; index < dropOuts.size(); index++) {
+        field.dropOuts.startx[index] = dropOuts.startx(index);
+        field.dropOuts.endx[index] = dropOuts.endx(index);
+        field.dropOuts.fieldLine[index] = dropOuts.fieldLine(index);
+    }
+
+    return field;
 }
 
-void LdDecodeMetaData::appendField(LdDecodeMetaData::Field fieldParam)
+void LdDecodeMetaData::appendField(const LdDecodeMetaData::Field &fieldParam)
 {
+    if (sidecar != nullptr) loadSidecarFields();
+    dropOutStore.appendField(fieldParam.dropOuts.startx, fieldParam.dropOuts.endx, fieldParam.dropOuts.fieldLine);
     metaData.fields.append(fieldParam);
+    metaData.fields.last().dropOuts = DropOuts();
+    internUserCode(metaData.fields.last().vbi.userCode);
+    isFrameIndexValid = false;
+    isSeekIndexValid = false;
+}
+
+void LdDecodeMetaData::updateField(const LdDecodeMetaData::Field &fieldParam, qint32 sequentialFieldNumber)
+{
+    if (sidecar != nullptr) loadSidecarFields();
+    storeField(fieldParam, sequentialFieldNumber);
+}
+
+// Get a field without copying it.  The reference is valid until fields are next added, and
+// the drop-outs of the field are empty (the drop-outs are held separately - see
+// getFieldDropOuts()).  Note: if the metadata was read from a sidecar, the first call
+// decodes all of the fields from the sidecar
+const LdDecodeMetaData::Field &LdDecodeMetaData::getConstField(qint32 sequentialFieldNumber)
+{
+    if (sidecar != nullptr) loadSidecarFields();
+    return metaData.fields[sequentialFieldNumber - 1];
+}
+
+// Get a field to change in place.  As for getConstField(), the drop-outs are held separately
+// (use setFieldDropOuts() to change them).  Changes made through the reference are not
+// recorded in the metadata journal (use updateField() or updateFields() for that)
+LdDecodeMetaData::Field &LdDecodeMetaData::getMutableField(qint32 sequentialFieldNumber)
+{
+    if (sidecar != nullptr) loadSidecarFields();
+    isFrameIndexValid = false;
+    isSeekIndexValid = false;
+    return metaData.fields[sequentialFieldNumber - 1];
+}
+
+// Get all of the fields as a range (the fields are not copied, and their drop-outs are
+// empty - see getConstField())
+LdDecodeMetaData::FieldRange LdDecodeMetaData::getFields(void)
+{
+    if (sidecar != nullptr) loadSidecarFields();
+    const Field *fields = metaData.fields.constData();
+    return FieldRange(fields, fields + metaData.fields.size());
+}
+
+// Get the fields from firstSequentialFieldNumber to lastSequentialFieldNumber (inclusive) as
+// a range (an empty range if the field numbers are out of range)
+LdDecodeMetaData::FieldRange LdDecodeMetaData::getFields(qint32 firstSequentialFieldNumber, qint32 lastSequentialFieldNumber)
+{
+    if (sidecar != nullptr) loadSidecarFields();
+    if (firstSequentialFieldNumber < 1 || lastSequentialFieldNumber > metaData.fields.size() ||
+            firstSequentialFieldNumber > lastSequentialFieldNumber) {
+        return FieldRange(nullptr, nullptr);
+    }
+
+    const Field *fields = metaData.fields.constData();
+    return FieldRange(fields + firstSequentialFieldNumber - 1, fields + lastSequentialFieldNumber);
+}
+
+// Append a number of fields
+void LdDecodeMetaData::appendFields(const QVector<LdDecodeMetaData::Field> &fieldsParam)
+{
+    if (sidecar != nullptr) loadSidecarFields();
+    metaData.fields.reserve(metaData.fields.size() + fieldsParam.size());
+    for (qint32 index = 0; index < fieldsParam.size(); index++) appendField(fieldsParam[index]);
+}
+
+// Replace a number of consecutive fields, starting at firstSequentialFieldNumber
+void LdDecodeMetaData::updateFields(const QVector<LdDecodeMetaData::Field> &fieldsParam, qint32 firstSequentialFieldNumber)
+{
+    if (sidecar != nullptr) loadSidecarFields();
+    if (firstSequentialFieldNumber < 1 || firstSequentialFieldNumber + fieldsParam.size() - 1 > metaData.fields.size()) {
+        qWarning() << "LdDecodeMetaData::updateFields(): Fields" << firstSequentialFieldNumber << "to" <<
+                      firstSequentialFieldNumber + fieldsParam.size() - 1 << "are out of range";
+        return;
+    }
+
+    for (qint32 index = 0; index < fieldsParam.size(); index++) storeField(fieldsParam[index], firstSequentialFieldNumber + index);
 }
 
-void LdDecodeMetaData::updateField(LdDecodeMetaData::Field fieldParam, qint32 sequentialFieldNumber)
+// Get the drop-outs of a field without copying them (the returned view is only valid until
+// the metadata is next changed)
+DropOutSpan LdDecodeMetaData::getFieldDropOuts(qint32 sequentialFieldNumber)
 {
-    metaData.fields[sequentialFieldNumber - 1] = fieldParam;
+    if (isSidecarDropOutsPending) loadSidecarDropOuts();
+    return dropOutStore.getDropOuts(sequentialFieldNumber - 1);
+}
+
+// Replace the drop-outs of a field (without copying the rest of the field)
+void LdDecodeMetaData::setFieldDropOuts(qint32 sequentialFieldNumber, const LdDecodeMetaData::DropOuts &dropOuts)
+{
+    if (isSidecarDropOutsPending) loadSidecarDropOuts();
+    dropOutStore.setDropOuts(sequentialFieldNumber - 1, dropOuts.startx, dropOuts.endx, dropOuts.fieldLine);
+
+    if (journal != nullptr && !journal->appendField(sequentialFieldNumber, getField(sequentialFieldNumber))) {
+        qWarning() << "Field" << sequentialFieldNumber << "could not be added to the metadata journal";
+    }
+}
+
+// Get the drop-out store holding the drop-outs of every field
+const DropOutStore &LdDecodeMetaData::getDropOutStore(void)
+{
+    if (isSidecarDropOutsPending) loadSidecarDropOuts();
+    return dropOutStore;
+}
+
+// Replace the drop-outs of every field (the store must have one entry per field).  Note:
+// this is not recorded in the metadata journal
+void LdDecodeMetaData::setDropOutStore(const DropOutStore &dropOutStoreParam)
+{
+    if (dropOutStoreParam.getNumberOfFields() != getNumberOfFields()) {
+        qWarning() << "LdDecodeMetaData::setDropOutStore(): Drop-out store has" << dropOutStoreParam.getNumberOfFields() <<
+                      "fields, expected" << getNumberOfFields();
+        return;
+    }
+
+    dropOutStore = dropOutStoreParam;
+    isSidecarDropOutsPending = false;
 }
 
 // Method to get the available number of fields
 qint32 LdDecodeMetaData::getNumberOfFields(void)
 {
+    if (sidecar != nullptr) return sidecar->getNumberOfFields();
     return metaData.fields.size();
 }
 
-// Method to get the available number of frames
+// Method to get the available number of frames (see buildFrameIndex())
 qint32 LdDecodeMetaData::getNumberOfFrames(void)
 {
-    qint32 frameOffset = 0;
-
-    // It's possible that the TBC file will start on the wrong field, so we have to allow for
-    // that here by skipping a field if the order isn't right
-    if (!getField(1).isFirstField) frameOffset++;
-
-    return (getNumberOfFields() / 2) - frameOffset;
+    if (!isFrameIndexValid) buildFrameIndex();
+    return frameIndex.size();
 }
 
-// Method to get the first field number based on the frame number
+// Method to get the first field number based on the frame number (returns -1 if the frame
+// does not exist)
 qint32 LdDecodeMetaData::getFirstFieldNumber(qint32 frameNumber)
 {
-    // Point at the first field in the TBC file (according to the current frame number)
-    qint32 firstFieldNumber = (frameNumber * 2) - 1;
-    qint32 secondFieldNumber = firstFieldNumber + 1;
+    if (!isFrameIndexValid) buildFrameIndex();
 
-    // It's possible that the TBC file will start on the wrong field, so we have to allow for
-    // that here by skipping a field if the order isn't right
-    if (!getField(firstFieldNumber).isFirstField) {
-        firstFieldNumber++;
-        secondFieldNumber++;
-        qDebug() << "LdDecodeMetaData::getFirstFieldNumber(): TBC file has an extra field at the start (out of field order) - skipping";
+    // Range check the frame number
+    if (frameNumber < 1 || frameNumber > frameIndex.size()) {
+        qCritical() << "LdDecodeMetaData::getFirstFieldNumber(): Frame number" << frameNumber << "is out of range!";
+        return -1;
     }
 
-    // Range check the field number
-    if (firstFieldNumber > getNumberOfFields()) {
-        qCritical() << "LdDecodeMetaData::getFirstFieldNumber(): First field number exceed the available number of fields!";
+    return frameIndex[frameNumber - 1];
+}
+
+// Method to get the second field number based on the frame number (returns -1 if the frame
+// does not exist)
+qint32 LdDecodeMetaData::getSecondFieldNumber(qint32 frameNumber)
+{
+    if (!isFrameIndexValid) buildFrameIndex();
+
+    // Range check the frame number
+    if (frameNumber < 1 || frameNumber > frameIndex.size()) {
+        qCritical() << "LdDecodeMetaData::getSecondFieldNumber(): Frame number" << frameNumber << "is out of range!";
         return -1;
     }
 
-    // Range check the field number
-    if (secondFieldNumber > getNumberOfFields()) {
-        qCritical() << "LdDecodeMetaData::getFirstFieldNumber(): Second field number exceed the available number of fields!";
+    return frameIndex[frameNumber - 1] + 1;
+}
+
+// Method to get the frame number of a CAV picture number.  If the picture number is not
+// in the VBI (e.g. the frame was dropped during capture) the frame with the next picture
+// number is used, or with the previous picture number if isAtOrBefore is set (for the end
+// of a range).  Returns -1 if there is no such frame
+qint32 LdDecodeMetaData::getFrameNumberForPictureNumber(qint32 pictureNumber, bool isAtOrBefore)
+{
+    if (!isSeekIndexValid) buildSeekIndex();
+
+    bool isExact;
+    qint32 frameNumber = seekIndex->getFrameNumberForPictureNumber(pictureNumber, isAtOrBefore, isExact);
+    if (frameNumber != -1 && !isExact) {
+        qInfo() << "Picture number" << pictureNumber << "was not found, using the" << (isAtOrBefore ? "previous" : "next") <<
+                   "picture number at frame" << frameNumber;
+    }
+
+    return frameNumber;
+}
+
+// Method to get the frame number of a CLV time code (as for getFrameNumberForPictureNumber())
+qint32 LdDecodeMetaData::getFrameNumberForTimeCode(qint32 hours, qint32 minutes, qint32 seconds, qint32 pictureNumber, bool isAtOrBefore)
+{
+    if (!isSeekIndexValid) buildSeekIndex();
+
+    bool isExact;
+    qint32 frameNumber = seekIndex->getFrameNumberForTimeCode(hours, minutes, seconds, pictureNumber, isAtOrBefore, isExact);
+    if (frameNumber != -1 && !isExact) {
+        qInfo() << "Time code" << QString("%1:%2:%3.%4").arg(hours).arg(minutes, 2, 10, QChar('0'))
+                   .arg(seconds, 2, 10, QChar('0')).arg(pictureNumber, 2, 10, QChar('0')) <<
+                   "was not found, using the" << (isAtOrBefore ? "previous" : "next") << "time code at frame" << frameNumber;
+    }
+
+    return frameNumber;
+}
+
+// Method to get the frame number of a position given as a CAV picture number or CLV time
+// code (see VbiSeekIndex::parsePosition() for the format).  Returns -1 if the position is
+// not valid or is not found
+qint32 LdDecodeMetaData::getFrameNumberForPosition(QString position, bool isAtOrBefore)
+{
+    qint32 pictureNumber, hours, minutes, seconds, timeCodePictureNumber;
+    if (!VbiSeekIndex::parsePosition(position, pictureNumber, hours, minutes, seconds, timeCodePictureNumber)) {
+        qWarning() << "Position" << position << "is not a valid picture number or time code";
         return -1;
     }
 
-    return firstFieldNumber;
+    if (pictureNumber != -1) return getFrameNumberForPictureNumber(pictureNumber, isAtOrBefore);
+    return getFrameNumberForTimeCode(hours, minutes, seconds, timeCodePictureNumber, isAtOrBefore);
 }
 
-// Method to get the second field number based on the frame number
-qint32 LdDecodeMetaData::getSecondFieldNumber(qint32 frameNumber)
+// Method to get the range of frames from a start position to an end position (inclusive).
+// A missing start position is found as the next position on the disc, and a missing end
+// position as the previous one, so the range never goes beyond the positions given.  If a
+// position is empty the corresponding value is left unchanged.  Returns false (with a
+// message for the user) if a position is not found or the end is before the start
+bool LdDecodeMetaData::getFrameRangeForPositions(QString startPosition, QString endPosition, qint32 &startFrameNumber, qint32 &numberOfFrames)
 {
-    // Point at the first field in the TBC file (according to the current frame number)
-    qint32 firstFieldNumber = (frameNumber * 2) - 1;
-    qint32 secondFieldNumber = firstFieldNumber + 1;
+    if (!startPosition.isEmpty()) {
+        startFrameNumber = getFrameNumberForPosition(startPosition);
+        if (startFrameNumber == -1) {
+            qInfo() << "Specified start position" << startPosition << "was not found in the VBI picture numbers or time codes";
+            return false;
+        }
+    }
 
-    // It's possible that the TBC file will start on the wrong field, so we have to allow for
-    // that here by skipping a field if the order isn't right
-    if (!getField(firstFieldNumber).isFirstField) {
-        firstFieldNumber++;
-        secondFieldNumber++;
-        qDebug() << "LdDecodeMetaData::getSecondFieldNumber(): TBC file has an extra field at the start (out of field order) - skipping";
+    if (!endPosition.isEmpty()) {
+        qint32 endFrameNumber = getFrameNumberForPosition(endPosition, true);
+        if (endFrameNumber == -1) {
+            qInfo() << "Specified end position" << endPosition << "was not found in the VBI picture numbers or time codes";
+            return false;
+        }
+
+        qint32 firstFrameNumber = (startFrameNumber == -1) ? 1 : startFrameNumber;
+        if (endFrameNumber < firstFrameNumber) {
+            qInfo() << "Specified end position" << endPosition << "is before the start frame";
+            return false;
+        }
+        numberOfFrames = endFrameNumber - firstFrameNumber + 1;
     }
 
-    // Range check the field number
-    if (firstFieldNumber > getNumberOfFields()) {
-        qCritical() << "LdDecodeMetaData::getSecondFieldNumber(): First field number exceed the available number of fields!";
-        return -1;
+    return true;
+}
+
+// Decode all of the fields from the sidecar (so they can be changed) and close it
+void LdDecodeMetaData::loadSidecarFields(void)
+{
+    if (isSidecarDropOutsPending) loadSidecarDropOuts();
+
+    qint32 numberOfFields = sidecar->getNumberOfFields();
+    metaData.fields.resize(numberOfFields);
+    for (qint32 fieldIndex = 0; fieldIndex < numberOfFields; fieldIndex++) {
+        metaData.fields[fieldIndex] = sidecar->getField(fieldIndex, false);
+        internUserCode(metaData.fields[fieldIndex].vbi.userCode);
     }
 
-    // Range check the field number
-    if (secondFieldNumber > getNumberOfFields()) {
-        qCritical() << "LdDecodeMetaData::getSecondFieldNumber(): Second field number exceed the available number of fields!";
-        return -1;
+    delete sidecar;
+    sidecar = nullptr;
+}
+
+// Returns true if two file names refer to the same file.  The canonical paths are compared
+// (so links and different spellings of the same path match); if a file does not exist yet
+// the absolute paths are compared
+bool LdDecodeMetaData::isSameFile(QString firstFileName, QString secondFileName)
+{
+    if (firstFileName.isEmpty() || secondFileName.isEmpty()) return false;
+
+    QFileInfo firstFileInfo(firstFileName);
+    QFileInfo secondFileInfo(secondFileName);
+    if (firstFileInfo.exists() && secondFileInfo.exists()) {
+        return firstFileInfo.canonicalFilePath() == secondFileInfo.canonicalFilePath();
+    }
+
+    return firstFileInfo.absoluteFilePath() == secondFileInfo.absoluteFilePath();
+}
+
+// Apply the field updates from the metadata journal for the JSON file (if there is one)
+void LdDecodeMetaData::replayJournal(QString jsonFileName)
+{
+    MetaDataJournal::replay(MetaDataJournal::getFileName(jsonFileName), jsonFileName, *this, journalLastFieldNumbers);
+}
+
+// Read the drop-outs of all fields from the sidecar into the drop-out store (this is done
+// when the drop-outs are first needed, so opening a sidecar stays quick)
+void LdDecodeMetaData::loadSidecarDropOuts(void)
+{
+    if (!sidecar->readDropOuts(dropOutStore)) {
+        qWarning() << "Could not read the drop-outs from the metadata sidecar";
+        dropOutStore.clear();
+        dropOutStore.resize(sidecar->getNumberOfFields());
+    }
+
+    isSidecarDropOutsPending = false;
+}
+
+// Replace a field (moving its drop-outs into the drop-out store) and journal it
+void LdDecodeMetaData::storeField(const LdDecodeMetaData::Field &fieldParam, qint32 sequentialFieldNumber)
+{
+    dropOutStore.setDropOuts(sequentialFieldNumber - 1, fieldParam.dropOuts.startx, fieldParam.dropOuts.endx, fieldParam.dropOuts.fieldLine);
+    Field &field = metaData.fields[sequentialFieldNumber - 1];
+    if (field.isFirstField != fieldParam.isFirstField || field.fieldPhaseID != fieldParam.fieldPhaseID) isFrameIndexValid = false;
+    field = fieldParam;
+    field.dropOuts = DropOuts();
+    internUserCode(field.vbi.userCode);
+    isSeekIndexValid = false;
+
+    if (journal != nullptr && !journal->appendField(sequentialFieldNumber, fieldParam)) {
+        qWarning() << "Field" << sequentialFieldNumber << "could not be added to the metadata journal";
+    }
+}
+
+// Make equal VBI user codes share their data.  The same user code is repeated on many
+// fields, so this keeps one copy of each user code rather than one per field
+void LdDecodeMetaData::internUserCode(QString &userCode)
+{
+    if (userCode.isEmpty()) return;
+
+    QString internedUserCode = userCodes.value(userCode, QString());
+    if (internedUserCode.isEmpty()) userCodes.insert(userCode, userCode);
+    else userCode = internedUserCode;
+}
+
+// Build the frame index, which holds the first field number of each frame.  A frame is a
+// first field followed by a second field (and, if the fields have phase IDs, the phase ID of
+// the second field follows on from the first).  Fields that cannot be paired (because a
+// field was dropped or repeated during capture) are skipped, so the pairing recovers at the
+// next first field instead of every later frame being shifted
+void LdDecodeMetaData::buildFrameIndex(void)
+{
+    qint32 numberOfFields = getNumberOfFields();
+    frameIndex.clear();
+    frameIndex.reserve(numberOfFields / 2);
+
+    qint32 numberOfSkippedFields = 0;
+    bool isFirstField;
+    qint32 fieldPhaseID;
+    bool isNextFirstField;
+    qint32 nextFieldPhaseID;
+    if (numberOfFields > 0) getFieldOrder(1, isFirstField, fieldPhaseID);
+
+    qint32 fieldNumber = 1;
+    while (fieldNumber < numberOfFields) {
+        getFieldOrder(fieldNumber + 1, isNextFirstField, nextFieldPhaseID);
+
+        bool isPhaseValid = fieldPhaseID <= 0 || nextFieldPhaseID <= 0 || nextFieldPhaseID == fieldPhaseID + 1;
+        if (isFirstField && !isNextFirstField && isPhaseValid) {
+            frameIndex.append(fieldNumber);
+            fieldNumber += 2;
+            if (fieldNumber <= numberOfFields) getFieldOrder(fieldNumber, isFirstField, fieldPhaseID);
+        } else {
+            qDebug() << "LdDecodeMetaData::buildFrameIndex(): Field" << fieldNumber << "is out of field order - skipping";
+            numberOfSkippedFields++;
+            fieldNumber++;
+            isFirstField = isNextFirstField;
+            fieldPhaseID = nextFieldPhaseID;
+        }
     }
 
-    return secondFieldNumber;
+    if (numberOfSkippedFields > 0) qInfo() << "Skipped" << numberOfSkippedFields << "fields that are out of field order";
+    isFrameIndexValid = true;
+}
+
+// Build the seek index from the VBI of each frame
+void LdDecodeMetaData::buildSeekIndex(void)
+{
+    if (seekIndex == nullptr) seekIndex = new VbiSeekIndex;
+    seekIndex->clear();
+
+    qint32 numberOfFrames = getNumberOfFrames();
+    for (qint32 frameNumber = 1; frameNumber <= numberOfFrames; frameNumber++) {
+        qint32 firstFieldIndex = frameIndex[frameNumber - 1] - 1;
+        if (sidecar != nullptr) {
+            seekIndex->addFrame(frameNumber, sidecar->getField(firstFieldIndex, false).vbi,
+                                sidecar->getField(firstFieldIndex + 1, false).vbi);
+        } else {
+            seekIndex->addFrame(frameNumber, metaData.fields[firstFieldIndex].vbi, metaData.fields[firstFieldIndex + 1].vbi);
+        }
+    }
+    seekIndex->finish();
+
+    qDebug() << "LdDecodeMetaData::buildSeekIndex(): Indexed" << seekIndex->getNumberOfPictureNumbers() << "picture numbers and" <<
+                seekIndex->getNumberOfTimeCodes() << "time codes";
+    isSeekIndexValid = true;
+}
+
+// Get the details used to pair the fields into frames (without copying the field)
+void LdDecodeMetaData::getFieldOrder(qint32 sequentialFieldNumber, bool &isFirstField, qint32 &fieldPhaseID)
+{
+    if (sidecar != nullptr) {
+        sidecar->getFieldOrder(sequentialFieldNumber - 1, isFirstField, fieldPhaseID);
+    } else {
+        isFirstField = metaData.fields[sequentialFieldNumber - 1].isFirstField;
+        fieldPhaseID = metaData.fields[sequentialFieldNumber - 1].fieldPhaseID;
+    }
 }
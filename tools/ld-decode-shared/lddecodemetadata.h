@@ -29,12 +29,20 @@
 
 #include <QObject>
 #include <QVector>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+#include <QHash>
 #include <QFile>
+#include <QFileInfo>
+#include <QThread>
 #include <QDebug>
 
+#include "jsonstreamreader.h"
+#include "jsonstreamwriter.h"
+#include "dropoutstore.h"
+
+class MetaDataSidecar;
+class MetaDataJournal;
+class VbiSeekIndex;
+
 class LDDECODESHAREDSHARED_EXPORT LdDecodeMetaData : public QObject
 {
     Q_OBJECT
@@ -68,28 +76,32 @@ public:
         futureUse               // 11
     };
 
+    // Note: the flags of the field structs are bit-fields, and the members are ordered by
+    // size, so a field takes as little memory as possible (a whole disc of fields is held in
+    // memory).  The field members are used as normal, except that a bit-field cannot be
+    // passed by reference or have its address taken
     struct vbiStatusCode {
-        bool valid;                 // Ture = programme status code is valid
-        bool cx;                    // True = CX on, false = CX off
-        bool size;                  // True = 12" disc, false = 8" disc
-        bool side;                  // True = first side, false = second side
-        bool teletext;              // True = teletext present, false = teletext not present
-        bool dump;                  // True = programme dump on, false = programme dump off
-        bool fm;                    // True = FM-FM Multiplex on, false = FM-FM Multiplex off
-        bool digital;               // True = digital video, false = analogue video
-        VbiSoundModes soundMode;    // The sound mode (see IEC spec)
-        bool parity;                // True = status code had valid parity, false = status code is invalid
+        bool valid : 1;                 // Ture = programme status code is valid
+        bool cx : 1;                    // True = CX on, false = CX off
+        bool size : 1;                  // True = 12" disc, false = 8" disc
+        bool side : 1;                  // True = first side, false = second side
+        bool teletext : 1;              // True = teletext present, false = teletext not present
+        bool dump : 1;                  // True = programme dump on, false = programme dump off
+        bool fm : 1;                    // True = FM-FM Multiplex on, false = FM-FM Multiplex off
+        bool digital : 1;               // True = digital video, false = analogue video
+        bool parity : 1;                // True = status code had valid parity, false = status code is invalid
+        VbiSoundModes soundMode : 5;    // The sound mode (see IEC spec)
     };
 
     struct vbiStatusCodeAm2 {
-        bool valid;                 // Ture = programme status code is valid
-        bool cx;                    // True = CX on, false = CX off
-        bool size;                  // True = 12" disc, false = 8" disc
-        bool side;                  // True = first side, false = second side
-        bool teletext;              // True = teletext present, false = teletext not present
-        bool copy;                  // True = copy allowed, false = copy not allowed
-        bool standard;              // True = video signal is standard, false = video signal is future use
-        VbiSoundModes soundMode;    // The sound mode (see IEC spec amendment 2)
+        bool valid : 1;                 // Ture = programme status code is valid
+        bool cx : 1;                    // True = CX on, false = CX off
+        bool size : 1;                  // True = 12" disc, false = 8" disc
+        bool side : 1;                  // True = first side, false = second side
+        bool teletext : 1;              // True = teletext present, false = teletext not present
+        bool copy : 1;                  // True = copy allowed, false = copy not allowed
+        bool standard : 1;              // True = video signal is standard, false = video signal is future use
+        VbiSoundModes soundMode : 5;    // The sound mode (see IEC spec amendment 2)
     };
 
     struct VbiClvPictureNumber {
@@ -99,23 +111,23 @@ public:
 
     // Overall container struct for VBI information
     struct Vbi {
-        bool inUse;
-
         qint32 vbi16;
         qint32 vbi17;
         qint32 vbi18;
 
-        VbiDiscTypes type;
-        bool leadIn;
-        bool leadOut;
-        QString userCode;
         qint32 picNo;
-        bool picStop;
         qint32 chNo;
         vbiTimeCode timeCode;
+        VbiClvPictureNumber clvPicNo;
+        QString userCode;           // Note: equal user codes of the stored fields share their data
         vbiStatusCode statusCode;
         vbiStatusCodeAm2 statusCodeAm2;
-        VbiClvPictureNumber clvPicNo;
+
+        bool inUse : 1;
+        bool leadIn : 1;
+        bool leadOut : 1;
+        bool picStop : 1;
+        VbiDiscTypes type : 3;
     };
 
     // Video metadata definition
@@ -151,17 +163,17 @@ public:
 
     // VITS metadata definition
     struct Vits {
-        bool inUse;
         qreal snr;
+        bool inUse : 1;
     };
 
     // NTSC Specific metadata definition
     struct Ntsc {
-        bool inUse;
-        bool isFmCodeDataValid;
         qint32 fmCodeData;
-        bool fieldFlag;
-        bool whiteFlag;
+        bool inUse : 1;
+        bool isFmCodeDataValid : 1;
+        bool fieldFlag : 1;
+        bool whiteFlag : 1;
     };
 
     // PCM sound metadata definition
@@ -172,13 +184,16 @@ public:
         qint32 bits;
     };
 
-    // Field metadata definition
+    // Field metadata definition.  The VITS, VBI and NTSC sections are held in every field,
+    // whether or not they are in use (see their inUse flags): getConstField(),
+    // getMutableField() and getFields() return references to the stored fields, so the
+    // sections cannot be allocated separately
     struct Field {
         qint32 seqNo;       // Note: This is the unique primary-key
-        bool isFirstField;
         qint32 syncConf;
         qreal medianBurstIRE;
         qint32 fieldPhaseID;
+        bool isFirstField;
 
         Vits vits;
         Vbi vbi;
@@ -194,9 +209,27 @@ public:
     };
 
     explicit LdDecodeMetaData(QObject *parent = nullptr);
+    ~LdDecodeMetaData() override;
 
     bool read(QString fileName);
     bool write(QString fileName);
+    bool write(QString fileName, qint32 firstSequentialFieldNumber, qint32 lastSequentialFieldNumber);
+    bool writeSidecar(QString jsonFileName);
+    bool isReadFromSidecar(void);
+    bool isPartial(void);
+    qint32 getPartialFirstFieldNumber(void);
+    void setJsonFormat(JsonStreamWriter::Format jsonFormatParam);
+    JsonStreamWriter::Format getJsonFormat(void);
+
+    bool openJournal(QString jsonFileName, QString passName,
+                     qint32 firstSequentialFieldNumber = 1, qint32 lastSequentialFieldNumber = -1);
+    qint32 getLastJournalledFieldNumber(void);
+    bool compactJournal(void);
+    bool finishJournal(bool isCompactSet);
+
+    bool beginFieldPass(QString outputJsonFileName, QString passName, bool isCompactSet, qint32 numberOfAvailableFields,
+                        qint32 &firstSequentialFieldNumber, qint32 &lastSequentialFieldNumber);
+    bool finishFieldPass(void);
 
     VideoParameters getVideoParameters(void);
     void setVideoParameters (VideoParameters videoParametersParam);
@@ -204,14 +237,43 @@ public:
     PcmAudioParameters getPcmAudioParameters(void);
     void setPcmAudioParameters(PcmAudioParameters pcmAudioParam);
 
+    // A range of fields, for use in range-based for loops (see getFields())
+    class FieldRange {
+    public:
+        FieldRange(const Field *firstParam, const Field *lastParam) : first(firstParam), last(lastParam) {}
+        const Field *begin(void) const { return first; }
+        const Field *end(void) const { return last; }
+        qint32 size(void) const { return static_cast<qint32>(last - first); }
+
+    private:
+        const Field *first;
+        const Field *last;
+    };
+
     Field getField(qint32 sequentialFieldNumber);
-    void appendField(Field fieldParam);
-    void updateField(Field fieldParam, qint32 sequentialFrameNumber);
+    void appendField(const Field &fieldParam);
+    void updateField(const Field &fieldParam, qint32 sequentialFieldNumber);
+
+    const Field &getConstField(qint32 sequentialFieldNumber);
+    Field &getMutableField(qint32 sequentialFieldNumber);
+    FieldRange getFields(void);
+    FieldRange getFields(qint32 firstSequentialFieldNumber, qint32 lastSequentialFieldNumber);
+    void appendFields(const QVector<Field> &fieldsParam);
+    void updateFields(const QVector<Field> &fieldsParam, qint32 firstSequentialFieldNumber);
+
+    DropOutSpan getFieldDropOuts(qint32 sequentialFieldNumber);
+    void setFieldDropOuts(qint32 sequentialFieldNumber, const DropOuts &dropOuts);
+    const DropOutStore &getDropOutStore(void);
+    void setDropOutStore(const DropOutStore &dropOutStoreParam);
 
     qint32 getNumberOfFields(void);
     qint32 getNumberOfFrames(void);
     qint32 getFirstFieldNumber(qint32 frameNumber);
     qint32 getSecondFieldNumber(qint32 frameNumber);
+    qint32 getFrameNumberForPictureNumber(qint32 pictureNumber, bool isAtOrBefore = false);
+    qint32 getFrameNumberForTimeCode(qint32 hours, qint32 minutes, qint32 seconds, qint32 pictureNumber, bool isAtOrBefore = false);
+    qint32 getFrameNumberForPosition(QString position, bool isAtOrBefore = false);
+    bool getFrameRangeForPositions(QString startPosition, QString endPosition, qint32 &startFrameNumber, qint32 &numberOfFrames);
 
 signals:
 
@@ -220,6 +282,67 @@ public slots:
 private:
     bool isMetaDataValid;
     MetaData metaData;
+    QString readFileName;
+
+    // The field number (in the complete metadata) of the first field of partial metadata,
+    // or 0 if the metadata is complete
+    qint32 partialFirstFieldNumber;
+
+    // The drop-outs of all fields (the drop-outs in metaData.fields are not used)
+    DropOutStore dropOutStore;
+
+    // Binary sidecar (when the metadata was read from a sidecar, the fields are decoded from
+    // it as they are requested, until a field is changed)
+    MetaDataSidecar *sidecar;
+    bool isSidecarDropOutsPending;
+    void loadSidecarFields(void);
+    void loadSidecarDropOuts(void);
+    void storeField(const Field &fieldParam, qint32 sequentialFieldNumber);
+
+    // The distinct VBI user codes of the fields (see internUserCode())
+    QHash<QString, QString> userCodes;
+    void internUserCode(QString &userCode);
+
+    // Frame index (the first field number of each frame, built when first needed)
+    QVector<qint32> frameIndex;
+    bool isFrameIndexValid;
+    void buildFrameIndex(void);
+    void getFieldOrder(qint32 sequentialFieldNumber, bool &isFirstField, qint32 &fieldPhaseID);
+
+    // Seek index from the VBI picture numbers and time codes to the frame numbers (built
+    // when first needed)
+    VbiSeekIndex *seekIndex;
+    bool isSeekIndexValid;
+    void buildSeekIndex(void);
+
+    // Metadata journal (while open, updated fields are appended to it)
+    MetaDataJournal *journal;
+    QString journalJsonFileName;
+    QString journalPassName;
+    QHash<QString, qint32> journalLastFieldNumbers;
+    qint32 journalFirstFieldNumber;
+    qint32 journalLastFieldNumber;
+    bool isFieldPassCompactSet;
+    void replayJournal(QString jsonFileName);
+    bool writeJournalFields(void);
+    static bool isSameFile(QString firstFileName, QString secondFileName);
+
+    void readVideoParameters(JsonStreamReader &reader, VideoParameters &videoParameters);
+    void readPcmAudioParameters(JsonStreamReader &reader, PcmAudioParameters &pcmAudioParameters);
+    void readFieldRange(JsonStreamReader &reader, qint32 &firstFieldNumber, qint32 &lastFieldNumber);
+    void readFields(JsonStreamReader &reader, QVector<Field> &fields, DropOutStore &dropOuts);
+    void readField(JsonStreamReader &reader, Field &fieldData);
+    void readVbi(JsonStreamReader &reader, Vbi &vbi);
+    void readIntArray(JsonStreamReader &reader, QVector<qint32> &values);
+    VbiSoundModes getSoundMode(qint32 soundMode);
+
+    // JSON writing (the fields are formatted in parallel by FieldChunkWriter threads)
+    class FieldChunkWriter;
+    JsonStreamWriter::Format jsonFormat;
+    void writeFields(JsonStreamWriter &writer, qint32 firstFieldIndex, qint32 lastFieldIndex);
+    static void writeField(JsonStreamWriter &writer, const Field &fieldData, const DropOutSpan &dropOuts);
+    static void writeVbi(JsonStreamWriter &writer, const Vbi &vbi);
+    static void writeIntArray(JsonStreamWriter &writer, const char *name, const qint32 *values, qint32 count);
 };
 
 #endif // LDDECODEMETADATA_H
@@ -0,0 +1,355 @@
+/************************************************************************
+
+    metadatajournal.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "metadatajournal.h"
+#include "metadatasidecar.h"
+
+#include <QDataStream>
+#include <QtEndian>
+
+namespace {
+    const char magic[8] = {'L', 'D', 'J', 'O', 'U', 'R', '0', '1'};
+    const quint32 formatVersion = 1;
+    const qint32 headerSize = 32;
+    const qint32 recordHeaderSize = 8;
+
+    // Records larger than this are treated as corrupt
+    const quint32 maximumPayloadSize = 64 * 1024 * 1024;
+
+    void writeField(QDataStream &stream, const LdDecodeMetaData::Field &field)
+    {
+        stream << field.seqNo << field.isFirstField << field.syncConf << field.medianBurstIRE << field.fieldPhaseID;
+
+        stream << field.vits.inUse << field.vits.snr;
+
+        const LdDecodeMetaData::Vbi &vbi = field.vbi;
+        stream << vbi.inUse << vbi.vbi16 << vbi.vbi17 << vbi.vbi18 << static_cast<qint32>(vbi.type)
+               << vbi.leadIn << vbi.leadOut << vbi.userCode << vbi.picNo << vbi.picStop << vbi.chNo
+               << vbi.timeCode.hr << vbi.timeCode.min;
+        stream << vbi.statusCode.valid << vbi.statusCode.cx << vbi.statusCode.size << vbi.statusCode.side
+               << vbi.statusCode.teletext << vbi.statusCode.dump << vbi.statusCode.fm << vbi.statusCode.digital
+               << static_cast<qint32>(vbi.statusCode.soundMode) << vbi.statusCode.parity;
+        stream << vbi.statusCodeAm2.valid << vbi.statusCodeAm2.cx << vbi.statusCodeAm2.size << vbi.statusCodeAm2.side
+               << vbi.statusCodeAm2.teletext << vbi.statusCodeAm2.copy << vbi.statusCodeAm2.standard
+               << static_cast<qint32>(vbi.statusCodeAm2.soundMode);
+        stream << vbi.clvPicNo.sec << vbi.clvPicNo.picNo;
+
+        stream << field.ntsc.inUse << field.ntsc.isFmCodeDataValid << field.ntsc.fmCodeData
+               << field.ntsc.fieldFlag << field.ntsc.whiteFlag;
+
+        stream << field.dropOuts.startx << field.dropOuts.endx << field.dropOuts.fieldLine;
+    }
+
+    // Read a flag (the flags of a field are bit-fields, so they cannot be read directly)
+    bool readFlag(QDataStream &stream)
+    {
+        bool flag = false;
+        stream >> flag;
+        return flag;
+    }
+
+    void readField(QDataStream &stream, LdDecodeMetaData::Field &field)
+    {
+        qint32 type;
+        qint32 soundMode;
+        qint32 soundModeAm2;
+
+        stream >> field.seqNo;
+        field.isFirstField = readFlag(stream);
+        stream >> field.syncConf >> field.medianBurstIRE >> field.fieldPhaseID;
+
+        field.vits.inUse = readFlag(stream);
+        stream >> field.vits.snr;
+
+        LdDecodeMetaData::Vbi &vbi = field.vbi;
+        vbi.inUse = readFlag(stream);
+        stream >> vbi.vbi16 >> vbi.vbi17 >> vbi.vbi18 >> type;
+        vbi.leadIn = readFlag(stream);
+        vbi.leadOut = readFlag(stream);
+        stream >> vbi.userCode >> vbi.picNo;
+        vbi.picStop = readFlag(stream);
+        stream >> vbi.chNo >> vbi.timeCode.hr >> vbi.timeCode.min;
+
+        vbi.statusCode.valid = readFlag(stream);
+        vbi.statusCode.cx = readFlag(stream);
+        vbi.statusCode.size = readFlag(stream);
+        vbi.statusCode.side = readFlag(stream);
+        vbi.statusCode.teletext = readFlag(stream);
+        vbi.statusCode.dump = readFlag(stream);
+        vbi.statusCode.fm = readFlag(stream);
+        vbi.statusCode.digital = readFlag(stream);
+        stream >> soundMode;
+        vbi.statusCode.parity = readFlag(stream);
+
+        vbi.statusCodeAm2.valid = readFlag(stream);
+        vbi.statusCodeAm2.cx = readFlag(stream);
+        vbi.statusCodeAm2.size = readFlag(stream);
+        vbi.statusCodeAm2.side = readFlag(stream);
+        vbi.statusCodeAm2.teletext = readFlag(stream);
+        vbi.statusCodeAm2.copy = readFlag(stream);
+        vbi.statusCodeAm2.standard = readFlag(stream);
+        stream >> soundModeAm2;
+
+        stream >> vbi.clvPicNo.sec >> vbi.clvPicNo.picNo;
+
+        vbi.type = static_cast<LdDecodeMetaData::VbiDiscTypes>(type);
+        vbi.statusCode.soundMode = static_cast<LdDecodeMetaData::VbiSoundModes>(soundMode);
+        vbi.statusCodeAm2.soundMode = static_cast<LdDecodeMetaData::VbiSoundModes>(soundModeAm2);
+
+        field.ntsc.inUse = readFlag(stream);
+        field.ntsc.isFmCodeDataValid = readFlag(stream);
+        stream >> field.ntsc.fmCodeData;
+        field.ntsc.fieldFlag = readFlag(stream);
+        field.ntsc.whiteFlag = readFlag(stream);
+
+        stream >> field.dropOuts.startx >> field.dropOuts.endx >> field.dropOuts.fieldLine;
+    }
+
+    // Read the next record from the journal (returns false at the end of the journal, or if
+    // the record is incomplete or corrupt)
+    bool readRecord(QFile &file, QString &passName, qint32 &fieldNumber, LdDecodeMetaData::Field &field)
+    {
+        QByteArray recordHeader = file.read(recordHeaderSize);
+        if (recordHeader.size() != recordHeaderSize) return false;
+
+        const uchar *data = reinterpret_cast<const uchar *>(recordHeader.constData());
+        quint32 payloadSize = qFromLittleEndian<quint32>(data);
+        quint16 checksum = qFromLittleEndian<quint16>(data + 4);
+        if (payloadSize > maximumPayloadSize) return false;
+
+        QByteArray payload = file.read(payloadSize);
+        if (payload.size() != static_cast<qint32>(payloadSize)) return false;
+        if (qChecksum(payload.constData(), payloadSize) != checksum) return false;
+
+        QDataStream stream(payload);
+        stream.setVersion(QDataStream::Qt_5_6);
+        stream >> passName >> fieldNumber;
+        if (fieldNumber != 0) readField(stream, field);
+
+        return stream.status() == QDataStream::Ok;
+    }
+}
+
+MetaDataJournal::MetaDataJournal()
+{
+    journalFile = nullptr;
+}
+
+MetaDataJournal::~MetaDataJournal()
+{
+    close();
+}
+
+// Open the journal for the specified JSON file, to append the fields updated by the named
+// processing pass (returns false on failure).  A journal that is out of date is emptied,
+// and an incomplete record at the end of the journal (from an interrupted run) is removed
+bool MetaDataJournal::open(QString fileName, QString jsonFileNameParam, QString passNameParam)
+{
+    close();
+
+    jsonFileName = jsonFileNameParam;
+    passName = passNameParam;
+    journalFile = new QFile(fileName);
+    if (!journalFile->open(QIODevice::ReadWrite)) {
+        qWarning() << "Could not open the metadata journal" << fileName << "-" << journalFile->errorString();
+        close();
+        return false;
+    }
+
+    // Start a new journal if the journal is empty or out of date
+    if (!isHeaderCurrent(journalFile->read(headerSize), jsonFileName)) {
+        if (journalFile->size() != 0) qInfo() << "Metadata journal" << fileName << "is out of date - starting a new journal";
+        if (!reset()) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    // Find the end of the last complete record
+    qint64 validLength = journalFile->pos();
+    QString recordPassName;
+    qint32 fieldNumber;
+    LdDecodeMetaData::Field field;
+    while (readRecord(*journalFile, recordPassName, fieldNumber, field)) validLength = journalFile->pos();
+
+    if (validLength != journalFile->size()) {
+        qInfo() << "Removing an incomplete record from the end of the metadata journal";
+        if (!journalFile->resize(validLength)) {
+            qWarning() << "Could not repair the metadata journal" << fileName << "-" << journalFile->errorString();
+            close();
+            return false;
+        }
+    }
+
+    journalFile->seek(validLength);
+    return true;
+}
+
+// Empty the journal (used once the journal has been compacted into the JSON file)
+bool MetaDataJournal::reset(void)
+{
+    if (journalFile == nullptr) return false;
+
+    if (!journalFile->resize(0) || !journalFile->seek(0) || !writeHeader()) {
+        qWarning() << "Could not start the metadata journal" << journalFile->fileName() << "-" << journalFile->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+void MetaDataJournal::close(void)
+{
+    if (journalFile != nullptr) {
+        journalFile->close();
+        delete journalFile;
+    }
+
+    journalFile = nullptr;
+}
+
+// Append an updated field to the journal (the data is passed to the operating system
+// before returning, so it survives the tool being interrupted)
+bool MetaDataJournal::appendField(qint32 fieldNumber, const LdDecodeMetaData::Field &field)
+{
+    return appendRecord(fieldNumber, field);
+}
+
+// Append a record to show that the processing pass is complete
+bool MetaDataJournal::appendEndOfPass(void)
+{
+    return appendRecord(0, LdDecodeMetaData::Field());
+}
+
+// Replay the journal for the specified JSON file into the metadata.  lastFieldNumbers is
+// set to the last field journalled by each processing pass that has not ended.  Returns
+// false if there is no journal or it is out of date
+bool MetaDataJournal::replay(QString fileName, QString jsonFileName, LdDecodeMetaData &ldDecodeMetaData,
+                             QHash<QString, qint32> &lastFieldNumbers)
+{
+    lastFieldNumbers.clear();
+
+    QFile file(fileName);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) return false;
+
+    if (!isHeaderCurrent(file.read(headerSize), jsonFileName)) {
+        if (file.size() > headerSize) qInfo() << "Metadata journal" << fileName << "is out of date - ignoring it";
+        return false;
+    }
+
+    qint32 numberOfRecords = 0;
+    qint64 validLength = file.pos();
+    QString passName;
+    qint32 fieldNumber;
+    LdDecodeMetaData::Field field;
+    while (readRecord(file, passName, fieldNumber, field)) {
+        validLength = file.pos();
+        if (fieldNumber == 0) {
+            lastFieldNumbers.remove(passName);
+            continue;
+        }
+
+        if (fieldNumber < 0 || fieldNumber > ldDecodeMetaData.getNumberOfFields()) {
+            qWarning() << "Metadata journal field" << fieldNumber << "is out of range - ignoring it";
+            continue;
+        }
+
+        ldDecodeMetaData.updateField(field, fieldNumber);
+        lastFieldNumbers.insert(passName, fieldNumber);
+        numberOfRecords++;
+    }
+
+    if (validLength != file.size()) qInfo() << "Metadata journal" << fileName << "ends with an incomplete record - ignoring it";
+    if (numberOfRecords > 0) qInfo() << "Replayed" << numberOfRecords << "field updates from the metadata journal";
+
+    return true;
+}
+
+// Get the journal file name for a JSON metadata file
+QString MetaDataJournal::getFileName(QString jsonFileName)
+{
+    return jsonFileName + ".journal";
+}
+
+// Private methods ----------------------------------------------------------------------------
+
+bool MetaDataJournal::appendRecord(qint32 fieldNumber, const LdDecodeMetaData::Field &field)
+{
+    if (journalFile == nullptr) return false;
+
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_6);
+    stream << passName << fieldNumber;
+    if (fieldNumber != 0) writeField(stream, field);
+
+    QByteArray record(recordHeaderSize, 0);
+    uchar *data = reinterpret_cast<uchar *>(record.data());
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), data);
+    qToLittleEndian<quint16>(qChecksum(payload.constData(), static_cast<uint>(payload.size())), data + 4);
+    record.append(payload);
+
+    if (journalFile->write(record) != record.size() || !journalFile->flush()) {
+        qWarning() << "Writing to the metadata journal failed:" << journalFile->errorString();
+        return false;
+    }
+
+    return true;
+}
+
+bool MetaDataJournal::writeHeader(void)
+{
+    qint64 jsonFileSize;
+    qint64 jsonFileModified;
+    MetaDataSidecar::getSourceDetails(jsonFileName, jsonFileSize, jsonFileModified);
+
+    QByteArray header(headerSize, 0);
+    uchar *data = reinterpret_cast<uchar *>(header.data());
+    for (qint32 i = 0; i < 8; i++) data[i] = static_cast<uchar>(magic[i]);
+    qToLittleEndian<quint32>(formatVersion, data + 8);
+    qToLittleEndian<quint64>(static_cast<quint64>(jsonFileSize), data + 16);
+    qToLittleEndian<quint64>(static_cast<quint64>(jsonFileModified), data + 24);
+
+    return journalFile->write(header) == headerSize && journalFile->flush();
+}
+
+// Returns true if the journal header is valid and matches the current JSON file
+bool MetaDataJournal::isHeaderCurrent(const QByteArray &header, QString jsonFileName)
+{
+    if (header.size() != headerSize) return false;
+
+    const uchar *data = reinterpret_cast<const uchar *>(header.constData());
+    for (qint32 i = 0; i < 8; i++) {
+        if (data[i] != static_cast<uchar>(magic[i])) return false;
+    }
+    if (qFromLittleEndian<quint32>(data + 8) != formatVersion) return false;
+
+    qint64 jsonFileSize;
+    qint64 jsonFileModified;
+    MetaDataSidecar::getSourceDetails(jsonFileName, jsonFileSize, jsonFileModified);
+
+    return static_cast<qint64>(qFromLittleEndian<quint64>(data + 16)) == jsonFileSize &&
+            static_cast<qint64>(qFromLittleEndian<quint64>(data + 24)) == jsonFileModified;
+}
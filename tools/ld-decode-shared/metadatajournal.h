@@ -0,0 +1,84 @@
+/************************************************************************
+
+    metadatajournal.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef METADATAJOURNAL_H
+#define METADATAJOURNAL_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QHash>
+#include <QDebug>
+
+#include "lddecodemetadata.h"
+
+// Append-only metadata journal.  Whilst a tool processes a file, each updated field is
+// appended to the journal as it is updated, so a run that is interrupted loses nothing and
+// can carry on from the last journalled field.  LdDecodeMetaData::read() replays the
+// journal on top of the JSON file; compacting the journal writes the JSON file and empties
+// the journal.  Like the sidecar, the journal records the size and modification time of its
+// JSON file and is ignored if the JSON file has since been rewritten.
+//
+// Each record holds the complete field, so replaying a record more than once is harmless.
+// Records are tagged with the name of the processing pass that wrote them, and a pass
+// that finishes appends an end record, so a pass can tell where it stopped last time.
+//
+// File layout (all values are little-endian):
+//   Header (32 bytes):  magic "LDJOUR01", version (quint32), reserved (quint32), JSON file
+//                       size (qint64), JSON file modification time (qint64, ms since the epoch)
+//   Records:            payload size (quint32), payload checksum (quint16, CRC-16), reserved
+//                       (quint16), then the payload (a QDataStream of the pass name, the field
+//                       number - or 0 for the end of a pass - and the field)
+// A record that is incomplete or fails its checksum (i.e. an interrupted write) ends the
+// journal.
+class LDDECODESHAREDSHARED_EXPORT MetaDataJournal
+{
+public:
+    MetaDataJournal();
+    ~MetaDataJournal();
+
+    bool open(QString fileName, QString jsonFileName, QString passNameParam);
+    bool reset(void);
+    void close(void);
+
+    bool appendField(qint32 fieldNumber, const LdDecodeMetaData::Field &field);
+    bool appendEndOfPass(void);
+
+    static bool replay(QString fileName, QString jsonFileName, LdDecodeMetaData &ldDecodeMetaData,
+                       QHash<QString, qint32> &lastFieldNumbers);
+    static QString getFileName(QString jsonFileName);
+
+private:
+    QFile *journalFile;
+    QString jsonFileName;
+    QString passName;
+
+    bool appendRecord(qint32 fieldNumber, const LdDecodeMetaData::Field &field);
+    bool writeHeader(void);
+    static bool isHeaderCurrent(const QByteArray &header, QString jsonFileName);
+};
+
+#endif // METADATAJOURNAL_H
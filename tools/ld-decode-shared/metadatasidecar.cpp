@@ -0,0 +1,648 @@
+/************************************************************************
+
+    metadatasidecar.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "metadatasidecar.h"
+
+#include <QSaveFile>
+#include <QDateTime>
+#include <QHash>
+#include <QtEndian>
+
+namespace {
+    const char magic[8] = {'L', 'D', 'M', 'E', 'T', 'A', '0', '1'};
+    const quint32 formatVersion = 1;
+    const qint32 headerSize = 160;
+
+    // Header offsets (after the section offsets)
+    //   80: numberOfSequentialFields, colourBurstStart, colourBurstEnd, blackLevelStart,
+    //       blackLevelEnd, activeVideoStart, activeVideoEnd, white16bIre, black16bIre,
+    //       fieldWidth, fieldHeight, sampleRate, fsc (qint32 each)
+    //  136: samplesPerUs (real)
+    //  144: PCM sampleRate, bits (qint32 each)
+    const qint32 videoParametersOffset = 80;
+    const qint32 samplesPerUsOffset = 136;
+    const qint32 pcmAudioParametersOffset = 144;
+
+    // Header flags
+    const quint32 isSourcePalFlag = 0x01;
+    const quint32 isLittleEndianFlag = 0x02;
+    const quint32 isSignedFlag = 0x04;
+
+    // Field record layout (104 bytes):
+    //    0: seqNo, flags, syncConf, fieldPhaseID (qint32 each)
+    //   16: medianBurstIRE, vits snr (real each)
+    //   32: vbi16, vbi17, vbi18, disc type, picNo, chNo, time code hr, time code min, status
+    //       code sound mode, amendment 2 sound mode, CLV sec, CLV picNo, NTSC FM code data
+    //       (qint32 each)
+    //   84: user code string offset, user code length, number of drop-outs (quint32 each)
+    //   96: index of the first drop-out (quint64)
+    const qint32 fieldRecordSize = 104;
+
+    // Field record flags (the VBI status code flags are at statusCodeShift, in the order
+    // valid, cx, size, side, teletext, dump, fm, digital, parity; the amendment 2 flags are
+    // at statusCodeAm2Shift in the order valid, cx, size, side, teletext, copy, standard)
+    const quint32 isFirstFieldFlag = 0x01;
+    const quint32 vitsInUseFlag = 0x02;
+    const quint32 vbiInUseFlag = 0x04;
+    const quint32 ntscInUseFlag = 0x08;
+    const quint32 leadInFlag = 0x10;
+    const quint32 leadOutFlag = 0x20;
+    const quint32 picStopFlag = 0x40;
+    const qint32 statusCodeShift = 7;
+    const qint32 statusCodeAm2Shift = 16;
+    const quint32 isFmCodeDataValidFlag = 0x00800000;
+    const quint32 fieldFlagFlag = 0x01000000;
+    const quint32 whiteFlagFlag = 0x02000000;
+
+    // Number of field records to write at a time
+    const qint32 writeBatchSize = 4096;
+
+    qint32 getInt(const uchar *data)
+    {
+        return static_cast<qint32>(qFromLittleEndian<quint32>(data));
+    }
+
+    qint64 getInt64(const uchar *data)
+    {
+        return static_cast<qint64>(qFromLittleEndian<quint64>(data));
+    }
+
+    qreal getReal(const uchar *data)
+    {
+        quint64 bits = qFromLittleEndian<quint64>(data);
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    void putInt(qint32 value, uchar *data)
+    {
+        qToLittleEndian<quint32>(static_cast<quint32>(value), data);
+    }
+
+    void putInt64(qint64 value, uchar *data)
+    {
+        qToLittleEndian<quint64>(static_cast<quint64>(value), data);
+    }
+
+    void putReal(qreal value, uchar *data)
+    {
+        double realValue = value;
+        quint64 bits;
+        memcpy(&bits, &realValue, sizeof(bits));
+        qToLittleEndian<quint64>(bits, data);
+    }
+
+    bool writeData(QSaveFile &file, const QByteArray &data)
+    {
+        return file.write(data) == data.size();
+    }
+}
+
+MetaDataSidecar::MetaDataSidecar()
+{
+    sidecarFile = nullptr;
+    mappedData = nullptr;
+    mappedSize = 0;
+    numberOfFields = 0;
+}
+
+MetaDataSidecar::~MetaDataSidecar()
+{
+    close();
+}
+
+// Open and map a sidecar file (returns false if the file does not exist, is not valid, or
+// does not match the current size and modification time of the JSON file).  If the JSON
+// file is optional, the sidecar is also used when the JSON file does not exist
+bool MetaDataSidecar::open(QString fileName, QString jsonFileName, bool isJsonOptional)
+{
+    close();
+
+    sidecarFile = new QFile(fileName);
+    if (!sidecarFile->exists() || !sidecarFile->open(QIODevice::ReadOnly) || sidecarFile->size() < headerSize) {
+        close();
+        return false;
+    }
+
+    mappedSize = sidecarFile->size();
+    mappedData = sidecarFile->map(0, mappedSize);
+    if (mappedData == nullptr) {
+        qDebug() << "MetaDataSidecar::open(): Could not map" << fileName << "-" << sidecarFile->errorString();
+        close();
+        return false;
+    }
+
+    // Check the header
+    const uchar *data = mappedData;
+    for (qint32 i = 0; i < 8; i++) {
+        if (data[i] != static_cast<uchar>(magic[i])) {
+            close();
+            return false;
+        }
+    }
+
+    if (qFromLittleEndian<quint32>(data + 8) != formatVersion || getInt(data + 16) != fieldRecordSize) {
+        qDebug() << "MetaDataSidecar::open(): Sidecar version is not supported - ignoring" << fileName;
+        close();
+        return false;
+    }
+
+    // Check the sidecar was made from the current JSON file (a missing JSON file means the
+    // sidecar cannot be checked, so it is treated as out of date unless the JSON file is
+    // optional)
+    qint64 jsonFileSize;
+    qint64 jsonFileModified;
+    getSourceDetails(jsonFileName, jsonFileSize, jsonFileModified);
+    if (jsonFileSize < 0 && !isJsonOptional) {
+        qDebug() << "MetaDataSidecar::open(): The JSON file" << jsonFileName << "is missing - ignoring" << fileName;
+        close();
+        return false;
+    }
+    if (jsonFileSize >= 0 && (jsonFileSize != getInt64(data + 24) || jsonFileModified != getInt64(data + 32))) {
+        qDebug() << "MetaDataSidecar::open(): Sidecar" << fileName << "is out of date";
+        close();
+        return false;
+    }
+
+    numberOfFields = getInt(data + 12);
+    quint32 flags = qFromLittleEndian<quint32>(data + 20);
+    fieldRecordsOffset = getInt64(data + 40);
+    dropOutsOffset = getInt64(data + 48);
+    numberOfDropOuts = getInt64(data + 56);
+    stringsOffset = getInt64(data + 64);
+    stringsSize = getInt64(data + 72);
+
+    // Check the sections are within the file
+    if (numberOfFields < 0 || numberOfDropOuts < 0 || stringsSize < 0 ||
+            fieldRecordsOffset < headerSize || fieldRecordsOffset + static_cast<qint64>(numberOfFields) * fieldRecordSize > mappedSize ||
+            dropOutsOffset < headerSize || dropOutsOffset + numberOfDropOuts * 12 > mappedSize ||
+            stringsOffset < headerSize || stringsOffset + stringsSize > mappedSize) {
+        qWarning() << "Metadata sidecar" << fileName << "is corrupt - ignoring it";
+        close();
+        return false;
+    }
+
+    const uchar *parameters = data + videoParametersOffset;
+    videoParameters.numberOfSequentialFields = getInt(parameters);
+    videoParameters.colourBurstStart = getInt(parameters + 4);
+    videoParameters.colourBurstEnd = getInt(parameters + 8);
+    videoParameters.blackLevelStart = getInt(parameters + 12);
+    videoParameters.blackLevelEnd = getInt(parameters + 16);
+    videoParameters.activeVideoStart = getInt(parameters + 20);
+    videoParameters.activeVideoEnd = getInt(parameters + 24);
+    videoParameters.white16bIre = getInt(parameters + 28);
+    videoParameters.black16bIre = getInt(parameters + 32);
+    videoParameters.fieldWidth = getInt(parameters + 36);
+    videoParameters.fieldHeight = getInt(parameters + 40);
+    videoParameters.sampleRate = getInt(parameters + 44);
+    videoParameters.fsc = getInt(parameters + 48);
+    videoParameters.samplesPerUs = getReal(data + samplesPerUsOffset);
+    videoParameters.isSourcePal = (flags & isSourcePalFlag) != 0;
+
+    pcmAudioParameters.sampleRate = getInt(data + pcmAudioParametersOffset);
+    pcmAudioParameters.bits = getInt(data + pcmAudioParametersOffset + 4);
+    pcmAudioParameters.isLittleEndian = (flags & isLittleEndianFlag) != 0;
+    pcmAudioParameters.isSigned = (flags & isSignedFlag) != 0;
+
+    qDebug() << "MetaDataSidecar::open(): Opened" << fileName << "-" << numberOfFields << "fields";
+    return true;
+}
+
+// Unmap and close the sidecar file
+void MetaDataSidecar::close(void)
+{
+    if (sidecarFile != nullptr) {
+        if (mappedData != nullptr) sidecarFile->unmap(const_cast<uchar *>(mappedData));
+        sidecarFile->close();
+        delete sidecarFile;
+    }
+
+    sidecarFile = nullptr;
+    mappedData = nullptr;
+    mappedSize = 0;
+    numberOfFields = 0;
+}
+
+qint32 MetaDataSidecar::getNumberOfFields(void)
+{
+    return numberOfFields;
+}
+
+LdDecodeMetaData::VideoParameters MetaDataSidecar::getVideoParameters(void)
+{
+    return videoParameters;
+}
+
+LdDecodeMetaData::PcmAudioParameters MetaDataSidecar::getPcmAudioParameters(void)
+{
+    return pcmAudioParameters;
+}
+
+// Decode a field record (the field index is zero-based).  If isDropOutsIncluded is false
+// the drop-outs are left empty (see readDropOuts())
+LdDecodeMetaData::Field MetaDataSidecar::getField(qint32 fieldIndex, bool isDropOutsIncluded)
+{
+    LdDecodeMetaData::Field field = LdDecodeMetaData::Field();
+    if (mappedData == nullptr || fieldIndex < 0 || fieldIndex >= numberOfFields) {
+        qWarning() << "Metadata sidecar field index" << fieldIndex << "is out of range";
+        return field;
+    }
+
+    const uchar *record = mappedData + fieldRecordsOffset + static_cast<qint64>(fieldIndex) * fieldRecordSize;
+    quint32 flags = qFromLittleEndian<quint32>(record + 4);
+
+    field.seqNo = getInt(record);
+    field.isFirstField = (flags & isFirstFieldFlag) != 0;
+    field.syncConf = getInt(record + 8);
+    field.fieldPhaseID = getInt(record + 12);
+    field.medianBurstIRE = getReal(record + 16);
+
+    field.vits.inUse = (flags & vitsInUseFlag) != 0;
+    field.vits.snr = getReal(record + 24);
+
+    field.vbi.inUse = (flags & vbiInUseFlag) != 0;
+    field.vbi.vbi16 = getInt(record + 32);
+    field.vbi.vbi17 = getInt(record + 36);
+    field.vbi.vbi18 = getInt(record + 40);
+    field.vbi.type = static_cast<LdDecodeMetaData::VbiDiscTypes>(getInt(record + 44));
+    field.vbi.leadIn = (flags & leadInFlag) != 0;
+    field.vbi.leadOut = (flags & leadOutFlag) != 0;
+    field.vbi.picNo = getInt(record + 48);
+    field.vbi.picStop = (flags & picStopFlag) != 0;
+    field.vbi.chNo = getInt(record + 52);
+    field.vbi.timeCode.hr = getInt(record + 56);
+    field.vbi.timeCode.min = getInt(record + 60);
+
+    quint32 statusCode = flags >> statusCodeShift;
+    field.vbi.statusCode.valid = (statusCode & 0x001) != 0;
+    field.vbi.statusCode.cx = (statusCode & 0x002) != 0;
+    field.vbi.statusCode.size = (statusCode & 0x004) != 0;
+    field.vbi.statusCode.side = (statusCode & 0x008) != 0;
+    field.vbi.statusCode.teletext = (statusCode & 0x010) != 0;
+    field.vbi.statusCode.dump = (statusCode & 0x020) != 0;
+    field.vbi.statusCode.fm = (statusCode & 0x040) != 0;
+    field.vbi.statusCode.digital = (statusCode & 0x080) != 0;
+    field.vbi.statusCode.parity = (statusCode & 0x100) != 0;
+    field.vbi.statusCode.soundMode = static_cast<LdDecodeMetaData::VbiSoundModes>(getInt(record + 64));
+
+    quint32 statusCodeAm2 = flags >> statusCodeAm2Shift;
+    field.vbi.statusCodeAm2.valid = (statusCodeAm2 & 0x01) != 0;
+    field.vbi.statusCodeAm2.cx = (statusCodeAm2 & 0x02) != 0;
+    field.vbi.statusCodeAm2.size = (statusCodeAm2 & 0x04) != 0;
+    field.vbi.statusCodeAm2.side = (statusCodeAm2 & 0x08) != 0;
+    field.vbi.statusCodeAm2.teletext = (statusCodeAm2 & 0x10) != 0;
+    field.vbi.statusCodeAm2.copy = (statusCodeAm2 & 0x20) != 0;
+    field.vbi.statusCodeAm2.standard = (statusCodeAm2 & 0x40) != 0;
+    field.vbi.statusCodeAm2.soundMode = static_cast<LdDecodeMetaData::VbiSoundModes>(getInt(record + 68));
+
+    field.vbi.clvPicNo.sec = getInt(record + 72);
+    field.vbi.clvPicNo.picNo = getInt(record + 76);
+
+    field.ntsc.inUse = (flags & ntscInUseFlag) != 0;
+    field.ntsc.isFmCodeDataValid = (flags & isFmCodeDataValidFlag) != 0;
+    field.ntsc.fmCodeData = getInt(record + 80);
+    field.ntsc.fieldFlag = (flags & fieldFlagFlag) != 0;
+    field.ntsc.whiteFlag = (flags & whiteFlagFlag) != 0;
+
+    // User code
+    qint64 userCodeOffset = qFromLittleEndian<quint32>(record + 84);
+    qint64 userCodeLength = qFromLittleEndian<quint32>(record + 88);
+    if (userCodeLength > 0) {
+        if (userCodeOffset + userCodeLength > stringsSize) {
+            qWarning() << "Metadata sidecar user code for field" << fieldIndex + 1 << "is out of range";
+        } else {
+            field.vbi.userCode = QString::fromUtf8(reinterpret_cast<const char *>(mappedData + stringsOffset + userCodeOffset),
+                                                   static_cast<qint32>(userCodeLength));
+        }
+    }
+
+    // Drop-outs
+    qint64 dropOutCount = qFromLittleEndian<quint32>(record + 92);
+    qint64 firstDropOut = getInt64(record + 96);
+    if (isDropOutsIncluded && dropOutCount > 0) {
+        if (firstDropOut < 0 || firstDropOut + dropOutCount > numberOfDropOuts) {
+            qWarning() << "Metadata sidecar drop-outs for field" << fieldIndex + 1 << "are out of range";
+        } else {
+            const uchar *startx = mappedData + dropOutsOffset + (firstDropOut * 4);
+            const uchar *endx = startx + (numberOfDropOuts * 4);
+            const uchar *fieldLine = endx + (numberOfDropOuts * 4);
+
+            qint32 count = static_cast<qint32>(dropOutCount);
+            field.dropOuts.startx.resize(count);
+            field.dropOuts.endx.resize(count);
+            field.dropOuts.fieldLine.resize(count);
+            for (qint32 i = 0; i < count; i++) {
+                field.dropOuts.startx[i] = getInt(startx + (i * 4));
+                field.dropOuts.endx[i] = getInt(endx + (i * 4));
+                field.dropOuts.fieldLine[i] = getInt(fieldLine + (i * 4));
+            }
+        }
+    }
+
+    return field;
+}
+
+// Get the field order details of a field, without decoding the rest of the field
+void MetaDataSidecar::getFieldOrder(qint32 fieldIndex, bool &isFirstField, qint32 &fieldPhaseID)
+{
+    if (mappedData == nullptr || fieldIndex < 0 || fieldIndex >= numberOfFields) {
+        isFirstField = false;
+        fieldPhaseID = 0;
+        return;
+    }
+
+    const uchar *record = mappedData + fieldRecordsOffset + static_cast<qint64>(fieldIndex) * fieldRecordSize;
+    isFirstField = (qFromLittleEndian<quint32>(record + 4) & isFirstFieldFlag) != 0;
+    fieldPhaseID = getInt(record + 12);
+}
+
+// Read the drop-outs of all of the fields into a drop-out store (returns false if the
+// drop-outs are out of range)
+bool MetaDataSidecar::readDropOuts(DropOutStore &dropOutStore)
+{
+    if (mappedData == nullptr || numberOfDropOuts > 0x7fffffff) return false;
+
+    // The drop-outs of each field follow on from the previous field
+    QVector<qint32> fieldCounts(numberOfFields);
+    qint64 nextDropOut = 0;
+    for (qint32 fieldIndex = 0; fieldIndex < numberOfFields; fieldIndex++) {
+        const uchar *record = mappedData + fieldRecordsOffset + static_cast<qint64>(fieldIndex) * fieldRecordSize;
+        qint64 dropOutCount = qFromLittleEndian<quint32>(record + 92);
+        if (dropOutCount > 0 && getInt64(record + 96) != nextDropOut) {
+            qWarning() << "Metadata sidecar drop-outs for field" << fieldIndex + 1 << "are out of order";
+            return false;
+        }
+
+        fieldCounts[fieldIndex] = static_cast<qint32>(dropOutCount);
+        nextDropOut += dropOutCount;
+    }
+    if (nextDropOut != numberOfDropOuts) {
+        qWarning() << "Metadata sidecar drop-out count does not match the fields";
+        return false;
+    }
+
+    // Decode the columns
+    qint32 count = static_cast<qint32>(numberOfDropOuts);
+    QVector<qint32> startx(count);
+    QVector<qint32> endx(count);
+    QVector<qint32> fieldLine(count);
+    const uchar *startxData = mappedData + dropOutsOffset;
+    const uchar *endxData = startxData + (numberOfDropOuts * 4);
+    const uchar *fieldLineData = endxData + (numberOfDropOuts * 4);
+    for (qint32 i = 0; i < count; i++) {
+        startx[i] = getInt(startxData + (i * 4));
+        endx[i] = getInt(endxData + (i * 4));
+        fieldLine[i] = getInt(fieldLineData + (i * 4));
+    }
+
+    return dropOutStore.setAllDropOuts(startx, endx, fieldLine, fieldCounts);
+}
+
+// Write the metadata to a sidecar file, recording the size and modification time of the
+// JSON file it was made from (returns false on failure).  The file is written to a
+// temporary file and renamed when complete, so a sidecar in use by another process is not
+// affected
+bool MetaDataSidecar::write(QString fileName, QString jsonFileName, LdDecodeMetaData &ldDecodeMetaData)
+{
+    QSaveFile sidecarFile(fileName);
+    if (!sidecarFile.open(QIODevice::WriteOnly)) {
+        qWarning() << "Could not open" << fileName << "to write the metadata sidecar";
+        return false;
+    }
+
+    // Reserve space for the header (which is written once the section sizes are known)
+    qint32 numberOfFields = ldDecodeMetaData.getNumberOfFields();
+    if (!writeData(sidecarFile, QByteArray(headerSize, 0))) {
+        qWarning() << "Writing the metadata sidecar failed:" << sidecarFile.errorString();
+        return false;
+    }
+
+    // Write the field records, collecting the drop-outs and user codes
+    QByteArray startxColumn;
+    QByteArray endxColumn;
+    QByteArray fieldLineColumn;
+    QByteArray strings;
+    QHash<QString, quint32> stringOffsets;
+    qint64 numberOfDropOuts = 0;
+
+    QByteArray records;
+    records.reserve(writeBatchSize * fieldRecordSize);
+    for (qint32 fieldIndex = 0; fieldIndex < numberOfFields; fieldIndex++) {
+        LdDecodeMetaData::Field field = ldDecodeMetaData.getField(fieldIndex + 1);
+
+        qint32 recordOffset = records.size();
+        records.resize(recordOffset + fieldRecordSize);
+        uchar *record = reinterpret_cast<uchar *>(records.data()) + recordOffset;
+
+        quint32 flags = 0;
+        if (field.isFirstField) flags |= isFirstFieldFlag;
+        if (field.vits.inUse) flags |= vitsInUseFlag;
+        if (field.vbi.inUse) flags |= vbiInUseFlag;
+        if (field.ntsc.inUse) flags |= ntscInUseFlag;
+        if (field.vbi.leadIn) flags |= leadInFlag;
+        if (field.vbi.leadOut) flags |= leadOutFlag;
+        if (field.vbi.picStop) flags |= picStopFlag;
+
+        quint32 statusCode = 0;
+        if (field.vbi.statusCode.valid) statusCode |= 0x001;
+        if (field.vbi.statusCode.cx) statusCode |= 0x002;
+        if (field.vbi.statusCode.size) statusCode |= 0x004;
+        if (field.vbi.statusCode.side) statusCode |= 0x008;
+        if (field.vbi.statusCode.teletext) statusCode |= 0x010;
+        if (field.vbi.statusCode.dump) statusCode |= 0x020;
+        if (field.vbi.statusCode.fm) statusCode |= 0x040;
+        if (field.vbi.statusCode.digital) statusCode |= 0x080;
+        if (field.vbi.statusCode.parity) statusCode |= 0x100;
+        flags |= statusCode << statusCodeShift;
+
+        quint32 statusCodeAm2 = 0;
+        if (field.vbi.statusCodeAm2.valid) statusCodeAm2 |= 0x01;
+        if (field.vbi.statusCodeAm2.cx) statusCodeAm2 |= 0x02;
+        if (field.vbi.statusCodeAm2.size) statusCodeAm2 |= 0x04;
+        if (field.vbi.statusCodeAm2.side) statusCodeAm2 |= 0x08;
+        if (field.vbi.statusCodeAm2.teletext) statusCodeAm2 |= 0x10;
+        if (field.vbi.statusCodeAm2.copy) statusCodeAm2 |= 0x20;
+        if (field.vbi.statusCodeAm2.standard) statusCodeAm2 |= 0x40;
+        flags |= statusCodeAm2 << statusCodeAm2Shift;
+
+        if (field.ntsc.isFmCodeDataValid) flags |= isFmCodeDataValidFlag;
+        if (field.ntsc.fieldFlag) flags |= fieldFlagFlag;
+        if (field.ntsc.whiteFlag) flags |= whiteFlagFlag;
+
+        putInt(field.seqNo, record);
+        qToLittleEndian<quint32>(flags, record + 4);
+        putInt(field.syncConf, record + 8);
+        putInt(field.fieldPhaseID, record + 12);
+        putReal(field.medianBurstIRE, record + 16);
+        putReal(field.vits.snr, record + 24);
+
+        putInt(field.vbi.vbi16, record + 32);
+        putInt(field.vbi.vbi17, record + 36);
+        putInt(field.vbi.vbi18, record + 40);
+        putInt(static_cast<qint32>(field.vbi.type), record + 44);
+        putInt(field.vbi.picNo, record + 48);
+        putInt(field.vbi.chNo, record + 52);
+        putInt(field.vbi.timeCode.hr, record + 56);
+        putInt(field.vbi.timeCode.min, record + 60);
+        putInt(static_cast<qint32>(field.vbi.statusCode.soundMode), record + 64);
+        putInt(static_cast<qint32>(field.vbi.statusCodeAm2.soundMode), record + 68);
+        putInt(field.vbi.clvPicNo.sec, record + 72);
+        putInt(field.vbi.clvPicNo.picNo, record + 76);
+        putInt(field.ntsc.fmCodeData, record + 80);
+
+        // User code (each distinct string is stored once)
+        QByteArray userCode = field.vbi.userCode.toUtf8();
+        quint32 userCodeOffset = 0;
+        if (!userCode.isEmpty()) {
+            if (stringOffsets.contains(field.vbi.userCode)) {
+                userCodeOffset = stringOffsets.value(field.vbi.userCode);
+            } else {
+                userCodeOffset = static_cast<quint32>(strings.size());
+                stringOffsets.insert(field.vbi.userCode, userCodeOffset);
+                strings.append(userCode);
+            }
+        }
+        qToLittleEndian<quint32>(userCodeOffset, record + 84);
+        qToLittleEndian<quint32>(static_cast<quint32>(userCode.size()), record + 88);
+
+        // Drop-outs
+        qint32 dropOutCount = field.dropOuts.startx.size();
+        qToLittleEndian<quint32>(static_cast<quint32>(dropOutCount), record + 92);
+        putInt64(numberOfDropOuts, record + 96);
+        for (qint32 i = 0; i < dropOutCount; i++) {
+            uchar value[4];
+            putInt(field.dropOuts.startx[i], value);
+            startxColumn.append(reinterpret_cast<const char *>(value), 4);
+            putInt(field.dropOuts.endx[i], value);
+            endxColumn.append(reinterpret_cast<const char *>(value), 4);
+            putInt(field.dropOuts.fieldLine[i], value);
+            fieldLineColumn.append(reinterpret_cast<const char *>(value), 4);
+        }
+        numberOfDropOuts += dropOutCount;
+
+        // Write the records in batches
+        if (records.size() >= writeBatchSize * fieldRecordSize || fieldIndex == numberOfFields - 1) {
+            if (!writeData(sidecarFile, records)) {
+                qWarning() << "Writing the metadata sidecar failed:" << sidecarFile.errorString();
+                return false;
+            }
+            records.resize(0);
+        }
+    }
+
+    // Write the drop-out columns and the strings
+    qint64 fieldRecordsOffset = headerSize;
+    qint64 dropOutsOffset = fieldRecordsOffset + static_cast<qint64>(numberOfFields) * fieldRecordSize;
+    qint64 stringsOffset = dropOutsOffset + numberOfDropOuts * 12;
+    if (!writeData(sidecarFile, startxColumn) || !writeData(sidecarFile, endxColumn) ||
+            !writeData(sidecarFile, fieldLineColumn) || !writeData(sidecarFile, strings)) {
+        qWarning() << "Writing the metadata sidecar failed:" << sidecarFile.errorString();
+        return false;
+    }
+
+    // Write the header
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+    LdDecodeMetaData::PcmAudioParameters pcmAudioParameters = ldDecodeMetaData.getPcmAudioParameters();
+
+    quint32 flags = 0;
+    if (videoParameters.isSourcePal) flags |= isSourcePalFlag;
+    if (pcmAudioParameters.isLittleEndian) flags |= isLittleEndianFlag;
+    if (pcmAudioParameters.isSigned) flags |= isSignedFlag;
+
+    qint64 jsonFileSize;
+    qint64 jsonFileModified;
+    getSourceDetails(jsonFileName, jsonFileSize, jsonFileModified);
+
+    QByteArray header(headerSize, 0);
+    uchar *data = reinterpret_cast<uchar *>(header.data());
+    for (qint32 i = 0; i < 8; i++) data[i] = static_cast<uchar>(magic[i]);
+    qToLittleEndian<quint32>(formatVersion, data + 8);
+    putInt(numberOfFields, data + 12);
+    putInt(fieldRecordSize, data + 16);
+    qToLittleEndian<quint32>(flags, data + 20);
+    putInt64(jsonFileSize, data + 24);
+    putInt64(jsonFileModified, data + 32);
+    putInt64(fieldRecordsOffset, data + 40);
+    putInt64(dropOutsOffset, data + 48);
+    putInt64(numberOfDropOuts, data + 56);
+    putInt64(stringsOffset, data + 64);
+    putInt64(strings.size(), data + 72);
+
+    uchar *parameters = data + videoParametersOffset;
+    putInt(videoParameters.numberOfSequentialFields, parameters);
+    putInt(videoParameters.colourBurstStart, parameters + 4);
+    putInt(videoParameters.colourBurstEnd, parameters + 8);
+    putInt(videoParameters.blackLevelStart, parameters + 12);
+    putInt(videoParameters.blackLevelEnd, parameters + 16);
+    putInt(videoParameters.activeVideoStart, parameters + 20);
+    putInt(videoParameters.activeVideoEnd, parameters + 24);
+    putInt(videoParameters.white16bIre, parameters + 28);
+    putInt(videoParameters.black16bIre, parameters + 32);
+    putInt(videoParameters.fieldWidth, parameters + 36);
+    putInt(videoParameters.fieldHeight, parameters + 40);
+    putInt(videoParameters.sampleRate, parameters + 44);
+    putInt(videoParameters.fsc, parameters + 48);
+    putReal(videoParameters.samplesPerUs, data + samplesPerUsOffset);
+
+    putInt(pcmAudioParameters.sampleRate, data + pcmAudioParametersOffset);
+    putInt(pcmAudioParameters.bits, data + pcmAudioParametersOffset + 4);
+
+    if (!sidecarFile.seek(0) || !writeData(sidecarFile, header) || !sidecarFile.commit()) {
+        qWarning() << "Writing the metadata sidecar failed:" << sidecarFile.errorString();
+        return false;
+    }
+
+    qDebug() << "MetaDataSidecar::write(): Wrote" << numberOfFields << "fields to" << fileName;
+    return true;
+}
+
+// Get the sidecar file name for a JSON metadata file
+QString MetaDataSidecar::getFileName(QString jsonFileName)
+{
+    return jsonFileName + ".bin";
+}
+
+// Get the name of the JSON file for a sidecar file name (returns an empty string if the
+// file name is not a sidecar file name)
+QString MetaDataSidecar::getJsonFileName(QString fileName)
+{
+    if (!fileName.endsWith(".json.bin")) return QString();
+    return fileName.left(fileName.size() - 4);
+}
+
+// Get the size and modification time of the JSON file (the size is -1 if the file does
+// not exist)
+void MetaDataSidecar::getSourceDetails(QString jsonFileName, qint64 &size, qint64 &modified)
+{
+    QFileInfo jsonFileInfo(jsonFileName);
+    if (!jsonFileInfo.exists()) {
+        size = -1;
+        modified = 0;
+        return;
+    }
+
+    size = jsonFileInfo.size();
+    modified = jsonFileInfo.lastModified().toMSecsSinceEpoch();
+}
@@ -0,0 +1,95 @@
+/************************************************************************
+
+    metadatasidecar.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef METADATASIDECAR_H
+#define METADATASIDECAR_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+#include <QDebug>
+
+#include "lddecodemetadata.h"
+#include "dropoutstore.h"
+
+// Binary metadata sidecar.  The sidecar holds the same metadata as the JSON file it is
+// made from, in a form that is memory mapped rather than parsed, so opening it takes the
+// same time however many fields there are and any field can be decoded directly.  The
+// sidecar records the size and modification time of its JSON file, and is only used
+// whilst they match (so a JSON file that is rewritten by a tool is read again).  If the
+// JSON file is missing the sidecar is not used, unless it was named directly (see
+// LdDecodeMetaData::read()).
+//
+// File layout (all values are little-endian, reals are IEEE 754 doubles):
+//   Header (160 bytes):  magic "LDMETA01", version (quint32), number of fields (quint32),
+//                        field record size (quint32), flags (quint32), JSON file size
+//                        (qint64), JSON file modification time (qint64, ms since the epoch),
+//                        field records offset, drop-outs offset, number of drop-outs,
+//                        strings offset and strings size (quint64 each), then the video and
+//                        PCM audio parameters (see metadatasidecar.cpp)
+//   Field records:       one fixed size record per field; the drop-outs and user code of a
+//                        field are referenced by index into the sections below
+//   Drop-outs:           columns of qint32 - all of the startx values, then all of the endx
+//                        values, then all of the fieldLine values
+//   Strings:             the VBI user codes (UTF-8, each distinct string stored once)
+class LDDECODESHAREDSHARED_EXPORT MetaDataSidecar
+{
+public:
+    MetaDataSidecar();
+    ~MetaDataSidecar();
+
+    bool open(QString fileName, QString jsonFileName, bool isJsonOptional = false);
+    void close(void);
+
+    qint32 getNumberOfFields(void);
+    LdDecodeMetaData::VideoParameters getVideoParameters(void);
+    LdDecodeMetaData::PcmAudioParameters getPcmAudioParameters(void);
+    LdDecodeMetaData::Field getField(qint32 fieldIndex, bool isDropOutsIncluded = true);
+    bool readDropOuts(DropOutStore &dropOutStore);
+    void getFieldOrder(qint32 fieldIndex, bool &isFirstField, qint32 &fieldPhaseID);
+
+    static bool write(QString fileName, QString jsonFileName, LdDecodeMetaData &ldDecodeMetaData);
+    static QString getFileName(QString jsonFileName);
+    static QString getJsonFileName(QString fileName);
+    static void getSourceDetails(QString jsonFileName, qint64 &size, qint64 &modified);
+
+private:
+    QFile *sidecarFile;
+    const uchar *mappedData;
+    qint64 mappedSize;
+
+    // Header values
+    qint32 numberOfFields;
+    qint64 fieldRecordsOffset;
+    qint64 dropOutsOffset;
+    qint64 numberOfDropOuts;
+    qint64 stringsOffset;
+    qint64 stringsSize;
+    LdDecodeMetaData::VideoParameters videoParameters;
+    LdDecodeMetaData::PcmAudioParameters pcmAudioParameters;
+};
+
+#endif // METADATASIDECAR_H
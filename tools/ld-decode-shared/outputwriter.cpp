@@ -0,0 +1,298 @@
+/************************************************************************
+
+    outputwriter.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "outputwriter.h"
+
+#ifdef Q_OS_LINUX
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+// The output writer is a background I/O thread used by the tools to write their output
+// video without stalling the processing.  Each write is copied into one of a fixed set of
+// pre-allocated buffers and queued; the thread writes the queued buffers to the file in
+// the order they were queued and then returns them to the free list.  The caller only
+// blocks when all of the buffers are queued (i.e. when the storage cannot keep up).
+//
+// If a write to the file fails, the remaining queued data is discarded and all further
+// calls to write() (and close()) return false.
+
+OutputWriter::OutputWriter(QObject *parent) : QThread(parent)
+{
+    // Thread control variables
+    isClosing = false;
+    writeFailed = false;
+
+    // Default object settings
+    outputFile = nullptr;
+    isScanModeEnabled = false;
+    fileOffset = 0;
+    releasedOffset = 0;
+
+    totalBytesWritten = 0;
+    totalBuffersWritten = 0;
+    totalWriteNsecs = 0;
+    totalWaitNsecs = 0;
+}
+
+OutputWriter::~OutputWriter()
+{
+    close();
+}
+
+// Open the target file (returns true on success)
+// A file name of "-" writes to stdout.  bufferSizeParam is the expected size of each
+// write in bytes (larger writes are accepted, but cause the buffer to be reallocated)
+bool OutputWriter::open(QString fileNameParam, qint32 bufferSizeParam, qint32 bufferCountParam)
+{
+    // Close any existing file
+    close();
+
+    outputFile = new QFile(fileNameParam);
+    bool isOpen;
+    if (fileNameParam == "-") isOpen = outputFile->open(stdout, QIODevice::WriteOnly);
+    else isOpen = outputFile->open(QIODevice::WriteOnly);
+
+    if (!isOpen) {
+        qWarning() << "Could not open" << fileNameParam << "as the output file";
+        delete outputFile;
+        outputFile = nullptr;
+        return false;
+    }
+
+    // At least two buffers are required so that one can be filled while the other is written
+    if (bufferCountParam < 2) bufferCountParam = 2;
+
+    mutex.lock();
+    isClosing = false;
+    writeFailed = false;
+    buffers.clear();
+    buffers.resize(bufferCountParam);
+    bufferLengths.fill(0, bufferCountParam);
+    freeBuffers.clear();
+    queuedBuffers.clear();
+    for (qint32 i = 0; i < bufferCountParam; i++) {
+        buffers[i].resize(bufferSizeParam);
+        freeBuffers.enqueue(i);
+    }
+    totalBytesWritten = 0;
+    totalBuffersWritten = 0;
+    totalWriteNsecs = 0;
+    totalWaitNsecs = 0;
+    fileOffset = 0;
+    releasedOffset = 0;
+    mutex.unlock();
+
+    // Start the I/O thread
+    start(NormalPriority);
+
+    return true;
+}
+
+// Write all of the queued data, stop the I/O thread and close the target file
+// (returns false if any of the data could not be written)
+bool OutputWriter::close(void)
+{
+    if (isRunning()) {
+        mutex.lock();
+        isClosing = true;
+        bufferQueued.wakeAll();
+        mutex.unlock();
+
+        wait();
+    }
+
+    if (outputFile == nullptr) return !writeFailed;
+
+    if (!writeFailed && !outputFile->flush()) {
+        qWarning() << "Writing to the output file failed:" << outputFile->errorString();
+        writeFailed = true;
+    }
+    outputFile->close();
+    delete outputFile;
+    outputFile = nullptr;
+
+    qDebug() << "OutputWriter::close(): Wrote" << totalBytesWritten << "bytes in" << totalWriteNsecs / 1000000 <<
+                "ms - the caller waited" << totalWaitNsecs / 1000000 << "ms for free buffers";
+
+    mutex.lock();
+    buffers.clear();
+    freeBuffers.clear();
+    queuedBuffers.clear();
+    mutex.unlock();
+
+    return !writeFailed;
+}
+
+// Queue data to be written (returns false if an earlier write has failed)
+// The data is copied, so the caller can reuse its buffer as soon as this returns
+bool OutputWriter::write(const char *data, qint64 length)
+{
+    QMutexLocker locker(&mutex);
+
+    if (outputFile == nullptr || writeFailed) return false;
+
+    // Wait for a free buffer
+    if (freeBuffers.isEmpty()) {
+        QElapsedTimer waitTimer;
+        waitTimer.start();
+        while (freeBuffers.isEmpty() && !writeFailed) bufferFree.wait(&mutex);
+        totalWaitNsecs += waitTimer.nsecsElapsed();
+        if (writeFailed) return false;
+    }
+    qint32 bufferIndex = freeBuffers.dequeue();
+
+    // Fill the buffer without holding the lock (the buffer is not in either queue, so the
+    // thread will not touch it)
+    locker.unlock();
+    if (buffers[bufferIndex].size() < length) buffers[bufferIndex].resize(static_cast<qint32>(length));
+    memcpy(buffers[bufferIndex].data(), data, static_cast<size_t>(length));
+    bufferLengths[bufferIndex] = length;
+    locker.relock();
+
+    queuedBuffers.enqueue(bufferIndex);
+    bufferQueued.wakeOne();
+
+    return true;
+}
+
+bool OutputWriter::write(QByteArray data)
+{
+    return write(data.constData(), data.size());
+}
+
+// Set scan mode on or off (must be set before the file is opened).  In scan mode each
+// buffer is sent to the disc as soon as it is written, and the written data is released
+// from the operating system's page cache once it is on the disc, so writing a whole disc
+// does not fill the page cache with dirty pages (see SourceVideo::setScanMode()).  Only
+// supported on Linux, and ignored if the output is not a regular file.
+void OutputWriter::setScanMode(bool enabled)
+{
+    if (isRunning()) {
+        qWarning() << "Output writer setScanMode called, but an output file is already open";
+        return;
+    }
+
+    isScanModeEnabled = enabled;
+}
+
+// Get the write statistics (the time figures allow the tools to report the sustained rate
+// of the write stage separately from the rate of the processing)
+OutputWriter::Statistics OutputWriter::getStatistics(void)
+{
+    QMutexLocker locker(&mutex);
+
+    Statistics statistics;
+    statistics.bytesWritten = totalBytesWritten;
+    statistics.buffersWritten = totalBuffersWritten;
+    statistics.writeNsecs = totalWriteNsecs;
+    statistics.waitNsecs = totalWaitNsecs;
+
+    return statistics;
+}
+
+// Returns true if a write to the target file has failed
+bool OutputWriter::isWriteFailed(void)
+{
+    QMutexLocker locker(&mutex);
+    return writeFailed;
+}
+
+void OutputWriter::run()
+{
+    qDebug() << "OutputWriter::run(): Thread running";
+
+    mutex.lock();
+    while (true) {
+        // Sleep until there is data to write
+        if (queuedBuffers.isEmpty()) {
+            if (isClosing) break;
+            bufferQueued.wait(&mutex);
+            continue;
+        }
+
+        qint32 bufferIndex = queuedBuffers.dequeue();
+        bool isDiscarded = writeFailed;
+        mutex.unlock();
+
+        // Perform the I/O without holding the lock
+        bool isWritten = true;
+        qint64 writeNsecs = 0;
+        if (!isDiscarded) {
+            QElapsedTimer writeTimer;
+            writeTimer.start();
+            qint64 length = bufferLengths[bufferIndex];
+            isWritten = (outputFile->write(buffers[bufferIndex].constData(), length) == length);
+            if (!isWritten) qWarning() << "Writing to the output file failed:" << outputFile->errorString();
+            else if (isScanModeEnabled) releaseFileCache(fileOffset, length);
+            fileOffset += length;
+            writeNsecs = writeTimer.nsecsElapsed();
+        }
+
+        mutex.lock();
+        if (!isWritten) writeFailed = true;
+        else if (!isDiscarded) {
+            totalBytesWritten += bufferLengths[bufferIndex];
+            totalBuffersWritten++;
+            totalWriteNsecs += writeNsecs;
+        }
+
+        // Return the buffer to the free list
+        freeBuffers.enqueue(bufferIndex);
+        bufferFree.wakeAll();
+    }
+    mutex.unlock();
+
+    qDebug() << "OutputWriter::run(): Thread stopped";
+}
+
+// Start writing a range of the output file to the disc and, once enough has been written,
+// wait for the older data to reach the disc and release it from the page cache (called by
+// the thread in scan mode).  The kernel only drops whole (large) folios, so the data is
+// released in batches aligned to scanReleaseAlignment rather than one buffer at a time;
+// waiting for the older data rather than the current buffer keeps the disc busy.
+void OutputWriter::releaseFileCache(qint64 position, qint64 bytes)
+{
+#ifdef Q_OS_LINUX
+    // Data held in QFile's own buffer must be passed to the kernel first
+    outputFile->flush();
+    int fileHandle = outputFile->handle();
+
+    // Ignore the hints if the output is not a regular file (e.g. a pipe)
+    if (sync_file_range(fileHandle, static_cast<off_t>(position), static_cast<off_t>(bytes), SYNC_FILE_RANGE_WRITE) != 0) return;
+
+    qint64 writtenOffset = position + bytes;
+    writtenOffset -= writtenOffset % scanReleaseAlignment;
+    if (writtenOffset - releasedOffset >= scanReleaseAlignment * 4) {
+        off_t length = static_cast<off_t>(writtenOffset - releasedOffset);
+        sync_file_range(fileHandle, static_cast<off_t>(releasedOffset), length,
+                        SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        posix_fadvise(fileHandle, static_cast<off_t>(releasedOffset), length, POSIX_FADV_DONTNEED);
+        releasedOffset = writtenOffset;
+    }
+#else
+    Q_UNUSED(position);
+    Q_UNUSED(bytes);
+#endif
+}
@@ -0,0 +1,102 @@
+/************************************************************************
+
+    outputwriter.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef OUTPUTWRITER_H
+#define OUTPUTWRITER_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QFile>
+#include <QVector>
+#include <QQueue>
+#include <QElapsedTimer>
+#include <QDebug>
+
+class LDDECODESHAREDSHARED_EXPORT OutputWriter : public QThread
+{
+    Q_OBJECT
+
+public:
+    explicit OutputWriter(QObject *parent = nullptr);
+    ~OutputWriter() override;
+
+    bool open(QString fileNameParam, qint32 bufferSizeParam, qint32 bufferCountParam = 4);
+    bool close(void);
+
+    bool write(const char *data, qint64 length);
+    bool write(QByteArray data);
+    bool isWriteFailed(void);
+    void setScanMode(bool enabled);
+
+    // Statistics (kept after the file is closed)
+    struct Statistics {
+        qint64 bytesWritten;
+        qint64 buffersWritten;
+        qint64 writeNsecs;  // Time the thread spent writing to the file
+        qint64 waitNsecs;   // Time the caller spent waiting for free buffers
+    };
+
+    Statistics getStatistics(void);
+
+protected:
+    void run() override;
+
+private:
+    // Thread control
+    QMutex mutex;
+    QWaitCondition bufferFree;
+    QWaitCondition bufferQueued;
+    bool isClosing;
+    bool writeFailed;
+
+    // Target file
+    QFile *outputFile;
+
+    // Pre-allocated output buffers (each buffer is either free, being filled by the caller,
+    // queued or being written by the thread)
+    QVector<QByteArray> buffers;
+    QVector<qint64> bufferLengths;
+    QQueue<qint32> freeBuffers;
+    QQueue<qint32> queuedBuffers;
+
+    // Scan mode (written data is flushed to disc and released from the page cache)
+    bool isScanModeEnabled;
+    static const qint64 scanReleaseAlignment = 8 * 1024 * 1024;
+    qint64 fileOffset;
+    qint64 releasedOffset;
+
+    void releaseFileCache(qint64 position, qint64 bytes);
+
+    // Statistics
+    qint64 totalBytesWritten;
+    qint64 totalBuffersWritten;
+    qint64 totalWriteNsecs;
+    qint64 totalWaitNsecs;
+};
+
+#endif // OUTPUTWRITER_H
@@ -32,15 +32,33 @@ SourceField::SourceField(QObject *parent) : QObject(parent)
 }
 
 // Public method to set the frame's greyscale data
+// Note: The data is implicitly shared (not copied)
 void SourceField::setFieldData(QByteArray fieldGreyscaleData)
 {
     qDebug() << "SourceField::setGreyScaleData(): Called";
 
     isFieldValid = true;
-    greyScaleData = QByteArray(fieldGreyscaleData, fieldGreyscaleData.size());
+    greyScaleData = fieldGreyscaleData;
+    mappedFile.clear();
+}
+
+// Public method to set the frame's greyscale data to a raw data view of a memory mapped
+// file.  The field holds a reference to the mapping, so the view remains valid for the
+// lifetime of the field object
+void SourceField::setMappedFieldData(QByteArray fieldGreyscaleData, QSharedPointer<uchar> mappedFileParam)
+{
+    qDebug() << "SourceField::setMappedFieldData(): Called";
+
+    isFieldValid = true;
+    greyScaleData = fieldGreyscaleData;
+    mappedFile = mappedFileParam;
 }
 
 // Public method to get the frame's greyscale data
+// Note: Use constData() on the returned array to access the samples; calling data() on a
+// memory mapped field will cause a deep copy of the field.  The returned array of a memory
+// mapped field is only valid whilst the field object is held (use the FieldBuffer
+// constructor that takes the field to keep the data beyond that)
 QByteArray SourceField::getFieldData(void)
 {
     if (!isFieldValid) {
@@ -28,6 +28,7 @@
 #include "ld-decode-shared_global.h"
 
 #include <QObject>
+#include <QSharedPointer>
 #include <QDebug>
 
 class LDDECODESHAREDSHARED_EXPORT SourceField : public QObject
@@ -37,12 +38,18 @@ class LDDECODESHAREDSHARED_EXPORT SourceField : public QObject
 public:
     explicit SourceField(QObject *parent = nullptr);
     void setFieldData(QByteArray fieldGreyscaleData);
+    void setMappedFieldData(QByteArray fieldGreyscaleData, QSharedPointer<uchar> mappedFileParam);
     QByteArray getFieldData(void);
 
 private:
     QByteArray greyScaleData;
     bool isFieldValid;
 
+    // The memory mapping the field data is a view of (null if the data is not mapped).  The
+    // mapping is shared, so it stays mapped whilst the field is held, even if the source
+    // video is closed
+    QSharedPointer<uchar> mappedFile;
+
     void configureParameters(void);
 
 };
@@ -24,6 +24,19 @@
 
 #include "sourcevideo.h"
 
+#include <QtEndian>
+
+#include <limits>
+
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#include <errno.h>
+#endif
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#endif
+
 // Class constructor
 SourceVideo::SourceVideo(QObject *parent) : QObject(parent)
 {
@@ -34,21 +47,52 @@ SourceVideo::SourceVideo(QObject *parent) : QObject(parent)
     availableFields = -1;
     fileName.clear();
     fieldLength = -1;
+    fieldWidth = -1;
     inputFile = nullptr;
+
+    // Memory map the input file by default on 64-bit platforms (a 32-bit
+    // address space is not large enough for a full disc TBC file)
+#if Q_PROCESSOR_WORDSIZE == 8
+    isMemoryMappingEnabled = true;
+#else
+    isMemoryMappingEnabled = false;
+#endif
+
+    // Read ahead 8 fields when the source is accessed sequentially
+    fieldPrefetcher = nullptr;
+    prefetchDepth = 8;
+    lastRequestedField = -1;
+    sequentialRequests = 0;
+
+    // Streaming input (the number of fields in a stream must be set by the caller)
+    fieldStreamReader = nullptr;
+    streamFieldCount = -1;
+    streamBufferSize = 64;
+
+    // Scan mode is off by default
+    isScanModeEnabled = false;
+    scanReleasedOffset = 0;
+
+    // Default field cache size of 64 MiB (around 90 PAL fields)
+    cacheSize = 64;
+    resetCacheStatistics();
 }
 
 SourceVideo::~SourceVideo()
 {
+    if (fieldPrefetcher != nullptr) delete fieldPrefetcher;
+    if (fieldStreamReader != nullptr) delete fieldStreamReader;
     if (inputFile != nullptr) delete inputFile;
 }
 
 // Source Video file manipulation methods -----------------------------------------------------------------------------
 
 // Open an input video data file (returns true on success)
-bool SourceVideo::open(QString fileNameParam, qint32 fieldLengthParam)
+// The field width (in samples) is only required for reading individual field lines.  A file
+// name of "-" (stdin) or a pipe is opened as a stream (see setStreamFieldCount()).
+bool SourceVideo::open(QString fileNameParam, qint32 fieldLengthParam, qint32 fieldWidthParam)
 {
-    fieldLength = fieldLengthParam;
-    qDebug() << "SourceVideo::open(): Called with field length =" << fieldLength;
+    qDebug() << "SourceVideo::open(): Called with field length =" << fieldLengthParam << "and field width =" << fieldWidthParam;
 
     if (isSourceVideoValid) {
         // Video file is already open, close it
@@ -56,13 +100,49 @@ bool SourceVideo::open(QString fileNameParam, qint32 fieldLengthParam)
         return false;
     }
 
+    fieldLength = fieldLengthParam;
+    fieldWidth = fieldWidthParam;
+
     // Open the source video file
-    inputFile = new QFile(fileNameParam);
-    if (!inputFile->open(QIODevice::ReadOnly)) {
-        // Failed to open input file
-        qWarning() << "Could not open " << fileNameParam << "as source video input file";
-        isSourceVideoValid = false;
-        return false;
+    if (inputFile != nullptr) delete inputFile;
+    inputFile = nullptr;
+    if (fileNameParam != "-") {
+        inputFile = new QFile(fileNameParam);
+        if (!inputFile->open(QIODevice::ReadOnly)) {
+            // Failed to open input file
+            qWarning() << "Could not open " << fileNameParam << "as source video input file";
+            isSourceVideoValid = false;
+            return false;
+        }
+
+        // A pipe cannot be seeked, so it is read as a stream
+        if (inputFile->isSequential()) {
+            delete inputFile;
+            inputFile = nullptr;
+        }
+    }
+
+    // Open a stream (the input is read in order by the stream reader thread)
+    if (inputFile == nullptr) return openStream(fileNameParam);
+
+    // In scan mode, tell the kernel the file will be read sequentially (so it reads ahead
+    // further)
+    scanReleasedOffset = 0;
+#ifdef Q_OS_LINUX
+    if (isScanModeEnabled) posix_fadvise(inputFile->handle(), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    // Open a compressed TBC (the fields are decompressed as they are read)
+    compressedFieldOffsets.clear();
+    if (inputFile->size() >= TbcCodec::headerSize) {
+        TbcCodec::Header header;
+        if (TbcCodec::readHeader(readRawData(0, TbcCodec::headerSize), header)) {
+            fileName = fileNameParam;
+            if (openCompressed(header)) return true;
+
+            inputFile->close();
+            return false;
+        }
     }
 
     // File open successful - configure source video parameters
@@ -72,10 +152,149 @@ bool SourceVideo::open(QString fileNameParam, qint32 fieldLengthParam)
     availableFields = static_cast<qint32>(tAvailableFields);
     qDebug() << "SourceVideo::open(): Successful -" << availableFields << "fields available";
 
+    // Size the field cache and reset the cache statistics
+    applyCacheSize();
+    resetCacheStatistics();
+
+    // Map the input file into memory (if enabled); if mapping fails we fall back to
+    // reading the fields from the file.  The file is not mapped in scan mode, as mapped
+    // pages cannot be released from the page cache whilst the mapping exists
+    mappedFile.clear();
+    if (isMemoryMappingEnabled && !isScanModeEnabled && availableFields > 0) {
+        mappedFile = mapFile(fileNameParam, static_cast<qint64>(fieldLength * 2) * static_cast<qint64>(availableFields));
+    }
+
+    // Start the read-ahead thread (if enabled)
+    lastRequestedField = -1;
+    sequentialRequests = 0;
+    if (prefetchDepth > 0) {
+        fieldPrefetcher = new FieldPrefetcher();
+        if (!fieldPrefetcher->open(fileNameParam, fieldLength, availableFields, mappedFile.data())) {
+            delete fieldPrefetcher;
+            fieldPrefetcher = nullptr;
+        }
+    }
+
+    return true;
+}
+
+// Open the input as a stream.  The size of a stream is unknown, so the number of
+// fields is taken from the value set by setStreamFieldCount() (from the metadata)
+bool SourceVideo::openStream(QString fileNameParam)
+{
+    if (streamFieldCount < 1) {
+        qWarning() << "Source video" << fileNameParam << "is a stream, but the number of fields in the stream is unknown";
+        return false;
+    }
+
+    fieldStreamReader = new FieldStreamReader();
+    if (!fieldStreamReader->open(fileNameParam, fieldLength, streamFieldCount, streamBufferSize)) {
+        delete fieldStreamReader;
+        fieldStreamReader = nullptr;
+        return false;
+    }
+
+    isSourceVideoValid = true;
+    fileName = fileNameParam;
+    availableFields = streamFieldCount;
+    qDebug() << "SourceVideo::openStream(): Successful -" << availableFields << "fields expected from the stream";
+
+    // Size the field cache and reset the cache statistics
+    applyCacheSize();
+    resetCacheStatistics();
+
+    // Streams are not memory mapped and do not use the read-ahead thread (the stream
+    // reader is always reading ahead)
+    mappedFile.clear();
+    lastRequestedField = -1;
+    sequentialRequests = 0;
+
+    return true;
+}
+
+// Open a compressed TBC by reading the field offset index from the end of the file
+bool SourceVideo::openCompressed(TbcCodec::Header header)
+{
+    if (header.fieldWidth < 1 || header.fieldHeight < 1 || static_cast<qint64>(header.fieldWidth) * header.fieldHeight != fieldLength) {
+        qWarning() << "Compressed source video has a field size of" << header.fieldWidth << "x" << header.fieldHeight <<
+                      "which does not match the expected field length of" << fieldLength;
+        return false;
+    }
+    if (fieldWidth < 1) fieldWidth = header.fieldWidth;
+
+    // Check the header describes an index that lies within the file (after the header),
+    // before any of it is read
+    qint64 indexLength = (static_cast<qint64>(header.numberOfFields) + 1) * 8;
+    if (header.numberOfFields < 0 || header.indexOffset < TbcCodec::headerSize || indexLength > std::numeric_limits<qint32>::max() ||
+            header.indexOffset > inputFile->size() - indexLength) {
+        qWarning() << "Compressed source video header is invalid - the file is corrupt or truncated";
+        return false;
+    }
+
+    QByteArray indexData = readRawData(header.indexOffset, static_cast<qint32>(indexLength));
+    if (indexData.isEmpty()) {
+        qWarning() << "Compressed source video index is missing or truncated";
+        return false;
+    }
+
+    // Read the field offsets.  The fields must follow each other between the header and the
+    // index, and each compressed field must fit in a single read
+    const uchar *index = reinterpret_cast<const uchar *>(indexData.constData());
+    compressedFieldOffsets.resize(header.numberOfFields + 1);
+    for (qint32 i = 0; i <= header.numberOfFields; i++) {
+        quint64 fieldOffset = qFromLittleEndian<quint64>(index + (i * 8));
+        qint64 previousOffset = (i == 0) ? TbcCodec::headerSize : compressedFieldOffsets[i - 1];
+
+        if (fieldOffset < static_cast<quint64>(previousOffset) || fieldOffset > static_cast<quint64>(header.indexOffset) ||
+                (i > 0 && static_cast<qint64>(fieldOffset) - previousOffset > std::numeric_limits<qint32>::max())) {
+            qWarning() << "Compressed source video index entry" << i << "is invalid - the file is corrupt";
+            compressedFieldOffsets.clear();
+            return false;
+        }
+        compressedFieldOffsets[i] = static_cast<qint64>(fieldOffset);
+    }
+
+    isSourceVideoValid = true;
+    availableFields = header.numberOfFields;
+    qDebug() << "SourceVideo::openCompressed(): Successful -" << availableFields << "compressed fields available";
+
+    // Size the field cache and reset the cache statistics
+    applyCacheSize();
+    resetCacheStatistics();
+
+    // Compressed fields are not memory mapped and do not use the read-ahead thread
+    mappedFile.clear();
+    lastRequestedField = -1;
+    sequentialRequests = 0;
+
     return true;
 }
 
+// Map the first bytes of a source video file into memory (returns a null pointer if the
+// file cannot be mapped).  The mapping has its own file handle, and is unmapped when the
+// last reference to it is released
+QSharedPointer<uchar> SourceVideo::mapFile(QString fileNameParam, qint64 bytes)
+{
+    QFile *mappedInputFile = new QFile(fileNameParam);
+    uchar *mappedData = nullptr;
+    if (mappedInputFile->open(QIODevice::ReadOnly)) mappedData = mappedInputFile->map(0, bytes);
+
+    if (mappedData == nullptr) {
+        qDebug() << "SourceVideo::mapFile(): Memory mapping failed, falling back to file reads -" << mappedInputFile->errorString();
+        delete mappedInputFile;
+        return QSharedPointer<uchar>();
+    }
+
+    qDebug() << "SourceVideo::mapFile(): Source video file is memory mapped";
+    return QSharedPointer<uchar>(mappedData, [mappedInputFile](uchar *data) {
+        mappedInputFile->unmap(data);
+        delete mappedInputFile;
+    });
+}
+
 // Close an input video data file
+// Note: Fields that are still held by the caller remain valid; a memory mapped file stays
+// mapped until the last field viewing it is released
 void SourceVideo::close(void)
 {
     if (!isSourceVideoValid) {
@@ -84,15 +303,60 @@ void SourceVideo::close(void)
     }
 
     qDebug() << "SourceVideo::close(): Called, closing the source video file and emptying the frame cache";
-    inputFile->close();
-    isSourceVideoValid = false;
 
-    // Clear the frame cache
-    fieldCache.clear();
+    CacheStatistics cacheStatistics = getCacheStatistics();
+    qDebug() << "SourceVideo::close(): Field cache hits =" << cacheStatistics.hits << "misses =" << cacheStatistics.misses <<
+                "evictions =" << cacheStatistics.evictions;
+
+    // Stop the read-ahead thread
+    if (fieldPrefetcher != nullptr) {
+        delete fieldPrefetcher;
+        fieldPrefetcher = nullptr;
+    }
+
+    // Stop the stream reader thread
+    if (fieldStreamReader != nullptr) {
+        delete fieldStreamReader;
+        fieldStreamReader = nullptr;
+    }
+
+    // Clear the frame cache and release the memory mapping (if mapped)
+    clearCache();
+    mappedFile.clear();
+
+    if (inputFile != nullptr) inputFile->close();
+    compressedFieldOffsets.clear();
+    isSourceVideoValid = false;
 
     qDebug() << "SourceVideo::close(): Source video input file closed";
 }
 
+// Set scan mode on or off (must be set before the file is opened).  Scan mode is for tools
+// that make a single sequential pass over a whole disc: the source file is not memory
+// mapped, the kernel is told the file will be read sequentially, and the fields are released
+// from the operating system's page cache once they have been read (so a pass over hundreds of
+// gigabytes does not push everything else out of the page cache).  The field cache and
+// read-ahead thread work as normal.
+//
+// Note: O_DIRECT is not used; it requires the file offset, length and buffer of every read
+// to be aligned to the device block size, and the fields of a TBC file are not (a PAL field
+// is 710510 bytes).  The page cache hints are only supported on Linux.
+void SourceVideo::setScanMode(bool enabled)
+{
+    if (isSourceVideoValid) {
+        qWarning() << "Source video setScanMode called, but an input file is already open";
+        return;
+    }
+
+    isScanModeEnabled = enabled;
+}
+
+// Returns true if scan mode is set
+bool SourceVideo::isScanMode(void)
+{
+    return isScanModeEnabled;
+}
+
 // Get the validity of the source video file
 bool SourceVideo::isSourceValid(void)
 {
@@ -105,116 +369,414 @@ qint32 SourceVideo::getNumberOfAvailableFields(void)
     return availableFields;
 }
 
-// Frame data retrieval methods ---------------------------------------------------------------------------------------
+// Set memory mapping of the source video file on or off (must be set before the file is opened)
+void SourceVideo::setMemoryMapping(bool enabled)
+{
+    if (isSourceVideoValid) {
+        qWarning() << "Source video setMemoryMapping called, but an input file is already open";
+        return;
+    }
 
-// Method to retrieve a single video frame (with caching)
-SourceField* SourceVideo::getVideoField(qint32 fieldNumber)
+    isMemoryMappingEnabled = enabled;
+}
+
+// Returns true if the open source video file is memory mapped
+bool SourceVideo::isMemoryMapped(void)
 {
-    // Check the cache
-    if (fieldCache.contains(fieldNumber)) {
-        qDebug() << "SourceVideo::getVideoField(): Returning cached field" << fieldNumber;
-        return fieldCache.object(fieldNumber);
+    return !mappedFile.isNull();
+}
+
+// Set the number of fields to read ahead when the source is accessed sequentially
+// (0 disables read-ahead; must be set before the file is opened)
+void SourceVideo::setPrefetchDepth(qint32 fields)
+{
+    if (isSourceVideoValid) {
+        qWarning() << "Source video setPrefetchDepth called, but an input file is already open";
+        return;
+    }
+
+    if (fields < 0) fields = 0;
+    prefetchDepth = fields;
+}
+
+// Get the number of fields to read ahead
+qint32 SourceVideo::getPrefetchDepth(void)
+{
+    return prefetchDepth;
+}
+
+// Set the maximum size of the field cache in MiB.  The cache always has room for at least
+// four fields, as callers can hold on to the first field of a frame whilst fetching the
+// second.  The cache can be resized at any time.
+void SourceVideo::setCacheSize(qint32 megabytes)
+{
+    if (megabytes < 0) megabytes = 0;
+    cacheSize = megabytes;
+
+    if (isSourceVideoValid) applyCacheSize();
+}
+
+// Get the maximum size of the field cache in MiB
+qint32 SourceVideo::getCacheSize(void)
+{
+    return cacheSize;
+}
+
+// Get the field cache statistics (since the source video was opened)
+SourceVideo::CacheStatistics SourceVideo::getCacheStatistics(void)
+{
+    CacheStatistics cacheStatistics;
+    cacheStatistics.hits = 0;
+    cacheStatistics.misses = 0;
+    cacheStatistics.evictions = 0;
+    cacheStatistics.cachedFields = 0;
+
+    for (qint32 shard = 0; shard < cacheShards; shard++) {
+        QMutexLocker locker(&fieldCache[shard].mutex);
+        cacheStatistics.hits += fieldCache[shard].hits;
+        cacheStatistics.misses += fieldCache[shard].misses;
+        cacheStatistics.evictions += fieldCache[shard].evictions;
+        cacheStatistics.cachedFields += fieldCache[shard].fields.count();
     }
+    cacheStatistics.cachedBytes = static_cast<qint64>(cacheStatistics.cachedFields) * static_cast<qint64>(fieldLength * 2);
+
+    return cacheStatistics;
+}
+
+// Set the number of fields in the source video when it is a stream (must be set before
+// the stream is opened; usually this is the number of fields in the metadata)
+void SourceVideo::setStreamFieldCount(qint32 fields)
+{
+    streamFieldCount = fields;
+}
+
+// Set the number of fields buffered from a stream (must be set before the stream is
+// opened).  Fields can only be read whilst they are in the buffer (or the field cache),
+// so the buffer must cover the range of fields the caller has in flight.
+void SourceVideo::setStreamBufferSize(qint32 fields)
+{
+    if (isSourceVideoValid) {
+        qWarning() << "Source video setStreamBufferSize called, but an input file is already open";
+        return;
+    }
+
+    if (fields < 4) fields = 4;
+    streamBufferSize = fields;
+}
+
+// Returns true if the source video is being read as a stream
+bool SourceVideo::isStreaming(void)
+{
+    return fieldStreamReader != nullptr;
+}
+
+// Returns true if the source video is a compressed TBC
+bool SourceVideo::isCompressed(void)
+{
+    return !compressedFieldOffsets.isEmpty();
+}
+
+// Frame data retrieval methods ---------------------------------------------------------------------------------------
 
+// Method to retrieve a single video field (with caching)
+// The returned field is reference counted and remains valid whilst it is held by the
+// caller (even after the source video is closed); returns a null pointer on failure
+QSharedPointer<SourceField> SourceVideo::getVideoField(qint32 fieldNumber)
+{
     // Verify that we have an open file
     if (!isSourceVideoValid) {
         qWarning() << "Source video getVideoField called, but no input file is open";
         // Return with error
-        return nullptr;
+        return QSharedPointer<SourceField>();
     }
 
     // Range check the requested field range
     if (fieldNumber < 1 || fieldNumber > availableFields) {
         qWarning() << "Requested field number" << fieldNumber << "is out of range!";
-        return nullptr;
+        return QSharedPointer<SourceField>();
     }
 
-    // Seek to the requested field
-    if (!seekToFieldNumber(fieldNumber)) {
-        // Seeking failed, just return the current cached field
-        qWarning() << "Source video seek failed... staying on the current field";
-        return nullptr;
+    // Check the cache
+    CacheShard &cacheShard = fieldCache[fieldNumber % cacheShards];
+    cacheShard.mutex.lock();
+    if (cacheShard.fields.contains(fieldNumber)) {
+        qDebug() << "SourceVideo::getVideoField(): Returning cached field" << fieldNumber;
+        cacheShard.hits++;
+        QSharedPointer<SourceField> cachedField = *cacheShard.fields.object(fieldNumber);
+        cacheShard.mutex.unlock();
+
+        updateReadAhead(fieldNumber);
+        return cachedField;
+    }
+    cacheShard.misses++;
+    cacheShard.mutex.unlock();
+
+    // Object for storing a field (shared by the cache and the callers)
+    QSharedPointer<SourceField> sourceField(new SourceField());
+
+    QByteArray prefetchedFieldData;
+    qint64 fieldOffset = static_cast<qint64>((fieldLength * 2)) * static_cast<qint64>(fieldNumber - 1);
+    if (fieldStreamReader != nullptr) {
+        // Streaming - wait for the field to arrive from the stream
+        QByteArray fieldData;
+        if (!fieldStreamReader->getField(fieldNumber, fieldData)) {
+            qWarning() << "Source video read of field" << fieldNumber << "from the input stream failed";
+            return QSharedPointer<SourceField>();
+        }
+        sourceField->setFieldData(fieldData);
+    } else if (!compressedFieldOffsets.isEmpty()) {
+        // Compressed - read and decompress the field
+        QByteArray fieldData;
+        QByteArray compressedData = readRawData(compressedFieldOffsets[fieldNumber - 1],
+                static_cast<qint32>(compressedFieldOffsets[fieldNumber] - compressedFieldOffsets[fieldNumber - 1]));
+        if (compressedData.isEmpty() || !TbcCodec::decompressField(compressedData, fieldWidth, fieldLength / fieldWidth, fieldData)) {
+            qWarning() << "Source video decompression of field" << fieldNumber << "failed";
+            return QSharedPointer<SourceField>();
+        }
+        sourceField->setFieldData(fieldData);
+    } else if (fieldPrefetcher != nullptr && fieldPrefetcher->takeField(fieldNumber, prefetchedFieldData)) {
+        // The field has already been read by the read-ahead thread
+        qDebug() << "SourceVideo::getVideoField(): Using prefetched field" << fieldNumber;
+        sourceField->setFieldData(prefetchedFieldData);
+    } else if (!mappedFile.isNull()) {
+        // Memory mapped - the field data is a read-only view of the mapped file (no copy
+        // is made; the field holds the mapping, so the view is valid whilst it is held)
+        sourceField->setMappedFieldData(QByteArray::fromRawData(reinterpret_cast<const char *>(mappedFile.data() + fieldOffset), fieldLength * 2),
+                                        mappedFile);
+    } else {
+        // Read the raw field data from the source video file
+        QByteArray fieldData = readRawData(fieldOffset, fieldLength * 2);
+        if (fieldData.isEmpty()) {
+            qWarning() << "Source video read of field" << fieldNumber << "failed";
+            return QSharedPointer<SourceField>();
+        }
+        sourceField->setFieldData(fieldData);
     }
 
-    // Persistant object for storing a field (managed by qcache)
-    sourceField = new SourceField();
+    // In scan mode the field is not needed in the page cache once it has been read
+    if (isScanModeEnabled && fieldStreamReader == nullptr) {
+        if (!compressedFieldOffsets.isEmpty()) {
+            releaseFileCache(compressedFieldOffsets[fieldNumber - 1], compressedFieldOffsets[fieldNumber] - compressedFieldOffsets[fieldNumber - 1]);
+        } else {
+            releaseFileCache(fieldOffset, fieldLength * 2);
+        }
+    }
+
+    // Keep the read-ahead thread ahead of the reader
+    updateReadAhead(fieldNumber);
 
-    // Add the raw field data from the source video file to the field object
-    sourceField->setFieldData(readRawFieldData());
+    // Place the field in the field cache.  QCache evicts the least recently used fields
+    // first, which suits the sliding windows used by the tools (the fields behind the
+    // window are the least recently used, and the fields being revisited are kept)
+    QMutexLocker locker(&cacheShard.mutex);
+    if (cacheShard.fields.contains(fieldNumber)) {
+        // Another thread read the same field whilst this thread was reading it
+        return *cacheShard.fields.object(fieldNumber);
+    }
 
-    // Place the frame in the frame cache
-    fieldCache.insert(fieldNumber, sourceField, 1);
+    qint32 cachedFields = cacheShard.fields.count();
+    cacheShard.fields.insert(fieldNumber, new QSharedPointer<SourceField>(sourceField), getFieldCost());
+    cacheShard.evictions += cachedFields + 1 - cacheShard.fields.count();
 
     qDebug() << "SourceVideo::getVideoField(): Completed";
-    return fieldCache.object(fieldNumber);
+    return sourceField;
 }
 
-// Private methods for image and file manipulation --------------------------------------------------------------------
+// Method to retrieve a range of lines from a field (the first line of the field is line 1).
+// Only the requested lines are read from the input file, so tools that examine just a few
+// lines of each field (such as the VBI lines) do not read the whole field.  The lines are
+// not cached and do not trigger the read-ahead thread.
+QByteArray SourceVideo::getFieldLines(qint32 fieldNumber, qint32 firstLine, qint32 numberOfLines)
+{
+    // Verify that we have an open file
+    if (!isSourceVideoValid) {
+        qWarning() << "Source video getFieldLines called, but no input file is open";
+        return QByteArray();
+    }
+
+    // The field width is required to locate the lines within the field
+    if (fieldWidth < 1) {
+        qWarning() << "Source video getFieldLines called, but the field width is unknown";
+        return QByteArray();
+    }
+
+    // Range check the requested field and lines
+    if (fieldNumber < 1 || fieldNumber > availableFields) {
+        qWarning() << "Requested field number" << fieldNumber << "is out of range!";
+        return QByteArray();
+    }
 
-// Seeks the input file to the specified field number
-bool SourceVideo::seekToFieldNumber(qint32 fieldNumber)
+    qint32 fieldHeight = fieldLength / fieldWidth;
+    if (firstLine < 1 || numberOfLines < 1 || (firstLine + numberOfLines - 1) > fieldHeight) {
+        qWarning() << "Requested field lines" << firstLine << "to" << firstLine + numberOfLines - 1 << "are out of range!";
+        return QByteArray();
+    }
+
+    qint32 lineOffset = (firstLine - 1) * fieldWidth * 2;
+    qint32 lineBytes = numberOfLines * fieldWidth * 2;
+
+    // If the whole field is already cached, take the lines from the cached copy
+    QSharedPointer<SourceField> cachedField = getCachedField(fieldNumber);
+    if (!cachedField.isNull()) {
+        return cachedField->getFieldData().mid(lineOffset, lineBytes);
+    }
+
+    // Streams and compressed TBCs must be read a field at a time
+    if (fieldStreamReader != nullptr || !compressedFieldOffsets.isEmpty()) {
+        QSharedPointer<SourceField> sourceField = getVideoField(fieldNumber);
+        if (sourceField.isNull()) return QByteArray();
+        return sourceField->getFieldData().mid(lineOffset, lineBytes);
+    }
+
+    // Read just the requested lines from the file
+    qint64 fieldOffset = static_cast<qint64>((fieldLength * 2)) * static_cast<qint64>(fieldNumber - 1);
+    QByteArray fieldLines = readRawData(fieldOffset + lineOffset, lineBytes);
+
+    // In scan mode, release the whole field (the kernel's read-ahead will have read more
+    // of the field than the requested lines)
+    if (isScanModeEnabled) releaseFileCache(fieldOffset, fieldLength * 2);
+
+    return fieldLines;
+}
+
+// Track the access pattern and, once the fields are being requested sequentially, ask
+// the read-ahead thread to fetch the next prefetchDepth fields
+void SourceVideo::updateReadAhead(qint32 fieldNumber)
 {
-    qDebug() << "SourceVideo::seekToFieldNumber(): Called with fieldNumber =" << fieldNumber;
+    if (fieldPrefetcher == nullptr) return;
 
-    if (!isSourceVideoValid) {
-        qWarning() << "Source video seekToFieldNumber called, but no input file is open";
-        return false;
+    QMutexLocker locker(&readAheadMutex);
+
+    // Tools request the first and second field of each frame in turn, so treat a repeat
+    // or a step of one or two fields forwards as sequential access
+    qint32 step = fieldNumber - lastRequestedField;
+    if (step >= 0 && step <= 2) {
+        if (step > 0) sequentialRequests++;
+    } else {
+        sequentialRequests = 0;
     }
+    lastRequestedField = fieldNumber;
 
-    // Check that the required field number is in range (and possible)
-    if (fieldNumber > availableFields || fieldNumber < 1) {
-        qWarning() << "Source video seekToFieldNumber - Requested field number" << fieldNumber << "is out of bounds!";
-        return false;
+    // Only read ahead once the access pattern is established
+    if (sequentialRequests >= 2) fieldPrefetcher->requestFields(fieldNumber + 1, fieldNumber + prefetchDepth);
+}
+
+// Get the cache cost of a field (the field size in KiB)
+qint32 SourceVideo::getFieldCost(void)
+{
+    return ((fieldLength * 2) + 1023) / 1024;
+}
+
+// Apply the configured cache size to the field cache (the size is divided evenly
+// between the cache shards)
+void SourceVideo::applyCacheSize(void)
+{
+    qint32 maxCost = cacheSize * 1024;
+    if (maxCost < getFieldCost() * 4) maxCost = getFieldCost() * 4;
+
+    qint32 shardMaxCost = maxCost / cacheShards;
+    if (shardMaxCost < getFieldCost()) shardMaxCost = getFieldCost();
+
+    for (qint32 shard = 0; shard < cacheShards; shard++) {
+        QMutexLocker locker(&fieldCache[shard].mutex);
+        qint32 cachedFields = fieldCache[shard].fields.count();
+        fieldCache[shard].fields.setMaxCost(shardMaxCost);
+        fieldCache[shard].evictions += cachedFields - fieldCache[shard].fields.count();
     }
 
-    qint64 requiredPosition = static_cast<qint64>((fieldLength * 2)) * static_cast<qint64>(fieldNumber - 1);
-    if (!inputFile->seek(requiredPosition)) {
-        qWarning() << "Source video seek to requested field number" << fieldNumber << "of" << availableFields << "failed!";
-        return false;
+    qDebug() << "SourceVideo::applyCacheSize(): Field cache maximum cost set to" << maxCost << "KiB";
+}
+
+// Private methods for image and file manipulation --------------------------------------------------------------------
+
+// Reset the field cache statistics
+void SourceVideo::resetCacheStatistics(void)
+{
+    for (qint32 shard = 0; shard < cacheShards; shard++) {
+        fieldCache[shard].hits = 0;
+        fieldCache[shard].misses = 0;
+        fieldCache[shard].evictions = 0;
     }
+}
 
-    return true;
+// Get a field from the field cache (returns a null pointer if the field is not cached)
+QSharedPointer<SourceField> SourceVideo::getCachedField(qint32 fieldNumber)
+{
+    CacheShard &cacheShard = fieldCache[fieldNumber % cacheShards];
+    QMutexLocker locker(&cacheShard.mutex);
+
+    if (!cacheShard.fields.contains(fieldNumber)) return QSharedPointer<SourceField>();
+    return *cacheShard.fields.object(fieldNumber);
 }
 
-// Read a field of data from the input file into the current field data QByteArray
-QByteArray SourceVideo::readRawFieldData(void)
+// Remove all fields from the field cache
+void SourceVideo::clearCache(void)
 {
-    qDebug() << "SourceVideo::readRawFieldData(): Called" <<
-                " - field length is" << fieldLength << "words";
+    for (qint32 shard = 0; shard < cacheShards; shard++) {
+        QMutexLocker locker(&fieldCache[shard].mutex);
+        fieldCache[shard].fields.clear();
+    }
+}
 
+// Read a range of bytes from the input file (returns an empty QByteArray on failure)
+// Positioned reads (pread) are used where available, so the file position is not shared
+// between threads; otherwise the seek and read are serialised
+QByteArray SourceVideo::readRawData(qint64 position, qint32 bytes)
+{
     QByteArray outputData;
+    outputData.resize(bytes);
 
-    // Resize the raw field buffer
-    // The size is fieldLength with 16-bit data words
-    outputData.resize((fieldLength * 2));
-
-    // Read the data from the file into the raw field buffer
     qint64 totalReceivedBytes = 0;
     qint64 receivedBytes = 0;
+
+#ifdef Q_OS_UNIX
+    int fileHandle = inputFile->handle();
     do {
-        receivedBytes = inputFile->read(outputData.data(), outputData.size() - receivedBytes);
+        receivedBytes = ::pread(fileHandle, outputData.data() + totalReceivedBytes,
+                                static_cast<size_t>(bytes - totalReceivedBytes), static_cast<off_t>(position + totalReceivedBytes));
 
         if (receivedBytes > 0) totalReceivedBytes += receivedBytes;
-        //qDebug() << "SourceVideo::readRawFieldData(): Got" << receivedBytes << "bytes from input file";
-    } while (receivedBytes > 0 && totalReceivedBytes < outputData.size());
-    //qDebug() << "SourceVideo::readRawFieldData(): Got a total of" << totalReceivedBytes << "bytes from input file";
-
-    // Did we run out of data before filling the buffer?
-    if (receivedBytes == 0) {
-        // Determine why we failed
-        if (totalReceivedBytes == 0) {
-            // We didn't get any data at all...
-            qWarning() << "Zero data received when reading raw field data";
-        } else {
-            // End of file was reached before filling buffer
-            qWarning() << "Reached end of file before filling buffer";
-        }
+    } while ((receivedBytes > 0 || (receivedBytes < 0 && errno == EINTR)) && totalReceivedBytes < bytes);
+#else
+    QMutexLocker locker(&fileMutex);
+    if (!inputFile->seek(position)) {
+        qWarning() << "Source video seek to position" << position << "failed!";
+        return QByteArray();
+    }
 
-        // Return with empty data
-        outputData.clear();
-        return outputData;
+    do {
+        receivedBytes = inputFile->read(outputData.data() + totalReceivedBytes, bytes - totalReceivedBytes);
+        if (receivedBytes > 0) totalReceivedBytes += receivedBytes;
+    } while (receivedBytes > 0 && totalReceivedBytes < bytes);
+#endif
+
+    if (totalReceivedBytes < bytes) {
+        qWarning() << "Reached end of file before reading" << bytes << "bytes from position" << position;
+        return QByteArray();
     }
 
-    // Successful
     return outputData;
 }
+
+// Release the input file from the operating system's page cache up to the end of a range
+// that has been read (used in scan mode).  The kernel only drops whole (large) folios, so
+// releasing each field on its own frees almost nothing; instead the file is released in
+// batches aligned to scanReleaseAlignment.  Fields are read in (roughly) ascending order,
+// so ranges behind the released offset are ignored.
+void SourceVideo::releaseFileCache(qint64 position, qint64 bytes)
+{
+#ifdef Q_OS_LINUX
+    qint64 readOffset = position + bytes;
+    readOffset -= readOffset % scanReleaseAlignment;
+
+    QMutexLocker locker(&scanMutex);
+    if (readOffset - scanReleasedOffset < scanReleaseAlignment * 4) return;
+
+    posix_fadvise(inputFile->handle(), static_cast<off_t>(scanReleasedOffset),
+                  static_cast<off_t>(readOffset - scanReleasedOffset), POSIX_FADV_DONTNEED);
+    scanReleasedOffset = readOffset;
+#else
+    Q_UNUSED(position);
+    Q_UNUSED(bytes);
+#endif
+}
@@ -31,9 +31,17 @@
 #include <QFile>
 #include <QDebug>
 #include <QCache>
+#include <QMutex>
+#include <QSharedPointer>
 
 #include "sourcefield.h"
+#include "fieldprefetcher.h"
+#include "fieldstreamreader.h"
+#include "tbccodec.h"
 
+// Note: Once open, the source video can be shared between threads; getVideoField() and
+// getFieldLines() are thread-safe.  open(), close() and the set methods must only be called
+// when no other thread is using the object.
 class LDDECODESHAREDSHARED_EXPORT SourceVideo : public QObject
 {
     Q_OBJECT
@@ -42,16 +50,39 @@ public:
     explicit SourceVideo(QObject *parent = nullptr);
     ~SourceVideo() override;
 
+    // Field cache statistics
+    struct CacheStatistics {
+        qint64 hits;
+        qint64 misses;
+        qint64 evictions;
+        qint32 cachedFields;
+        qint64 cachedBytes;
+    };
+
     // File handling methods
-    bool open(QString fileName, qint32 fieldLengthParam);
+    bool open(QString fileName, qint32 fieldLengthParam, qint32 fieldWidthParam = -1);
     void close(void);
 
     // Field handling methods
-    SourceField *getVideoField(qint32 fieldNumber);
+    QSharedPointer<SourceField> getVideoField(qint32 fieldNumber);
+    QByteArray getFieldLines(qint32 fieldNumber, qint32 firstLine, qint32 numberOfLines);
 
     // Get and set methods
     bool isSourceValid(void);
     qint32 getNumberOfAvailableFields(void);
+    void setMemoryMapping(bool enabled);
+    bool isMemoryMapped(void);
+    void setPrefetchDepth(qint32 fields);
+    qint32 getPrefetchDepth(void);
+    void setCacheSize(qint32 megabytes);
+    qint32 getCacheSize(void);
+    CacheStatistics getCacheStatistics(void);
+    void setStreamFieldCount(qint32 fields);
+    void setStreamBufferSize(qint32 fields);
+    bool isStreaming(void);
+    bool isCompressed(void);
+    void setScanMode(bool enabled);
+    bool isScanMode(void);
 
 private:
     // File handling globals
@@ -60,14 +91,64 @@ private:
     bool isSourceVideoValid;
     qint32 availableFields;
     qint32 fieldLength;
-
-    // Field caching
-    SourceField *sourceField;
-    QCache<qint32, SourceField> fieldCache;
+    qint32 fieldWidth;
+
+    // Memory mapping globals (the mapping is shared with the fields that view it, and is
+    // only unmapped once the source video and all of those fields have released it)
+    bool isMemoryMappingEnabled;
+    QSharedPointer<uchar> mappedFile;
+
+    // Field caching (the cache cost of each field is its size in KiB).  The cache is split
+    // into shards (by field number), each with its own lock, so that threads fetching
+    // different fields do not contend.  The cache holds shared references to the fields,
+    // so a field stays valid for as long as the caller holds it, even if it is evicted.
+    static const qint32 cacheShards = 8;
+    struct CacheShard {
+        QMutex mutex;
+        QCache<qint32, QSharedPointer<SourceField>> fields;
+        qint64 hits;
+        qint64 misses;
+        qint64 evictions;
+    };
+    CacheShard fieldCache[cacheShards];
+    qint32 cacheSize;
+
+    // Sequential read-ahead
+    QMutex readAheadMutex;
+    FieldPrefetcher *fieldPrefetcher;
+    qint32 prefetchDepth;
+    qint32 lastRequestedField;
+    qint32 sequentialRequests;
+
+    // Streaming input (from a pipe or stdin)
+    FieldStreamReader *fieldStreamReader;
+    qint32 streamFieldCount;
+    qint32 streamBufferSize;
+
+    // Compressed TBC input (the file offset of each field, plus the end of the last field)
+    QVector<qint64> compressedFieldOffsets;
+
+    // Scan mode (for single sequential passes over a whole disc; see setScanMode())
+    static const qint64 scanReleaseAlignment = 8 * 1024 * 1024;
+    bool isScanModeEnabled;
+    QMutex scanMutex;
+    qint64 scanReleasedOffset;
+
+    // Positioned reads (used when pread() is not available)
+    QMutex fileMutex;
 
     // Data processing methods
-    bool seekToFieldNumber(qint32 fieldNumber);
-    QByteArray readRawFieldData(void);
+    bool openStream(QString fileNameParam);
+    bool openCompressed(TbcCodec::Header header);
+    QSharedPointer<uchar> mapFile(QString fileNameParam, qint64 bytes);
+    void resetCacheStatistics(void);
+    QByteArray readRawData(qint64 position, qint32 bytes);
+    void releaseFileCache(qint64 position, qint64 bytes);
+    QSharedPointer<SourceField> getCachedField(qint32 fieldNumber);
+    void clearCache(void);
+    void updateReadAhead(qint32 fieldNumber);
+    qint32 getFieldCost(void);
+    void applyCacheSize(void);
 };
 
 #endif // SOURCEVIDEO_H
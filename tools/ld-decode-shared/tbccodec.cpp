@@ -0,0 +1,429 @@
+/************************************************************************
+
+    tbccodec.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "tbccodec.h"
+
+#include <QtEndian>
+#include <QtAlgorithms>
+
+// The samples of each field line are predicted from the samples already coded, using
+// whichever predictor gives the smallest residuals for that line (the predictor is stored
+// as a 3-bit code at the start of the line).  The TBC is sampled at 4 x fSC, so the sample
+// four to the left has the same subcarrier phase, as does the sample two lines up for NTSC.
+//
+//   0 - Left:                the previous sample on the line
+//   1 - Up:                  the same sample on the previous line
+//   2 - Up two:              the same sample two lines up
+//   3 - Subcarrier:          the sample one subcarrier cycle (four samples) to the left
+//   4 - Subcarrier gradient: subcarrier + up - up subcarrier
+//   5 - Up two gradient:     subcarrier + up two - up two subcarrier
+//
+// The residuals are zig-zag mapped to unsigned values and Rice coded.  The Rice parameter
+// adapts to the running mean of the mapped residuals (as in LOCO-I), and large values
+// (such as at sync edges) are escaped and stored as raw 17-bit values.
+
+namespace {
+    const char magic[8] = {'L', 'D', 'T', 'B', 'C', 'Z', '0', '1'};
+    const quint32 formatVersion = 1;
+
+    const qint32 numberOfPredictors = 6;
+    const qint32 predictorBits = 3;
+    const qint32 escapeLimit = 20;
+    const qint32 escapeBits = 17;
+    const qint32 maximumRiceParameter = 16;
+    const qint32 adaptationReset = 64;
+
+    // Adaptive Rice parameter (the running sum and count of the mapped residuals)
+    struct RiceState {
+        qint32 sum;
+        qint32 count;
+
+        void reset(void)
+        {
+            sum = 32;
+            count = 1;
+        }
+
+        // The smallest k where (count << k) >= sum; this is either the difference of the
+        // logarithms (rounded down) of sum and count, or one more
+        qint32 getParameter(void) const
+        {
+            if (sum <= count) return 0;
+
+            qint32 k = static_cast<qint32>(qCountLeadingZeroBits(static_cast<quint32>(count))) -
+                    static_cast<qint32>(qCountLeadingZeroBits(static_cast<quint32>(sum)));
+            if ((count << k) < sum) k++;
+            if (k > maximumRiceParameter) k = maximumRiceParameter;
+            return k;
+        }
+
+        void update(quint32 mappedResidual)
+        {
+            sum += static_cast<qint32>(mappedResidual);
+            count++;
+            if (count >= adaptationReset) {
+                sum >>= 1;
+                count >>= 1;
+            }
+        }
+    };
+
+    // MSB-first bit writer
+    class BitWriter {
+    public:
+        BitWriter(QByteArray &outputParam) : output(outputParam), accumulator(0), bits(0) {}
+
+        void put(quint32 value, qint32 numberOfBits)
+        {
+            if (numberOfBits == 0) return;
+            accumulator = (accumulator << numberOfBits) | (value & ((1ULL << numberOfBits) - 1));
+            bits += numberOfBits;
+            while (bits >= 8) {
+                bits -= 8;
+                output.append(static_cast<char>(accumulator >> bits));
+            }
+        }
+
+        void putOnes(qint32 numberOfBits)
+        {
+            while (numberOfBits > 16) {
+                put(0xFFFF, 16);
+                numberOfBits -= 16;
+            }
+            put(0xFFFF, numberOfBits);
+        }
+
+        void flush(void)
+        {
+            if (bits > 0) put(0, 8 - bits);
+        }
+
+    private:
+        QByteArray &output;
+        quint64 accumulator;
+        qint32 bits;
+    };
+
+    // MSB-first bit reader (the next bit is the top bit of the accumulator)
+    class BitReader {
+    public:
+        BitReader(const uchar *dataParam, qint32 sizeParam) : data(dataParam), size(sizeParam), position(0), accumulator(0), bits(0) {}
+
+        // Returns false if the data ran out
+        bool get(qint32 numberOfBits, quint32 &value)
+        {
+            if (numberOfBits == 0) {
+                value = 0;
+                return true;
+            }
+            if (bits < numberOfBits) refill();
+            if (bits < numberOfBits) return false;
+
+            value = static_cast<quint32>(accumulator >> (64 - numberOfBits));
+            accumulator <<= numberOfBits;
+            bits -= numberOfBits;
+            return true;
+        }
+
+        // Read a unary coded value (a run of ones ended by a zero), stopping after limit ones
+        bool getUnary(qint32 limit, qint32 &value)
+        {
+            value = 0;
+            while (true) {
+                if (bits < 32) refill();
+                if (bits == 0) return false;
+
+                // Count the leading ones
+                quint64 inverted = ~accumulator;
+                qint32 ones = (inverted == 0) ? 64 : static_cast<qint32>(qCountLeadingZeroBits(inverted));
+                if (ones > bits) ones = bits;
+
+                if (value + ones >= limit) {
+                    consume(limit - value);
+                    value = limit;
+                    return true;
+                }
+
+                if (ones < bits) {
+                    // The terminating zero is in the accumulator
+                    consume(ones + 1);
+                    value += ones;
+                    return true;
+                }
+
+                consume(ones);
+                value += ones;
+            }
+        }
+
+    private:
+        const uchar *data;
+        qint32 size;
+        qint32 position;
+        quint64 accumulator;
+        qint32 bits;
+
+        void refill(void)
+        {
+            while (bits <= 56 && position < size) {
+                accumulator |= static_cast<quint64>(data[position]) << (56 - bits);
+                position++;
+                bits += 8;
+            }
+        }
+
+        void consume(qint32 numberOfBits)
+        {
+            if (numberOfBits == 0) return;
+            if (numberOfBits == 64) accumulator = 0;
+            else accumulator <<= numberOfBits;
+            bits -= numberOfBits;
+        }
+    };
+
+    inline qint32 clampSample(qint32 sample)
+    {
+        if (sample < 0) return 0;
+        if (sample > 65535) return 65535;
+        return sample;
+    }
+
+    // Get the prediction for sample x of a line (the predictors that look to the left
+    // fall back to the left predictor at the start of the line)
+    inline qint32 predict(qint32 predictor, const quint16 *line, const quint16 *up, const quint16 *upTwo, qint32 x)
+    {
+        switch (predictor) {
+        case 1:
+            return up[x];
+        case 2:
+            return upTwo[x];
+        case 3:
+            if (x < 4) break;
+            return line[x - 4];
+        case 4:
+            if (x < 4) return up[x];
+            return clampSample(static_cast<qint32>(line[x - 4]) + static_cast<qint32>(up[x]) - static_cast<qint32>(up[x - 4]));
+        case 5:
+            if (x < 4) return upTwo[x];
+            return clampSample(static_cast<qint32>(line[x - 4]) + static_cast<qint32>(upTwo[x]) - static_cast<qint32>(upTwo[x - 4]));
+        default:
+            break;
+        }
+
+        if (x > 0) return line[x - 1];
+        return (up != nullptr) ? up[0] : 0;
+    }
+
+    // Returns true if the predictor can be used for line y (the predictors that use the
+    // lines above are not available for the first lines of the field)
+    inline bool isPredictorAvailable(qint32 predictor, qint32 y)
+    {
+        if (predictor == 1 || predictor == 4) return y >= 1;
+        if (predictor == 2 || predictor == 5) return y >= 2;
+        return true;
+    }
+
+    // Decode the residuals of a line (the predictor is a template parameter so that the
+    // prediction is resolved at compile time)
+    template<qint32 predictor>
+    bool decodeLine(BitReader &bitReader, RiceState &riceState, quint16 *line, const quint16 *up, const quint16 *upTwo, qint32 fieldWidth);
+
+    inline quint32 mapResidual(qint32 residual)
+    {
+        return (residual >= 0) ? static_cast<quint32>(residual) << 1 : (static_cast<quint32>(-residual) << 1) - 1;
+    }
+
+    inline qint32 unmapResidual(quint32 mappedResidual)
+    {
+        return (mappedResidual & 1) ? -static_cast<qint32>((mappedResidual + 1) >> 1) : static_cast<qint32>(mappedResidual >> 1);
+    }
+}
+
+namespace {
+    template<qint32 predictor>
+    bool decodeLine(BitReader &bitReader, RiceState &riceState, quint16 *line, const quint16 *up, const quint16 *upTwo, qint32 fieldWidth)
+    {
+        for (qint32 x = 0; x < fieldWidth; x++) {
+            qint32 k = riceState.getParameter();
+
+            qint32 quotient;
+            quint32 mappedResidual;
+            if (!bitReader.getUnary(escapeLimit, quotient)) return false;
+            if (quotient < escapeLimit) {
+                quint32 remainder;
+                if (!bitReader.get(k, remainder)) return false;
+                mappedResidual = (static_cast<quint32>(quotient) << k) | remainder;
+            } else {
+                if (!bitReader.get(escapeBits, mappedResidual)) return false;
+            }
+
+            qint32 sample = predict(predictor, line, up, upTwo, x) + unmapResidual(mappedResidual);
+            if (sample < 0 || sample > 65535) return false;
+            line[x] = static_cast<quint16>(sample);
+
+            riceState.update(mappedResidual);
+        }
+
+        return true;
+    }
+}
+
+// Read and verify a compressed TBC header (returns false if the data is not a compressed TBC)
+bool TbcCodec::readHeader(const QByteArray &headerData, Header &header)
+{
+    if (headerData.size() < headerSize) return false;
+
+    const uchar *data = reinterpret_cast<const uchar *>(headerData.constData());
+    for (qint32 i = 0; i < 8; i++) {
+        if (data[i] != static_cast<uchar>(magic[i])) return false;
+    }
+
+    quint32 version = qFromLittleEndian<quint32>(data + 8);
+    if (version != formatVersion) {
+        qWarning() << "Compressed TBC version" << version << "is not supported";
+        return false;
+    }
+
+    header.fieldWidth = static_cast<qint32>(qFromLittleEndian<quint32>(data + 12));
+    header.fieldHeight = static_cast<qint32>(qFromLittleEndian<quint32>(data + 16));
+    header.numberOfFields = static_cast<qint32>(qFromLittleEndian<quint32>(data + 20));
+    header.indexOffset = static_cast<qint64>(qFromLittleEndian<quint64>(data + 24));
+
+    return true;
+}
+
+// Generate a compressed TBC header
+QByteArray TbcCodec::writeHeader(const Header &header)
+{
+    QByteArray headerData(headerSize, 0);
+    uchar *data = reinterpret_cast<uchar *>(headerData.data());
+
+    for (qint32 i = 0; i < 8; i++) data[i] = static_cast<uchar>(magic[i]);
+    qToLittleEndian<quint32>(formatVersion, data + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(header.fieldWidth), data + 12);
+    qToLittleEndian<quint32>(static_cast<quint32>(header.fieldHeight), data + 16);
+    qToLittleEndian<quint32>(static_cast<quint32>(header.numberOfFields), data + 20);
+    qToLittleEndian<quint64>(static_cast<quint64>(header.indexOffset), data + 24);
+
+    return headerData;
+}
+
+// Compress a field of 16-bit samples (fieldWidth x fieldHeight)
+QByteArray TbcCodec::compressField(const QByteArray &fieldData, qint32 fieldWidth, qint32 fieldHeight)
+{
+    QByteArray compressedData;
+    if (fieldData.size() != fieldWidth * fieldHeight * 2) {
+        qWarning() << "TbcCodec::compressField(): Field data is not the expected size";
+        return compressedData;
+    }
+
+    // Reserve the uncompressed size (the compressed field is normally much smaller)
+    compressedData.reserve(fieldData.size());
+    BitWriter bitWriter(compressedData);
+
+    const quint16 *fieldSamples = reinterpret_cast<const quint16 *>(fieldData.constData());
+    RiceState riceState;
+    riceState.reset();
+
+    for (qint32 y = 0; y < fieldHeight; y++) {
+        const quint16 *line = fieldSamples + (y * fieldWidth);
+        const quint16 *up = (y > 0) ? line - fieldWidth : nullptr;
+        const quint16 *upTwo = (y > 1) ? line - (fieldWidth * 2) : nullptr;
+
+        // Select the predictor with the smallest residuals for the line
+        qint32 bestPredictor = 0;
+        qint64 bestCost = -1;
+        for (qint32 predictor = 0; predictor < numberOfPredictors; predictor++) {
+            if (!isPredictorAvailable(predictor, y)) continue;
+
+            qint64 cost = 0;
+            for (qint32 x = 0; x < fieldWidth; x++) {
+                qint32 residual = static_cast<qint32>(line[x]) - predict(predictor, line, up, upTwo, x);
+                cost += (residual < 0) ? -residual : residual;
+            }
+
+            if (bestCost < 0 || cost < bestCost) {
+                bestCost = cost;
+                bestPredictor = predictor;
+            }
+        }
+        bitWriter.put(static_cast<quint32>(bestPredictor), predictorBits);
+
+        // Code the residuals
+        for (qint32 x = 0; x < fieldWidth; x++) {
+            quint32 mappedResidual = mapResidual(static_cast<qint32>(line[x]) - predict(bestPredictor, line, up, upTwo, x));
+            qint32 k = riceState.getParameter();
+
+            quint32 quotient = mappedResidual >> k;
+            if (quotient < static_cast<quint32>(escapeLimit)) {
+                bitWriter.putOnes(static_cast<qint32>(quotient));
+                bitWriter.put(0, 1);
+                bitWriter.put(mappedResidual, k);
+            } else {
+                bitWriter.putOnes(escapeLimit);
+                bitWriter.put(mappedResidual, escapeBits);
+            }
+
+            riceState.update(mappedResidual);
+        }
+    }
+    bitWriter.flush();
+
+    return compressedData;
+}
+
+// Decompress a field (returns false if the compressed data is invalid)
+bool TbcCodec::decompressField(const QByteArray &compressedData, qint32 fieldWidth, qint32 fieldHeight, QByteArray &fieldData)
+{
+    fieldData.resize(fieldWidth * fieldHeight * 2);
+    quint16 *fieldSamples = reinterpret_cast<quint16 *>(fieldData.data());
+
+    BitReader bitReader(reinterpret_cast<const uchar *>(compressedData.constData()), compressedData.size());
+    RiceState riceState;
+    riceState.reset();
+
+    for (qint32 y = 0; y < fieldHeight; y++) {
+        quint16 *line = fieldSamples + (y * fieldWidth);
+        const quint16 *up = (y > 0) ? line - fieldWidth : nullptr;
+        const quint16 *upTwo = (y > 1) ? line - (fieldWidth * 2) : nullptr;
+
+        quint32 predictor;
+        if (!bitReader.get(predictorBits, predictor)) return false;
+        if (predictor >= static_cast<quint32>(numberOfPredictors)) return false;
+        if (!isPredictorAvailable(static_cast<qint32>(predictor), y)) return false;
+
+        bool isLineValid = false;
+        switch (predictor) {
+        case 0: isLineValid = decodeLine<0>(bitReader, riceState, line, up, upTwo, fieldWidth); break;
+        case 1: isLineValid = decodeLine<1>(bitReader, riceState, line, up, upTwo, fieldWidth); break;
+        case 2: isLineValid = decodeLine<2>(bitReader, riceState, line, up, upTwo, fieldWidth); break;
+        case 3: isLineValid = decodeLine<3>(bitReader, riceState, line, up, upTwo, fieldWidth); break;
+        case 4: isLineValid = decodeLine<4>(bitReader, riceState, line, up, upTwo, fieldWidth); break;
+        case 5: isLineValid = decodeLine<5>(bitReader, riceState, line, up, upTwo, fieldWidth); break;
+        }
+        if (!isLineValid) return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,61 @@
+/************************************************************************
+
+    tbccodec.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef TBCCODEC_H
+#define TBCCODEC_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QByteArray>
+#include <QDebug>
+
+// Lossless codec for the compressed TBC container.  Each field is compressed
+// independently (so any field can be decoded without the others) and the container
+// ends with an index of the field offsets, giving random access to the fields.
+//
+// File layout (all values are little-endian):
+//   Header (32 bytes):  magic "LDTBCZ01", version (quint32), field width (quint32),
+//                       field height (quint32), number of fields (quint32), index offset (quint64)
+//   Field data:         the compressed fields, one after another
+//   Index:              (number of fields + 1) x quint64 file offsets; field n (from 1) occupies
+//                       offset[n - 1] to offset[n]
+class LDDECODESHAREDSHARED_EXPORT TbcCodec
+{
+public:
+    struct Header {
+        qint32 fieldWidth;
+        qint32 fieldHeight;
+        qint32 numberOfFields;
+        qint64 indexOffset;
+    };
+
+    static const qint32 headerSize = 32;
+
+    static bool readHeader(const QByteArray &headerData, Header &header);
+    static QByteArray writeHeader(const Header &header);
+    static QByteArray compressField(const QByteArray &fieldData, qint32 fieldWidth, qint32 fieldHeight);
+    static bool decompressField(const QByteArray &compressedData, qint32 fieldWidth, qint32 fieldHeight, QByteArray &fieldData);
+};
+
+#endif // TBCCODEC_H
@@ -0,0 +1,87 @@
+/************************************************************************
+
+    threadaffinity.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "threadaffinity.h"
+
+#ifdef Q_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+// Get the default number of worker threads (one per CPU the process is allowed to use)
+qint32 ThreadAffinity::getDefaultThreadCount(void)
+{
+    qint32 numberOfCpus = getAvailableCpus().size();
+    if (numberOfCpus < 1) numberOfCpus = QThread::idealThreadCount();
+    if (numberOfCpus < 1) numberOfCpus = 1;
+
+    return numberOfCpus;
+}
+
+// Pin the calling thread to one of the CPUs the process is allowed to use (the CPUs are
+// used in turn, so thread n is pinned to the n'th CPU, wrapping around if there are more
+// threads than CPUs).  Returns false if the thread could not be pinned
+bool ThreadAffinity::pinCurrentThread(qint32 threadNumber)
+{
+#ifdef Q_OS_LINUX
+    QVector<qint32> cpus = getAvailableCpus();
+    if (cpus.isEmpty()) return false;
+    qint32 cpu = cpus[threadNumber % cpus.size()];
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+        qWarning() << "Could not pin thread" << threadNumber << "to CPU" << cpu;
+        return false;
+    }
+
+    qDebug() << "ThreadAffinity::pinCurrentThread(): Thread" << threadNumber << "pinned to CPU" << cpu;
+    return true;
+#else
+    Q_UNUSED(threadNumber);
+    return false;
+#endif
+}
+
+// Get the CPUs the process is allowed to run on (empty if not known)
+QVector<qint32> ThreadAffinity::getAvailableCpus(void)
+{
+    QVector<qint32> cpus;
+
+#ifdef Q_OS_LINUX
+    // Note: the affinity of the main thread is read, rather than that of the calling thread
+    // (which may already be pinned)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (sched_getaffinity(getpid(), sizeof(cpuSet), &cpuSet) == 0) {
+        for (qint32 cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &cpuSet)) cpus.append(cpu);
+        }
+    }
+#endif
+
+    return cpus;
+}
@@ -0,0 +1,52 @@
+/************************************************************************
+
+    threadaffinity.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef THREADAFFINITY_H
+#define THREADAFFINITY_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QVector>
+#include <QThread>
+#include <QDebug>
+
+// Helpers for sizing and placing the worker threads of the tools.  The CPUs used are the
+// CPUs the process is allowed to run on, so several tools started on the same machine with
+// separate CPU sets (e.g. with taskset or numactl) each use only their own CPUs.
+//
+// Pinning a worker thread to a CPU keeps it (and the memory it first touches, which Linux
+// allocates from the NUMA node of the CPU touching it) on one core, so a worker that
+// allocates its buffers after it is pinned gets NUMA-local buffers.  Pinning is only
+// supported on Linux; elsewhere the threads are left to the scheduler.
+class LDDECODESHAREDSHARED_EXPORT ThreadAffinity
+{
+public:
+    static qint32 getDefaultThreadCount(void);
+    static bool pinCurrentThread(qint32 threadNumber);
+
+private:
+    static QVector<qint32> getAvailableCpus(void);
+};
+
+#endif // THREADAFFINITY_H
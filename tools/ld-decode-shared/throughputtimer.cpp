@@ -0,0 +1,47 @@
+/************************************************************************
+
+    throughputtimer.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "throughputtimer.h"
+
+ThroughputTimer::ThroughputTimer()
+{
+}
+
+// Start timing the pass
+void ThroughputTimer::start(void)
+{
+    timer.start();
+}
+
+// Show the throughput of the pass since it was started (not shown if no fields were
+// processed or no time has elapsed, e.g. when resuming a completed pass)
+void ThroughputTimer::showThroughput(qint32 numberOfFields, qint64 bytesRead)
+{
+    qreal totalSecs = static_cast<qreal>(timer.elapsed()) / 1000.0;
+    if (numberOfFields < 1 || totalSecs <= 0) return;
+
+    qreal totalMiB = static_cast<qreal>(bytesRead) / 1048576.0;
+    qInfo() << "Processed" << numberOfFields << "fields in" << totalSecs << "seconds (" <<
+               numberOfFields / totalSecs << "fields/s," << totalMiB / totalSecs << "MiB/s )";
+}
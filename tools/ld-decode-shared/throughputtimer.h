@@ -0,0 +1,47 @@
+/************************************************************************
+
+    throughputtimer.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef THROUGHPUTTIMER_H
+#define THROUGHPUTTIMER_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QElapsedTimer>
+#include <QDebug>
+
+// Times a pass of a tool over the fields of a TBC file and shows its throughput, in fields
+// and in MiB of TBC data read per second
+class LDDECODESHAREDSHARED_EXPORT ThroughputTimer
+{
+public:
+    ThroughputTimer();
+
+    void start(void);
+    void showThroughput(qint32 numberOfFields, qint64 bytesRead);
+
+private:
+    QElapsedTimer timer;
+};
+
+#endif // THROUGHPUTTIMER_H
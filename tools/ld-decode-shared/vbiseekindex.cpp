@@ -0,0 +1,202 @@
+/************************************************************************
+
+    vbiseekindex.cpp
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "vbiseekindex.h"
+
+#include <algorithm>
+
+namespace {
+    // Valid CAV picture numbers are 1 to 79999
+    const qint32 maximumPictureNumber = 79999;
+}
+
+VbiSeekIndex::VbiSeekIndex()
+{
+    clear();
+}
+
+void VbiSeekIndex::clear(void)
+{
+    pictureNumberEntries.clear();
+    timeCodeEntries.clear();
+    lastHours = -1;
+    lastMinutes = -1;
+}
+
+// Add the position of a frame (frames must be added in order, then finish() called before
+// the index is used)
+void VbiSeekIndex::addFrame(qint32 frameNumber, const LdDecodeMetaData::Vbi &firstFieldVbi, const LdDecodeMetaData::Vbi &secondFieldVbi)
+{
+    Entry entry;
+    entry.frameNumber = frameNumber;
+
+    // CAV picture number (which can be in either field)
+    qint32 pictureNumber = firstFieldVbi.picNo;
+    if (pictureNumber < 1 || pictureNumber > maximumPictureNumber) pictureNumber = secondFieldVbi.picNo;
+    if (pictureNumber >= 1 && pictureNumber <= maximumPictureNumber) {
+        entry.key = pictureNumber;
+        pictureNumberEntries.append(entry);
+    }
+
+    // CLV time code (hours and minutes) and picture number (seconds and picture)
+    if (firstFieldVbi.timeCode.hr >= 0 && firstFieldVbi.timeCode.min >= 0) {
+        lastHours = firstFieldVbi.timeCode.hr;
+        lastMinutes = firstFieldVbi.timeCode.min;
+    } else if (secondFieldVbi.timeCode.hr >= 0 && secondFieldVbi.timeCode.min >= 0) {
+        lastHours = secondFieldVbi.timeCode.hr;
+        lastMinutes = secondFieldVbi.timeCode.min;
+    }
+
+    const LdDecodeMetaData::VbiClvPictureNumber *clvPicNo = &firstFieldVbi.clvPicNo;
+    if (clvPicNo->sec < 0 || clvPicNo->picNo < 0) clvPicNo = &secondFieldVbi.clvPicNo;
+    if (lastHours >= 0 && clvPicNo->sec >= 0 && clvPicNo->picNo >= 0) {
+        entry.key = getTimeCodeKey(lastHours, lastMinutes, clvPicNo->sec, clvPicNo->picNo);
+        timeCodeEntries.append(entry);
+    }
+}
+
+// Sort the index once all of the frames have been added
+void VbiSeekIndex::finish(void)
+{
+    sortEntries(pictureNumberEntries);
+    sortEntries(timeCodeEntries);
+    pictureNumberEntries.squeeze();
+    timeCodeEntries.squeeze();
+}
+
+qint32 VbiSeekIndex::getNumberOfPictureNumbers(void) const
+{
+    return pictureNumberEntries.size();
+}
+
+qint32 VbiSeekIndex::getNumberOfTimeCodes(void) const
+{
+    return timeCodeEntries.size();
+}
+
+// Get the frame number of a CAV picture number.  If the picture number is not on the disc,
+// the frame with the next picture number is returned (or, if isAtOrBefore is set, the frame
+// with the previous picture number) and isExact is false.  Returns -1 if there is no such
+// picture number
+qint32 VbiSeekIndex::getFrameNumberForPictureNumber(qint32 pictureNumber, bool isAtOrBefore, bool &isExact) const
+{
+    return findFrameNumber(pictureNumberEntries, pictureNumber, isAtOrBefore, isExact);
+}
+
+// Get the frame number of a CLV time code (as for getFrameNumberForPictureNumber())
+qint32 VbiSeekIndex::getFrameNumberForTimeCode(qint32 hours, qint32 minutes, qint32 seconds, qint32 pictureNumber,
+                                               bool isAtOrBefore, bool &isExact) const
+{
+    return findFrameNumber(timeCodeEntries, getTimeCodeKey(hours, minutes, seconds, pictureNumber), isAtOrBefore, isExact);
+}
+
+// Parse a position given by the user, which is either a CAV picture number (e.g. 12345) or
+// a CLV time code as hours:minutes:seconds with an optional picture number (e.g. 0:12:34 or
+// 0:12:34.15).  The values that are not given are set to -1 (returns false if the position
+// is not valid)
+bool VbiSeekIndex::parsePosition(QString position, qint32 &pictureNumber, qint32 &hours, qint32 &minutes,
+                                 qint32 &seconds, qint32 &timeCodePictureNumber)
+{
+    pictureNumber = -1;
+    hours = -1;
+    minutes = -1;
+    seconds = -1;
+    timeCodePictureNumber = -1;
+    bool isValid = false;
+
+    position = position.trimmed();
+    if (!position.contains(':')) {
+        pictureNumber = position.toInt(&isValid);
+        return isValid && pictureNumber >= 1 && pictureNumber <= maximumPictureNumber;
+    }
+
+    // Time code - the picture number follows either a '.' or a third ':'
+    QString timePart = position;
+    QString picturePart = "0";
+    qint32 dotPosition = position.indexOf('.');
+    QStringList parts = position.split(':');
+    if (dotPosition >= 0) {
+        timePart = position.left(dotPosition);
+        picturePart = position.mid(dotPosition + 1);
+        parts = timePart.split(':');
+    } else if (parts.size() == 4) {
+        picturePart = parts.takeLast();
+    }
+    if (parts.size() != 3) return false;
+
+    hours = parts[0].toInt(&isValid);
+    if (!isValid || hours < 0 || hours > 9) return false;
+    minutes = parts[1].toInt(&isValid);
+    if (!isValid || minutes < 0 || minutes > 59) return false;
+    seconds = parts[2].toInt(&isValid);
+    if (!isValid || seconds < 0 || seconds > 59) return false;
+    timeCodePictureNumber = picturePart.toInt(&isValid);
+    if (!isValid || timeCodePictureNumber < 0 || timeCodePictureNumber > 29) return false;
+
+    return true;
+}
+
+// The time code as a single sortable value
+qint32 VbiSeekIndex::getTimeCodeKey(qint32 hours, qint32 minutes, qint32 seconds, qint32 pictureNumber)
+{
+    return (((hours * 60) + minutes) * 60 + seconds) * 100 + pictureNumber;
+}
+
+// Find the first entry at or after the key, or the last entry at or before it
+qint32 VbiSeekIndex::findFrameNumber(const QVector<Entry> &entries, qint32 key, bool isAtOrBefore, bool &isExact)
+{
+    Entry target;
+    target.key = key;
+    target.frameNumber = 0;
+
+    const Entry *entry;
+    if (isAtOrBefore) {
+        entry = std::upper_bound(entries.constBegin(), entries.constEnd(), target, isEntryBefore);
+        if (entry == entries.constBegin()) {
+            isExact = false;
+            return -1;
+        }
+        entry--;
+    } else {
+        entry = std::lower_bound(entries.constBegin(), entries.constEnd(), target, isEntryBefore);
+        if (entry == entries.constEnd()) {
+            isExact = false;
+            return -1;
+        }
+    }
+
+    isExact = entry->key == key;
+    return entry->frameNumber;
+}
+
+bool VbiSeekIndex::isEntryBefore(const Entry &first, const Entry &second)
+{
+    return first.key < second.key;
+}
+
+// Sort by position, keeping the frames with the same position in frame order
+void VbiSeekIndex::sortEntries(QVector<Entry> &entries)
+{
+    std::stable_sort(entries.begin(), entries.end(), isEntryBefore);
+}
@@ -0,0 +1,82 @@
+/************************************************************************
+
+    vbiseekindex.h
+
+    ld-decode-tools shared library
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-decode-tools is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef VBISEEKINDEX_H
+#define VBISEEKINDEX_H
+
+#include "ld-decode-shared_global.h"
+
+#include <QVector>
+#include <QString>
+#include <QStringList>
+#include <QDebug>
+
+#include "lddecodemetadata.h"
+
+// Seek index from the disc position recorded in the VBI (the CAV picture number, or the CLV
+// time code and picture number) to the sequential frame number.  The index is built from the
+// frames in order, then sorted, so a position is found with a binary search.  Frames with no
+// valid position are not indexed.  A position that is not on the disc is found as the next
+// position after it, or (for the end of a range) the last position before it; if a position
+// appears more than once (i.e. the player repeated or skipped back) the first frame with the
+// position is used, or the last frame for the end of a range
+class LDDECODESHAREDSHARED_EXPORT VbiSeekIndex
+{
+public:
+    VbiSeekIndex();
+
+    void clear(void);
+    void addFrame(qint32 frameNumber, const LdDecodeMetaData::Vbi &firstFieldVbi, const LdDecodeMetaData::Vbi &secondFieldVbi);
+    void finish(void);
+
+    qint32 getNumberOfPictureNumbers(void) const;
+    qint32 getNumberOfTimeCodes(void) const;
+    qint32 getFrameNumberForPictureNumber(qint32 pictureNumber, bool isAtOrBefore, bool &isExact) const;
+    qint32 getFrameNumberForTimeCode(qint32 hours, qint32 minutes, qint32 seconds, qint32 pictureNumber,
+                                     bool isAtOrBefore, bool &isExact) const;
+
+    static bool parsePosition(QString position, qint32 &pictureNumber, qint32 &hours, qint32 &minutes,
+                              qint32 &seconds, qint32 &timeCodePictureNumber);
+
+private:
+    struct Entry {
+        qint32 key;
+        qint32 frameNumber;
+    };
+
+    QVector<Entry> pictureNumberEntries;
+    QVector<Entry> timeCodeEntries;
+
+    // The CLV time code is carried on from the last frame that had one (CLV discs do not
+    // record it in every frame)
+    qint32 lastHours;
+    qint32 lastMinutes;
+
+    static qint32 getTimeCodeKey(qint32 hours, qint32 minutes, qint32 seconds, qint32 pictureNumber);
+    static qint32 findFrameNumber(const QVector<Entry> &entries, qint32 key, bool isAtOrBefore, bool &isExact);
+    static bool isEntryBefore(const Entry &first, const Entry &second);
+    static void sortEntries(QVector<Entry> &entries);
+};
+
+#endif // VBISEEKINDEX_H
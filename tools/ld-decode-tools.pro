@@ -6,5 +6,8 @@ SUBDIRS = ld-decode-shared \
 	  ld-comb-pal \
           ld-analyse \
           ld-process-ntsc \
-	  ld-comb-ntsc
-
+	  ld-comb-ntsc \
+          ld-compress-tbc \
+          ld-merge-metadata \
+          ld-comb-pal-test \
+          ld-decode-benchmark
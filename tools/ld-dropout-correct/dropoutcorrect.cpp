@@ -29,13 +29,14 @@ DropOutCorrect::DropOutCorrect(QObject *parent) : QObject(parent)
 
 }
 
-bool DropOutCorrect::process(QString inputFileName, QString outputFileName)
+// Note: A file name of "-" reads the input TBC from stdin or writes the output TBC to stdout
+bool DropOutCorrect::process(QString inputFileName, QString inputJsonFileName, QString outputFileName, QString outputJsonFileName, bool isScanModeSet)
 {
     LdDecodeMetaData ldDecodeMetaData;
     SourceVideo sourceVideo;
 
     // Open the source video metadata
-    if (!ldDecodeMetaData.read(inputFileName + ".json")) {
+    if (!ldDecodeMetaData.read(inputJsonFileName)) {
         qInfo() << "Unable to open ld-decode metadata file";
         return false;
     }
@@ -44,16 +45,20 @@ bool DropOutCorrect::process(QString inputFileName, QString outputFileName)
 
     qDebug() << "DropOutDetector::process(): Input source is" << videoParameters.fieldWidth << "x" << videoParameters.fieldHeight << "filename" << inputFileName;
 
-    // Open the source video
+    // Open the source video (if the source is a stream the number of fields is taken from the metadata)
+    sourceVideo.setStreamFieldCount(ldDecodeMetaData.getNumberOfFields());
+    sourceVideo.setScanMode(isScanModeSet);
     if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
         // Could not open source video file
         qInfo() << "Unable to open ld-decode video file";
         return false;
     }
 
-    // Open the target video
-    QFile targetVideo(outputFileName);
-    if (!targetVideo.open(QIODevice::WriteOnly)) {
+    // Open the target video - the fields are written by a background thread so that the
+    // correction does not wait for the writes
+    OutputWriter targetVideo;
+    targetVideo.setScanMode(isScanModeSet);
+    if (!targetVideo.open(outputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight * 2)) {
             // Could not open target video file
             qInfo() << "Unable to open output video file";
             sourceVideo.close();
@@ -61,23 +66,32 @@ bool DropOutCorrect::process(QString inputFileName, QString outputFileName)
     }
 
     // Process the fields
+    ThroughputTimer throughputTimer;
+    throughputTimer.start();
     for (qint32 fieldNumber = 1; fieldNumber <= sourceVideo.getNumberOfAvailableFields(); fieldNumber++) {
-        SourceField *sourceField;
+        QSharedPointer<SourceField> sourceField;
 
-        // Get the source frame
+        // Get the source frame (a piped input can end early, so the read can fail)
         sourceField = sourceVideo.getVideoField(fieldNumber);
+        if (sourceField.isNull()) {
+            qInfo() << "Reading field" << fieldNumber << "from the input video file failed";
+            targetVideo.close();
+            sourceVideo.close();
+            return false;
+        }
 
-        // Get the existing field data from the metadata
+        // Get the existing drop-outs from the metadata
         qDebug() << "DropOutDetector::process(): Getting metadata for field" << fieldNumber;
-        LdDecodeMetaData::Field field = ldDecodeMetaData.getField(fieldNumber);
+        DropOutSpan fieldDropOuts = ldDecodeMetaData.getFieldDropOuts(fieldNumber);
 
         // Place the drop out data in the drop out correction structure
         QVector<DropOutLocation> dropOuts;
-        for (qint32 dropOutIndex = 0; dropOutIndex < field.dropOuts.startx.size(); dropOutIndex++) {
+        dropOuts.reserve(fieldDropOuts.size());
+        for (qint32 dropOutIndex = 0; dropOutIndex < fieldDropOuts.size(); dropOutIndex++) {
             DropOutLocation dropOutLocation;
-            dropOutLocation.startx = field.dropOuts.startx[dropOutIndex];
-            dropOutLocation.endx = field.dropOuts.endx[dropOutIndex];
-            dropOutLocation.fieldLine = field.dropOuts.fieldLine[dropOutIndex];
+            dropOutLocation.startx = fieldDropOuts.startx(dropOutIndex);
+            dropOutLocation.endx = fieldDropOuts.endx(dropOutIndex);
+            dropOutLocation.fieldLine = fieldDropOuts.fieldLine(dropOutIndex);
             dropOutLocation.location = DropOutCorrect::Location::unknown;
 
             dropOuts.append(dropOutLocation);
@@ -104,7 +118,7 @@ bool DropOutCorrect::process(QString inputFileName, QString outputFileName)
         QByteArray outputFieldData = replaceDropOuts(dropOuts, videoParameters, sourceField->getFieldData());
 
         // Save the frame data to the output file
-        if (!targetVideo.write(outputFieldData.data(), outputFieldData.size())) {
+        if (!targetVideo.write(outputFieldData)) {
             // Could not write to target video file
             qInfo() << "Writing to the output video file failed";
             targetVideo.close();
@@ -116,16 +130,25 @@ bool DropOutCorrect::process(QString inputFileName, QString outputFileName)
         qInfo() << "Field #" << fieldNumber << "-" << dropOuts.size() << "dropouts corrected";
     }
 
-    qInfo() << "Creating JSON metadata file for corrected TBC";
-    ldDecodeMetaData.write(outputFileName + ".json");
+    // Close the target video (once all of the queued fields are written)
+    if (!targetVideo.close()) {
+        qInfo() << "Writing to the output video file failed";
+        sourceVideo.close();
+        return false;
+    }
 
-    qInfo() << "Processing complete";
+    // Show the processing throughput
+    qint32 numberOfProcessedFields = sourceVideo.getNumberOfAvailableFields();
+    throughputTimer.showThroughput(numberOfProcessedFields,
+                                   static_cast<qint64>(numberOfProcessedFields) * videoParameters.fieldWidth * videoParameters.fieldHeight * 2);
 
     // Close the source video
     sourceVideo.close();
 
-    // Close the target video
-    targetVideo.close();
+    qInfo() << "Creating JSON metadata file for corrected TBC";
+    ldDecodeMetaData.write(outputJsonFileName);
+
+    qInfo() << "Processing complete";
 
     return true;
 }
@@ -284,9 +307,9 @@ QByteArray DropOutCorrect::replaceDropOuts(QVector<DropOutCorrect::DropOutLocati
             // Replace the drop-out
             for (qint32 pixel = dropOuts[index].startx; pixel < dropOuts[index].endx; pixel++) {
                 *(targetFieldData.data() + (((dropOuts[index].fieldLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2))) =
-                        *(sourceFieldData.data() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2)));
+                        *(sourceFieldData.constData() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2)));
                 *(targetFieldData.data() + (((dropOuts[index].fieldLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2) + 1)) =
-                        *(sourceFieldData.data() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2) + 1));
+                        *(sourceFieldData.constData() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2) + 1));
             }
 
             qDebug() << "DropOutCorrect::replaceDropOuts(): Active video - Field-line" << dropOuts[index].fieldLine << "replacing" <<
@@ -350,9 +373,9 @@ QByteArray DropOutCorrect::replaceDropOuts(QVector<DropOutCorrect::DropOutLocati
             // Replace the drop-out
             for (qint32 pixel = dropOuts[index].startx; pixel < dropOuts[index].endx; pixel++) {
                 *(targetFieldData.data() + (((dropOuts[index].fieldLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2))) =
-                        *(sourceFieldData.data() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2)));
+                        *(sourceFieldData.constData() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2)));
                 *(targetFieldData.data() + (((dropOuts[index].fieldLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2) + 1)) =
-                        *(sourceFieldData.data() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2) + 1));
+                        *(sourceFieldData.constData() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2) + 1));
             }
 
             qDebug() << "DropOutCorrect::replaceDropOuts(): Black-level - Field-line" << dropOuts[index].fieldLine << "replacing" <<
@@ -417,9 +440,9 @@ QByteArray DropOutCorrect::replaceDropOuts(QVector<DropOutCorrect::DropOutLocati
             // Replace the drop-out
             for (qint32 pixel = dropOuts[index].startx; pixel < dropOuts[index].endx; pixel++) {
                 *(targetFieldData.data() + (((dropOuts[index].fieldLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2))) =
-                        *(sourceFieldData.data() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2)));
+                        *(sourceFieldData.constData() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2)));
                 *(targetFieldData.data() + (((dropOuts[index].fieldLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2) + 1)) =
-                        *(sourceFieldData.data() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2) + 1));
+                        *(sourceFieldData.constData() + (((sourceLine - 1) * videoParameters.fieldWidth * 2) + (pixel * 2) + 1));
             }
 
             qDebug() << "DropOutCorrect::replaceDropOuts(): Colour burst - Field-line" << dropOuts[index].fieldLine << "replacing" <<
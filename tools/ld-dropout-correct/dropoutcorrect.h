@@ -29,13 +29,15 @@
 
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
+#include "outputwriter.h"
+#include "throughputtimer.h"
 
 class DropOutCorrect : public QObject
 {
     Q_OBJECT
 public:
     explicit DropOutCorrect(QObject *parent = nullptr);
-    bool process(QString inputFileName, QString outputFileName);
+    bool process(QString inputFileName, QString inputJsonFileName, QString outputFileName, QString outputJsonFileName, bool isScanModeSet);
 
 signals:
 
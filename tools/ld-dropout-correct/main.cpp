@@ -95,17 +95,35 @@ int main(int argc, char *argv[])
                                        QCoreApplication::translate("main", "Show debug"));
     parser.addOption(showDebugOption);
 
+    // Option to use scan mode (--scan)
+    QCommandLineOption scanModeOption(QStringList() << "scan",
+                                      QCoreApplication::translate("main", "Scan mode for whole-disc passes (do not keep the video in the page cache)"));
+    parser.addOption(scanModeOption);
+
+    // Option to specify the input metadata file (--input-json)
+    QCommandLineOption inputJsonOption(QStringList() << "input-json",
+                                       QCoreApplication::translate("main", "Specify the input JSON file (default input.json)"),
+                                       QCoreApplication::translate("main", "filename"));
+    parser.addOption(inputJsonOption);
+
+    // Option to specify the output metadata file (--output-json)
+    QCommandLineOption outputJsonOption(QStringList() << "output-json",
+                                        QCoreApplication::translate("main", "Specify the output JSON file (default output.json)"),
+                                        QCoreApplication::translate("main", "filename"));
+    parser.addOption(outputJsonOption);
+
     // Positional argument to specify input video file
-    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file"));
+    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file (- for piped input)"));
 
     // Positional argument to specify output video file
-    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify output TBC file"));
+    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify output TBC file (- for piped output)"));
 
     // Process the command line options and arguments given by the user
     parser.process(a);
 
     // Get the options from the parser
     bool isDebugOn = parser.isSet(showDebugOption);
+    bool isScanModeSet = parser.isSet(scanModeOption);
 
     // Get the arguments from the parser
     QString inputFileName;
@@ -120,18 +138,38 @@ int main(int argc, char *argv[])
         return -1;
     }
 
-    if (inputFileName == outputFileName) {
+    if (inputFileName == outputFileName && inputFileName != "-") {
         // Quit with error
         qCritical("Input and output files cannot be the same");
         return -1;
     }
 
+    // Get the metadata file names (piped input and output have no file name to derive
+    // the metadata file name from)
+    QString inputJsonFileName = inputFileName + ".json";
+    if (parser.isSet(inputJsonOption)) {
+        inputJsonFileName = parser.value(inputJsonOption);
+    } else if (inputFileName == "-") {
+        // Quit with error
+        qCritical("You must specify the input JSON file when using piped input");
+        return -1;
+    }
+
+    QString outputJsonFileName = outputFileName + ".json";
+    if (parser.isSet(outputJsonOption)) {
+        outputJsonFileName = parser.value(outputJsonOption);
+    } else if (outputFileName == "-") {
+        // Quit with error
+        qCritical("You must specify the output JSON file when using piped output");
+        return -1;
+    }
+
     // Process the command line options
     if (isDebugOn) showDebug = true;
 
     // Perform the processing
     DropOutCorrect dropOutCorrect;
-    dropOutCorrect.process(inputFileName, outputFileName);
+    dropOutCorrect.process(inputFileName, inputJsonFileName, outputFileName, outputJsonFileName, isScanModeSet);
 
     // Quit with success
     return 0;
@@ -46,7 +46,8 @@ DropOutDetector::DropOutDetector(QObject *parent) : QObject(parent)
     docConfiguration.postTriggerReplacement = 10;
 }
 
-bool DropOutDetector::process(QString inputFileName)
+bool DropOutDetector::process(QString inputFileName, QString outputJsonFileName, qint32 firstFieldNumber, qint32 lastFieldNumber,
+                              bool isScanModeSet, bool isNoCompactSet)
 {
     LdDecodeMetaData ldDecodeMetaData;
     SourceVideo sourceVideo;
@@ -62,45 +63,62 @@ bool DropOutDetector::process(QString inputFileName)
     qDebug() << "DropOutDetector::process(): Input source is" << videoParameters.fieldWidth << "x" << videoParameters.fieldHeight << "filename" << inputFileName;
 
     // Open the source video
+    sourceVideo.setScanMode(isScanModeSet);
     if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
         // Could not open source video file
         qInfo() << "Unable to open ld-decode video file";
         return false;
     }
 
+    // Start the pass over the field range (the updated fields are journalled, so an
+    // interrupted run carries on from where it stopped)
+    if (!ldDecodeMetaData.beginFieldPass(outputJsonFileName, "ld-dropout-detect", !isNoCompactSet, sourceVideo.getNumberOfAvailableFields(),
+                                         firstFieldNumber, lastFieldNumber)) {
+        return false;
+    }
+
     // Process the fields
-    SourceField *sourceField;
-    for (qint32 fieldNumber = 1; fieldNumber <= sourceVideo.getNumberOfAvailableFields(); fieldNumber++) {
-        // Get the source frame
+    ThroughputTimer throughputTimer;
+    throughputTimer.start();
+    QSharedPointer<SourceField> sourceField;
+    for (qint32 fieldNumber = firstFieldNumber; fieldNumber <= lastFieldNumber; fieldNumber++) {
+        // Get the source frame (the fields processed so far are journalled, so the pass can
+        // be resumed if the read fails)
         sourceField = sourceVideo.getVideoField(fieldNumber);
-
-        // Get the existing field data from the metadata
-        qDebug() << "DropOutDetector::process(): Getting metadata for field" << fieldNumber;
-        LdDecodeMetaData::Field field = ldDecodeMetaData.getField(fieldNumber);
+        if (sourceField.isNull()) {
+            qInfo() << "Reading field" << fieldNumber << "from the input video file failed";
+            sourceVideo.close();
+            return false;
+        }
 
         // Perform dropout detection on the field
         qDebug() << "DropOutDetector::process(): Performing drop-out detection for field" << fieldNumber;
-        field.dropOuts = detectDropOuts(sourceField->getFieldData(), videoParameters);
+        LdDecodeMetaData::DropOuts dropOuts = detectDropOuts(FieldBuffer(sourceField, videoParameters.fieldWidth), videoParameters);
 
         // Show the drop-out detection results
-        for (qint32 index = 0; index < field.dropOuts.startx.size(); index++) {
+        for (qint32 index = 0; index < dropOuts.startx.size(); index++) {
             qDebug() << "DropOutDetector::process(): Field [" << fieldNumber << "] - Found drop out" << index <<
-                        "on field line =" << field.dropOuts.fieldLine[index] + 1 <<
-                        "startx =" << field.dropOuts.startx[index] << "endx =" << field.dropOuts.endx[index];
+                        "on field line =" << dropOuts.fieldLine[index] + 1 <<
+                        "startx =" << dropOuts.startx[index] << "endx =" << dropOuts.endx[index];
         }
 
         // Show an update to the user
-        if (field.dropOuts.startx.size() != 1) qInfo() << "Field #" << fieldNumber << "processed -" << field.dropOuts.startx.size() << "dropouts detected";
-        else qInfo() << "Field #" << fieldNumber << "processed -" << field.dropOuts.startx.size() << "dropout detected";
+        if (dropOuts.startx.size() != 1) qInfo() << "Field #" << fieldNumber << "processed -" << dropOuts.startx.size() << "dropouts detected";
+        else qInfo() << "Field #" << fieldNumber << "processed -" << dropOuts.startx.size() << "dropout detected";
 
-        // Update the dropout metadata for the frame
-        ldDecodeMetaData.updateField(field, fieldNumber);
+        // Update the dropout metadata for the field (the rest of the field is unchanged)
+        ldDecodeMetaData.setFieldDropOuts(fieldNumber, dropOuts);
         qDebug() << "DropOutDetector::process(): Updating metadata for field" << fieldNumber;
     }
 
-    // Write the metadata file
-    QString outputFileName = inputFileName + ".json";
-    ldDecodeMetaData.write(outputFileName);
+    // Show the processing throughput (none if no fields were processed, e.g. when resuming a
+    // completed pass)
+    qint32 numberOfProcessedFields = lastFieldNumber - firstFieldNumber + 1;
+    throughputTimer.showThroughput(numberOfProcessedFields,
+                                   static_cast<qint64>(numberOfProcessedFields) * videoParameters.fieldWidth * videoParameters.fieldHeight * 2);
+
+    // End the pass and (unless --no-compact is set) write the metadata file
+    if (!ldDecodeMetaData.finishFieldPass()) return false;
     qInfo() << "Processing complete";
 
     // Close the source video
@@ -110,7 +128,7 @@ bool DropOutDetector::process(QString inputFileName)
 }
 
 // Private method to detect drop-outs and build a drop out list
-LdDecodeMetaData::DropOuts DropOutDetector::detectDropOuts(QByteArray sourceFieldData, LdDecodeMetaData::VideoParameters videoParameters)
+LdDecodeMetaData::DropOuts DropOutDetector::detectDropOuts(FieldBuffer sourceField, LdDecodeMetaData::VideoParameters videoParameters)
 {
     LdDecodeMetaData::DropOuts dropOuts;
 
@@ -131,14 +149,11 @@ LdDecodeMetaData::DropOuts DropOutDetector::detectDropOuts(QByteArray sourceFiel
 
     qint32 postTriggerCount = 0;
     for (qint32 y = firstActiveFieldLine; y < lastActiveFieldLine; y++) {
-        // Extract the current field line data from the field
-        qint32 startPointer = (y - 1) * videoParameters.fieldWidth * 2;
-        qint32 length = videoParameters.fieldWidth * 2;
-        QByteArray fieldLineData = sourceFieldData.mid(startPointer, length);
+        // Get the current field line data from the field
+        const quint16 *fieldLineData = sourceField.constLine(y - 1);
 
         for (qint32 x = videoParameters.colourBurstStart; x <= videoParameters.activeVideoEnd; x++) {
-            qint32 dp = x * 2;
-            qint32 pixelValue = (static_cast<uchar>(fieldLineData[dp + 1]) * 256) + static_cast<uchar>(fieldLineData[dp]);
+            qint32 pixelValue = fieldLineData[x];
 
             // Examine the current pixel
             if (pixelValue == 0 || pixelValue >= 65535) dropout = true; else dropout = false;
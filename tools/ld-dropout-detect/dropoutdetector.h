@@ -29,6 +29,8 @@
 
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
+#include "fieldbuffer.h"
+#include "throughputtimer.h"
 
 class DropOutDetector : public QObject
 {
@@ -36,7 +38,8 @@ class DropOutDetector : public QObject
 public:
     explicit DropOutDetector(QObject *parent = nullptr);
 
-    bool process(QString inputFileName);
+    bool process(QString inputFileName, QString outputJsonFileName, qint32 firstFieldNumber, qint32 lastFieldNumber,
+                 bool isScanModeSet, bool isNoCompactSet);
 
 signals:
 
@@ -52,7 +55,7 @@ private:
 
     DocConfiguration docConfiguration;
 
-    LdDecodeMetaData::DropOuts detectDropOuts(QByteArray sourceFieldData, LdDecodeMetaData::VideoParameters videoParameters);
+    LdDecodeMetaData::DropOuts detectDropOuts(FieldBuffer sourceField, LdDecodeMetaData::VideoParameters videoParameters);
 };
 
 #endif // DROPOUTDETECTOR_H
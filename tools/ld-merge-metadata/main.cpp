@@ -0,0 +1,147 @@
+/************************************************************************
+
+    main.cpp
+
+    ld-merge-metadata - Metadata merge for ld-decode
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-merge-metadata is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QtGlobal>
+#include <QCommandLineParser>
+
+#include "metadatamerger.h"
+
+// Global for debug output
+static bool showDebug = false;
+
+// Qt debug message handler
+void debugOutputHandler(QtMsgType type, const QMessageLogContext &context, const QString &msg)
+{
+    // Use:
+    // context.file - to show the filename
+    // context.line - to show the line number
+    // context.function - to show the function name
+
+    QByteArray localMsg = msg.toLocal8Bit();
+    switch (type) {
+    case QtDebugMsg: // These are debug messages meant for developers
+        if (showDebug) {
+            // If the code was compiled as 'release' the context.file will be NULL
+            if (context.file != nullptr) fprintf(stderr, "Debug: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+            else fprintf(stderr, "Debug: %s\n", localMsg.constData());
+        }
+        break;
+    case QtInfoMsg: // These are information messages meant for end-users
+        if (context.file != nullptr) fprintf(stderr, "Info: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+        else fprintf(stderr, "Info: %s\n", localMsg.constData());
+        break;
+    case QtWarningMsg:
+        if (context.file != nullptr) fprintf(stderr, "Warning: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+        else fprintf(stderr, "Warning: %s\n", localMsg.constData());
+        break;
+    case QtCriticalMsg:
+        if (context.file != nullptr) fprintf(stderr, "Critical: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+        else fprintf(stderr, "Critical: %s\n", localMsg.constData());
+        break;
+    case QtFatalMsg:
+        if (context.file != nullptr) fprintf(stderr, "Fatal: [%s:%d] %s\n", context.file, context.line, localMsg.constData());
+        else fprintf(stderr, "Fatal: %s\n", localMsg.constData());
+        abort();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Install the local debug message handler
+    qInstallMessageHandler(debugOutputHandler);
+
+    QCoreApplication a(argc, argv);
+
+    // Set application name and version
+    QCoreApplication::setApplicationName("ld-merge-metadata");
+    QCoreApplication::setApplicationVersion("1.0");
+    QCoreApplication::setOrganizationDomain("domesday86.com");
+
+    // Set up the command line parser
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "ld-merge-metadata - Metadata merge for ld-decode\n"
+                "\n"
+                "Merges the partial JSON metadata written by ld-dropout-detect, ld-process-vbi and\n"
+                "ld-process-ntsc (when run with a field range and --output-json) into the complete\n"
+                "metadata for the input TBC file\n"
+                "\n"
+                "(c)2018 Simon Inns\n"
+                "GPLv3 Open-Source - github: https://github.com/happycube/ld-decode");
+    parser.addHelpOption();
+    parser.addVersionOption();
+
+    // Option to show debug (-d)
+    QCommandLineOption showDebugOption(QStringList() << "d" << "debug",
+                                       QCoreApplication::translate("main", "Show debug"));
+    parser.addOption(showDebugOption);
+
+    // Option to write the output JSON file without white space (--compact-json)
+    QCommandLineOption setCompactJsonOption(QStringList() << "compact-json",
+                                            QCoreApplication::translate("main", "Write the output JSON file in compact form (without indentation)"));
+    parser.addOption(setCompactJsonOption);
+
+    // Positional argument to specify the input metadata file
+    parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify the input (complete) JSON file"));
+
+    // Positional argument to specify the output metadata file
+    parser.addPositionalArgument("output", QCoreApplication::translate("main", "Specify the output JSON file (can be the input JSON file)"));
+
+    // Positional arguments to specify the partial metadata files
+    parser.addPositionalArgument("partial", QCoreApplication::translate("main", "Specify the partial JSON files to merge"), "partial...");
+
+    // Process the command line options and arguments given by the user
+    parser.process(a);
+
+    // Get the options from the parser
+    bool isDebugOn = parser.isSet(showDebugOption);
+    bool isCompactJsonSet = parser.isSet(setCompactJsonOption);
+
+    // Get the arguments from the parser
+    QString inputJsonFileName;
+    QString outputJsonFileName;
+    QStringList partialJsonFileNames;
+    QStringList positionalArguments = parser.positionalArguments();
+    if (positionalArguments.count() >= 3) {
+        inputJsonFileName = positionalArguments.takeFirst();
+        outputJsonFileName = positionalArguments.takeFirst();
+        partialJsonFileNames = positionalArguments;
+    } else {
+        // Quit with error
+        qCritical("You must specify the input and output JSON files and at least one partial JSON file");
+        return -1;
+    }
+
+    // Process the command line options
+    if (isDebugOn) showDebug = true;
+
+    // Perform the processing
+    MetaDataMerger metaDataMerger;
+    if (!metaDataMerger.process(inputJsonFileName, outputJsonFileName, partialJsonFileNames, isCompactJsonSet)) return -1;
+
+    // Quit with success
+    return 0;
+}
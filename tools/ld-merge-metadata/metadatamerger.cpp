@@ -0,0 +1,123 @@
+/************************************************************************
+
+    metadatamerger.cpp
+
+    ld-merge-metadata - Metadata merge for ld-decode
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-merge-metadata is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#include "metadatamerger.h"
+
+MetaDataMerger::MetaDataMerger(QObject *parent) : QObject(parent)
+{
+
+}
+
+// Merge the partial metadata files into the input metadata and write the output metadata.
+// The fields of each partial file replace the same fields of the input (if the partial
+// files overlap, the later file is used)
+bool MetaDataMerger::process(QString inputJsonFileName, QString outputJsonFileName, QStringList partialJsonFileNames,
+                             bool isCompactJsonSet)
+{
+    LdDecodeMetaData ldDecodeMetaData;
+
+    // Open the input metadata
+    if (!ldDecodeMetaData.read(inputJsonFileName)) {
+        qInfo() << "Unable to open ld-decode metadata file";
+        return false;
+    }
+
+    if (ldDecodeMetaData.isPartial()) {
+        qInfo() << "The input JSON file" << inputJsonFileName << "is partial metadata - the input must be complete";
+        return false;
+    }
+
+    // Merge the partial metadata files
+    QVector<bool> isFieldMerged(ldDecodeMetaData.getNumberOfFields());
+    isFieldMerged.fill(false);
+    for (qint32 i = 0; i < partialJsonFileNames.size(); i++) {
+        if (!mergePartial(ldDecodeMetaData, partialJsonFileNames[i], isFieldMerged)) return false;
+    }
+
+    // Show the fields that are not in any of the partial files (these are unchanged)
+    qint32 numberOfUnmergedFields = isFieldMerged.count(false);
+    if (numberOfUnmergedFields > 0) {
+        qInfo() << numberOfUnmergedFields << "fields are not in any of the partial JSON files and are unchanged";
+    }
+
+    // Write the output metadata
+    if (isCompactJsonSet) ldDecodeMetaData.setJsonFormat(JsonStreamWriter::compact);
+    if (!ldDecodeMetaData.write(outputJsonFileName)) {
+        qInfo() << "Unable to write the ld-decode metadata";
+        return false;
+    }
+    qInfo() << "Merge complete -" << partialJsonFileNames.size() << "partial JSON files merged into" << outputJsonFileName;
+
+    return true;
+}
+
+// Merge one partial metadata file
+bool MetaDataMerger::mergePartial(LdDecodeMetaData &ldDecodeMetaData, QString partialJsonFileName, QVector<bool> &isFieldMerged)
+{
+    LdDecodeMetaData partialMetaData;
+    if (!partialMetaData.read(partialJsonFileName)) {
+        qInfo() << "Unable to open partial metadata file" << partialJsonFileName;
+        return false;
+    }
+
+    // Check the partial metadata is for the same source
+    LdDecodeMetaData::VideoParameters videoParameters = ldDecodeMetaData.getVideoParameters();
+    LdDecodeMetaData::VideoParameters partialVideoParameters = partialMetaData.getVideoParameters();
+    if (partialVideoParameters.isSourcePal != videoParameters.isSourcePal ||
+            partialVideoParameters.fieldWidth != videoParameters.fieldWidth ||
+            partialVideoParameters.fieldHeight != videoParameters.fieldHeight) {
+        qInfo() << "Partial metadata file" << partialJsonFileName << "is not for the same video as the input JSON file";
+        return false;
+    }
+
+    qint32 firstFieldNumber = partialMetaData.getPartialFirstFieldNumber();
+    qint32 numberOfFields = partialMetaData.getNumberOfFields();
+    qint32 lastFieldNumber = firstFieldNumber + numberOfFields - 1;
+    if (lastFieldNumber > ldDecodeMetaData.getNumberOfFields()) {
+        qInfo() << "Partial metadata file" << partialJsonFileName << "has fields" << firstFieldNumber << "to" << lastFieldNumber <<
+                   "but the input JSON file only has" << ldDecodeMetaData.getNumberOfFields() << "fields";
+        return false;
+    }
+
+    if (!partialMetaData.isPartial()) {
+        qInfo() << "Partial metadata file" << partialJsonFileName << "is complete metadata - merging all of its fields";
+    }
+
+    // Copy the fields
+    qint32 numberOfOverlappingFields = 0;
+    for (qint32 fieldNumber = firstFieldNumber; fieldNumber <= lastFieldNumber; fieldNumber++) {
+        if (isFieldMerged[fieldNumber - 1]) numberOfOverlappingFields++;
+        isFieldMerged[fieldNumber - 1] = true;
+
+        ldDecodeMetaData.updateField(partialMetaData.getField(fieldNumber - firstFieldNumber + 1), fieldNumber);
+    }
+
+    if (numberOfOverlappingFields > 0) {
+        qWarning() << "Partial metadata file" << partialJsonFileName << "overlaps" << numberOfOverlappingFields <<
+                      "fields of an earlier partial file - using the fields from" << partialJsonFileName;
+    }
+    qInfo() << "Merged fields" << firstFieldNumber << "to" << lastFieldNumber << "from" << partialJsonFileName;
+
+    return true;
+}
@@ -0,0 +1,51 @@
+/************************************************************************
+
+    metadatamerger.h
+
+    ld-merge-metadata - Metadata merge for ld-decode
+    Copyright (C) 2018 Simon Inns
+
+    This file is part of ld-decode-tools.
+
+    ld-merge-metadata is free software: you can redistribute it and/or
+    modify it under the terms of the GNU General Public License as
+    published by the Free Software Foundation, either version 3 of the
+    License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+************************************************************************/
+
+#ifndef METADATAMERGER_H
+#define METADATAMERGER_H
+
+#include <QObject>
+#include <QStringList>
+#include <QVector>
+
+#include "lddecodemetadata.h"
+
+class MetaDataMerger : public QObject
+{
+    Q_OBJECT
+public:
+    explicit MetaDataMerger(QObject *parent = nullptr);
+
+    bool process(QString inputJsonFileName, QString outputJsonFileName, QStringList partialJsonFileNames,
+                 bool isCompactJsonSet);
+
+signals:
+
+public slots:
+
+private:
+    bool mergePartial(LdDecodeMetaData &ldDecodeMetaData, QString partialJsonFileName, QVector<bool> &isFieldMerged);
+};
+
+#endif // METADATAMERGER_H
@@ -28,6 +28,7 @@
 #include <QCommandLineParser>
 
 #include "ntscprocess.h"
+#include "fieldpassoptions.h"
 
 // Global for debug output
 static bool showDebug = false;
@@ -95,6 +96,10 @@ int main(int argc, char *argv[])
                                        QCoreApplication::translate("main", "Show debug"));
     parser.addOption(showDebugOption);
 
+    // Options to select the field range, the output JSON file and --no-compact
+    FieldPassOptions fieldPassOptions;
+    fieldPassOptions.addOptions(parser);
+
     // Positional argument to specify input video file
     parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file"));
 
@@ -115,12 +120,19 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    // Get the field range and output options
+    if (!fieldPassOptions.readOptions(parser, inputFileName)) {
+        // Quit with error
+        return -1;
+    }
+
     // Process the command line options
     if (isDebugOn) showDebug = true;
 
     // Perform the processing
     NtscProcess ntscProcess;
-    ntscProcess.process(inputFileName);
+    ntscProcess.process(inputFileName, fieldPassOptions.getOutputJsonFileName(), fieldPassOptions.getFirstFieldNumber(),
+                        fieldPassOptions.getLastFieldNumber(), fieldPassOptions.isNoCompactSet());
 
     // Quit with success
     return 0;
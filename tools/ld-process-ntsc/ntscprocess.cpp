@@ -29,7 +29,8 @@ NtscProcess::NtscProcess(QObject *parent) : QObject(parent)
 
 }
 
-bool NtscProcess::process(QString inputFileName)
+bool NtscProcess::process(QString inputFileName, QString outputJsonFileName, qint32 firstFieldNumber, qint32 lastFieldNumber,
+                          bool isNoCompactSet)
 {
     LdDecodeMetaData ldDecodeMetaData;
     SourceVideo sourceVideo;
@@ -50,23 +51,37 @@ bool NtscProcess::process(QString inputFileName)
         return false;
     }
 
-    // Open the source video
-    if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
+    // Open the source video (only a few lines of each field are read, so the read-ahead
+    // thread is not required)
+    sourceVideo.setPrefetchDepth(0);
+    if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight, videoParameters.fieldWidth)) {
         // Could not open source video file
         qInfo() << "Unable to open ld-decode video file";
         return false;
     }
 
+    // Start the pass over the field range (the updated fields are journalled, so an
+    // interrupted run carries on from where it stopped)
+    if (!ldDecodeMetaData.beginFieldPass(outputJsonFileName, "ld-process-ntsc", !isNoCompactSet, sourceVideo.getNumberOfAvailableFields(),
+                                         firstFieldNumber, lastFieldNumber)) {
+        return false;
+    }
+
     // Process the VBI data for the fields
-    for (qint32 fieldNumber = 1; fieldNumber <= sourceVideo.getNumberOfAvailableFields(); fieldNumber++) {
-        SourceField *sourceField;
+    for (qint32 fieldNumber = firstFieldNumber; fieldNumber <= lastFieldNumber; fieldNumber++) {
+        QByteArray fieldLines;
         FmCode fmCode;
         FmCode::FmDecode fmDecode;
         bool isWhiteFlag = false;
         WhiteFlag whiteFlag;
 
-        // Get the source field
-        sourceField = sourceVideo.getVideoField(fieldNumber);
+        // Get the FM code and white flag field lines (10 and 11) from the source field
+        fieldLines = sourceVideo.getFieldLines(fieldNumber, 10, 2);
+        if (fieldLines.isEmpty()) {
+            qInfo() << "Reading field" << fieldNumber << "from the input video file failed";
+            sourceVideo.close();
+            return false;
+        }
 
         // Get the existing field data from the metadata
         LdDecodeMetaData::Field field = ldDecodeMetaData.getField(fieldNumber);
@@ -74,10 +89,10 @@ bool NtscProcess::process(QString inputFileName)
         else  qInfo() << "Processing field" << fieldNumber << "(second)";
 
         // Get the 40-bit FM coded data from the field lines
-        fmDecode = fmCode.fmDecoder(getActiveVideoLine(sourceField, 10, videoParameters), videoParameters);
+        fmDecode = fmCode.fmDecoder(getActiveVideoLine(fieldLines, 10, 10, videoParameters), videoParameters);
 
         // Get the white flag from the field lines
-        isWhiteFlag = whiteFlag.getWhiteFlag(getActiveVideoLine(sourceField, 11, videoParameters), videoParameters);
+        isWhiteFlag = whiteFlag.getWhiteFlag(getActiveVideoLine(fieldLines, 10, 11, videoParameters), videoParameters);
 
         // Update the metadata
         if (fmDecode.receiverClockSyncBits != 0) {
@@ -99,9 +114,8 @@ bool NtscProcess::process(QString inputFileName)
         qDebug() << "NtscProcess::process(): Updating metadata for field" << fieldNumber;
     }
 
-    // Write the metadata file
-    QString outputFileName = inputFileName + ".json";
-    ldDecodeMetaData.write(outputFileName);
+    // End the pass and (unless --no-compact is set) write the metadata file
+    if (!ldDecodeMetaData.finishFieldPass()) return false;
     qInfo() << "Processing complete";
 
     // Close the source video
@@ -111,17 +125,19 @@ bool NtscProcess::process(QString inputFileName)
 }
 
 // Private method to get a single scanline of greyscale data
-QByteArray NtscProcess::getActiveVideoLine(SourceField *sourceField, qint32 fieldLine,
+// (fieldLines contains the field lines read from the source video starting at firstLine)
+QByteArray NtscProcess::getActiveVideoLine(QByteArray fieldLines, qint32 firstLine, qint32 fieldLine,
                                         LdDecodeMetaData::VideoParameters videoParameters)
 {
     // Range-check the scan line
-    if (fieldLine > videoParameters.fieldHeight || fieldLine < 1) {
+    qint32 lastLine = firstLine + (fieldLines.size() / (videoParameters.fieldWidth * 2)) - 1;
+    if (fieldLine > lastLine || fieldLine < firstLine) {
         qWarning() << "Cannot generate field-line data, line number is out of bounds! Scan line =" << fieldLine;
         return QByteArray();
     }
 
-    qint32 startPointer = ((fieldLine - 1) * videoParameters.fieldWidth * 2) + (videoParameters.blackLevelEnd * 2);
+    qint32 startPointer = ((fieldLine - firstLine) * videoParameters.fieldWidth * 2) + (videoParameters.blackLevelEnd * 2);
     qint32 length = (videoParameters.activeVideoEnd - videoParameters.blackLevelEnd) * 2;
 
-    return sourceField->getFieldData().mid(startPointer, length);
+    return fieldLines.mid(startPointer, length);
 }
@@ -38,14 +38,15 @@ class NtscProcess : public QObject
 public:
     explicit NtscProcess(QObject *parent = nullptr);
 
-    bool process(QString inputFileName);
+    bool process(QString inputFileName, QString outputJsonFileName, qint32 firstFieldNumber, qint32 lastFieldNumber,
+                 bool isNoCompactSet);
 
 signals:
 
 public slots:
 
 private:
-    QByteArray getActiveVideoLine(SourceField *sourceField, qint32 fieldLine,
+    QByteArray getActiveVideoLine(QByteArray fieldLines, qint32 firstLine, qint32 fieldLine,
                                             LdDecodeMetaData::VideoParameters videoParameters);
 };
 
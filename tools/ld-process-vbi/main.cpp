@@ -28,6 +28,7 @@
 #include <QCommandLineParser>
 
 #include "vbidecoder.h"
+#include "fieldpassoptions.h"
 
 // Global for debug output
 static bool showDebug = false;
@@ -95,6 +96,15 @@ int main(int argc, char *argv[])
                                        QCoreApplication::translate("main", "Show debug"));
     parser.addOption(showDebugOption);
 
+    // Option to use scan mode (--scan)
+    QCommandLineOption scanModeOption(QStringList() << "scan",
+                                      QCoreApplication::translate("main", "Scan mode for whole-disc passes (do not keep the video in the page cache)"));
+    parser.addOption(scanModeOption);
+
+    // Options to select the field range, the output JSON file and --no-compact
+    FieldPassOptions fieldPassOptions;
+    fieldPassOptions.addOptions(parser);
+
     // Positional argument to specify input video file
     parser.addPositionalArgument("input", QCoreApplication::translate("main", "Specify input TBC file"));
 
@@ -103,6 +113,7 @@ int main(int argc, char *argv[])
 
     // Get the options from the parser
     bool isDebugOn = parser.isSet(showDebugOption);
+    bool isScanModeSet = parser.isSet(scanModeOption);
 
     // Get the arguments from the parser
     QString inputFileName;
@@ -115,12 +126,19 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    // Get the field range and output options
+    if (!fieldPassOptions.readOptions(parser, inputFileName)) {
+        // Quit with error
+        return -1;
+    }
+
     // Process the command line options
     if (isDebugOn) showDebug = true;
 
     // Perform the processing
     VbiDecoder vbiDecoder;
-    vbiDecoder.process(inputFileName);
+    vbiDecoder.process(inputFileName, fieldPassOptions.getOutputJsonFileName(), fieldPassOptions.getFirstFieldNumber(),
+                       fieldPassOptions.getLastFieldNumber(), isScanModeSet, fieldPassOptions.isNoCompactSet());
 
     // Quit with success
     return 0;
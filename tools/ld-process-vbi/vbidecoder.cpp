@@ -29,7 +29,8 @@ VbiDecoder::VbiDecoder(QObject *parent) : QObject(parent)
 
 }
 
-bool VbiDecoder::process(QString inputFileName)
+bool VbiDecoder::process(QString inputFileName, QString outputJsonFileName, qint32 firstFieldNumber, qint32 lastFieldNumber,
+                         bool isScanModeSet, bool isNoCompactSet)
 {
     LdDecodeMetaData ldDecodeMetaData;
     SourceVideo sourceVideo;
@@ -44,20 +45,37 @@ bool VbiDecoder::process(QString inputFileName)
 
     qDebug() << "VbiDecoder::process(): Input source is" << videoParameters.fieldWidth << "x" << videoParameters.fieldHeight << "filename" << inputFileName;
 
-    // Open the source video
-    if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight)) {
+    // Open the source video (only a few lines of each field are read, so the read-ahead
+    // thread is not required)
+    sourceVideo.setPrefetchDepth(0);
+    sourceVideo.setScanMode(isScanModeSet);
+    if (!sourceVideo.open(inputFileName, videoParameters.fieldWidth * videoParameters.fieldHeight, videoParameters.fieldWidth)) {
         // Could not open source video file
         qInfo() << "Unable to open ld-decode video file";
         return false;
     }
 
+    // Start the pass over the field range (the updated fields are journalled, so an
+    // interrupted run carries on from where it stopped)
+    if (!ldDecodeMetaData.beginFieldPass(outputJsonFileName, "ld-process-vbi", !isNoCompactSet, sourceVideo.getNumberOfAvailableFields(),
+                                         firstFieldNumber, lastFieldNumber)) {
+        return false;
+    }
+
     // Process the VBI data for the fields
-    for (qint32 fieldNumber = 1; fieldNumber <= sourceVideo.getNumberOfAvailableFields(); fieldNumber++) {
-        SourceField *sourceField;
+    ThroughputTimer throughputTimer;
+    throughputTimer.start();
+    for (qint32 fieldNumber = firstFieldNumber; fieldNumber <= lastFieldNumber; fieldNumber++) {
+        QByteArray fieldLines;
         VbiDecoder vbiDecoder;
 
-        // Get the source field
-        sourceField = sourceVideo.getVideoField(fieldNumber);
+        // Get the VBI field lines (16 to 18) from the source field
+        fieldLines = sourceVideo.getFieldLines(fieldNumber, 16, 3);
+        if (fieldLines.isEmpty()) {
+            qInfo() << "Reading field" << fieldNumber << "from the input video file failed";
+            sourceVideo.close();
+            return false;
+        }
 
         // Get the existing field data from the metadata
         LdDecodeMetaData::Field field = ldDecodeMetaData.getField(fieldNumber);
@@ -69,9 +87,9 @@ bool VbiDecoder::process(QString inputFileName)
 
         // Get the VBI data from the field lines
         qDebug() << "VbiDecoder::process(): Getting field-lines for field" << fieldNumber;
-        field.vbi.vbi16 = manchesterDecoder(getActiveVideoLine(sourceField, 16, videoParameters), zcPoint, videoParameters);
-        field.vbi.vbi17 = manchesterDecoder(getActiveVideoLine(sourceField, 17, videoParameters), zcPoint, videoParameters);
-        field.vbi.vbi18 = manchesterDecoder(getActiveVideoLine(sourceField, 18, videoParameters), zcPoint, videoParameters);
+        field.vbi.vbi16 = manchesterDecoder(getActiveVideoLine(fieldLines, 16, 16, videoParameters), zcPoint, videoParameters);
+        field.vbi.vbi17 = manchesterDecoder(getActiveVideoLine(fieldLines, 16, 17, videoParameters), zcPoint, videoParameters);
+        field.vbi.vbi18 = manchesterDecoder(getActiveVideoLine(fieldLines, 16, 18, videoParameters), zcPoint, videoParameters);
 
         // Show the VBI data as hexadecimal
         qInfo() << "Processing field" << fieldNumber <<
@@ -88,9 +106,13 @@ bool VbiDecoder::process(QString inputFileName)
         qDebug() << "VbiDecoder::process(): Updating metadata for field" << fieldNumber;
     }
 
-    // Write the metadata file
-    QString outputFileName = inputFileName + ".json";
-    ldDecodeMetaData.write(outputFileName);
+    // Show the processing throughput (only the three VBI lines of each field are read; none
+    // if no fields were processed, e.g. when resuming a completed pass)
+    qint32 numberOfProcessedFields = lastFieldNumber - firstFieldNumber + 1;
+    throughputTimer.showThroughput(numberOfProcessedFields, static_cast<qint64>(numberOfProcessedFields) * videoParameters.fieldWidth * 3 * 2);
+
+    // End the pass and (unless --no-compact is set) write the metadata file
+    if (!ldDecodeMetaData.finishFieldPass()) return false;
     qInfo() << "Processing complete";
 
     // Close the source video
@@ -703,19 +725,21 @@ quint32 VbiDecoder::hammingCode(quint32 x4, quint32 x5)
 }
 
 // Private method to get a single scanline of greyscale data
-QByteArray VbiDecoder::getActiveVideoLine(SourceField *sourceField, qint32 fieldLine,
+// (fieldLines contains the field lines read from the source video starting at firstLine)
+QByteArray VbiDecoder::getActiveVideoLine(QByteArray fieldLines, qint32 firstLine, qint32 fieldLine,
                                         LdDecodeMetaData::VideoParameters videoParameters)
 {
     // Range-check the scan line
-    if (fieldLine > videoParameters.fieldHeight || fieldLine < 1) {
+    qint32 lastLine = firstLine + (fieldLines.size() / (videoParameters.fieldWidth * 2)) - 1;
+    if (fieldLine > lastLine || fieldLine < firstLine) {
         qWarning() << "Cannot generate field-line data, line number is out of bounds! Scan line =" << fieldLine;
         return QByteArray();
     }
 
-    qint32 startPointer = ((fieldLine - 1) * videoParameters.fieldWidth * 2) + (videoParameters.blackLevelEnd * 2);
+    qint32 startPointer = ((fieldLine - firstLine) * videoParameters.fieldWidth * 2) + (videoParameters.blackLevelEnd * 2);
     qint32 length = (videoParameters.activeVideoEnd - videoParameters.blackLevelEnd) * 2;
 
-    return sourceField->getFieldData().mid(startPointer, length);
+    return fieldLines.mid(startPointer, length);
 }
 
 // Private method to read a 24-bit biphase coded signal (manchester code) from a field line
@@ -29,6 +29,7 @@
 
 #include "sourcevideo.h"
 #include "lddecodemetadata.h"
+#include "throughputtimer.h"
 
 class VbiDecoder : public QObject
 {
@@ -36,14 +37,15 @@ class VbiDecoder : public QObject
 public:
     // Public methods
     explicit VbiDecoder(QObject *parent = nullptr);
-    bool process(QString inputFileName);
+    bool process(QString inputFileName, QString outputJsonFileName, qint32 firstFieldNumber, qint32 lastFieldNumber,
+                 bool isScanModeSet, bool isNoCompactSet);
 
 signals:
 
 public slots:
 
 private:
-    QByteArray getActiveVideoLine(SourceField *sourceFrame, qint32 scanLine, LdDecodeMetaData::VideoParameters videoParameters);
+    QByteArray getActiveVideoLine(QByteArray fieldLines, qint32 firstLine, qint32 scanLine, LdDecodeMetaData::VideoParameters videoParameters);
     LdDecodeMetaData::Vbi translateVbi(qint32 vbi16, qint32 vbi17, qint32 vbi18);
     quint32 hammingCode(quint32 x4, quint32 x5);
     qint32 manchesterDecoder(QByteArray lineData, qint32 zcPoint, LdDecodeMetaData::VideoParameters videoParameters);